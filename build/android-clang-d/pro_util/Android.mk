@@ -14,6 +14,7 @@ LOCAL_SRC_FILES := pro_bsd_wrapper.cpp       \
                    pro_memory_pool.cpp       \
                    pro_notify_pipe.cpp       \
                    pro_shaper.cpp            \
+                   pro_slab_pool.cpp         \
                    pro_ssl_util.cpp          \
                    pro_stat.cpp              \
                    pro_thread.cpp            \
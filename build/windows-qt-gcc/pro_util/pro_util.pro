@@ -42,6 +42,7 @@ SOURCES += \
     ../../../src/pronet/pro_util/pro_memory_pool.cpp \
     ../../../src/pronet/pro_util/pro_notify_pipe.cpp \
     ../../../src/pronet/pro_util/pro_shaper.cpp \
+    ../../../src/pronet/pro_util/pro_slab_pool.cpp \
     ../../../src/pronet/pro_util/pro_ssl_util.cpp \
     ../../../src/pronet/pro_util/pro_stat.cpp \
     ../../../src/pronet/pro_util/pro_thread.cpp \
@@ -67,6 +68,7 @@ HEADERS += \
     ../../../src/pronet/pro_util/pro_notify_pipe.h \
     ../../../src/pronet/pro_util/pro_ref_count.h \
     ../../../src/pronet/pro_util/pro_shaper.h \
+    ../../../src/pronet/pro_util/pro_slab_pool.h \
     ../../../src/pronet/pro_util/pro_ssl_util.h \
     ../../../src/pronet/pro_util/pro_stat.h \
     ../../../src/pronet/pro_util/pro_stl.h \
@@ -118,6 +118,18 @@
 #if !defined(PRO_TCP4_PAYLOAD_SIZE)
 #define PRO_TCP4_PAYLOAD_SIZE  (1024 * 1024 * 96)
 #endif
+#if !defined(PRO_SGI_TCACHE_BYTES)
+#define PRO_SGI_TCACHE_BYTES   (1024 * 32)
+#endif
+#if !defined(PRO_SGI_TCACHE_DEPTH)
+#define PRO_SGI_TCACHE_DEPTH   64
+#endif
+#if !defined(PRO_SGI_LARGE_CACHE_BYTES)
+#define PRO_SGI_LARGE_CACHE_BYTES (1024 * 1024 * 8)
+#endif
+#if !defined(PRO_SLAB_POOL_BYTES)
+#define PRO_SLAB_POOL_BYTES    (1024 * 16)
+#endif
 
 /////////////////////////////////////////////////////////////////////////////
 ////
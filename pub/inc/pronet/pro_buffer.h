@@ -21,6 +21,7 @@
 
 #include "pro_a.h"
 #include "pro_memory_pool.h"
+#include "pro_slab_pool.h"
 #include "pro_z.h"
 
 /////////////////////////////////////////////////////////////////////////////
@@ -69,7 +70,7 @@ private:
     size_t  m_size;
     int64_t m_magic;
 
-    DECLARE_SGI_POOL(0)
+    DECLARE_SLAB_POOL(0)
 };
 
 /////////////////////////////////////////////////////////////////////////////
@@ -129,6 +129,30 @@ static const PRO_TRANS_TYPE PRO_TRANS_SSL   = 11;
  * ]]]]
  */
 
+/*
+ * [[[[ Reactor backends
+ */
+typedef unsigned char PRO_REACTOR_BACKEND;
+
+static const PRO_REACTOR_BACKEND PRO_REACTOR_DEFAULT  = 0; /* epoll or select */
+static const PRO_REACTOR_BACKEND PRO_REACTOR_SELECT   = 1;
+static const PRO_REACTOR_BACKEND PRO_REACTOR_EPOLL    = 2;
+static const PRO_REACTOR_BACKEND PRO_REACTOR_IO_URING = 3;
+/*
+ * ]]]]
+ */
+
+/*
+ * [[[[ Reactor balance policies
+ */
+typedef unsigned char PRO_REACTOR_BALANCE;
+
+static const PRO_REACTOR_BALANCE PRO_BALANCE_HANDLERS = 0; /* fewest handlers */
+static const PRO_REACTOR_BALANCE PRO_BALANCE_LOAD     = 1; /* least measured load */
+/*
+ * ]]]]
+ */
+
 /*
  * Session nonce
  */
@@ -137,6 +161,51 @@ struct PRO_NONCE
     unsigned char nonce[32];
 };
 
+/*
+ * Reactor configuration
+ *
+ * Please refer to ProCreateReactorEx()
+ */
+struct PRO_REACTOR_CONFIG
+{
+    PRO_REACTOR_CONFIG()
+    {
+        ioThreadCount    = 1;
+        edgeTriggered    = false;
+        backend          = PRO_REACTOR_DEFAULT;
+        reusePortAccept  = false;
+        ioThreadCpus     = NULL;
+        acceptThreadCpus = NULL;
+        timerThreadCpus  = NULL;
+        balance          = PRO_BALANCE_HANDLERS;
+        migrateHandlers  = false;
+        busyPollTime     = 0;
+        busyPollSockets  = false;
+        loopStats        = false;
+        slowCallbackTime = 0;
+        timingWheel      = false;
+        handlerTimers    = false;
+        poolTrimInterval = 0;
+    }
+
+    unsigned int        ioThreadCount;    /* Number of threads for handling I/O events */
+    bool                edgeTriggered;    /* Whether to register transports edge-triggered */
+    PRO_REACTOR_BACKEND backend;          /* Event demultiplexer of the I/O threads */
+    bool                reusePortAccept;  /* Whether every I/O thread accepts on its own port socket */
+    const char*         ioThreadCpus;     /* Cpus to pin the I/O threads to, such as "0-7,16" */
+    const char*         acceptThreadCpus; /* Cpus to pin the accept thread to */
+    const char*         timerThreadCpus;  /* Cpus to pin the timer and mm-timer threads to */
+    PRO_REACTOR_BALANCE balance;          /* How to place a new handler on the I/O threads */
+    bool                migrateHandlers;  /* Whether to move busy transports off a hot thread */
+    unsigned int        busyPollTime;     /* Microseconds to spin for events before blocking */
+    bool                busyPollSockets;  /* Whether to set SO_BUSY_POLL on the transport sockets */
+    bool                loopStats;        /* Whether to keep histograms of the reactor loops */
+    unsigned int        slowCallbackTime; /* Microseconds a callback may run before it's reported */
+    bool                timingWheel;      /* Whether the timer threads keep a timing wheel */
+    bool                handlerTimers;    /* Whether the I/O threads fire the timers of their handlers */
+    unsigned int        poolTrimInterval; /* Seconds between two ProTrimSgiPools() calls. 0 for none */
+};
+
 /////////////////////////////////////////////////////////////////////////////
 ////
 
@@ -242,6 +311,25 @@ public:
         char*  buf,
         size_t size
         ) const = 0;
+
+    /*
+     * Create a normal timer that may trigger up to slack late (coarse timer)
+     *
+     * Coarse timers are aligned to shared time points and triggered in
+     * batches, with fewer wakeups of the timer thread. Suits periodic jobs
+     * such as statistics and keepalive checks
+     *
+     * Return timer ID. 0 is invalid
+     *
+     * Appended last, to keep the vtable slots of the earlier methods
+     */
+    virtual uint64_t SetupCoarseTimer(
+        IProOnTimer* onTimer,
+        uint64_t     firstDelay, /* First trigger delay (ms) */
+        uint64_t     period,     /* Timer period (ms). If 0, triggers only once */
+        uint64_t     slack,      /* Tolerated delay (ms). No more than period */
+        int64_t      userData = 0
+        ) = 0;
 };
 
 /////////////////////////////////////////////////////////////////////////////
@@ -839,6 +927,95 @@ PRO_NET_API
 IProReactor*
 ProCreateReactor(unsigned int ioThreadCount);
 
+/*
+ * Function: Create a reactor with a configuration
+ *
+ * Parameters:
+ * config : Reactor configuration
+ *
+ * Return: Reactor object or NULL
+ *
+ * Note: With config.edgeTriggered, the TCP, SSL and UDP transports are
+ *       registered with epoll edge-triggered for both reading and writing
+ *       once, and read/write until EAGAIN. A few reads or writes are
+ *       done per wakeup, and the rest is replayed on the next one, so that
+ *       a busy socket can't starve the others. Toggling write interest
+ *       then costs no epoll_ctl() call. It has no effect without epoll.
+ *
+ *       config.backend selects the event demultiplexer of the I/O threads.
+ *       A backend not built in or refused by the kernel falls back to the
+ *       default one, epoll on Linux and select elsewhere. io_uring needs
+ *       "-DPRO_HAS_IO_URING", see "build/DEFINE.txt". Where the kernel has
+ *       multishot recv and buffer rings, io_uring reads the TCP transports
+ *       with one multishot recv each, into buffers of the I/O thread,
+ *       instead of polling them. Those transports are then not migrated.
+ *       SSL and UDP transports and the acceptors are still polled.
+ *
+ *       With config.reusePortAccept, every TCP acceptor opens one
+ *       SO_REUSEPORT socket per I/O thread for its port, and the kernel
+ *       spreads the incoming connections over them. The handlers that
+ *       are registered from an I/O thread, such as the transports created
+ *       in OnAccept(), then stay on that thread. It has no effect without
+ *       "PRO_HAS_REUSEPORT".
+ *
+ *       The cpu lists are comma-separated cpus and ranges. The n-th thread
+ *       of a group is pinned to the (n % count)-th cpu of its list. NULL or
+ *       "" leaves the group unpinned. Every reactor is created on its own
+ *       thread, after pinning, so that its memory is first touched on the
+ *       local NUMA node. Pinning is not supported on macOS
+ *
+ *       With config.balance set to PRO_BALANCE_LOAD, the load of every I/O
+ *       thread is sampled once a second, as the cpu time it consumed, or
+ *       as the events it dispatched where the cpu time is not available.
+ *       A new handler goes to the least loaded thread. With
+ *       config.migrateHandlers as well, one busy TCP or SSL transport a
+ *       second is moved from the hottest thread to the coldest one when
+ *       the hottest is more than twice as loaded. The move is done by the
+ *       old thread between two wakeups, so the callbacks of a transport
+ *       never overlap. Its handler timers, see config.handlerTimers, move
+ *       along with it
+ *
+ *       With config.busyPollTime, an epoll or io_uring I/O thread polls
+ *       for events without blocking for up to that many microseconds
+ *       before it sleeps, trading a busy cpu for a lower wakeup latency.
+ *       config.busyPollSockets also sets SO_BUSY_POLL to that time on the
+ *       sockets of the I/O threads, where supported. Raising it above
+ *       "net.core.busy_read" needs CAP_NET_ADMIN. GetTraceInfo() then
+ *       shows the spin and the blocked time of every thread
+ *
+ *       With config.loopStats, GetTraceInfo() shows the p50/p99/max of
+ *       every I/O thread, for the time blocked a wakeup, the events a
+ *       wakeup, the time in each callback, and the lag of a cross-thread
+ *       wakeup, and of the timer threads, for the time in each OnTimer()
+ *       and the lag past the expiry. With config.slowCallbackTime, it
+ *       also shows the count and the latest few of the callbacks that
+ *       ran that long, with the handler type and sockId or timer ID, and
+ *       a callback that has been running that long and hasn't returned
+ *
+ *       With config.timingWheel, the timer and mm-timer threads keep their
+ *       timers in a hierarchical timing wheel of 1ms slots instead of a
+ *       sorted tree, so that setting up, cancelling and firing a timer
+ *       cost O(1) however many timers there are. The timers fire as
+ *       they would otherwise, but those expiring in the same millisecond
+ *       may fire in any order
+ *
+ *       With config.handlerTimers, the heartbeat and timeout timers of the
+ *       transports and handshakers are fired by the I/O thread of the
+ *       transport or handshaker, between two wakeups, instead of by the
+ *       timer thread. They never run alongside the I/O callbacks of that
+ *       transport then, and the timer work spreads over the I/O threads.
+ *       The I/O thread waits for events no longer than until its next
+ *       timer. The timers set up by SetupTimer() still fire on the timer
+ *       thread
+ *
+ *       With config.poolTrimInterval, the timer thread calls
+ *       ProTrimSgiPools() on the 4 SGI memory pools that often, so that
+ *       the memory left idle after a load peak goes back to the system
+ */
+PRO_NET_API
+IProReactor*
+ProCreateReactorEx(const PRO_REACTOR_CONFIG& config);
+
 /*
  * Function: Delete a reactor
  *
@@ -919,6 +1096,26 @@ PRO_NET_API
 unsigned short
 ProGetAcceptorPort(IProAcceptor* acceptor);
 
+/*
+ * Function: Get acceptor's status information string
+ *
+ * Parameters:
+ * acceptor : Acceptor object
+ * buf      : Output buffer
+ * size     : Buffer size
+ *
+ * Return: None
+ *
+ * Note: Each wakeup of a listening socket accepts up to PRO_ACCEPTOR_BATCH
+ *       connections. The string shows how many wakeups accepted 0, 1,
+ *       2+, 4+, ... connections, i.e. the burst sizes
+ */
+PRO_NET_API
+void
+ProGetAcceptorTraceInfo(IProAcceptor* acceptor,
+                        char*         buf,
+                        size_t        size);
+
 /*
  * Function: Delete an acceptor
  *
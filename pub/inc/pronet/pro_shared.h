@@ -69,6 +69,30 @@ extern "C" {
 /////////////////////////////////////////////////////////////////////////////
 ////
 
+/*
+ * SGI memory pool chunk backing, see ProGetSgiPoolPageInfo()
+ */
+#define PRO_SGI_PAGE_NORMAL  0 /* regular pages */
+#define PRO_SGI_PAGE_THP     1 /* transparent huge pages */
+#define PRO_SGI_PAGE_HUGETLB 2 /* hugetlbfs pages */
+
+/*
+ * SGI memory pool allocation profile, see ProGetSgiPoolTagProfile()
+ */
+#define PRO_SGI_PROFILE_TAGS          64 /* tag 0 holds the untagged allocations */
+#define PRO_SGI_PROFILE_LIFETIMES     24 /* [0] < 1 unit, [i] in [2^(i-1), 2^i) units */
+#define PRO_SGI_PROFILE_LIFETIME_UNIT 64 /* ms */
+
+/*
+ * Clock source of the cached tick, see ProSetCachedTickSource()
+ */
+#define PRO_TICK_SOURCE_PRECISE   0 /* the clock of ProGetTickCount64() */
+#define PRO_TICK_SOURCE_COARSE    1 /* CLOCK_MONOTONIC_COARSE */
+#define PRO_TICK_SOURCE_TSC       2 /* invariant TSC, calibrated against the precise clock */
+
+/////////////////////////////////////////////////////////////////////////////
+////
+
 /*
  * Function: Get the version number of this library
  *
@@ -167,6 +191,86 @@ PRO_SHARED_API
 void
 ProSleep(unsigned int milliseconds);
 
+/*
+ * Function: Select the clock source of the cached tick
+ *
+ * Parameters:
+ * source : PRO_TICK_SOURCE_PRECISE, PRO_TICK_SOURCE_COARSE
+ *          or PRO_TICK_SOURCE_TSC
+ *
+ * Return: The source in effect
+ *
+ * Note: A source the platform lacks falls back to the precise clock.
+ *       Selecting the TSC calibrates it, which takes about 10ms
+ */
+PRO_SHARED_API
+int
+ProSetCachedTickSource(int source);
+
+/*
+ * Function: Stamp the cached tick of the calling thread
+ *
+ * Parameters: None
+ *
+ * Return: Tick count in milliseconds
+ *
+ * Note: Reactor threads call this once per wakeup. From then on,
+ *       ProGetCachedTickCount64() on the thread returns the stamp
+ */
+PRO_SHARED_API
+int64_t
+ProUpdateCachedTickCount64();
+
+/*
+ * Function: Stop the calling thread from using the cached tick
+ *
+ * Parameters: None
+ *
+ * Return: None
+ *
+ * Note: None
+ */
+PRO_SHARED_API
+void
+ProResetCachedTickCount64();
+
+/*
+ * Function: Get the cached tick count since system boot
+ *
+ * Parameters: None
+ *
+ * Return: Tick count in milliseconds
+ *
+ * Note: On a thread that has stamped the cached tick, this returns the
+ *       last stamp without reading any clock, which may lag behind
+ *       ProGetTickCount64(). Otherwise it's ProGetTickCount64().
+ *       Per-packet paths that can live with the lag should use this
+ */
+PRO_SHARED_API
+int64_t
+ProGetCachedTickCount64();
+
+/*
+ * Function: Get the measured staleness of the cached tick
+ *
+ * Parameters:
+ * maxStaleness : Returned maximum staleness in microseconds
+ * avgStaleness : Returned average staleness in microseconds
+ * sampleNum    : Returned count of samples
+ * reset        : Whether to start a new measurement
+ *
+ * Return: None
+ *
+ * Note: Every 16th stamp of a thread samples how far the previous stamp
+ *       lags behind the precise clock at the moment it's replaced
+ */
+PRO_SHARED_API
+void
+ProGetCachedTickStaleness(int64_t*  maxStaleness, /* = NULL */
+                          int64_t*  avgStaleness, /* = NULL */
+                          uint64_t* sampleNum,    /* = NULL */
+                          bool      reset);
+
 /*
  * Function: Generate a normal timer ID
  *
@@ -202,7 +306,9 @@ ProMakeMmTimerId();
  *
  * Return: Allocated memory address or NULL
  *
- * Note: Each memory pool has its own access lock
+ * Note: Each memory pool has its own access lock. If the calling thread
+ *       is bound to a shard, requests for pool 0 are served by the pool
+ *       of that shard, see ProSetSgiPoolShard()
  */
 PRO_SHARED_API
 void*
@@ -219,7 +325,9 @@ ProAllocateSgiPoolBuffer(size_t       size,
  *
  * Return: Reallocated memory address or NULL
  *
- * Note: Each memory pool has its own access lock
+ * Note: Each memory pool has its own access lock. The memory stays in
+ *       the pool it was allocated from, poolIndex only applies if buf
+ *       is NULL
  */
 PRO_SHARED_API
 void*
@@ -236,8 +344,8 @@ ProReallocateSgiPoolBuffer(void*        buf,
  *
  * Return: None
  *
- * Note: The memory allocated from one memory pool can be deallocated
- *       to another, though rarely used this way
+ * Note: The memory always goes back to the pool it was allocated from,
+ *       whatever poolIndex is
  */
 PRO_SHARED_API
 void
@@ -252,12 +360,20 @@ ProDeallocateSgiPoolBuffer(void*        buf,
  * objSize     : Returned object size list
  * busyObjNum  : Returned count of busy objects list
  * totalObjNum : Returned total object count list
- * heapBytes   : Returned total heap capacity
+ * heapBytes   : Returned total chunk capacity
  * poolIndex   : Memory pool index [0, 3], total 4 memory pools
  *
  * Return: None
  *
- * Note: This function is used for debugging or status monitoring
+ * Note: This function is used for debugging or status monitoring.
+ *       Entries [0, 56] are the chunk-carved size classes (<= 128K),
+ *       entries [57, 63] are the large object classes (256K, 512K, ...,
+ *       16M), whose freed objects are cached up to
+ *       PRO_SGI_LARGE_CACHE_BYTES in all, shared by the classes and the
+ *       4 pools. Objects larger than 16M go to malloc() and are not
+ *       counted.
+ *       Objects parked in thread caches or remote-free lists are counted
+ *       as busy here, see ProGetSgiPoolCacheInfo() and ProSetSgiPoolShard()
  */
 PRO_SHARED_API
 void
@@ -268,6 +384,245 @@ ProGetSgiPoolInfo(void*        freeList[64],
                   size_t*      heapBytes,  /* = NULL */
                   unsigned int poolIndex); /* [0, 3] */
 
+/*
+ * Function: Get the idle memory of a SGI memory pool
+ *
+ * Parameters:
+ * poolIndex : Memory pool index [0, 3], total 4 memory pools
+ *
+ * Return: Bytes of the chunks that hold no busy object, and of the
+ *         cached large objects. ProTrimSgiPools() can release them
+ */
+PRO_SHARED_API
+size_t
+ProGetSgiPoolReclaimableBytes(unsigned int poolIndex); /* [0, 3] */
+
+/*
+ * Function: Give the idle memory of a SGI memory pool back to the system
+ *
+ * Parameters:
+ * poolIndex : Memory pool index [0, 3], total 4 memory pools
+ *
+ * Return: Bytes released
+ *
+ * Note: A chunk is released only when none of its objects is busy.
+ *       Cached large objects are all released.
+ *       The caller's own thread cache is drained first. The other
+ *       threads give their caches back at their next call of
+ *       ProCollectSgiPoolRemoteFrees(), so their chunks are released
+ *       by a later trim.
+ *       The free lists of the pool are walked under the pool lock,
+ *       so call it from a housekeeping path, not per packet
+ */
+PRO_SHARED_API
+size_t
+ProTrimSgiPools(unsigned int poolIndex); /* [0, 3] */
+
+/*
+ * Function: Back the chunks of a SGI memory pool with huge pages
+ *
+ * Parameters:
+ * enable    : Whether to try huge pages for new chunks
+ * poolIndex : Memory pool index [0, 3], total 4 memory pools
+ *
+ * Return: None
+ *
+ * Note: New chunks try MAP_HUGETLB (2M pages reserved via
+ *       /proc/sys/vm/nr_hugepages) first, then transparent huge pages
+ *       via madvise(MADV_HUGEPAGE), and quietly fall back to regular
+ *       pages. Chunks already mapped keep their backing, so call it
+ *       at startup. It is a no-op on platforms other than Linux
+ */
+PRO_SHARED_API
+void
+ProSetSgiPoolHugePage(bool         enable,
+                      unsigned int poolIndex); /* [0, 3] */
+
+/*
+ * Function: Get SGI memory pool chunk backing information
+ *
+ * Parameters:
+ * pageBytes : Returned heap bytes of each backing, indexed by
+ *             PRO_SGI_PAGE_NORMAL, PRO_SGI_PAGE_THP and PRO_SGI_PAGE_HUGETLB
+ * poolIndex : Memory pool index [0, 3], total 4 memory pools
+ *
+ * Return: None
+ *
+ * Note: This function is used for debugging or status monitoring
+ */
+PRO_SHARED_API
+void
+ProGetSgiPoolPageInfo(size_t       pageBytes[3],
+                      unsigned int poolIndex); /* [0, 3] */
+
+/*
+ * Function: Get SGI memory pool thread cache information
+ *
+ * Parameters:
+ * hitNum       : Returned count of allocations served by thread caches list
+ * missNum      : Returned count of thread cache refills list
+ * cachedObjNum : Returned count of objects parked in thread caches list
+ * poolIndex    : Memory pool index [0, 3], total 4 memory pools
+ *
+ * Return: None
+ *
+ * Note: Each thread keeps a small magazine per size class in front of
+ *       the pools, so most allocations and deallocations take no lock.
+ *       The counters are folded in at refill, drain and thread exit,
+ *       so they lag slightly behind. All values are 0 if the library is
+ *       built with PRO_LACKS_SGI_POOL_TCACHE
+ */
+PRO_SHARED_API
+void
+ProGetSgiPoolCacheInfo(size_t       hitNum[64],
+                       size_t       missNum[64],
+                       size_t       cachedObjNum[64],
+                       unsigned int poolIndex); /* [0, 3] */
+
+/*
+ * Function: Bind the current thread to a shard of the SGI memory pools
+ *
+ * Parameters:
+ * shard : Memory pool index [0, 3], or -1 to unbind
+ *
+ * Return: The previous shard of the current thread
+ *
+ * Note: Requests of a bound thread for pool 0 are served by the pool of
+ *       its shard, so threads bound to different shards don't contend for
+ *       a lock. Small objects that a bound thread frees into the pool of
+ *       another shard are handed over through a lock-free remote-free
+ *       list, which the owner pool picks up at its next thread cache
+ *       refill or trim, or in ProCollectSgiPoolRemoteFrees(). A list
+ *       longer than 4 magazines is handed to the pool by the freeing
+ *       thread. The reactor binds each I/O thread to a shard.
+ *       This function has no effect if the library is built with
+ *       PRO_LACKS_SGI_POOL_SHARD
+ */
+PRO_SHARED_API
+int
+ProSetSgiPoolShard(int shard); /* [0, 3], or -1 */
+
+/*
+ * Function: Pick up the objects freed by other shards into the pool of the
+ *           current thread's shard
+ *
+ * Parameters: None
+ *
+ * Return: None
+ *
+ * Note: The objects go to the thread cache of the current thread, up to
+ *       a magazine, and the rest to the pool. If ProTrimSgiPools() has
+ *       been called since, the whole thread cache goes back to the pools.
+ *       It costs two loads when nothing is pending, so a thread can call
+ *       it on every loop. The reactor calls it once per wakeup of each
+ *       I/O thread
+ */
+PRO_SHARED_API
+void
+ProCollectSgiPoolRemoteFrees();
+
+/*
+ * Function: Switch the allocation profile of the SGI memory pools on or off
+ *
+ * Parameters:
+ * enable : Whether to profile the allocations
+ *
+ * Return: None
+ *
+ * Note: The profile is off by default. While it's on, every allocation
+ *       records its pool, size class, tag and birth tick in its header,
+ *       and its deallocation is counted against them, no matter whether
+ *       the profile is still on by then. The counters are never reset
+ */
+PRO_SHARED_API
+void
+ProEnableSgiPoolProfile(bool enable);
+
+/*
+ * Function: Register an allocation tag of the SGI memory pools
+ *
+ * Parameters:
+ * name : Tag name, such as "rtp_packet". At most 31 characters are kept
+ *
+ * Return: Tag [1, PRO_SGI_PROFILE_TAGS - 1]. 0 if all tags are taken
+ *
+ * Note: Registering a name twice returns the same tag
+ */
+PRO_SHARED_API
+unsigned int
+ProRegisterSgiPoolTag(const char* name);
+
+/*
+ * Function: Set the allocation tag of the current thread
+ *
+ * Parameters:
+ * tag : Tag returned by ProRegisterSgiPoolTag(), or 0 for untagged
+ *
+ * Return: The previous tag of the current thread
+ *
+ * Note: Allocations of the current thread are counted against the tag
+ *       while the profile is on. Restore the previous tag when the
+ *       tagged call site is left, see CProSgiPoolTagScope
+ */
+PRO_SHARED_API
+unsigned int
+ProSetSgiPoolTag(unsigned int tag);
+
+/*
+ * Function: Get the allocation profile of each size class of a SGI memory pool
+ *
+ * Parameters:
+ * allocNum  : Returned count of allocations list
+ * freeNum   : Returned count of deallocations list
+ * liveBytes : Returned bytes of live objects list
+ * peakBytes : Returned high-water mark of live bytes list
+ * poolIndex : Memory pool index [0, 3], total 4 memory pools
+ *
+ * Return: None
+ *
+ * Note: This function is used for debugging or status monitoring.
+ *       The entries are the same as those of ProGetSgiPoolInfo().
+ *       Bytes are the requested sizes plus the 8-byte object header
+ */
+PRO_SHARED_API
+void
+ProGetSgiPoolProfile(uint64_t     allocNum[64],
+                     uint64_t     freeNum[64],
+                     size_t       liveBytes[64],
+                     size_t       peakBytes[64],
+                     unsigned int poolIndex); /* [0, 3] */
+
+/*
+ * Function: Get the allocation profile of a tag
+ *
+ * Parameters:
+ * tag       : Tag [0, PRO_SGI_PROFILE_TAGS - 1]
+ * name      : Returned tag name. "-" for tag 0
+ * allocNum  : Returned count of allocations
+ * freeNum   : Returned count of deallocations
+ * liveBytes : Returned bytes of live objects
+ * peakBytes : Returned high-water mark of live bytes
+ * lifetimes : Returned lifetime histogram of the deallocated objects.
+ *             [0] < 1 unit, [i] in [2^(i-1), 2^i) units,
+ *             the unit is PRO_SGI_PROFILE_LIFETIME_UNIT ms
+ *
+ * Return: false if the tag isn't registered
+ *
+ * Note: This function is used for debugging or status monitoring.
+ *       The last bucket holds everything from 2^22 units (about 3.1
+ *       days) up. Birth ticks wrap every 2^23 units (about 6.2 days),
+ *       so only longer lifetimes are folded into shorter ones
+ */
+PRO_SHARED_API
+bool
+ProGetSgiPoolTagProfile(unsigned int tag,
+                        char         name[32],
+                        uint64_t*    allocNum,
+                        uint64_t*    freeNum,
+                        size_t*      liveBytes,
+                        size_t*      peakBytes,
+                        uint64_t     lifetimes[PRO_SGI_PROFILE_LIFETIMES]);
+
 /////////////////////////////////////////////////////////////////////////////
 ////
 
@@ -0,0 +1,240 @@
+/*
+ * Copyright (C) 2018-2019 Eric Tung <libpronet@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"),
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file is part of LibProNet (https://github.com/libpronet/libpronet)
+ */
+
+/*
+ * A slab pool serves objects of one fixed size. Objects are carved from
+ * cache-line aligned slabs and recycled through an intrusive free list,
+ * so they carry no per-object header, and the live count of each type
+ * can be observed.
+ *
+ * Usage:
+ *
+ *   //// xxx.h
+ *   class CXxx
+ *   {
+ *       ...
+ *       DECLARE_SLAB_POOL(0)
+ *   };
+ *
+ *   //// xxx.cpp
+ *   IMPLEMENT_SLAB_POOL(CXxx, 0)
+ *
+ * The pool of a class is defined in one translation unit, so there is
+ * exactly one pool per type no matter how many modules include the header.
+ */
+
+#ifndef ____PRO_SLAB_POOL_H____
+#define ____PRO_SLAB_POOL_H____
+
+#include "pro_a.h"
+#include "pro_memory_pool.h"
+#include "pro_thread_mutex.h"
+#include "pro_z.h"
+
+/////////////////////////////////////////////////////////////////////////////
+////
+
+struct PRO_SLAB_OBJ
+{
+    PRO_SLAB_OBJ* next;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+////
+
+class CProSlabPool
+{
+public:
+
+    /*
+     * objSize is 0: the size of the first allocation is adopted
+     */
+    CProSlabPool(
+        size_t       objSize,
+        unsigned int poolIndex /* = 0 */
+        );
+
+    ~CProSlabPool();
+
+    /*
+     * Sizes larger than the object size go to the SGI pool
+     */
+    void* Allocate(size_t size);
+
+    void Deallocate(
+        void*  p,
+        size_t size
+        );
+
+    void GetInfo(
+        size_t* objSize,      /* = NULL */
+        size_t* liveObjNum,   /* = NULL */
+        size_t* totalObjNum,  /* = NULL */
+        size_t* slabBytes     /* = NULL */
+        ) const;
+
+private:
+
+    bool Grow_i();
+
+private:
+
+    const unsigned int      m_poolIndex;
+    size_t                  m_objSize;
+    PRO_SLAB_OBJ*           m_freeList;
+    char*                   m_startFree;
+    char*                   m_endFree;
+    size_t                  m_liveObjNum;
+    size_t                  m_totalObjNum;
+    size_t                  m_slabBytes;
+    PRO_SLAB_OBJ*           m_slabList;   /* the first line of each slab links them */
+    mutable CProThreadMutex m_lock;
+
+    DECLARE_SGI_POOL(0)
+};
+
+/////////////////////////////////////////////////////////////////////////////
+////
+
+#if defined(DECLARE_SLAB_POOL)
+#undef DECLARE_SLAB_POOL
+#endif
+#if defined(IMPLEMENT_SLAB_POOL)
+#undef IMPLEMENT_SLAB_POOL
+#endif
+
+#if !defined(PRO_LACKS_SGI_POOL) && !defined(PRO_LACKS_SGI_POOL_OPNEW)
+#define DECLARE_SLAB_POOL(a)                                                                     \
+public:                                                                                          \
+    static CProSlabPool& GetSlabPool();                                                          \
+    static void* operator new(size_t size);                                                      \
+    static void  operator delete(void* p, size_t size);                                          \
+    static void* operator new[](size_t size)     { return ProAllocateSgiPoolBuffer(size, (a)); } \
+    static void  operator delete[](void* p)      { ProDeallocateSgiPoolBuffer(p, (a)); }         \
+    static void* operator new(size_t, void* p)   { return p; }                                   \
+    static void  operator delete(void*, void*)   {}                                              \
+    static void* operator new[](size_t, void* p) { return p; }                                   \
+    static void  operator delete[](void*, void*) {}                                              \
+protected:
+#define IMPLEMENT_SLAB_POOL(c, a)                                                                \
+    CProSlabPool& c::GetSlabPool()                                                               \
+    {                                                                                            \
+        static CProSlabPool* s_pool = new CProSlabPool(sizeof(c), (a)); /* never deleted */      \
+        return *s_pool;                                                                          \
+    }                                                                                            \
+    void* c::operator new(size_t size)             { return GetSlabPool().Allocate(size); }     \
+    void  c::operator delete(void* p, size_t size) { GetSlabPool().Deallocate(p, size); }
+#else
+#define DECLARE_SLAB_POOL(a)                                                                     \
+public:                                                                                          \
+    static CProSlabPool& GetSlabPool();                                                          \
+protected:
+#define IMPLEMENT_SLAB_POOL(c, a)                                                                \
+    CProSlabPool& c::GetSlabPool()                                                               \
+    {                                                                                            \
+        static CProSlabPool* s_pool = new CProSlabPool(sizeof(c), (a)); /* never deleted */      \
+        return *s_pool;                                                                          \
+    }
+#endif
+
+/////////////////////////////////////////////////////////////////////////////
+////
+
+namespace std {
+
+/*
+ * An allocator for node based containers, such as set and map. Single
+ * nodes come from the slab pool returned by __getPool(), everything
+ * else from the SGI pool.
+ */
+template<typename __T, CProSlabPool& (*__getPool)()>
+class pro_slab_allocator : public pro_allocator<__T, 0>
+{
+public:
+
+    template<typename __Other>
+    struct rebind
+    {
+        typedef pro_slab_allocator<__Other, __getPool> other;
+    };
+
+    pro_slab_allocator() : pro_allocator<__T, 0>()
+    {
+    }
+
+    pro_slab_allocator(const pro_slab_allocator<__T, __getPool>&) : pro_allocator<__T, 0>()
+    {
+    }
+
+    template<typename __Other>
+    pro_slab_allocator(const pro_slab_allocator<__Other, __getPool>&)
+    {
+        /*
+         * do nothing
+         */
+    }
+
+    template<typename __Other>
+    pro_slab_allocator<__T, __getPool>& operator=(const pro_slab_allocator<__Other, __getPool>&)
+    {
+        /*
+         * do nothing
+         */
+        return *this;
+    }
+
+    __T* allocate(size_t __n)
+    {
+#if !defined(PRO_LACKS_SGI_POOL) && !defined(PRO_LACKS_SGI_POOL_STL)
+        if (__n == 1)
+        {
+            return (__T*)__getPool().Allocate(sizeof(__T));
+        }
+#endif
+
+        return pro_allocator<__T, 0>::allocate(__n);
+    }
+
+    __T* allocate(size_t __n, const void*)
+    {
+        return allocate(__n);
+    }
+
+    void deallocate(void* __p, size_t __n)
+    {
+#if !defined(PRO_LACKS_SGI_POOL) && !defined(PRO_LACKS_SGI_POOL_STL)
+        if (__n == 1)
+        {
+            __getPool().Deallocate(__p, sizeof(__T));
+
+            return;
+        }
+#endif
+
+        pro_allocator<__T, 0>::deallocate(__p, __n);
+    }
+
+    DECLARE_SGI_POOL(0)
+};
+
+} /* namespace std */
+
+/////////////////////////////////////////////////////////////////////////////
+////
+
+#endif /* ____PRO_SLAB_POOL_H____ */
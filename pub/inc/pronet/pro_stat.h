@@ -39,6 +39,12 @@ public:
 
     void SetTimeSpan(unsigned int timeSpanInSeconds); /* = 5 */
 
+    /*
+     * Whether the tick is the per-wakeup stamp of a reactor thread. Set it
+     * only if the data is pushed on the reactor thread
+     */
+    void SetCachedTick(bool cachedTick); /* = false */
+
     void PushDataBytes(size_t dataBytes);
 
     void PushDataBits(size_t dataBits);
@@ -53,6 +59,7 @@ private:
 
 private:
 
+    bool    m_cachedTick;
     int64_t m_timeSpan;
     int64_t m_startTick;
     int64_t m_calcTick;
@@ -77,6 +84,12 @@ public:
 
     void SetMaxBrokenDuration(unsigned int brokenDurationInSeconds); /* = 5 */
 
+    /*
+     * Whether the tick is the per-wakeup stamp of a reactor thread. Set it
+     * only if the data is pushed on the reactor thread
+     */
+    void SetCachedTick(bool cachedTick); /* = false */
+
     void PushData(
         uint16_t seq,
         uint32_t ssrc = 0
@@ -96,6 +109,7 @@ private:
 
 private:
 
+    bool               m_cachedTick;
     int64_t            m_timeSpan;
     int64_t            m_maxBrokenDuration;
     int64_t            m_startTick;
@@ -123,6 +137,12 @@ public:
 
     void SetTimeSpan(unsigned int timeSpanInSeconds); /* = 5 */
 
+    /*
+     * Whether the tick is the per-wakeup stamp of a reactor thread. Set it
+     * only if the data is pushed on the reactor thread
+     */
+    void SetCachedTick(bool cachedTick); /* = false */
+
     void PushData(double dataValue);
 
     double CalcAvgValue();
@@ -135,6 +155,7 @@ private:
 
 private:
 
+    bool    m_cachedTick;
     int64_t m_timeSpan;
     int64_t m_startTick;
     int64_t m_calcTick;
@@ -161,6 +161,18 @@ extern
 int64_t
 ProGetNtpTickCount64();
 
+extern
+int64_t
+ProUpdateCachedTickCount64();
+
+extern
+void
+ProResetCachedTickCount64();
+
+extern
+int64_t
+ProGetCachedTickCount64();
+
 extern
 void
 ProSleep(unsigned int milliseconds);
@@ -21,6 +21,7 @@
 
 #include "pro_a.h"
 #include "pro_memory_pool.h"
+#include "pro_slab_pool.h"
 #include "pro_stl.h"
 #include "pro_thread_mutex.h"
 #include "pro_z.h"
@@ -75,9 +76,20 @@ struct PRO_TIMER_NODE
     unsigned int htbtSlotIndex;
     int64_t      userData;
 
+    /*
+     * The pool of the tree nodes holding PRO_TIMER_NODE, see CProTimerNodeSet
+     */
+    static CProSlabPool& GetSlabPool();
+
     DECLARE_SGI_POOL(0)
 };
 
+using CProTimerNodeSet = std::set<
+    PRO_TIMER_NODE,
+    std::less<PRO_TIMER_NODE>,
+    std::pro_slab_allocator<PRO_TIMER_NODE, &PRO_TIMER_NODE::GetSlabPool>
+    >;
+
 /////////////////////////////////////////////////////////////////////////////
 ////
 
@@ -159,7 +171,7 @@ private:
     bool                          m_wantExit;
     bool                          m_mmTimer;
     unsigned int                  m_mmResolution;
-    CProStlSet<PRO_TIMER_NODE>    m_timers;
+    CProTimerNodeSet              m_timers;
     CProStlMap<uint64_t, int64_t> m_timerId2ExpireTick;
     int64_t                       m_htbtPeriod;
     CProStlVector<size_t>         m_htbtTimerCounts;
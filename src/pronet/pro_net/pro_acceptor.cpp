@@ -72,9 +72,13 @@ m_loopExt(loopExt)
     m_sockId           = -1;
     m_sockIdUn         = -1;
     m_timeoutInSeconds = DEFAULT_TIMEOUT;
+    m_wakeupCount      = 0;
+    m_acceptCount      = 0;
+    m_maxBurst         = 0;
 
     memset(&m_localAddr  , 0, sizeof(pbsd_sockaddr_in));
     memset(&m_localAddrUn, 0, sizeof(pbsd_sockaddr_un));
+    memset(m_burstBuckets, 0, sizeof(m_burstBuckets));
 }
 
 CProAcceptor::~CProAcceptor()
@@ -91,6 +95,16 @@ CProAcceptor::~CProAcceptor()
 #endif
     m_sockId   = -1;
     m_sockIdUn = -1;
+
+    int i = 0;
+    int c = (int)m_shardSockIds.size();
+
+    for (; i < c; ++i)
+    {
+        ProCloseSockId(m_shardSockIds[i]);
+    }
+
+    m_shardSockIds.clear();
 }
 
 bool
@@ -123,9 +137,10 @@ CProAcceptor::Init(IProAcceptorObserver* observer,
         return false;
     }
 
-    int64_t          sockId   = -1;
-    int64_t          sockIdUn = -1;
-    pbsd_sockaddr_un localAddrUn;
+    int64_t                sockId   = -1;
+    int64_t                sockIdUn = -1;
+    CProStlVector<int64_t> shardSockIds;
+    pbsd_sockaddr_un       localAddrUn;
     memset(&localAddrUn, 0, sizeof(pbsd_sockaddr_un));
 
     {
@@ -138,37 +153,82 @@ CProAcceptor::Init(IProAcceptorObserver* observer,
             return false;
         }
 
-        sockId = pbsd_socket(AF_INET, SOCK_STREAM, 0);
-        if (sockId == -1)
+#if defined(PRO_HAS_REUSEPORT)
+        if (reactorTask->IsReusePortAccept())
         {
-            goto EXIT;
+            /*
+             * one listening socket per I/O thread. the first one fixes the port
+             */
+            for (int i = 0; i < (int)reactorTask->GetIoThreadCount(); ++i)
+            {
+                int64_t shardSockId = pbsd_socket(AF_INET, SOCK_STREAM, 0);
+                if (shardSockId == -1)
+                {
+                    goto EXIT;
+                }
+
+                shardSockIds.push_back(shardSockId);
+
+                int option = 1;
+                pbsd_setsockopt(shardSockId, IPPROTO_TCP, TCP_NODELAY , &option, sizeof(int));
+                pbsd_setsockopt(shardSockId, SOL_SOCKET , SO_REUSEPORT, &option, sizeof(int));
+
+                if (pbsd_bind(shardSockId, &localAddr, true) != 0)
+                {
+                    goto EXIT;
+                }
+
+                if (pbsd_getsockname(shardSockId, &localAddr) != 0)
+                {
+                    goto EXIT;
+                }
+
+                if (pbsd_listen(shardSockId) != 0)
+                {
+                    goto EXIT;
+                }
+
+                if (!reactorTask->AddAcceptShard(shardSockId, this, i))
+                {
+                    goto EXIT;
+                }
+            }
         }
+        else
+#endif /* PRO_HAS_REUSEPORT */
+        {
+            sockId = pbsd_socket(AF_INET, SOCK_STREAM, 0);
+            if (sockId == -1)
+            {
+                goto EXIT;
+            }
 
-        int option = 1;
-        pbsd_setsockopt(sockId, IPPROTO_TCP, TCP_NODELAY, &option, sizeof(int));
+            int option = 1;
+            pbsd_setsockopt(sockId, IPPROTO_TCP, TCP_NODELAY, &option, sizeof(int));
 
 #if defined(_WIN32)
-        if (pbsd_bind(sockId, &localAddr, false) != 0)
+            if (pbsd_bind(sockId, &localAddr, false) != 0)
 #else
-        if (pbsd_bind(sockId, &localAddr, true)  != 0)
+            if (pbsd_bind(sockId, &localAddr, true)  != 0)
 #endif
-        {
-            goto EXIT;
-        }
+            {
+                goto EXIT;
+            }
 
-        if (pbsd_getsockname(sockId, &localAddr) != 0)
-        {
-            goto EXIT;
-        }
+            if (pbsd_getsockname(sockId, &localAddr) != 0)
+            {
+                goto EXIT;
+            }
 
-        if (pbsd_listen(sockId) != 0)
-        {
-            goto EXIT;
-        }
+            if (pbsd_listen(sockId) != 0)
+            {
+                goto EXIT;
+            }
 
-        if (!reactorTask->AddHandler(sockId, this, PRO_MASK_ACCEPT))
-        {
-            goto EXIT;
+            if (!reactorTask->AddHandler(sockId, this, PRO_MASK_ACCEPT))
+            {
+                goto EXIT;
+            }
         }
 
 #if !defined(_WIN32)
@@ -218,6 +278,7 @@ CProAcceptor::Init(IProAcceptorObserver* observer,
         m_reactorTask      = reactorTask;
         m_sockId           = sockId;
         m_sockIdUn         = sockIdUn;
+        m_shardSockIds     = shardSockIds;
         m_localAddr        = localAddr;
         m_localAddrUn      = localAddrUn;
         m_timeoutInSeconds = timeoutInSeconds;
@@ -238,6 +299,12 @@ EXIT:
     }
 #endif
 
+    for (int i = 0; i < (int)shardSockIds.size(); ++i)
+    {
+        reactorTask->RemoveAcceptShard(shardSockIds[i], i);
+        ProCloseSockId(shardSockIds[i]);
+    }
+
     return false;
 }
 
@@ -258,6 +325,14 @@ CProAcceptor::Fini()
         m_reactorTask->RemoveHandler(m_sockId  , this, PRO_MASK_ACCEPT);
         m_reactorTask->RemoveHandler(m_sockIdUn, this, PRO_MASK_ACCEPT);
 
+        int i = 0;
+        int c = (int)m_shardSockIds.size();
+
+        for (; i < c; ++i)
+        {
+            m_reactorTask->RemoveAcceptShard(m_shardSockIds[i], i);
+        }
+
         handshaker2Nonce = m_handshaker2Nonce;
         m_handshaker2Nonce.clear();
         m_reactorTask = NULL;
@@ -302,6 +377,46 @@ CProAcceptor::GetLocalPort() const
     return localPort;
 }
 
+void
+CProAcceptor::GetTraceInfo(char*  buf,
+                           size_t size) const
+{
+    assert(buf != NULL);
+    assert(size > 0);
+    if (buf == NULL || size == 0)
+    {
+        return;
+    }
+
+    {
+        CProThreadMutexGuard mon(m_lock);
+
+        char theBuf[512] = "";
+
+        sprintf(
+            theBuf,
+            " [ Wakeups ] : %llu \n"
+            " [ Accepts ] : %llu \n"
+            " [ MaxBurst] : %u \n"
+            " [ Bursts  ] : 0:%llu 1:%llu 2+:%llu 4+:%llu 8+:%llu 16+:%llu 32+:%llu 64+:%llu "
+            ,
+            (unsigned long long)m_wakeupCount,
+            (unsigned long long)m_acceptCount,
+            m_maxBurst,
+            (unsigned long long)m_burstBuckets[0],
+            (unsigned long long)m_burstBuckets[1],
+            (unsigned long long)m_burstBuckets[2],
+            (unsigned long long)m_burstBuckets[3],
+            (unsigned long long)m_burstBuckets[4],
+            (unsigned long long)m_burstBuckets[5],
+            (unsigned long long)m_burstBuckets[6],
+            (unsigned long long)m_burstBuckets[7]
+            );
+
+        strncpy_pro(buf, size, theBuf);
+    }
+}
+
 void
 CProAcceptor::OnInput(int64_t sockId)
 {
@@ -311,6 +426,40 @@ CProAcceptor::OnInput(int64_t sockId)
         return;
     }
 
+    /*
+     * drain the backlog, but leave the rest of the reactor some time
+     */
+    unsigned int count = 0;
+    while (count < PRO_ACCEPTOR_BATCH && AcceptOnce(sockId))
+    {
+        ++count;
+    }
+
+    {
+        CProThreadMutexGuard mon(m_lock);
+
+        int          bucket = 0;
+        unsigned int burst  = count;
+
+        for (; burst > 0 && bucket < 7; burst >>= 1)
+        {
+            ++bucket;
+        }
+
+        ++m_wakeupCount;
+        m_acceptCount += count;
+        ++m_burstBuckets[bucket];
+
+        if (count > m_maxBurst)
+        {
+            m_maxBurst = count;
+        }
+    }
+}
+
+bool
+CProAcceptor::AcceptOnce(int64_t sockId)
+{
     IProAcceptorObserver* observer   = NULL;
     IProTcpHandshaker*    handshaker = NULL;
     int64_t               newSockId  = -1;
@@ -323,23 +472,44 @@ CProAcceptor::OnInput(int64_t sockId)
 
         if (m_observer == NULL || m_reactorTask == NULL)
         {
-            return;
+            return false;
+        }
+
+        bool isShard = false;
+
+        for (int i = 0; i < (int)m_shardSockIds.size(); ++i)
+        {
+            if (sockId == m_shardSockIds[i])
+            {
+                isShard = true;
+                break;
+            }
         }
 
-        if (sockId == m_sockId)
+        if (sockId == m_sockId || isShard)
         {
-            newSockId  = pbsd_accept(m_sockId, &remoteAddr);
+            newSockId  = pbsd_accept(sockId, &remoteAddr);
             unixSocket = false;
 
             if (newSockId != -1)
             {
+#if !defined(__linux__)
                 int option = 1;
                 pbsd_setsockopt(newSockId, IPPROTO_TCP, TCP_NODELAY, &option, sizeof(int));
+#endif
 
-                if (pbsd_getsockname(newSockId, &localAddr) != 0)
+                /*
+                 * a listener bound to a specific address tells the local one
+                 */
+                if (m_localAddr.sin_addr.s_addr != 0)
+                {
+                    localAddr = m_localAddr;
+                }
+                else if (pbsd_getsockname(newSockId, &localAddr) != 0)
                 {
                     ProCloseSockId(newSockId);
-                    newSockId = -1;
+
+                    return true; /* consumed */
                 }
             }
         }
@@ -351,12 +521,12 @@ CProAcceptor::OnInput(int64_t sockId)
         }
         else
         {
-            return;
+            return false;
         }
 
         if (newSockId == -1)
         {
-            return;
+            return false;
         }
 
         /*
@@ -366,7 +536,7 @@ CProAcceptor::OnInput(int64_t sockId)
         {
             ProCloseSockId(newSockId);
 
-            return;
+            return true;
         }
 
         bool isLoop = false;
@@ -404,7 +574,7 @@ CProAcceptor::OnInput(int64_t sockId)
                 ProCloseSockId(newSockId);
             }
 
-            return; /* return now */
+            return true; /* return now */
         }
 
         m_observer->AddRef();
@@ -430,6 +600,8 @@ CProAcceptor::OnInput(int64_t sockId)
         remotePort
         );
     observer->Release();
+
+    return true;
 }
 
 void
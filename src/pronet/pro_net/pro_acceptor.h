@@ -59,6 +59,11 @@ public:
 
     unsigned short GetLocalPort() const;
 
+    void GetTraceInfo(
+        char*  buf,
+        size_t size
+        ) const;
+
 private:
 
     CProAcceptor(
@@ -68,8 +73,15 @@ private:
 
     virtual ~CProAcceptor();
 
+    virtual const char* GetHandlerName() const
+    {
+        return "acceptor";
+    }
+
     virtual void OnInput(int64_t sockId);
 
+    bool AcceptOnce(int64_t sockId);
+
     virtual void OnError(
         int64_t sockId,
         int     errorCode
@@ -98,12 +110,21 @@ private:
     CProTpReactorTask*                        m_reactorTask;
     int64_t                                   m_sockId;
     int64_t                                   m_sockIdUn;
+    CProStlVector<int64_t>                    m_shardSockIds; /* SO_REUSEPORT, one per I/O thread */
     pbsd_sockaddr_in                          m_localAddr;
     pbsd_sockaddr_un                          m_localAddrUn;
     unsigned int                              m_timeoutInSeconds;
 
     CProStlMap<IProTcpHandshaker*, PRO_NONCE> m_handshaker2Nonce;
 
+    /*
+     * accepts per wakeup, bucketed by 0, 1, 2+, 4+, 8+, 16+, 32+ and 64+
+     */
+    uint64_t                                  m_wakeupCount;
+    uint64_t                                  m_acceptCount;
+    unsigned int                              m_maxBurst;
+    uint64_t                                  m_burstBuckets[8];
+
     mutable CProThreadMutex                   m_lock;
 
     DECLARE_SGI_POOL(0)
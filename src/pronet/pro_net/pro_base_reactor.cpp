@@ -19,10 +19,16 @@
 #include "pro_base_reactor.h"
 #include "pro_event_handler.h"
 #include "pro_handler_mgr.h"
+#include "pro_tp_reactor_task.h"
+#include "../pro_shared/pro_shared.h"
 #include "../pro_util/pro_bsd_wrapper.h"
 #include "../pro_util/pro_memory_pool.h"
 #include "../pro_util/pro_notify_pipe.h"
+#include "../pro_util/pro_stat.h"
+#include "../pro_util/pro_thread.h"
 #include "../pro_util/pro_thread_mutex.h"
+#include "../pro_util/pro_time_util.h"
+#include "../pro_util/pro_timer_factory.h"
 #include "../pro_util/pro_z.h"
 
 /////////////////////////////////////////////////////////////////////////////
@@ -30,13 +36,61 @@
 
 CProBaseReactor::CProBaseReactor()
 {
-    m_threadId   = 0;
-    m_wantExit   = false;
-    m_notifyPipe = new CProNotifyPipe;
+    m_threadId      = 0;
+    m_wantExit      = false;
+    m_notifyPipe    = new CProNotifyPipe;
+    m_eventCount    = 0;
+    m_busyPollTime  = 0;
+    m_spinTime      = 0;
+    m_waitTime      = 0;
+    m_migrationTask = NULL;
+    m_migrantSockId = -1;
+    m_migrant       = NULL;
+    m_timers        = NULL;
+    m_wakeTick      = 0;
+
+    m_loopStats        = false;
+    m_slowCallbackTime = 0;
+    m_callStart        = 0;
+    m_callSockId       = -1;
+    m_callName         = "";
+    m_callback         = "";
+    m_nextTimerTick    = 0;
 }
 
 CProBaseReactor::~CProBaseReactor()
 {
+    if (m_migrant != NULL)
+    {
+        m_migrant->Release();
+        m_migrant = NULL;
+    }
+
+    if (m_timers != NULL)
+    {
+        CProStlVector<PRO_TIMER_NODE> timers;
+        m_timers->GetAll(timers);
+
+        for (int i = 0; i < (int)timers.size(); ++i)
+        {
+            if (timers[i].onTimer != NULL)
+            {
+                timers[i].onTimer->Release();
+            }
+        }
+
+        CProStlVector<IProOnTimer*> htbtTimers;
+        m_htbtSlots.Clear(htbtTimers);
+
+        for (int j = 0; j < (int)htbtTimers.size(); ++j)
+        {
+            htbtTimers[j]->Release();
+        }
+
+        delete m_timers;
+        m_timers = NULL;
+    }
+
     delete m_notifyPipe;
     m_notifyPipe = NULL;
 }
@@ -54,3 +108,660 @@ CProBaseReactor::GetHandlerCount() const
 
     return count;
 }
+
+uint64_t
+CProBaseReactor::GetEventCount() const
+{
+    uint64_t count = 0;
+
+    {
+        CProThreadMutexGuard mon(m_lock);
+
+        count = m_eventCount;
+    }
+
+    return count;
+}
+
+void
+CProBaseReactor::GetPollTimes(uint64_t& spinTime,
+                              uint64_t& waitTime) const
+{
+    CProThreadMutexGuard mon(m_lock);
+
+    spinTime = m_spinTime;
+    waitTime = m_waitTime;
+}
+
+void
+CProBaseReactor::GetWakeupCounts(uint64_t& sentCount,
+                                 uint64_t& coalescedCount) const
+{
+    CProThreadMutexGuard mon(m_lock);
+
+    sentCount      = m_notifyPipe->GetSentCount();
+    coalescedCount = m_notifyPipe->GetCoalescedCount();
+}
+
+void
+CProBaseReactor::Wakeup()
+{
+    CProThreadMutexGuard mon(m_lock);
+
+    if (m_threadId != 0 && ProGetThreadId() != m_threadId)
+    {
+        m_notifyPipe->Notify();
+    }
+}
+
+bool
+CProBaseReactor::GetStuckCall(PRO_SLOW_CALL& call) const
+{
+    int64_t start = m_callStart;
+    if (start == 0 || m_slowCallbackTime == 0)
+    {
+        return false;
+    }
+
+    int64_t time = GetTickUs() - start;
+    if (time < (int64_t)m_slowCallbackTime)
+    {
+        return false;
+    }
+
+    /*
+     * the fields are read one by one, and may mix two calls. Good enough
+     * for a look at a callback that has been stuck for a while
+     */
+    call.tick     = ProGetTickCount64();
+    call.id       = m_callSockId;
+    call.name     = m_callName;
+    call.callback = m_callback;
+    call.time     = (uint64_t)time;
+
+    return true;
+}
+
+void
+CProBaseReactor::SetHandlerTimers(bool handlerTimers)
+{
+    CProThreadMutexGuard mon(m_lock);
+
+    assert(m_threadId == 0);
+    if (m_threadId != 0 || !handlerTimers || m_timers != NULL)
+    {
+        return;
+    }
+
+    m_timers = new CProTimerWheel(ProGetTickCount64());
+}
+
+uint64_t
+CProBaseReactor::SetupTimer(IProOnTimer* onTimer,
+                            uint64_t     firstDelay, /* [0, 0xFFFFFFFFFFFF] */
+                            uint64_t     period,     /* [0, 0xFFFFFFFFFFFF] */
+                            int64_t      userData)
+{
+    if (firstDelay > 0xFFFFFFFFFFFFULL)
+    {
+        firstDelay = 0xFFFFFFFFFFFFULL;
+    }
+    if (period > 0xFFFFFFFFFFFFULL)
+    {
+        period     = 0xFFFFFFFFFFFFULL;
+    }
+
+    assert(onTimer != NULL);
+    if (onTimer == NULL)
+    {
+        return 0;
+    }
+
+    PRO_TIMER_NODE node;
+    node.expireTick = ProGetTickCount64() + firstDelay;
+    node.timerId    = ProMakeTimerId();
+    node.onTimer    = onTimer;
+    node.period     = period;
+    node.userData   = userData;
+
+    if (!AddTimer(node))
+    {
+        return 0;
+    }
+
+    return node.timerId;
+}
+
+uint64_t
+CProBaseReactor::SetupHeartbeatTimer(IProOnTimer* onTimer,
+                                     int64_t      htbtPeriod, /* ms */
+                                     int64_t      userData)
+{
+    assert(onTimer != NULL);
+    assert(htbtPeriod > 0);
+    if (onTimer == NULL || htbtPeriod <= 0)
+    {
+        return 0;
+    }
+
+    uint64_t       timerId = ProMakeTimerId();
+    PRO_TIMER_NODE slotNode;
+
+    CProThreadMutexGuard mon(m_lock);
+
+    if (m_timers == NULL || m_wantExit)
+    {
+        return 0;
+    }
+
+    if (!m_htbtSlots.Add(
+        timerId, onTimer, userData, ProGetTickCount64(), htbtPeriod, slotNode))
+    {
+        return 0;
+    }
+
+    onTimer->AddRef();
+    if (slotNode.timerId != 0)
+    {
+        m_timers->Insert(slotNode);
+
+        if (m_wakeTick != 0 && slotNode.expireTick < m_wakeTick &&
+            ProGetThreadId() != m_threadId)
+        {
+            m_notifyPipe->Notify();
+        }
+    }
+
+    return timerId;
+}
+
+bool
+CProBaseReactor::CancelTimer(uint64_t timerId)
+{
+    PRO_TIMER_NODE node;
+
+    {
+        CProThreadMutexGuard mon(m_lock);
+
+        if (m_timers == NULL)
+        {
+            return false;
+        }
+
+        if (!m_timers->Remove(timerId, node))
+        {
+            uint64_t slotTimerId = 0;
+            if (!m_htbtSlots.Remove(timerId, node.onTimer, slotTimerId))
+            {
+                return false;
+            }
+
+            if (slotTimerId != 0)
+            {
+                PRO_TIMER_NODE slotNode;
+                m_timers->Remove(slotTimerId, slotNode);
+            }
+        }
+    }
+
+    node.onTimer->Release();
+
+    return true;
+}
+
+void
+CProBaseReactor::UpdateHeartbeatTimers(int64_t htbtPeriod) /* ms */
+{
+    assert(htbtPeriod > 0);
+    if (htbtPeriod <= 0)
+    {
+        return;
+    }
+
+    CProThreadMutexGuard mon(m_lock);
+
+    if (m_timers == NULL || m_wantExit)
+    {
+        return;
+    }
+
+    CProStlVector<PRO_TIMER_NODE> slotNodes;
+    m_htbtSlots.GetSlotNodes(ProGetTickCount64(), htbtPeriod, slotNodes);
+
+    for (int i = 0; i < (int)slotNodes.size(); ++i)
+    {
+        PRO_TIMER_NODE node;
+        m_timers->Remove(slotNodes[i].timerId, node);
+        m_timers->Insert(slotNodes[i]);
+    }
+
+    if (m_wakeTick != 0 && ProGetThreadId() != m_threadId)
+    {
+        m_notifyPipe->Notify();
+    }
+}
+
+size_t
+CProBaseReactor::GetTimerCount() const
+{
+    CProThreadMutexGuard mon(m_lock);
+
+    if (m_timers == NULL)
+    {
+        return 0;
+    }
+
+    return m_timers->GetCount() - m_htbtSlots.GetSlotsInUse() + m_htbtSlots.GetCount();
+}
+
+void
+CProBaseReactor::MoveTimers(IProOnTimer*     onTimer,
+                            CProBaseReactor* to,
+                            int64_t          htbtPeriod) /* ms */
+{
+    assert(onTimer != NULL);
+    assert(to != NULL);
+    assert(htbtPeriod > 0);
+    if (onTimer == NULL || to == NULL || to == this || htbtPeriod <= 0)
+    {
+        return;
+    }
+
+    CProStlVector<PRO_TIMER_NODE> timers;
+    CProStlVector<PRO_TIMER_NODE> htbtTimers;
+
+    {
+        CProThreadMutexGuard mon(m_lock);
+
+        if (m_timers == NULL)
+        {
+            return;
+        }
+
+        CProStlVector<PRO_TIMER_NODE> all;
+        m_timers->GetAll(all);
+
+        for (int i = 0; i < (int)all.size(); ++i)
+        {
+            if (all[i].onTimer == onTimer)
+            {
+                PRO_TIMER_NODE node;
+                m_timers->Remove(all[i].timerId, node);
+                timers.push_back(node);
+            }
+        }
+
+        CProStlVector<uint64_t> slotTimerIds;
+        m_htbtSlots.RemoveAll(onTimer, htbtTimers, slotTimerIds);
+
+        for (int j = 0; j < (int)slotTimerIds.size(); ++j)
+        {
+            PRO_TIMER_NODE slotNode;
+            m_timers->Remove(slotTimerIds[j], slotNode);
+        }
+    }
+
+    if (timers.size() == 0 && htbtTimers.size() == 0)
+    {
+        return;
+    }
+
+    /*
+     * "to" may be exiting. Then they stay here
+     */
+    if (to->AdoptTimers(timers, htbtTimers, htbtPeriod) ||
+        AdoptTimers(timers, htbtTimers, htbtPeriod))
+    {
+        return;
+    }
+
+    for (int i = 0; i < (int)timers.size(); ++i)
+    {
+        timers[i].onTimer->Release();
+    }
+
+    for (int j = 0; j < (int)htbtTimers.size(); ++j)
+    {
+        htbtTimers[j].onTimer->Release();
+    }
+}
+
+bool
+CProBaseReactor::AdoptTimers(const CProStlVector<PRO_TIMER_NODE>& timers,
+                             const CProStlVector<PRO_TIMER_NODE>& htbtTimers,
+                             int64_t                              htbtPeriod) /* ms */
+{
+    CProThreadMutexGuard mon(m_lock);
+
+    if (m_timers == NULL || m_wantExit)
+    {
+        return false;
+    }
+
+    for (int i = 0; i < (int)timers.size(); ++i)
+    {
+        m_timers->Insert(timers[i]);
+    }
+
+    int64_t tick = ProGetTickCount64();
+
+    for (int j = 0; j < (int)htbtTimers.size(); ++j)
+    {
+        const PRO_TIMER_NODE& node = htbtTimers[j];
+
+        PRO_TIMER_NODE slotNode;
+        m_htbtSlots.Add(node.timerId, node.onTimer, node.userData, tick, htbtPeriod, slotNode);
+        if (slotNode.timerId != 0)
+        {
+            m_timers->Insert(slotNode);
+        }
+    }
+
+    if (m_wakeTick != 0 && ProGetThreadId() != m_threadId)
+    {
+        m_notifyPipe->Notify();
+    }
+
+    return true;
+}
+
+bool
+CProBaseReactor::AddTimer(const PRO_TIMER_NODE& node)
+{
+    CProThreadMutexGuard mon(m_lock);
+
+    if (m_timers == NULL || m_wantExit)
+    {
+        return false;
+    }
+
+    node.onTimer->AddRef();
+    m_timers->Insert(node);
+
+    /*
+     * wake the worker up if it sleeps past the new timer
+     */
+    if (m_wakeTick != 0 && node.expireTick < m_wakeTick && ProGetThreadId() != m_threadId)
+    {
+        m_notifyPipe->Notify();
+    }
+
+    return true;
+}
+
+int
+CProBaseReactor::GetTimerTimeout(int timeout)
+{
+    if (m_timers != NULL)
+    {
+        int64_t nextTick = m_timers->GetNextTick();
+        int64_t tick     = ProGetTickCount64();
+
+        m_nextTimerTick = nextTick >= 0 ? nextTick : 0x7FFFFFFFFFFFFFFFLL;
+
+        if (nextTick >= 0)
+        {
+            int64_t delta = nextTick > tick ? nextTick - tick : 0;
+            if (delta > 0x7FFFFFFF)
+            {
+                delta = 0x7FFFFFFF;
+            }
+
+            if (timeout < 0 || delta < timeout)
+            {
+                timeout = (int)delta;
+            }
+        }
+
+        if (timeout < 0)
+        {
+            m_wakeTick = 0x7FFFFFFFFFFFFFFFLL;
+        }
+        else
+        {
+            m_wakeTick = timeout > 0 ? tick + timeout : 0;
+        }
+    }
+
+    return timeout;
+}
+
+void
+CProBaseReactor::ProcessTimers()
+{
+    if (m_timers == NULL)
+    {
+        return;
+    }
+
+    /*
+     * a timer set up meanwhile before m_nextTimerTick makes the next wait
+     * return at once
+     */
+    int64_t tick = ProGetTickCount64();
+    if (tick < m_nextTimerTick)
+    {
+        return;
+    }
+
+    {
+        CProThreadMutexGuard mon(m_lock);
+
+        m_wakeTick = 0;
+        m_timers->Expire(tick, m_expiredTimers); /* removed from the wheel */
+
+        int i = 0;
+        int c = (int)m_expiredTimers.size();
+
+        for (; i < c; ++i)
+        {
+            PRO_TIMER_NODE node = m_expiredTimers[i];
+            if (node.period > 0)
+            {
+                node.Rearm(tick);
+                if (node.onTimer != NULL)
+                {
+                    node.onTimer->AddRef(); /* !!! */
+                }
+                m_timers->Insert(node);
+            }
+        }
+
+        /*
+         * the subscribers of the slots due, appended as one-shot nodes
+         */
+        for (i = 0; i < c; ++i)
+        {
+            if (m_expiredTimers[i].IsHeartbeatSlot())
+            {
+                m_htbtSlots.GetSubscribers(m_expiredTimers[i].htbtSlotIndex, m_expiredTimers);
+            }
+        }
+    }
+
+    for (int j = 0; j < (int)m_expiredTimers.size(); ++j)
+    {
+        const PRO_TIMER_NODE& node = m_expiredTimers[j];
+        if (node.IsHeartbeatSlot())
+        {
+            continue;
+        }
+
+        int64_t start = BeginCall((int64_t)node.timerId,
+            node.heartbeat ? "heartbeat" : "timer", "OnTimer");
+
+        node.onTimer->OnTimer(this, node.timerId, tick, node.userData);
+
+        EndCall(start, (int64_t)node.timerId, "OnTimer");
+        node.onTimer->Release();
+    }
+
+    m_expiredTimers.clear();
+}
+
+bool
+CProBaseReactor::CollectEvents(uint32_t           maxEvents,
+                               CProTpReactorTask* task) /* = NULL */
+{
+    CProThreadMutexGuard mon(m_lock);
+
+    int64_t          sockId = -1;
+    PRO_HANDLER_INFO info;
+
+    if (!m_handlerMgr.CollectEvents(task != NULL ? maxEvents : 0, sockId, info))
+    {
+        return false;
+    }
+
+    if (m_wantExit || m_migrant != NULL)
+    {
+        return false;
+    }
+
+    info.handler->AddRef();
+    m_migrationTask = task;
+    m_migrantSockId = sockId;
+    m_migrant       = info.handler;
+    m_notifyPipe->Notify();
+
+    return true;
+}
+
+void
+CProBaseReactor::DoMigration()
+{
+    CProTpReactorTask* task    = NULL;
+    int64_t            sockId  = -1;
+    CProEventHandler*  handler = NULL;
+
+    {
+        CProThreadMutexGuard mon(m_lock);
+
+        if (m_migrant == NULL)
+        {
+            return;
+        }
+
+        task            = m_migrationTask;
+        sockId          = m_migrantSockId;
+        handler         = m_migrant;
+        m_migrationTask = NULL;
+        m_migrantSockId = -1;
+        m_migrant       = NULL;
+    }
+
+    task->MigrateHandler(sockId, handler, this);
+    handler->Release();
+}
+
+void
+CProBaseReactor::Dispatch(int64_t           sockId,
+                          CProEventHandler* handler,
+                          unsigned long     mask)
+{
+    if (PRO_BIT_ENABLED(mask, PRO_MASK_ERROR))
+    {
+        int64_t start = BeginCall(sockId, handler->GetHandlerName(), "OnError");
+        handler->OnError(sockId, -1);
+        EndCall(start, sockId, "OnError");
+
+        return;
+    }
+
+    if (PRO_BIT_ENABLED(mask, PRO_MASK_WRITE))
+    {
+        int64_t start = BeginCall(sockId, handler->GetHandlerName(), "OnOutput");
+        handler->OnOutput(sockId);
+        EndCall(start, sockId, "OnOutput");
+    }
+    if (PRO_BIT_ENABLED(mask, PRO_MASK_READ))
+    {
+        int64_t start = BeginCall(sockId, handler->GetHandlerName(), "OnInput");
+        handler->OnInput(sockId);
+        EndCall(start, sockId, "OnInput");
+    }
+    if (PRO_BIT_ENABLED(mask, PRO_MASK_EXCEPTION))
+    {
+        int64_t start = BeginCall(sockId, handler->GetHandlerName(), "OnException");
+        handler->OnException(sockId);
+        EndCall(start, sockId, "OnException");
+    }
+}
+
+void
+CProBaseReactor::DispatchBuffer(int64_t           sockId,
+                                CProEventHandler* handler,
+                                const void*       buf,
+                                size_t            size,
+                                int               errorCode)
+{
+    int64_t start = BeginCall(sockId, handler->GetHandlerName(), "OnInputBuffer");
+    handler->OnInputBuffer(sockId, buf, size, errorCode);
+    EndCall(start, sockId, "OnInputBuffer");
+}
+
+int64_t
+CProBaseReactor::BeginCall(int64_t     id,
+                           const char* name,
+                           const char* callback)
+{
+    if (!m_loopStats)
+    {
+        return 0;
+    }
+
+    m_callSockId = id;
+    m_callName   = name;
+    m_callback   = callback;
+
+    int64_t start = GetTickUs();
+    m_callStart   = start;
+
+    return start;
+}
+
+void
+CProBaseReactor::EndCall(int64_t     start,
+                         int64_t     id,
+                         const char* callback)
+{
+    if (!m_loopStats)
+    {
+        return;
+    }
+
+    m_callStart = 0;
+
+    uint64_t time = GetTickUs() - start;
+    m_callHisto.PushData(time);
+
+    if (m_slowCallbackTime > 0 && time >= m_slowCallbackTime)
+    {
+        m_slowCalls.PushCall(id, m_callName, callback, time);
+    }
+}
+
+bool
+CProBaseReactor::RogerNotify()
+{
+    int64_t notifyTime = m_notifyPipe->GetNotifyTime();
+
+    if (!m_notifyPipe->Roger())
+    {
+        return false;
+    }
+
+    if (m_loopStats && notifyTime > 0)
+    {
+        m_lagHisto.PushData(GetTickUs() - notifyTime);
+    }
+
+    return true;
+}
+
+int64_t
+CProBaseReactor::GetTickUs()
+{
+    return (int64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
@@ -23,13 +23,16 @@
 #include "pro_handler_mgr.h"
 #include "../pro_util/pro_bsd_wrapper.h"
 #include "../pro_util/pro_memory_pool.h"
+#include "../pro_util/pro_stat.h"
 #include "../pro_util/pro_thread_mutex.h"
+#include "../pro_util/pro_timer_factory.h"
 #include "../pro_util/pro_z.h"
 
 /////////////////////////////////////////////////////////////////////////////
 ////
 
 class CProNotifyPipe;
+class CProTpReactorTask;
 
 /////////////////////////////////////////////////////////////////////////////
 ////
@@ -57,12 +60,192 @@ public:
         unsigned long mask
         ) = 0;
 
+    /*
+     * Dispatch the events of the mask once more in the next round.
+     * Level-triggered reactors report a pending readiness again anyway
+     */
+    virtual void ReplayHandler(
+        int64_t       sockId,
+        unsigned long mask
+        )
+    {
+    }
+
+    /*
+     * Whether the reactor reads for the handlers that support it, see
+     * CProEventHandler::SupportsRecvBuffers(). Fixed after Init()
+     */
+    virtual bool HasRecvBuffers() const
+    {
+        return false;
+    }
+
     virtual size_t GetHandlerCount() const;
 
     virtual void WorkerRun() = 0;
 
+    uint64_t GetEventCount() const;
+
+    void SetBusyPollTime(unsigned int busyPollTime) /* before WorkerRun() */
+    {
+        m_busyPollTime = busyPollTime;
+    }
+
+    void GetPollTimes(
+        uint64_t& spinTime,
+        uint64_t& waitTime
+        ) const;
+
+    void GetWakeupCounts(
+        uint64_t& sentCount,
+        uint64_t& coalescedCount
+        ) const;
+
+    /*
+     * Makes the worker run one more loop, such as for the thread cache
+     * flush of ProTrimSgiPools()
+     */
+    void Wakeup();
+
+    void SetLoopStats( /* before WorkerRun() */
+        bool         loopStats,
+        unsigned int slowCallbackTime /* us. 0 means no watchdog */
+        )
+    {
+        m_loopStats        = loopStats || slowCallbackTime > 0;
+        m_slowCallbackTime = slowCallbackTime;
+    }
+
+    const CProStatHistogram& GetWaitHistogram() const  /* us blocked a wakeup */
+    {
+        return m_waitHisto;
+    }
+
+    const CProStatHistogram& GetEventHistogram() const /* events a wakeup */
+    {
+        return m_eventHisto;
+    }
+
+    const CProStatHistogram& GetCallHistogram() const  /* us per callback */
+    {
+        return m_callHisto;
+    }
+
+    const CProStatHistogram& GetLagHistogram() const   /* us from Notify() to Roger() */
+    {
+        return m_lagHisto;
+    }
+
+    const CProStatSlowCalls& GetSlowCalls() const
+    {
+        return m_slowCalls;
+    }
+
+    /*
+     * The callback running now, if it has run for slowCallbackTime or
+     * more. A stuck one doesn't reach the slow calls until it returns
+     */
+    bool GetStuckCall(PRO_SLOW_CALL& call) const;
+
+    void SetHandlerTimers(bool handlerTimers); /* before WorkerRun() */
+
+    /*
+     * Timers fired by the worker between two wakeups, so that they never
+     * overlap the callbacks of the handlers on this thread. 0 is returned
+     * without SetHandlerTimers()
+     */
+    uint64_t SetupTimer(
+        IProOnTimer* onTimer,
+        uint64_t     firstDelay, /* [0, 0xFFFFFFFFFFFF] */
+        uint64_t     period,     /* [0, 0xFFFFFFFFFFFF] */
+        int64_t      userData
+        );
+
+    uint64_t SetupHeartbeatTimer(
+        IProOnTimer* onTimer,
+        int64_t      htbtPeriod, /* ms */
+        int64_t      userData
+        );
+
+    bool CancelTimer(uint64_t timerId);
+
+    void UpdateHeartbeatTimers(int64_t htbtPeriod); /* ms */
+
+    size_t GetTimerCount() const;
+
+    /*
+     * Moves the timers and heartbeat timers of onTimer to the reactor "to",
+     * with their ids, so that they follow a migrated handler. By the worker,
+     * between two wakeups, when none of them is being fired
+     */
+    void MoveTimers(
+        IProOnTimer*     onTimer,
+        CProBaseReactor* to,
+        int64_t          htbtPeriod /* ms */
+        );
+
+    /*
+     * Resets the per-handler event counts. With a task, the busiest handler
+     * that supports migration and has no more than maxEvents events is
+     * handed to task->MigrateHandler() by the worker, between two wakeups,
+     * so that none of its callbacks is running then
+     */
+    bool CollectEvents(
+        uint32_t           maxEvents,
+        CProTpReactorTask* task /* = NULL */
+        );
+
 protected:
 
+    void CountEvent(int64_t sockId) /* with m_lock held */
+    {
+        m_handlerMgr.CountEvent(sockId);
+        ++m_eventCount;
+    }
+
+    void DoMigration();
+
+    /*
+     * Calls the handler for the bits of the mask, timed with loop stats
+     */
+    void Dispatch(
+        int64_t           sockId,
+        CProEventHandler* handler,
+        unsigned long     mask
+        );
+
+    void DispatchBuffer(
+        int64_t           sockId,
+        CProEventHandler* handler,
+        const void*       buf,
+        size_t            size,
+        int               errorCode
+        );
+
+    void RecordWakeup(
+        int64_t waitTime, /* us */
+        size_t  events
+        )
+    {
+        if (m_loopStats)
+        {
+            m_waitHisto.PushData(waitTime);
+            m_eventHisto.PushData(events);
+        }
+    }
+
+    bool RogerNotify(); /* m_notifyPipe->Roger(), and the lag */
+
+    /*
+     * Bounds the wait of the worker by the next timer. With m_lock held.
+     * The timeouts are in milliseconds, and -1 means forever
+     */
+    int GetTimerTimeout(int timeout);
+
+    void ProcessTimers();
+
+    static int64_t GetTickUs(); /* monotonic, in microseconds */
+
     virtual unsigned long AddRef()
     {
         return 1;
@@ -73,14 +256,68 @@ protected:
         return 1;
     }
 
+    virtual const char* GetHandlerName() const
+    {
+        return "notify_pipe";
+    }
+
 protected:
 
     uint64_t                m_threadId;
     bool                    m_wantExit;
     CProHandlerMgr          m_handlerMgr;
     CProNotifyPipe*         m_notifyPipe;
+    uint64_t                m_eventCount;
+    unsigned int            m_busyPollTime; /* us */
+    uint64_t                m_spinTime;     /* us */
+    uint64_t                m_waitTime;     /* us, with busy-polling or loop stats only */
+    CProTpReactorTask*      m_migrationTask;
+    int64_t                 m_migrantSockId;
+    CProEventHandler*       m_migrant;
+    bool                    m_loopStats;
+    unsigned int            m_slowCallbackTime; /* us */
+    CProStatHistogram       m_waitHisto;
+    CProStatHistogram       m_eventHisto;
+    CProStatHistogram       m_callHisto;
+    CProStatHistogram       m_lagHisto;
+    CProStatSlowCalls       m_slowCalls;
+    CProTimerWheel*         m_timers;   /* with handler timers only */
+    CProHeartbeatSlots      m_htbtSlots;
+    int64_t                 m_wakeTick; /* of the worker for the timers. 0 if awake */
     mutable CProThreadMutex m_lock;
 
+private:
+
+    bool AddTimer(const PRO_TIMER_NODE& node);
+
+    bool AdoptTimers( /* takes over the references of the nodes */
+        const CProStlVector<PRO_TIMER_NODE>& timers,
+        const CProStlVector<PRO_TIMER_NODE>& htbtTimers,
+        int64_t                              htbtPeriod /* ms */
+        );
+
+    int64_t BeginCall(
+        int64_t     id,
+        const char* name,
+        const char* callback
+        );
+
+    void EndCall(
+        int64_t     start,
+        int64_t     id,
+        const char* callback
+        );
+
+private:
+
+    std::atomic<int64_t>     m_callStart; /* us. 0 when idle */
+    std::atomic<int64_t>     m_callSockId;
+    std::atomic<const char*> m_callName;
+    std::atomic<const char*> m_callback;
+
+    int64_t                       m_nextTimerTick; /* by the worker */
+    CProStlVector<PRO_TIMER_NODE> m_expiredTimers; /* reused by the worker */
+
     DECLARE_SGI_POOL(0)
 };
 
@@ -71,6 +71,11 @@ private:
 
     virtual ~CProConnector();
 
+    virtual const char* GetHandlerName() const
+    {
+        return "connector";
+    }
+
     virtual void OnInput(int64_t sockId);
 
     virtual void OnOutput(int64_t sockId);
@@ -19,6 +19,7 @@
 #include "pro_epoll_reactor.h"
 #include "pro_base_reactor.h"
 #include "../pro_util/pro_bsd_wrapper.h"
+#include "../pro_util/pro_memory_pool.h"
 #include "../pro_util/pro_notify_pipe.h"
 #include "../pro_util/pro_thread.h"
 #include "../pro_util/pro_time_util.h"
@@ -48,12 +49,49 @@
 #define PRO_EPOLLHUP     EPOLLHUP
 #define PRO_EPOLLERR     EPOLLERR
 
+/*
+ * An edge-triggered handler is registered for both reading and writing
+ * once, and its mask is kept in the handler manager only. The edges
+ * that arrive while a mask bit is off are dropped, so turning a bit
+ * on replays it once, see ReplayHandler(). PRO_EPOLLEX_SET is added
+ * while the mask has PRO_MASK_EXCEPTION
+ */
+#define PRO_EPOLLET_SET  (EPOLLIN | EPOLLOUT | EPOLLET)
+
+/////////////////////////////////////////////////////////////////////////////
+////
+
+static
+inline
+uint32_t
+pbsd_epoll_events_i(unsigned long mask)
+{
+    uint32_t events = 0;
+    if (PRO_BIT_ENABLED(mask, PRO_MASK_WRITE))
+    {
+        events |= PRO_EPOLLOUT_SET;
+    }
+    if (PRO_BIT_ENABLED(mask, PRO_MASK_READ))
+    {
+        events |= PRO_EPOLLIN_SET;
+    }
+    if (PRO_BIT_ENABLED(mask, PRO_MASK_EXCEPTION))
+    {
+        events |= PRO_EPOLLEX_SET;
+    }
+
+    return events;
+}
+
 /////////////////////////////////////////////////////////////////////////////
 ////
 
-CProEpollReactor::CProEpollReactor()
+CProEpollReactor::CProEpollReactor(bool edgeTriggered) /* = false */
+: m_edgeTriggered(edgeTriggered)
 {
     m_epfd = -1;
+
+    m_dispatches.reserve(PRO_EPOLLFD_GETSIZE);
 }
 
 CProEpollReactor::~CProEpollReactor()
@@ -65,8 +103,8 @@ CProEpollReactor::~CProEpollReactor()
         pbsd_epoll_event ev;
         memset(&ev, 0, sizeof(pbsd_epoll_event));
 
-        const CProStlMap<int64_t, PRO_HANDLER_INFO>& sockId2HandlerInfo =
-            m_handlerMgr.GetAllHandlers();
+        CProHandlerMap sockId2HandlerInfo;
+        m_handlerMgr.GetAllHandlers(sockId2HandlerInfo);
 
         auto itr = sockId2HandlerInfo.begin();
         auto end = sockId2HandlerInfo.end();
@@ -196,71 +234,43 @@ CProEpollReactor::AddHandler(int64_t           sockId,
             return true;
         }
 
-        short oldEvents = 0;
-        if (PRO_BIT_ENABLED(oldInfo.mask, PRO_MASK_WRITE))
-        {
-            oldEvents |= PRO_EPOLLOUT_SET;
-        }
-        if (PRO_BIT_ENABLED(oldInfo.mask, PRO_MASK_READ))
-        {
-            oldEvents |= PRO_EPOLLIN_SET;
-        }
-        if (PRO_BIT_ENABLED(oldInfo.mask, PRO_MASK_EXCEPTION))
+        if (!m_handlerMgr.AddHandler(sockId, handler, mask))
         {
-            oldEvents |= PRO_EPOLLEX_SET;
+            return false;
         }
 
-        short events = oldEvents;
-        if (PRO_BIT_ENABLED(mask, PRO_MASK_WRITE))
-        {
-            events |= PRO_EPOLLOUT_SET;
-        }
-        if (PRO_BIT_ENABLED(mask, PRO_MASK_READ))
-        {
-            events |= PRO_EPOLLIN_SET;
-        }
-        if (PRO_BIT_ENABLED(mask, PRO_MASK_EXCEPTION))
+        if (oldInfo.handler == NULL)
         {
-            events |= PRO_EPOLLEX_SET;
-        }
+            /*
+             * registered before returning, so a failure goes to the caller.
+             * Only the changes of the mask are deferred
+             */
+            if (!DoRegister(sockId, m_handlerMgr.FindHandler(sockId)))
+            {
+                m_handlerMgr.RemoveHandler(sockId, mask);
 
-        pbsd_epoll_event ev;
-        memset(&ev, 0, sizeof(pbsd_epoll_event));
-        ev.events  = events;
-        ev.data.fd = (int)sockId;
+                return false;
+            }
 
-        int retc = -1;
-        if (oldEvents == 0)
-        {
-            retc = pbsd_epoll_ctl(m_epfd, EPOLL_CTL_ADD, ev.data.fd, &ev);
-        }
-        else
-        {
-            retc = pbsd_epoll_ctl(m_epfd, EPOLL_CTL_MOD, ev.data.fd, &ev);
-        }
-        if (retc != 0)
-        {
-            return false;
+            return true;
         }
 
-        if (!m_handlerMgr.AddHandler(sockId, handler, mask))
+        if (m_edgeTriggered && handler->SupportsEdgeTrigger())
         {
             /*
-             * rollback
+             * registered already. no epoll_ctl() unless the exception bit
+             * changes
              */
-            if (oldEvents == 0)
-            {
-                pbsd_epoll_ctl(m_epfd, EPOLL_CTL_DEL, ev.data.fd, &ev);
-            }
-            else
+            DoReplay(sockId, handler, mask);
+
+            if (!PRO_BIT_ENABLED(mask, PRO_MASK_EXCEPTION))
             {
-                ev.events = oldEvents;
-                pbsd_epoll_ctl(m_epfd, EPOLL_CTL_MOD, ev.data.fd, &ev);
+                return true;
             }
-
-            return false;
         }
 
+        PostSync(sockId);
+
         if (ProGetThreadId() != m_threadId)
         {
             m_notifyPipe->Notify();
@@ -313,55 +323,233 @@ CProEpollReactor::RemoveHandler(int64_t       sockId,
             return;
         }
 
-        short oldEvents = 0;
-        if (PRO_BIT_ENABLED(oldInfo.mask, PRO_MASK_WRITE))
-        {
-            oldEvents |= PRO_EPOLLOUT_SET;
-        }
-        if (PRO_BIT_ENABLED(oldInfo.mask, PRO_MASK_READ))
+        m_handlerMgr.RemoveHandler(sockId, mask);
+
+        if ((oldInfo.mask & ~mask) == 0)
         {
-            oldEvents |= PRO_EPOLLIN_SET;
+            /*
+             * out of the epoll set before returning. The caller may close
+             * the fd or send it away right after this, and a deferred DEL
+             * would hit a closed or reused fd number
+             */
+            pbsd_epoll_event ev;
+            memset(&ev, 0, sizeof(pbsd_epoll_event));
+            ev.data.fd = (int)sockId;
+
+            pbsd_epoll_ctl(m_epfd, EPOLL_CTL_DEL, ev.data.fd, &ev);
+            m_registered.erase(sockId);
         }
-        if (PRO_BIT_ENABLED(oldInfo.mask, PRO_MASK_EXCEPTION))
+        else if (!m_edgeTriggered || !oldInfo.handler->SupportsEdgeTrigger() ||
+            PRO_BIT_ENABLED(mask, PRO_MASK_EXCEPTION))
         {
-            oldEvents |= PRO_EPOLLEX_SET;
+            /*
+             * no notification. The events left are dropped by the worker
+             * until it syncs the registration
+             */
+            PostSync(sockId);
         }
+    }
+}
 
-        short events = oldEvents;
-        if (PRO_BIT_ENABLED(mask, PRO_MASK_WRITE))
-        {
-            events &= ~PRO_EPOLLOUT_SET;
-        }
-        if (PRO_BIT_ENABLED(mask, PRO_MASK_READ))
+void
+CProEpollReactor::ReplayHandler(int64_t       sockId,
+                                unsigned long mask)
+{
+    if (sockId == -1 || mask == 0 || !m_edgeTriggered)
+    {
+        return;
+    }
+
+    CProThreadMutexGuard mon(m_lock);
+
+    if (m_epfd == -1 || m_wantExit)
+    {
+        return;
+    }
+
+    PRO_HANDLER_INFO info = m_handlerMgr.FindHandler(sockId);
+    if (info.handler == NULL || !info.handler->SupportsEdgeTrigger())
+    {
+        return;
+    }
+
+    DoReplay(sockId, info.handler, mask);
+}
+
+void
+CProEpollReactor::DoReplay(int64_t           sockId,
+                           CProEventHandler* handler,
+                           unsigned long     mask)
+{
+    mask &= (PRO_MASK_WRITE | PRO_MASK_READ);
+    if (mask == 0)
+    {
+        return;
+    }
+
+    /*
+     * a stale entry is dropped by WorkerRun() if the handler has gone
+     */
+    if (!m_replays.empty()                 &&
+        m_replays.back().sockId  == sockId &&
+        m_replays.back().handler == handler)
+    {
+        PRO_SET_BITS(m_replays.back().mask, mask);
+    }
+    else
+    {
+        PRO_DISPATCH_INFO info;
+        info.sockId  = sockId;
+        info.handler = handler;
+        info.mask    = mask;
+        m_replays.push_back(info);
+    }
+
+    if (ProGetThreadId() != m_threadId)
+    {
+        m_notifyPipe->Notify();
+    }
+}
+
+uint32_t
+CProEpollReactor::GetEvents(const PRO_HANDLER_INFO& info) const
+{
+    if (m_edgeTriggered && info.handler->SupportsEdgeTrigger())
+    {
+        if (PRO_BIT_ENABLED(info.mask, PRO_MASK_EXCEPTION))
         {
-            events &= ~PRO_EPOLLIN_SET;
+            return PRO_EPOLLET_SET | PRO_EPOLLEX_SET;
         }
-        if (PRO_BIT_ENABLED(mask, PRO_MASK_EXCEPTION))
+
+        return PRO_EPOLLET_SET;
+    }
+    else
+    {
+        return pbsd_epoll_events_i(info.mask);
+    }
+}
+
+bool
+CProEpollReactor::DoRegister(int64_t                 sockId,
+                             const PRO_HANDLER_INFO& info)
+{
+    uint32_t events    = GetEvents(info);
+    uint32_t oldEvents = 0;
+    auto     itr       = m_registered.find(sockId);
+    if (itr != m_registered.end())
+    {
+        oldEvents = itr->second;
+    }
+
+    if (events == oldEvents)
+    {
+        return true;
+    }
+
+    pbsd_epoll_event ev;
+    memset(&ev, 0, sizeof(pbsd_epoll_event));
+    ev.events  = events;
+    ev.data.fd = (int)sockId;
+
+    /*
+     * a closed fd leaves the epoll set by itself, but not while a dup of
+     * it is still open somewhere
+     */
+    int retc = -1;
+    if (oldEvents == 0)
+    {
+        retc = pbsd_epoll_ctl(m_epfd, EPOLL_CTL_ADD, ev.data.fd, &ev);
+        if (retc != 0 && errno == EEXIST)
         {
-            events &= ~PRO_EPOLLEX_SET;
+            retc = pbsd_epoll_ctl(m_epfd, EPOLL_CTL_MOD, ev.data.fd, &ev);
         }
+    }
+    else
+    {
+        retc = pbsd_epoll_ctl(m_epfd, EPOLL_CTL_MOD, ev.data.fd, &ev);
+    }
 
-        pbsd_epoll_event ev;
-        memset(&ev, 0, sizeof(pbsd_epoll_event));
-        ev.events  = events;
-        ev.data.fd = (int)sockId;
+    if (retc != 0)
+    {
+        m_registered.erase(sockId);
+
+        return false;
+    }
+
+    m_registered[sockId] = events;
+
+    return true;
+}
+
+void
+CProEpollReactor::PostSync(int64_t sockId)
+{
+    /*
+     * SuspendRecv()/ResumeRecv() come in pairs. Merged here, the pair
+     * costs no epoll_ctl() at all.
+     *
+     * An entry is synced from the table as it is then, so one left
+     * behind by a removed handler is harmless
+     */
+    if (!m_syncs.empty() && m_syncs.back().sockId == sockId)
+    {
+        return;
+    }
+
+    PRO_DISPATCH_INFO info;
+    info.sockId  = sockId;
+    info.handler = NULL;
+    info.mask    = 0;
+    m_syncs.push_back(info);
+}
+
+void
+CProEpollReactor::DoSyncs()
+{
+    {
+        CProThreadMutexGuard mon(m_lock);
 
-        if (events == 0)
+        if (m_syncs.empty())
         {
-            pbsd_epoll_ctl(m_epfd, EPOLL_CTL_DEL, ev.data.fd, &ev);
+            return;
         }
-        else
+
+        for (int i = 0; i < (int)m_syncs.size(); ++i)
         {
-            pbsd_epoll_ctl(m_epfd, EPOLL_CTL_MOD, ev.data.fd, &ev);
-        }
+            int64_t          sockId = m_syncs[i].sockId;
+            PRO_HANDLER_INFO info   = m_handlerMgr.FindHandler(sockId);
+            if (info.handler == NULL || DoRegister(sockId, info))
+            {
+                continue;
+            }
 
-        m_handlerMgr.RemoveHandler(sockId, mask);
+            /*
+             * the handlers that failed to sync are taken out of the table,
+             * then told by OnError() as if the socket had failed
+             */
+            m_handlerMgr.RemoveHandler(sockId, info.mask);
 
-        if (ProGetThreadId() != m_threadId)
-        {
-            m_notifyPipe->Notify();
+            PRO_DISPATCH_INFO fail;
+            fail.sockId  = sockId;
+            fail.handler = info.handler;
+            fail.mask    = PRO_MASK_ERROR;
+            m_applies.push_back(fail);
+
+            info.handler->AddRef();
         }
+
+        m_syncs.clear();
     }
+
+    for (int j = 0; j < (int)m_applies.size(); ++j)
+    {
+        const PRO_DISPATCH_INFO& info = m_applies[j];
+
+        info.handler->OnError(info.sockId, -1);
+        info.handler->Release();
+    }
+
+    m_applies.clear();
 }
 
 void
@@ -373,8 +561,12 @@ CProEpollReactor::WorkerRun()
         m_threadId = ProGetThreadId();
     }
 
+    ProUpdateCachedTickCount64();
+
     while (1)
     {
+        int timeout = -1;
+
         {
             CProThreadMutexGuard mon(m_lock);
 
@@ -382,19 +574,61 @@ CProEpollReactor::WorkerRun()
             {
                 break;
             }
+
+            if (!m_replays.empty())
+            {
+                timeout = 0; /* don't block on pending replays */
+            }
+
+            timeout = GetTimerTimeout(timeout);
         }
 
+        DoSyncs();
+
+        int     retc     = 0;
+        int64_t spinTime = 0;
+        int64_t waitTime = 0;
+
         /*
-         * epoll_wait()
+         * busy-poll first, then block
          */
-        int retc = pbsd_epoll_wait(m_epfd, m_events, PRO_EPOLLFD_GETSIZE, -1);
-        if (retc <= 0)
+        if (m_busyPollTime > 0 && timeout != 0)
+        {
+            int64_t start = GetTickUs();
+            int64_t now   = start;
+
+            do
+            {
+                retc = pbsd_epoll_wait(m_epfd, m_events, PRO_EPOLLFD_GETSIZE, 0);
+                now  = GetTickUs();
+            }
+            while (retc == 0 && now - start < (int64_t)m_busyPollTime);
+
+            spinTime = now - start;
+        }
+
+        if (retc == 0)
+        {
+            bool    timed = m_busyPollTime > 0 || m_loopStats;
+            int64_t start = timed ? GetTickUs() : 0;
+
+            retc = pbsd_epoll_wait(m_epfd, m_events, PRO_EPOLLFD_GETSIZE, timeout);
+
+            if (timed)
+            {
+                waitTime = GetTickUs() - start;
+            }
+        }
+
+        ProUpdateCachedTickCount64(); /* once per wakeup */
+        ProCollectSgiPoolRemoteFrees();
+        if (retc < 0 || (retc == 0 && timeout < 0))
         {
             ProSleep(1);
             continue;
         }
 
-        CProStlMap<int64_t, PRO_HANDLER_INFO> sockId2HandlerInfo;
+        m_dispatches.clear();
 
         {
             CProThreadMutexGuard mon(m_lock);
@@ -404,9 +638,15 @@ CProEpollReactor::WorkerRun()
                 break;
             }
 
+            m_spinTime += spinTime;
+            m_waitTime += waitTime;
+
+            /*
+             * epoll_wait() reports each fd once, so no merging is needed
+             */
             for (int i = 0; i < retc; ++i)
             {
-                const pbsd_epoll_event& ev = m_events[i];
+                pbsd_epoll_event ev = m_events[i];
                 if (ev.events == 0)
                 {
                     continue;
@@ -418,75 +658,108 @@ CProEpollReactor::WorkerRun()
                     continue;
                 }
 
+                /*
+                 * a change of the mask may lag behind the table, see DoSyncs()
+                 */
+                bool edge = m_edgeTriggered && info.handler->SupportsEdgeTrigger();
+                if (!PRO_BIT_ENABLED(info.mask, PRO_MASK_WRITE))
+                {
+                    ev.events &= ~PRO_EPOLLOUT_SET;
+                }
+                if (!PRO_BIT_ENABLED(info.mask, PRO_MASK_READ))
+                {
+                    ev.events &= edge ? ~(PRO_EPOLLIN_SET | PRO_EPOLLHUP) : ~PRO_EPOLLIN_SET;
+                }
+                if (!PRO_BIT_ENABLED(info.mask, PRO_MASK_EXCEPTION))
+                {
+                    ev.events &= ~PRO_EPOLLEX_SET;
+                }
+
+                unsigned long mask = 0;
+
                 if ((ev.events & PRO_EPOLLERR) != 0)
                 {
-                    info.handler->AddRef();
-                    PRO_HANDLER_INFO& info2 = sockId2HandlerInfo[ev.data.fd]; /* insert */
-                    info2.handler = info.handler;
-                    PRO_SET_BITS(info2.mask, PRO_MASK_ERROR);
-                    continue;
+                    mask = PRO_MASK_ERROR;
+                }
+                else
+                {
+                    if ((ev.events & PRO_EPOLLOUT_SET) != 0)
+                    {
+                        PRO_SET_BITS(mask, PRO_MASK_WRITE);
+                    }
+                    if ((ev.events & (PRO_EPOLLIN_SET | PRO_EPOLLHUP)) != 0)
+                    {
+                        PRO_SET_BITS(mask, PRO_MASK_READ);
+                    }
+                    if ((ev.events & PRO_EPOLLEX_SET) != 0)
+                    {
+                        PRO_SET_BITS(mask, PRO_MASK_EXCEPTION);
+                    }
                 }
 
-                if ((ev.events & PRO_EPOLLOUT_SET) != 0)
+                if (mask == 0)
                 {
-                    info.handler->AddRef();
-                    PRO_HANDLER_INFO& info2 = sockId2HandlerInfo[ev.data.fd]; /* insert */
-                    info2.handler = info.handler;
-                    PRO_SET_BITS(info2.mask, PRO_MASK_WRITE);
+                    continue;
                 }
 
-                if ((ev.events & (PRO_EPOLLIN_SET | PRO_EPOLLHUP)) != 0)
+                PRO_DISPATCH_INFO info2;
+                info2.sockId  = ev.data.fd;
+                info2.handler = info.handler;
+                info2.mask    = mask;
+                m_dispatches.push_back(info2);
+
+                info.handler->AddRef();
+                CountEvent(ev.data.fd);
+            } /* end of for () */
+
+            /*
+             * a replayed fd may be in the ready list too. Then it's
+             * dispatched twice, which edge-triggered handlers tolerate
+             */
+            for (int j = 0; j < (int)m_replays.size(); ++j)
+            {
+                const PRO_DISPATCH_INFO& replay = m_replays[j];
+
+                PRO_HANDLER_INFO info = m_handlerMgr.FindHandler(replay.sockId);
+                if (info.handler != replay.handler)
                 {
-                    info.handler->AddRef();
-                    PRO_HANDLER_INFO& info2 = sockId2HandlerInfo[ev.data.fd]; /* insert */
-                    info2.handler = info.handler;
-                    PRO_SET_BITS(info2.mask, PRO_MASK_READ);
+                    continue;
                 }
 
-                if ((ev.events & PRO_EPOLLEX_SET) != 0)
+                unsigned long mask = replay.mask & info.mask;
+                if (mask == 0)
                 {
-                    info.handler->AddRef();
-                    PRO_HANDLER_INFO& info2 = sockId2HandlerInfo[ev.data.fd]; /* insert */
-                    info2.handler = info.handler;
-                    PRO_SET_BITS(info2.mask, PRO_MASK_EXCEPTION);
+                    continue;
                 }
+
+                PRO_DISPATCH_INFO info2;
+                info2.sockId  = replay.sockId;
+                info2.handler = info.handler;
+                info2.mask    = mask;
+                m_dispatches.push_back(info2);
+
+                info.handler->AddRef();
             } /* end of for () */
+
+            m_replays.clear();
         }
 
-        auto itr = sockId2HandlerInfo.begin();
-        auto end = sockId2HandlerInfo.end();
+        RecordWakeup(waitTime, m_dispatches.size());
 
-        for (; itr != end; ++itr)
+        for (int k = 0; k < (int)m_dispatches.size(); ++k)
         {
-            int64_t                 sockId = itr->first;
-            const PRO_HANDLER_INFO& info   = itr->second;
-
-            if (PRO_BIT_ENABLED(info.mask, PRO_MASK_ERROR))
-            {
-                info.handler->OnError(sockId, -1);
-                info.handler->Release();
-                continue;
-            }
-
-            if (PRO_BIT_ENABLED(info.mask, PRO_MASK_WRITE))
-            {
-                info.handler->OnOutput(sockId);
-                info.handler->Release();
-            }
+            const PRO_DISPATCH_INFO& info = m_dispatches[k];
 
-            if (PRO_BIT_ENABLED(info.mask, PRO_MASK_READ))
-            {
-                info.handler->OnInput(sockId);
-                info.handler->Release();
-            }
+            Dispatch(info.sockId, info.handler, info.mask);
 
-            if (PRO_BIT_ENABLED(info.mask, PRO_MASK_EXCEPTION))
-            {
-                info.handler->OnException(sockId);
-                info.handler->Release();
-            }
+            info.handler->Release();
         } /* end of for () */
+
+        ProcessTimers();
+        DoMigration();
     } /* end of while () */
+
+    ProResetCachedTickCount64();
 }
 
 void
@@ -498,7 +771,7 @@ CProEpollReactor::OnInput(int64_t sockId)
         return;
     }
 
-    if (m_notifyPipe->Roger())
+    if (RogerNotify())
     {
         return;
     }
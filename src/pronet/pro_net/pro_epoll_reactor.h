@@ -20,6 +20,7 @@
 #define PRO_EPOLL_REACTOR_H
 
 #include "pro_base_reactor.h"
+#include "../pro_util/pro_stl.h"
 
 #if defined(PRO_HAS_EPOLL)
 
@@ -30,7 +31,7 @@ class CProEpollReactor : public CProBaseReactor
 {
 public:
 
-    CProEpollReactor();
+    CProEpollReactor(bool edgeTriggered); /* = false */
 
     virtual ~CProEpollReactor();
 
@@ -49,12 +50,34 @@ public:
         unsigned long mask
         );
 
+    virtual void ReplayHandler(
+        int64_t       sockId,
+        unsigned long mask
+        );
+
     virtual void WorkerRun();
 
 private:
 
     virtual void OnInput(int64_t sockId);
 
+    void DoReplay(
+        int64_t           sockId,
+        CProEventHandler* handler,
+        unsigned long     mask
+        );
+
+    uint32_t GetEvents(const PRO_HANDLER_INFO& info) const;
+
+    bool DoRegister(
+        int64_t                 sockId,
+        const PRO_HANDLER_INFO& info
+        );
+
+    void PostSync(int64_t sockId);
+
+    void DoSyncs();
+
     virtual void OnError(
         int64_t sockId,
         int     errorCode
@@ -62,8 +85,25 @@ private:
 
 private:
 
-    int              m_epfd;
-    pbsd_epoll_event m_events[PRO_EPOLLFD_GETSIZE]; /* sizeof(epoll_event) is 16 */
+    const bool                       m_edgeTriggered;
+    int                              m_epfd;
+    pbsd_epoll_event                 m_events[PRO_EPOLLFD_GETSIZE]; /* sizeof(epoll_event) is 16 */
+    CProStlVector<PRO_DISPATCH_INFO> m_replays;                     /* edge-triggered only */
+    CProStlVector<PRO_DISPATCH_INFO> m_syncs;                       /* EPOLL_CTL_MOD deferred */
+
+    /*
+     * Under the lock. The events registered with the kernel. ADD and DEL
+     * are made by AddHandler()/RemoveHandler(), a change of the mask
+     * lags behind the handler manager until DoSyncs()
+     */
+    CProStlHashMap<int64_t, uint32_t> m_registered;
+    CProStlVector<PRO_DISPATCH_INFO>  m_applies;                    /* worker only */
+
+    /*
+     * Reused across wakeups by the worker thread. The capacity is kept,
+     * so the dispatch loop doesn't allocate in the steady state
+     */
+    CProStlVector<PRO_DISPATCH_INFO>  m_dispatches;
 
     DECLARE_SGI_POOL(0)
 };
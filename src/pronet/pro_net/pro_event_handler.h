@@ -61,6 +61,21 @@ public:
     {
     }
 
+    /*
+     * The input read by the reactor into its buffers, followed by one
+     * OnInput() after those of a wakeup. size 0 is the end of the stream,
+     * or an error if errorCode isn't 0. buf is valid only during the call,
+     * see SupportsRecvBuffers()
+     */
+    virtual void OnInputBuffer(
+        int64_t     sockId,
+        const void* buf,
+        size_t      size,
+        int         errorCode
+        )
+    {
+    }
+
     virtual void OnOutput(int64_t sockId)
     {
     }
@@ -85,6 +100,52 @@ public:
     {
     }
 
+    /*
+     * Whether the handler reads/writes until EAGAIN, and so can be
+     * registered edge-triggered
+     */
+    virtual bool SupportsEdgeTrigger() const
+    {
+        return false;
+    }
+
+    /*
+     * Whether the handler serializes its callbacks itself, and so can be
+     * moved to another I/O thread, see CProTpReactorTask::OnTimer()
+     */
+    virtual bool SupportsMigration() const
+    {
+        return false;
+    }
+
+    /*
+     * Whether the handler takes its input from OnInputBuffer(), if the
+     * reactor has buffers, see CProBaseReactor::HasRecvBuffers(). OnInput()
+     * then consumes what has been handed over, and never reads
+     */
+    virtual bool SupportsRecvBuffers() const
+    {
+        return false;
+    }
+
+    /*
+     * Whether the reactor stops reading for the handler for now, so the
+     * input stays in the socket. Read without the handler's lock, each
+     * time the handler is re-armed
+     */
+    virtual bool HoldsRecvBuffers() const
+    {
+        return false;
+    }
+
+    /*
+     * For the slow-callback watchdog, see CProBaseReactor::Dispatch()
+     */
+    virtual const char* GetHandlerName() const
+    {
+        return "handler";
+    }
+
     void SetReactor(CProBaseReactor* reactor)
     {
         m_reactor = reactor;
@@ -19,14 +19,37 @@
 #include "pro_handler_mgr.h"
 #include "pro_event_handler.h"
 #include "../pro_util/pro_memory_pool.h"
+#include "../pro_util/pro_slab_pool.h"
 #include "../pro_util/pro_stl.h"
 #include "../pro_util/pro_z.h"
 
 /////////////////////////////////////////////////////////////////////////////
 ////
 
+CProSlabPool&
+PRO_HANDLER_INFO::GetSlabPool()
+{
+    static CProSlabPool* s_pool = new CProSlabPool(
+        std::pro_tree_node_size<CProHandlerMap::value_type>::value, 0); /* never deleted */
+
+    return *s_pool;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+////
+
+CProHandlerMgr::CProHandlerMgr()
+{
+#if !defined(_WIN32)
+    m_handlerCount = 0;
+    m_maxSockId    = -1;
+#endif
+    m_collecting = false;
+}
+
 CProHandlerMgr::~CProHandlerMgr()
 {
+#if defined(_WIN32)
     auto itr = m_sockId2HandlerInfo.begin();
     auto end = m_sockId2HandlerInfo.end();
 
@@ -37,6 +60,20 @@ CProHandlerMgr::~CProHandlerMgr()
     }
 
     m_sockId2HandlerInfo.clear();
+#else
+    for (int64_t i = 0; i <= m_maxSockId; ++i)
+    {
+        const PRO_HANDLER_INFO& info = m_fd2HandlerInfo[(size_t)i];
+        if (info.handler != NULL)
+        {
+            info.handler->Release();
+        }
+    }
+
+    m_fd2HandlerInfo.clear();
+    m_handlerCount = 0;
+    m_maxSockId    = -1;
+#endif
 }
 
 bool
@@ -52,6 +89,8 @@ CProHandlerMgr::AddHandler(int64_t           sockId,
         return false;
     }
 
+#if defined(_WIN32)
+
     auto itr = m_sockId2HandlerInfo.find(sockId);
     if (itr == m_sockId2HandlerInfo.end())
     {
@@ -67,6 +106,47 @@ CProHandlerMgr::AddHandler(int64_t           sockId,
 
     PRO_HANDLER_INFO& info = itr->second;
 
+#else  /* _WIN32 */
+
+    assert(sockId >= 0);
+    if (sockId < 0)
+    {
+        return false;
+    }
+
+    if (sockId >= (int64_t)m_fd2HandlerInfo.size())
+    {
+        size_t size = m_fd2HandlerInfo.size() * 2;
+        if (size < (size_t)sockId + 1)
+        {
+            size = (size_t)sockId + 1;
+        }
+        if (size < 64)
+        {
+            size = 64;
+        }
+
+        m_fd2HandlerInfo.resize(size);
+    }
+
+    PRO_HANDLER_INFO& info = m_fd2HandlerInfo[(size_t)sockId];
+    if (info.handler == NULL)
+    {
+        info.handler = handler;
+        info.mask    = mask;
+
+        info.handler->AddRef();
+        ++m_handlerCount;
+        if (sockId > m_maxSockId)
+        {
+            m_maxSockId = sockId;
+        }
+
+        return true;
+    }
+
+#endif /* _WIN32 */
+
     if (handler == info.handler)
     {
         PRO_SET_BITS(info.mask, mask);
@@ -88,6 +168,8 @@ CProHandlerMgr::RemoveHandler(int64_t       sockId,
         return;
     }
 
+#if defined(_WIN32)
+
     auto itr = m_sockId2HandlerInfo.find(sockId);
     if (itr == m_sockId2HandlerInfo.end())
     {
@@ -102,11 +184,46 @@ CProHandlerMgr::RemoveHandler(int64_t       sockId,
         info.handler->Release();
         m_sockId2HandlerInfo.erase(itr);
     }
+
+#else  /* _WIN32 */
+
+    if (sockId < 0 || sockId > m_maxSockId)
+    {
+        return;
+    }
+
+    PRO_HANDLER_INFO& info = m_fd2HandlerInfo[(size_t)sockId];
+    if (info.handler == NULL)
+    {
+        return;
+    }
+
+    PRO_CLR_BITS(info.mask, mask);
+
+    if (info.mask == 0)
+    {
+        info.handler->Release();
+        info.handler = NULL;
+        info.events  = 0;
+        --m_handlerCount;
+
+        /*
+         * m_maxSockId is kept as a bound, not scanned down. select()
+         * takes it as nfds, and the full scans are rare
+         */
+        if (m_handlerCount == 0)
+        {
+            m_maxSockId = -1;
+        }
+    }
+
+#endif /* _WIN32 */
 }
 
 int64_t
 CProHandlerMgr::GetMaxSockId() const
 {
+#if defined(_WIN32)
     int64_t sockId = -1;
 
     auto itr = m_sockId2HandlerInfo.rbegin();
@@ -116,14 +233,86 @@ CProHandlerMgr::GetMaxSockId() const
     }
 
     return sockId;
+#else
+    return m_maxSockId;
+#endif
+}
+
+void
+CProHandlerMgr::GetAllHandlers(CProHandlerMap& sockId2HandlerInfo) const
+{
+#if defined(_WIN32)
+    sockId2HandlerInfo = m_sockId2HandlerInfo;
+#else
+    sockId2HandlerInfo.clear();
+
+    for (int64_t i = 0; i <= m_maxSockId; ++i)
+    {
+        const PRO_HANDLER_INFO& info = m_fd2HandlerInfo[(size_t)i];
+        if (info.handler != NULL)
+        {
+            sockId2HandlerInfo[i] = info;
+        }
+    }
+#endif
 }
 
+bool
+CProHandlerMgr::CollectEvents(uint32_t          maxEvents,
+                              int64_t&          sockId,
+                              PRO_HANDLER_INFO& info)
+{
+    sockId = -1;
+    info   = PRO_HANDLER_INFO();
+
+    m_collecting = true;
+
+    /*
+     * only the handlers that have had events since the last call. A
+     * socket listed twice is seen with 0 events the second time
+     */
+    for (int i = 0; i < (int)m_hotSockIds.size(); ++i)
+    {
+        int64_t sockId2 = m_hotSockIds[i];
+
+#if defined(_WIN32)
+        auto itr = m_sockId2HandlerInfo.find(sockId2);
+        if (itr == m_sockId2HandlerInfo.end())
+        {
+            continue;
+        }
+
+        PRO_HANDLER_INFO& info2 = itr->second;
+#else
+        PRO_HANDLER_INFO& info2 = m_fd2HandlerInfo[(size_t)sockId2];
+        if (info2.handler == NULL)
+        {
+            continue;
+        }
+#endif
+
+        if (info2.events > info.events && info2.events <= maxEvents &&
+            info2.handler->SupportsMigration())
+        {
+            sockId = sockId2;
+            info   = info2;
+        }
+
+        info2.events = 0;
+    }
+
+    m_hotSockIds.clear();
+
+    return info.handler != NULL;
+}
+
+#if defined(_WIN32)
+
 PRO_HANDLER_INFO
-CProHandlerMgr::FindHandler(int64_t sockId) const
+CProHandlerMgr::FindHandlerInTree(int64_t sockId) const
 {
     PRO_HANDLER_INFO info;
 
-    assert(sockId != -1);
     if (sockId == -1)
     {
         return info;
@@ -137,3 +326,5 @@ CProHandlerMgr::FindHandler(int64_t sockId) const
 
     return info;
 }
+
+#endif /* _WIN32 */
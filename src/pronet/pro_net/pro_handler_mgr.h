@@ -20,6 +20,7 @@
 #define PRO_HANDLER_MGR_H
 
 #include "../pro_util/pro_memory_pool.h"
+#include "../pro_util/pro_slab_pool.h"
 #include "../pro_util/pro_stl.h"
 #include "../pro_util/pro_z.h"
 
@@ -34,24 +35,51 @@ struct PRO_HANDLER_INFO
     {
         handler = NULL;
         mask    = 0;
+        events  = 0;
     }
 
     CProEventHandler* handler;
     unsigned long     mask;
+    uint32_t          events; /* dispatched since the last CollectEvents() */
+
+    /*
+     * The pool of the tree nodes holding PRO_HANDLER_INFO, see CProHandlerMap
+     */
+    static CProSlabPool& GetSlabPool();
 
     DECLARE_SGI_POOL(0)
 };
 
+using CProHandlerMap = std::map<
+    int64_t,
+    PRO_HANDLER_INFO,
+    std::less<int64_t>,
+    std::pro_slab_allocator<std::pair<const int64_t, PRO_HANDLER_INFO>, &PRO_HANDLER_INFO::GetSlabPool>
+    >;
+
+/*
+ * An entry of a reactor's per-wakeup dispatch list
+ */
+struct PRO_DISPATCH_INFO
+{
+    int64_t           sockId;
+    CProEventHandler* handler;
+    unsigned long     mask;
+};
+
 /////////////////////////////////////////////////////////////////////////////
 ////
 
+/*
+ * On Windows, sockets are handles, so the handlers are kept in a tree.
+ * Elsewhere, fds are dense small integers, and the handlers are kept in
+ * a flat table indexed by fd. Then FindHandler() is one array load
+ */
 class CProHandlerMgr
 {
 public:
 
-    CProHandlerMgr()
-    {
-    }
+    CProHandlerMgr();
 
     ~CProHandlerMgr();
 
@@ -70,19 +98,85 @@ public:
 
     size_t GetHandlerCount() const
     {
+#if defined(_WIN32)
         return m_sockId2HandlerInfo.size();
+#else
+        return m_handlerCount;
+#endif
+    }
+
+    PRO_HANDLER_INFO FindHandler(int64_t sockId) const
+    {
+        assert(sockId != -1);
+
+#if defined(_WIN32)
+        return FindHandlerInTree(sockId);
+#else
+        if (sockId < 0 || sockId >= (int64_t)m_fd2HandlerInfo.size())
+        {
+            return PRO_HANDLER_INFO();
+        }
+
+        return m_fd2HandlerInfo[(size_t)sockId];
+#endif
     }
 
-    PRO_HANDLER_INFO FindHandler(int64_t sockId) const;
+    void GetAllHandlers(CProHandlerMap& sockId2HandlerInfo) const;
 
-    const CProStlMap<int64_t, PRO_HANDLER_INFO>& GetAllHandlers() const
+    /*
+     * A handler's first event since the last CollectEvents() puts it on
+     * the hot list. Nothing is counted until CollectEvents() is used
+     */
+    void CountEvent(int64_t sockId)
     {
-        return m_sockId2HandlerInfo;
+        if (!m_collecting)
+        {
+            return;
+        }
+
+#if defined(_WIN32)
+        auto itr = m_sockId2HandlerInfo.find(sockId);
+        if (itr != m_sockId2HandlerInfo.end() && itr->second.events++ == 0)
+        {
+            m_hotSockIds.push_back(sockId);
+        }
+#else
+        if (sockId >= 0 && sockId < (int64_t)m_fd2HandlerInfo.size() &&
+            m_fd2HandlerInfo[(size_t)sockId].events++ == 0)
+        {
+            m_hotSockIds.push_back(sockId);
+        }
+#endif
     }
 
+    /*
+     * Resets the event counts of the hot list, and returns the busiest
+     * handler that supports migration and has no more than maxEvents
+     * events
+     */
+    bool CollectEvents(
+        uint32_t          maxEvents,
+        int64_t&          sockId,
+        PRO_HANDLER_INFO& info
+        );
+
+private:
+
+#if defined(_WIN32)
+    PRO_HANDLER_INFO FindHandlerInTree(int64_t sockId) const;
+#endif
+
 private:
 
-    CProStlMap<int64_t, PRO_HANDLER_INFO> m_sockId2HandlerInfo;
+#if defined(_WIN32)
+    CProHandlerMap                  m_sockId2HandlerInfo;
+#else
+    CProStlVector<PRO_HANDLER_INFO> m_fd2HandlerInfo;
+    size_t                          m_handlerCount;
+    int64_t                         m_maxSockId;   /* no handler above it */
+#endif
+    bool                            m_collecting;
+    CProStlVector<int64_t>          m_hotSockIds;  /* with events. A removed one may stay */
 
     DECLARE_SGI_POOL(0)
 };
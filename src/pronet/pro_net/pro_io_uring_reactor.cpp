@@ -0,0 +1,1314 @@
+/*
+ * Copyright (C) 2018-2019 Eric Tung <libpronet@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"),
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file is part of LibProNet (https://github.com/libpronet/libpronet)
+ */
+
+#include "pro_io_uring_reactor.h"
+#include "pro_base_reactor.h"
+#include "../pro_util/pro_bsd_wrapper.h"
+#include "../pro_util/pro_memory_pool.h"
+#include "../pro_util/pro_notify_pipe.h"
+#include "../pro_util/pro_stl.h"
+#include "../pro_util/pro_thread.h"
+#include "../pro_util/pro_time_util.h"
+#include "../pro_util/pro_z.h"
+
+#if defined(PRO_HAS_IO_URING)
+
+#include <sys/mman.h>
+
+/////////////////////////////////////////////////////////////////////////////
+////
+
+#define PRO_URING_IN_SET  (POLLIN | POLLHUP | POLLRDHUP)
+#define PRO_URING_OUT_SET POLLOUT
+#define PRO_URING_EX_SET  POLLPRI
+#define PRO_URING_ERR     POLLERR
+
+/*
+ * in the low word of user_data, above the fd, for the multishot recvs
+ */
+#define PRO_URING_RECV_TAG 0x80000000U
+
+/*
+ * The ring indices are shared with the kernel
+ */
+#define PRO_URING_LOAD(p)     __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define PRO_URING_STORE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+
+/////////////////////////////////////////////////////////////////////////////
+////
+
+CProIoUringReactor::CProIoUringReactor()
+{
+    m_ringfd     = -1;
+    m_sqRing     = NULL;
+    m_sqRingSize = 0;
+    m_cqRing     = NULL;
+    m_cqRingSize = 0;
+    m_sqes       = NULL;
+    m_sqesSize   = 0;
+    m_sqHead     = NULL;
+    m_sqTail     = NULL;
+    m_sqMask     = 0;
+    m_sqEntries  = 0;
+    m_cqHead     = NULL;
+    m_cqTail     = NULL;
+    m_cqMask     = 0;
+    m_cqes       = NULL;
+
+    m_recvBuffers = false;
+    m_bufRing     = NULL;
+    m_bufRingSize = 0;
+    m_bufs        = NULL;
+    m_bufTail     = 0;
+
+    m_timeout.tv_sec  = 0;
+    m_timeout.tv_nsec = 0;
+
+    m_dispatches.reserve(PRO_IO_URING_ENTRIES);
+    m_recvs.reserve(PRO_IO_URING_ENTRIES);
+}
+
+CProIoUringReactor::~CProIoUringReactor()
+{
+    Fini();
+    CloseRing(); /* cancels all the polls in flight */
+}
+
+bool
+CProIoUringReactor::Init()
+{
+    CProThreadMutexGuard mon(m_lock);
+
+    assert(m_ringfd == -1);
+    if (m_ringfd != -1)
+    {
+        return false;
+    }
+
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(struct io_uring_params));
+    params.flags      = IORING_SETUP_CQSIZE;
+    params.cq_entries = PRO_IO_URING_ENTRIES * 4;
+
+    m_ringfd = pbsd_io_uring_setup(PRO_IO_URING_ENTRIES, &params);
+    if (m_ringfd == -1)
+    {
+        return false;
+    }
+
+    m_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+    m_cqRingSize = params.cq_off.cqes  + params.cq_entries * sizeof(struct io_uring_cqe);
+    if ((params.features & IORING_FEAT_SINGLE_MMAP) != 0)
+    {
+        if (m_cqRingSize > m_sqRingSize)
+        {
+            m_sqRingSize = m_cqRingSize;
+        }
+        m_cqRingSize = m_sqRingSize;
+    }
+
+    m_sqRing = mmap(NULL, m_sqRingSize, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, m_ringfd, IORING_OFF_SQ_RING);
+    if (m_sqRing == MAP_FAILED)
+    {
+        m_sqRing = NULL;
+        CloseRing();
+
+        return false;
+    }
+
+    if ((params.features & IORING_FEAT_SINGLE_MMAP) != 0)
+    {
+        m_cqRing = m_sqRing;
+    }
+    else
+    {
+        m_cqRing = mmap(NULL, m_cqRingSize, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE, m_ringfd, IORING_OFF_CQ_RING);
+        if (m_cqRing == MAP_FAILED)
+        {
+            m_cqRing = NULL;
+            CloseRing();
+
+            return false;
+        }
+    }
+
+    m_sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+    m_sqes     = (struct io_uring_sqe*)mmap(NULL, m_sqesSize, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, m_ringfd, IORING_OFF_SQES);
+    if (m_sqes == MAP_FAILED)
+    {
+        m_sqes = NULL;
+        CloseRing();
+
+        return false;
+    }
+
+    char* sq    = (char*)m_sqRing;
+    char* cq    = (char*)m_cqRing;
+    m_sqHead    = (unsigned int*)(sq + params.sq_off.head);
+    m_sqTail    = (unsigned int*)(sq + params.sq_off.tail);
+    m_sqMask    = *(unsigned int*)(sq + params.sq_off.ring_mask);
+    m_sqEntries = params.sq_entries;
+    m_cqHead    = (unsigned int*)(cq + params.cq_off.head);
+    m_cqTail    = (unsigned int*)(cq + params.cq_off.tail);
+    m_cqMask    = *(unsigned int*)(cq + params.cq_off.ring_mask);
+    m_cqes      = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+
+    /*
+     * the SQE at index i always goes to slot i
+     */
+    unsigned int* array = (unsigned int*)(sq + params.sq_off.array);
+    for (unsigned int i = 0; i < m_sqEntries; ++i)
+    {
+        array[i] = i;
+    }
+
+    /*
+     * without the buffers, the input of all the handlers is polled
+     */
+    m_recvBuffers = InitBuffers();
+
+    m_notifyPipe->Init();
+
+    int64_t sockId = m_notifyPipe->GetReaderSockId();
+    if (sockId == -1)
+    {
+        CloseRing();
+
+        return false;
+    }
+
+    if (!m_handlerMgr.AddHandler(sockId, this, PRO_MASK_READ))
+    {
+        CloseRing();
+
+        return false;
+    }
+
+    Arm(sockId);
+
+    return true;
+}
+
+void
+CProIoUringReactor::Fini()
+{
+    CProThreadMutexGuard mon(m_lock);
+
+    if (m_ringfd == -1)
+    {
+        return;
+    }
+
+    m_wantExit = true;
+    m_notifyPipe->Notify();
+}
+
+bool
+CProIoUringReactor::InitBuffers()
+{
+#if defined(IORING_RECV_MULTISHOT)
+
+    /*
+     * the ring, page-aligned, followed by the buffers
+     */
+    size_t ringSize = (PRO_IO_URING_BUF_COUNT * sizeof(struct io_uring_buf) + 4095) & ~(size_t)4095;
+    m_bufRingSize   = ringSize + (size_t)PRO_IO_URING_BUF_COUNT * PRO_IO_URING_BUF_SIZE;
+    m_bufRing       = mmap(NULL, m_bufRingSize, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (m_bufRing == MAP_FAILED)
+    {
+        m_bufRing = NULL;
+
+        return false;
+    }
+
+    m_bufs = (char*)m_bufRing + ringSize;
+
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(struct io_uring_buf_reg));
+    reg.ring_addr    = (uint64_t)(uintptr_t)m_bufRing;
+    reg.ring_entries = PRO_IO_URING_BUF_COUNT;
+    reg.bgid         = 0;
+
+    /*
+     * EINVAL without the buffer rings (Linux 5.19)
+     */
+    if (pbsd_io_uring_register(m_ringfd, IORING_REGISTER_PBUF_RING, &reg, 1) != 0)
+    {
+        munmap(m_bufRing, m_bufRingSize);
+        m_bufRing = NULL;
+        m_bufs    = NULL;
+
+        return false;
+    }
+
+    for (int i = 0; i < PRO_IO_URING_BUF_COUNT; ++i)
+    {
+        RecycleBuffer(i);
+    }
+
+    PRO_URING_STORE(&((struct io_uring_buf_ring*)m_bufRing)->tail, m_bufTail);
+
+    if (!ProbeRecv())
+    {
+        memset(&reg, 0, sizeof(struct io_uring_buf_reg));
+        reg.bgid = 0;
+        pbsd_io_uring_register(m_ringfd, IORING_UNREGISTER_PBUF_RING, &reg, 1);
+
+        munmap(m_bufRing, m_bufRingSize);
+        m_bufRing = NULL;
+        m_bufs    = NULL;
+
+        return false;
+    }
+
+    return true;
+
+#else  /* IORING_RECV_MULTISHOT */
+
+    return false;
+
+#endif /* IORING_RECV_MULTISHOT */
+}
+
+bool
+CProIoUringReactor::ProbeRecv()
+{
+#if defined(IORING_RECV_MULTISHOT)
+
+    /*
+     * A kernel with the buffer rings may still reject multishot recv (Linux
+     * 6.0+) with EINVAL. A recv on an idle socket is canceled right away.
+     * The ring is private to Init() yet, so the two CQEs are ours
+     */
+    int64_t fds[2] = { -1, -1 };
+    if (pbsd_socketpair(fds) != 0)
+    {
+        return false;
+    }
+
+    struct io_uring_sqe sqe;
+    memset(&sqe, 0, sizeof(struct io_uring_sqe));
+    sqe.opcode    = IORING_OP_RECV;
+    sqe.fd        = (int)fds[0];
+    sqe.flags     = IOSQE_BUFFER_SELECT;
+    sqe.ioprio    = IORING_RECV_MULTISHOT;
+    sqe.buf_group = 0;
+    sqe.user_data = 1;
+    PushSqe(sqe);
+
+    memset(&sqe, 0, sizeof(struct io_uring_sqe));
+    sqe.opcode    = IORING_OP_ASYNC_CANCEL;
+    sqe.fd        = -1;
+    sqe.addr      = 1;
+    sqe.user_data = 2;
+    PushSqe(sqe); /* both in the ring, which is fresh */
+
+    int  retc = pbsd_io_uring_enter(m_ringfd, 2, 2, IORING_ENTER_GETEVENTS);
+    bool ret  = retc >= 0;
+
+    unsigned int head = *m_cqHead;
+    unsigned int tail = PRO_URING_LOAD(m_cqTail);
+    for (; head != tail; ++head)
+    {
+        const struct io_uring_cqe& cqe = m_cqes[head & m_cqMask];
+        if (cqe.user_data == 1)
+        {
+            if (cqe.res == -EINVAL)
+            {
+                ret = false;
+            }
+
+            if ((cqe.flags & IORING_CQE_F_BUFFER) != 0)
+            {
+                RecycleBuffer((int)(cqe.flags >> IORING_CQE_BUFFER_SHIFT));
+                PRO_URING_STORE(&((struct io_uring_buf_ring*)m_bufRing)->tail, m_bufTail);
+            }
+        }
+    }
+
+    PRO_URING_STORE(m_cqHead, tail);
+
+    pbsd_closesocket(fds[0]);
+    pbsd_closesocket(fds[1]);
+
+    return ret;
+
+#else  /* IORING_RECV_MULTISHOT */
+
+    return false;
+
+#endif /* IORING_RECV_MULTISHOT */
+}
+
+void
+CProIoUringReactor::RecycleBuffer(int bufId)
+{
+#if defined(IORING_RECV_MULTISHOT)
+
+    if (bufId < 0 || bufId >= PRO_IO_URING_BUF_COUNT)
+    {
+        return;
+    }
+
+    /*
+     * The kernel sees it after the next store of the tail, see WorkerRun().
+     * The ring is indexed as an array, since the "bufs" of the header is at
+     * a wrong offset in C++
+     */
+    struct io_uring_buf* buf = (struct io_uring_buf*)m_bufRing +
+        (m_bufTail & (PRO_IO_URING_BUF_COUNT - 1));
+    buf->addr = (uint64_t)(uintptr_t)(m_bufs + (size_t)bufId * PRO_IO_URING_BUF_SIZE);
+    buf->len  = PRO_IO_URING_BUF_SIZE;
+    buf->bid  = (uint16_t)bufId;
+
+    ++m_bufTail;
+
+#endif /* IORING_RECV_MULTISHOT */
+}
+
+void
+CProIoUringReactor::CloseRing()
+{
+#if defined(IORING_RECV_MULTISHOT)
+    if (m_bufRing != NULL)
+    {
+        /*
+         * no recv copies into the buffers once this returns
+         */
+        if (m_ringfd != -1)
+        {
+            struct io_uring_buf_reg reg;
+            memset(&reg, 0, sizeof(struct io_uring_buf_reg));
+            reg.bgid = 0;
+            pbsd_io_uring_register(m_ringfd, IORING_UNREGISTER_PBUF_RING, &reg, 1);
+        }
+
+        munmap(m_bufRing, m_bufRingSize);
+        m_bufRing = NULL;
+        m_bufs    = NULL;
+    }
+#endif
+
+    if (m_sqes != NULL)
+    {
+        munmap(m_sqes, m_sqesSize);
+        m_sqes = NULL;
+    }
+    if (m_cqRing != NULL && m_cqRing != m_sqRing)
+    {
+        munmap(m_cqRing, m_cqRingSize);
+    }
+    m_cqRing = NULL;
+    if (m_sqRing != NULL)
+    {
+        munmap(m_sqRing, m_sqRingSize);
+        m_sqRing = NULL;
+    }
+    if (m_ringfd != -1)
+    {
+        close(m_ringfd);
+        m_ringfd = -1;
+    }
+
+    m_sqHead = NULL;
+    m_sqTail = NULL;
+    m_cqHead = NULL;
+    m_cqTail = NULL;
+    m_cqes   = NULL;
+}
+
+bool
+CProIoUringReactor::AddHandler(int64_t           sockId,
+                               CProEventHandler* handler,
+                               unsigned long     mask)
+{
+    mask &= (PRO_MASK_ACCEPT | PRO_MASK_CONNECT |
+        PRO_MASK_WRITE | PRO_MASK_READ | PRO_MASK_EXCEPTION);
+
+    assert(sockId != -1);
+    assert(handler != NULL);
+    assert(mask != 0);
+    if (sockId == -1 || handler == NULL || mask == 0)
+    {
+        return false;
+    }
+
+    if (PRO_BIT_ENABLED(mask, PRO_MASK_ACCEPT))
+    {
+        PRO_CLR_BITS(mask, PRO_MASK_ACCEPT);
+        PRO_SET_BITS(mask, PRO_MASK_READ);
+    }
+    if (PRO_BIT_ENABLED(mask, PRO_MASK_CONNECT))
+    {
+        PRO_CLR_BITS(mask, PRO_MASK_CONNECT);
+        PRO_SET_BITS(mask, PRO_MASK_WRITE | PRO_MASK_READ | PRO_MASK_EXCEPTION);
+    }
+
+    {
+        CProThreadMutexGuard mon(m_lock);
+
+        if (m_ringfd == -1 || m_wantExit)
+        {
+            return false;
+        }
+
+        PRO_HANDLER_INFO oldInfo = m_handlerMgr.FindHandler(sockId);
+        if (oldInfo.handler != NULL && handler != oldInfo.handler)
+        {
+            return false;
+        }
+
+        mask &= ~oldInfo.mask;
+        if (mask == 0)
+        {
+            return true;
+        }
+
+        if (!m_handlerMgr.AddHandler(sockId, handler, mask))
+        {
+            return false;
+        }
+
+        /*
+         * re-arm with the new mask
+         */
+        Disarm(sockId);
+        Arm(sockId);
+
+        if (ProGetThreadId() != m_threadId)
+        {
+            m_notifyPipe->Notify();
+        }
+    }
+
+    return true;
+}
+
+void
+CProIoUringReactor::RemoveHandler(int64_t       sockId,
+                                  unsigned long mask)
+{
+    mask &= (PRO_MASK_ACCEPT | PRO_MASK_CONNECT |
+        PRO_MASK_WRITE | PRO_MASK_READ | PRO_MASK_EXCEPTION);
+
+    if (sockId == -1 || mask == 0)
+    {
+        return;
+    }
+
+    if (PRO_BIT_ENABLED(mask, PRO_MASK_ACCEPT))
+    {
+        PRO_CLR_BITS(mask, PRO_MASK_ACCEPT);
+        PRO_SET_BITS(mask, PRO_MASK_READ);
+    }
+    if (PRO_BIT_ENABLED(mask, PRO_MASK_CONNECT))
+    {
+        PRO_CLR_BITS(mask, PRO_MASK_CONNECT);
+        PRO_SET_BITS(mask, PRO_MASK_WRITE | PRO_MASK_READ | PRO_MASK_EXCEPTION);
+    }
+
+    {
+        CProThreadMutexGuard mon(m_lock);
+
+        if (m_ringfd == -1)
+        {
+            return;
+        }
+
+        PRO_HANDLER_INFO oldInfo = m_handlerMgr.FindHandler(sockId);
+        if (oldInfo.handler == NULL || (oldInfo.mask & mask) == 0)
+        {
+            return;
+        }
+
+        m_handlerMgr.RemoveHandler(sockId, mask);
+
+        /*
+         * The poll or recv in flight holds a reference to the socket, so
+         * the POLL_REMOVE or ASYNC_CANCEL must reach the kernel soon, even
+         * if the socket is closed right after this
+         */
+        if (m_handlerMgr.FindHandler(sockId).handler == NULL)
+        {
+            ReleaseRecv(sockId);
+        }
+        Disarm(sockId);
+        Arm(sockId);
+
+        if (ProGetThreadId() != m_threadId)
+        {
+            m_notifyPipe->Notify();
+        }
+    }
+}
+
+void
+CProIoUringReactor::ReplayHandler(int64_t       sockId,
+                                  unsigned long mask)
+{
+    mask &= (PRO_MASK_WRITE | PRO_MASK_READ);
+
+    if (sockId == -1 || mask == 0)
+    {
+        return;
+    }
+
+    CProThreadMutexGuard mon(m_lock);
+
+    if (m_ringfd == -1 || m_wantExit)
+    {
+        return;
+    }
+
+    PRO_HANDLER_INFO info = m_handlerMgr.FindHandler(sockId);
+    if (info.handler == NULL)
+    {
+        return;
+    }
+
+    /*
+     * a stale entry is dropped by WorkerRun() if the handler has gone
+     */
+    if (!m_replays.empty()                 &&
+        m_replays.back().sockId  == sockId &&
+        m_replays.back().handler == info.handler)
+    {
+        PRO_SET_BITS(m_replays.back().mask, mask);
+    }
+    else
+    {
+        PRO_DISPATCH_INFO info2;
+        info2.sockId  = sockId;
+        info2.handler = info.handler;
+        info2.mask    = mask;
+        m_replays.push_back(info2);
+    }
+
+    if (ProGetThreadId() != m_threadId)
+    {
+        m_notifyPipe->Notify();
+    }
+}
+
+void
+CProIoUringReactor::PushSqe(const struct io_uring_sqe& sqe)
+{
+    unsigned int tail = *m_sqTail; /* written by us only */
+    unsigned int head = PRO_URING_LOAD(m_sqHead);
+
+    /*
+     * full, or behind the ones already waiting. For the worker thread,
+     * see FlushSqes()
+     */
+    if (!m_sqeBacklog.empty() || tail - head >= m_sqEntries)
+    {
+        m_sqeBacklog.push_back(sqe);
+
+        return;
+    }
+
+    m_sqes[tail & m_sqMask] = sqe;
+    PRO_URING_STORE(m_sqTail, tail + 1);
+}
+
+bool
+CProIoUringReactor::FlushSqes()
+{
+    size_t i = 0;
+
+    while (i < m_sqeBacklog.size())
+    {
+        unsigned int tail = *m_sqTail;
+        unsigned int head = PRO_URING_LOAD(m_sqHead);
+
+        if (tail - head >= m_sqEntries)
+        {
+            /*
+             * submit the full ring without waiting. On the worker thread
+             * only, which owns io_uring_enter()
+             */
+            if (pbsd_io_uring_enter(m_ringfd, tail - head, 0, 0) <= 0)
+            {
+                break;
+            }
+
+            continue;
+        }
+
+        m_sqes[tail & m_sqMask] = m_sqeBacklog[i];
+        PRO_URING_STORE(m_sqTail, tail + 1);
+        ++i;
+    }
+
+    m_sqeBacklog.erase(m_sqeBacklog.begin(), m_sqeBacklog.begin() + i);
+
+    return m_sqeBacklog.empty();
+}
+
+void
+CProIoUringReactor::Arm(int64_t sockId)
+{
+    PRO_HANDLER_INFO info = m_handlerMgr.FindHandler(sockId);
+    if (info.handler == NULL)
+    {
+        return;
+    }
+
+    /*
+     * the input of a buffer-fed handler isn't polled, see ArmRecv()
+     */
+    bool recv = m_recvBuffers && info.handler->SupportsRecvBuffers();
+
+    unsigned int events = 0;
+    if (PRO_BIT_ENABLED(info.mask, PRO_MASK_WRITE))
+    {
+        events |= PRO_URING_OUT_SET;
+    }
+    if (PRO_BIT_ENABLED(info.mask, PRO_MASK_READ) && !recv)
+    {
+        events |= PRO_URING_IN_SET;
+    }
+    if (PRO_BIT_ENABLED(info.mask, PRO_MASK_EXCEPTION))
+    {
+        events |= PRO_URING_EX_SET;
+    }
+    if (events == 0 && !recv)
+    {
+        return;
+    }
+
+    if ((size_t)sockId >= m_fd2Slot.size())
+    {
+        size_t size = m_fd2Slot.size() < 64 ? 64 : m_fd2Slot.size();
+        while (size <= (size_t)sockId)
+        {
+            size *= 2;
+        }
+
+        PRO_URING_SLOT slot;
+        slot.gen       = 1; /* user_data 0 is for POLL_REMOVE */
+        slot.armed     = false;
+        slot.recvGen   = 1;
+        slot.receiving = false;
+        slot.canceling = false;
+        m_fd2Slot.resize(size, slot);
+    }
+
+    if (recv)
+    {
+        ArmRecv(sockId,
+            PRO_BIT_ENABLED(info.mask, PRO_MASK_READ) && !info.handler->HoldsRecvBuffers());
+    }
+
+    PRO_URING_SLOT& slot = m_fd2Slot[(size_t)sockId];
+    if (events == 0 || slot.armed)
+    {
+        return;
+    }
+
+    struct io_uring_sqe sqe;
+    memset(&sqe, 0, sizeof(struct io_uring_sqe));
+    sqe.opcode        = IORING_OP_POLL_ADD;
+    sqe.fd            = (int)sockId;
+    sqe.poll32_events = events;
+    sqe.user_data     = ((uint64_t)slot.gen << 32) | (uint32_t)sockId;
+    PushSqe(sqe);
+
+    slot.armed = true;
+}
+
+void
+CProIoUringReactor::Disarm(int64_t sockId)
+{
+    if ((size_t)sockId >= m_fd2Slot.size())
+    {
+        return;
+    }
+
+    PRO_URING_SLOT& slot = m_fd2Slot[(size_t)sockId];
+    if (!slot.armed)
+    {
+        return;
+    }
+
+    struct io_uring_sqe sqe;
+    memset(&sqe, 0, sizeof(struct io_uring_sqe));
+    sqe.opcode    = IORING_OP_POLL_REMOVE;
+    sqe.fd        = -1;
+    sqe.addr      = ((uint64_t)slot.gen << 32) | (uint32_t)sockId;
+    sqe.user_data = 0;
+    PushSqe(sqe);
+
+    /*
+     * a late completion of the old poll is stale from now on
+     */
+    slot.armed = false;
+    ++slot.gen;
+    if (slot.gen == 0)
+    {
+        slot.gen = 1;
+    }
+}
+
+void
+CProIoUringReactor::ArmRecv(int64_t sockId,
+                            bool    reading)
+{
+#if defined(IORING_RECV_MULTISHOT)
+
+    PRO_URING_SLOT& slot = m_fd2Slot[(size_t)sockId];
+
+    if (!reading)
+    {
+        if (slot.receiving && !slot.canceling)
+        {
+            CancelRecv(sockId);
+        }
+
+        return;
+    }
+
+    /*
+     * one being canceled is re-armed when it ends, see ReapRecv()
+     */
+    if (slot.receiving)
+    {
+        return;
+    }
+
+    struct io_uring_sqe sqe;
+    memset(&sqe, 0, sizeof(struct io_uring_sqe));
+    sqe.opcode    = IORING_OP_RECV;
+    sqe.fd        = (int)sockId;
+    sqe.flags     = IOSQE_BUFFER_SELECT;
+    sqe.ioprio    = IORING_RECV_MULTISHOT;
+    sqe.buf_group = 0;
+    sqe.user_data = ((uint64_t)slot.recvGen << 32) | PRO_URING_RECV_TAG | (uint32_t)sockId;
+    PushSqe(sqe);
+
+    slot.receiving = true;
+    slot.canceling = false;
+
+#endif /* IORING_RECV_MULTISHOT */
+}
+
+void
+CProIoUringReactor::CancelRecv(int64_t sockId)
+{
+    PRO_URING_SLOT& slot = m_fd2Slot[(size_t)sockId];
+
+    struct io_uring_sqe sqe;
+    memset(&sqe, 0, sizeof(struct io_uring_sqe));
+    sqe.opcode    = IORING_OP_ASYNC_CANCEL;
+    sqe.fd        = -1;
+    sqe.addr      = ((uint64_t)slot.recvGen << 32) | PRO_URING_RECV_TAG | (uint32_t)sockId;
+    sqe.user_data = 0;
+    PushSqe(sqe);
+
+    slot.canceling = true;
+}
+
+void
+CProIoUringReactor::ReleaseRecv(int64_t sockId)
+{
+    if ((size_t)sockId >= m_fd2Slot.size())
+    {
+        return;
+    }
+
+    PRO_URING_SLOT& slot = m_fd2Slot[(size_t)sockId];
+    if (!slot.receiving)
+    {
+        return;
+    }
+
+    if (!slot.canceling)
+    {
+        CancelRecv(sockId);
+    }
+
+    /*
+     * the late completions of the old recv are stale from now on. Their
+     * buffers are recycled only
+     */
+    slot.receiving = false;
+    slot.canceling = false;
+    ++slot.recvGen;
+    if (slot.recvGen == 0)
+    {
+        slot.recvGen = 1;
+    }
+}
+
+bool
+CProIoUringReactor::ReapRecv(const struct io_uring_cqe& cqe)
+{
+    int64_t  sockId = (int64_t)((uint32_t)cqe.user_data & ~PRO_URING_RECV_TAG);
+    uint32_t gen    = (uint32_t)(cqe.user_data >> 32);
+    int      bufId  = -1;
+
+#if defined(IORING_RECV_MULTISHOT)
+    if ((cqe.flags & IORING_CQE_F_BUFFER) != 0)
+    {
+        bufId = (int)(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+    }
+#endif
+
+    if ((size_t)sockId >= m_fd2Slot.size() || m_fd2Slot[(size_t)sockId].recvGen != gen)
+    {
+        RecycleBuffer(bufId);
+
+        return false;
+    }
+
+    PRO_HANDLER_INFO info = m_handlerMgr.FindHandler(sockId);
+    if (info.handler == NULL)
+    {
+        RecycleBuffer(bufId);
+
+        return false;
+    }
+
+    PRO_URING_SLOT& slot = m_fd2Slot[(size_t)sockId];
+
+    if ((cqe.flags & IORING_CQE_F_MORE) == 0)
+    {
+        slot.receiving = false;
+        slot.canceling = false;
+
+        /*
+         * ended without EOF or an error. Re-armed with the polls, if the
+         * handler still reads, see WorkerRun()
+         */
+        if (cqe.res > 0 || cqe.res == -ENOBUFS || cqe.res == -ECANCELED)
+        {
+            PRO_DISPATCH_INFO info2;
+            info2.sockId  = sockId;
+            info2.handler = info.handler;
+            info2.mask    = 0;
+            m_dispatches.push_back(info2);
+
+            info.handler->AddRef();
+        }
+    }
+
+    if (cqe.res == -ENOBUFS || cqe.res == -ECANCELED)
+    {
+        RecycleBuffer(bufId);
+
+        return false;
+    }
+
+    PRO_URING_RECV recv;
+    recv.sockId    = sockId;
+    recv.handler   = info.handler;
+    recv.buf       = NULL;
+    recv.size      = 0;
+    recv.errorCode = cqe.res < 0 ? -cqe.res : 0;
+    recv.bufId     = bufId;
+    if (cqe.res > 0 && bufId >= 0)
+    {
+        recv.buf  = m_bufs + (size_t)bufId * PRO_IO_URING_BUF_SIZE;
+        recv.size = (size_t)cqe.res;
+    }
+    m_recvs.push_back(recv);
+
+    info.handler->AddRef();
+    CountEvent(sockId);
+
+    return true;
+}
+
+void
+CProIoUringReactor::WorkerRun()
+{
+    {
+        CProThreadMutexGuard mon(m_lock);
+
+        m_threadId = ProGetThreadId();
+    }
+
+    ProUpdateCachedTickCount64();
+
+    while (1)
+    {
+        unsigned int toSubmit    = 0;
+        unsigned int minComplete = 1;
+
+        {
+            CProThreadMutexGuard mon(m_lock);
+
+            if (m_ringfd == -1 || m_wantExit)
+            {
+                break;
+            }
+
+            /*
+             * re-arm the one-shot polls consumed by the last wakeup, and
+             * the recvs of the handlers that may hold their input now.
+             * Give back the buffers it has handed over
+             */
+            for (int i = 0; i < (int)m_dispatches.size(); ++i)
+            {
+                Arm(m_dispatches[i].sockId);
+            }
+            for (int i = 0; i < (int)m_recvs.size(); ++i)
+            {
+                if (i == 0 || m_recvs[i].sockId != m_recvs[i - 1].sockId)
+                {
+                    Arm(m_recvs[i].sockId);
+                }
+            }
+
+            if (m_recvBuffers)
+            {
+                PRO_URING_STORE(&((struct io_uring_buf_ring*)m_bufRing)->tail, m_bufTail);
+            }
+
+            int timeout = -1;
+            if (!m_replays.empty())
+            {
+                timeout = 0; /* don't block on pending replays */
+            }
+
+            timeout = GetTimerTimeout(timeout);
+            if (timeout >= 0)
+            {
+                m_timeout.tv_sec  = timeout / 1000;
+                m_timeout.tv_nsec = timeout % 1000 * 1000000LL;
+
+                struct io_uring_sqe sqe;
+                memset(&sqe, 0, sizeof(struct io_uring_sqe));
+                sqe.opcode    = IORING_OP_TIMEOUT;
+                sqe.fd        = -1;
+                sqe.addr      = (uint64_t)(uintptr_t)&m_timeout;
+                sqe.len       = 1;
+                sqe.off       = 1; /* or the first other completion */
+                sqe.user_data = 0;
+                PushSqe(sqe);
+            }
+
+            /*
+             * don't block with SQEs (maybe the timeout) still waiting
+             */
+            if (!FlushSqes())
+            {
+                minComplete = 0;
+            }
+
+            toSubmit = *m_sqTail - PRO_URING_LOAD(m_sqHead);
+        }
+
+        m_dispatches.clear();
+        m_recvs.clear();
+
+        int     retc     = 0;
+        bool    polled   = false;
+        int64_t spinTime = 0;
+        int64_t waitTime = 0;
+        size_t  events   = 0;
+
+        /*
+         * busy-poll first. Entering with min_complete 0 also runs the
+         * pending poll completions, which are queued as task work
+         */
+        if (m_busyPollTime > 0)
+        {
+            int64_t start = GetTickUs();
+            int64_t now   = start;
+
+            do
+            {
+                retc     = pbsd_io_uring_enter(m_ringfd, toSubmit, 0, IORING_ENTER_GETEVENTS);
+                toSubmit = 0;
+                polled   = *m_cqHead != PRO_URING_LOAD(m_cqTail);
+                now      = GetTickUs();
+            }
+            while (retc >= 0 && !polled && now - start < (int64_t)m_busyPollTime);
+
+            spinTime = now - start;
+        }
+
+        /*
+         * io_uring_enter(). submit and wait in one call
+         */
+        if (retc >= 0 && !polled)
+        {
+            bool    timed = m_busyPollTime > 0 || m_loopStats;
+            int64_t start = timed ? GetTickUs() : 0;
+
+            retc = pbsd_io_uring_enter(m_ringfd, toSubmit, minComplete, IORING_ENTER_GETEVENTS);
+
+            if (timed)
+            {
+                waitTime = GetTickUs() - start;
+            }
+        }
+
+        ProUpdateCachedTickCount64(); /* once per wakeup */
+        ProCollectSgiPoolRemoteFrees();
+        if (retc < 0)
+        {
+            ProSleep(1);
+            continue;
+        }
+
+        {
+            CProThreadMutexGuard mon(m_lock);
+
+            if (m_ringfd == -1 || m_wantExit)
+            {
+                break;
+            }
+
+            m_spinTime += spinTime;
+            m_waitTime += waitTime;
+
+            unsigned int head = *m_cqHead; /* written by us only */
+            unsigned int tail = PRO_URING_LOAD(m_cqTail);
+
+            for (; head != tail; ++head)
+            {
+                const struct io_uring_cqe& cqe = m_cqes[head & m_cqMask];
+                if (cqe.user_data == 0)
+                {
+                    continue;
+                }
+
+                if (((uint32_t)cqe.user_data & PRO_URING_RECV_TAG) != 0)
+                {
+                    if (ReapRecv(cqe))
+                    {
+                        ++events;
+                    }
+
+                    continue;
+                }
+
+                int64_t  sockId = (int64_t)(uint32_t)cqe.user_data;
+                uint32_t gen    = (uint32_t)(cqe.user_data >> 32);
+
+                if ((size_t)sockId >= m_fd2Slot.size())
+                {
+                    continue;
+                }
+
+                PRO_URING_SLOT& slot = m_fd2Slot[(size_t)sockId];
+                if (!slot.armed || slot.gen != gen)
+                {
+                    continue;
+                }
+
+                slot.armed = false; /* one-shot */
+
+                PRO_HANDLER_INFO info = m_handlerMgr.FindHandler(sockId);
+                if (info.handler == NULL)
+                {
+                    continue;
+                }
+
+                unsigned long mask = 0;
+
+                if (cqe.res < 0 || (cqe.res & PRO_URING_ERR) != 0)
+                {
+                    mask = PRO_MASK_ERROR;
+                }
+                else
+                {
+                    if ((cqe.res & PRO_URING_OUT_SET) != 0)
+                    {
+                        PRO_SET_BITS(mask, PRO_MASK_WRITE);
+                    }
+                    if ((cqe.res & PRO_URING_IN_SET) != 0)
+                    {
+                        PRO_SET_BITS(mask, PRO_MASK_READ);
+                    }
+                    if ((cqe.res & PRO_URING_EX_SET) != 0)
+                    {
+                        PRO_SET_BITS(mask, PRO_MASK_EXCEPTION);
+                    }
+
+                    mask &= info.mask;
+                }
+
+                /*
+                 * an entry with no bits is kept for re-arming
+                 */
+                PRO_DISPATCH_INFO info2;
+                info2.sockId  = sockId;
+                info2.handler = info.handler;
+                info2.mask    = mask;
+                m_dispatches.push_back(info2);
+
+                info.handler->AddRef();
+                if (mask != 0)
+                {
+                    CountEvent(sockId);
+                    ++events;
+                }
+            } /* end of for () */
+
+            PRO_URING_STORE(m_cqHead, tail);
+
+            for (int j = 0; j < (int)m_replays.size(); ++j)
+            {
+                const PRO_DISPATCH_INFO& replay = m_replays[j];
+
+                PRO_HANDLER_INFO info = m_handlerMgr.FindHandler(replay.sockId);
+                if (info.handler != replay.handler)
+                {
+                    continue;
+                }
+
+                unsigned long mask = replay.mask & info.mask;
+                if (mask == 0)
+                {
+                    continue;
+                }
+
+                PRO_DISPATCH_INFO info2;
+                info2.sockId  = replay.sockId;
+                info2.handler = info.handler;
+                info2.mask    = mask;
+                m_dispatches.push_back(info2);
+
+                info.handler->AddRef();
+            } /* end of for () */
+
+            m_replays.clear();
+        }
+
+        RecordWakeup(waitTime, events);
+
+        /*
+         * in the order of the completions, before the polled events
+         */
+        for (int j = 0; j < (int)m_recvs.size(); ++j)
+        {
+            const PRO_URING_RECV& recv = m_recvs[j];
+
+            DispatchBuffer(recv.sockId, recv.handler, recv.buf, recv.size, recv.errorCode);
+            RecycleBuffer(recv.bufId);
+
+            /*
+             * one OnInput() after the buffers of a handler in a row
+             */
+            if (j + 1 == (int)m_recvs.size()            ||
+                m_recvs[j + 1].sockId  != recv.sockId   ||
+                m_recvs[j + 1].handler != recv.handler)
+            {
+                Dispatch(recv.sockId, recv.handler, PRO_MASK_READ);
+            }
+
+            recv.handler->Release();
+        } /* end of for () */
+
+        for (int j = 0; j < (int)m_dispatches.size(); ++j)
+        {
+            const PRO_DISPATCH_INFO& info = m_dispatches[j];
+
+            Dispatch(info.sockId, info.handler, info.mask);
+
+            info.handler->Release();
+        } /* end of for () */
+
+        ProcessTimers();
+        DoMigration();
+    } /* end of while () */
+
+    ProResetCachedTickCount64();
+}
+
+void
+CProIoUringReactor::OnInput(int64_t sockId)
+{
+    assert(sockId != -1);
+    if (sockId == -1)
+    {
+        return;
+    }
+
+    if (RogerNotify())
+    {
+        return;
+    }
+
+    OnError(sockId, -1);
+}
+
+void
+CProIoUringReactor::OnError(int64_t sockId,
+                            int     errorCode)
+{
+    assert(sockId != -1);
+    if (sockId == -1)
+    {
+        return;
+    }
+
+    {
+        CProThreadMutexGuard mon(m_lock);
+
+        if (m_ringfd == -1 || m_wantExit || sockId != m_notifyPipe->GetReaderSockId())
+        {
+            return;
+        }
+
+        CProNotifyPipe* newPipe = new CProNotifyPipe;
+        newPipe->Init();
+
+        int64_t newSockId = newPipe->GetReaderSockId();
+        if (newSockId == -1)
+        {
+            delete newPipe;
+
+            return;
+        }
+
+        if (!m_handlerMgr.AddHandler(newSockId, this, PRO_MASK_READ))
+        {
+            delete newPipe;
+
+            return;
+        }
+
+        Arm(newSockId);
+
+        /*
+         * unregister old
+         */
+        m_handlerMgr.RemoveHandler(sockId, PRO_MASK_READ);
+        Disarm(sockId);
+        delete m_notifyPipe;
+        m_notifyPipe = NULL;
+
+        /*
+         * register new
+         */
+        m_notifyPipe = newPipe;
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+////
+
+#endif /* PRO_HAS_IO_URING */
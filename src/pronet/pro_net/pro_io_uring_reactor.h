@@ -0,0 +1,178 @@
+/*
+ * Copyright (C) 2018-2019 Eric Tung <libpronet@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"),
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file is part of LibProNet (https://github.com/libpronet/libpronet)
+ */
+
+#ifndef PRO_IO_URING_REACTOR_H
+#define PRO_IO_URING_REACTOR_H
+
+#include "pro_base_reactor.h"
+#include "../pro_util/pro_stl.h"
+
+#if defined(PRO_HAS_IO_URING)
+
+/////////////////////////////////////////////////////////////////////////////
+////
+
+struct PRO_URING_SLOT
+{
+    uint32_t gen;       /* tags the armed poll in user_data */
+    bool     armed;
+    uint32_t recvGen;   /* tags the multishot recv in user_data */
+    bool     receiving; /* a multishot recv in flight */
+    bool     canceling;
+};
+
+struct PRO_URING_RECV
+{
+    int64_t           sockId;
+    CProEventHandler* handler;
+    const void*       buf;
+    size_t            size;
+    int               errorCode;
+    int               bufId; /* -1 for none */
+};
+
+/*
+ * A readiness reactor on io_uring. Every handler has at most one one-shot
+ * IORING_OP_POLL_ADD in flight, which is re-armed after its callbacks. A
+ * one-shot poll completes at once if the fd is ready already, so the
+ * semantics are level-triggered, just as CProEpollReactor's.
+ *
+ * Where the kernel has multishot recv and buffer rings (probed in Init(),
+ * Linux 6.0+), the input of the handlers that support it is read by
+ * one multishot IORING_OP_RECV per handler, into a ring of provided
+ * buffers, and handed over by OnInputBuffer(). No poll and no recv() is
+ * left on that path. Removing PRO_MASK_READ, or HoldsRecvBuffers() at a
+ * re-arm, cancels the recv, but what it has read already is still handed
+ * over.
+ *
+ * The SQEs are queued under the lock by any thread, and submitted in one
+ * io_uring_enter() by the worker thread, together with waiting. If the SQ
+ * ring is full, they wait in a backlog that only the worker thread moves
+ * into the ring, entering as often as needed. The wait
+ * for the next handler timer is an IORING_OP_TIMEOUT that also completes
+ * with the first other completion.
+ */
+class CProIoUringReactor : public CProBaseReactor
+{
+public:
+
+    CProIoUringReactor();
+
+    virtual ~CProIoUringReactor();
+
+    virtual bool Init();
+
+    virtual void Fini();
+
+    virtual bool AddHandler(
+        int64_t           sockId,
+        CProEventHandler* handler,
+        unsigned long     mask
+        );
+
+    virtual void RemoveHandler(
+        int64_t       sockId,
+        unsigned long mask
+        );
+
+    virtual void ReplayHandler(
+        int64_t       sockId,
+        unsigned long mask
+        );
+
+    virtual bool HasRecvBuffers() const
+    {
+        return m_recvBuffers; /* read-only after Init() */
+    }
+
+    virtual void WorkerRun();
+
+private:
+
+    virtual void OnInput(int64_t sockId);
+
+    virtual void OnError(
+        int64_t sockId,
+        int     errorCode
+        );
+
+    void Arm(int64_t sockId);
+
+    void Disarm(int64_t sockId);
+
+    void ArmRecv(
+        int64_t sockId,
+        bool    reading
+        );
+
+    void CancelRecv(int64_t sockId);
+
+    void ReleaseRecv(int64_t sockId);
+
+    bool ReapRecv(const struct io_uring_cqe& cqe);
+
+    bool InitBuffers();
+
+    bool ProbeRecv();
+
+    void RecycleBuffer(int bufId);
+
+    void PushSqe(const struct io_uring_sqe& sqe);
+
+    bool FlushSqes();
+
+    void CloseRing();
+
+private:
+
+    int                              m_ringfd;
+    void*                            m_sqRing;
+    size_t                           m_sqRingSize;
+    void*                            m_cqRing;
+    size_t                           m_cqRingSize;
+    struct io_uring_sqe*             m_sqes;
+    size_t                           m_sqesSize;
+    unsigned int*                    m_sqHead;
+    unsigned int*                    m_sqTail;
+    unsigned int                     m_sqMask;
+    unsigned int                     m_sqEntries;
+    unsigned int*                    m_cqHead;
+    unsigned int*                    m_cqTail;
+    unsigned int                     m_cqMask;
+    struct io_uring_cqe*             m_cqes;
+    bool                             m_recvBuffers;
+    void*                            m_bufRing;    /* struct io_uring_buf_ring */
+    size_t                           m_bufRingSize;
+    char*                            m_bufs;
+    unsigned short                   m_bufTail;    /* written by the worker only */
+    CProStlVector<PRO_URING_SLOT>    m_fd2Slot;
+    CProStlVector<io_uring_sqe>      m_sqeBacklog; /* while the SQ ring is full */
+    CProStlVector<PRO_DISPATCH_INFO> m_dispatches; /* reused across wakeups */
+    CProStlVector<PRO_URING_RECV>    m_recvs;      /* reused across wakeups */
+    CProStlVector<PRO_DISPATCH_INFO> m_replays;
+    struct __kernel_timespec         m_timeout;    /* of the IORING_OP_TIMEOUT for the timers */
+
+    DECLARE_SGI_POOL(0)
+};
+
+/////////////////////////////////////////////////////////////////////////////
+////
+
+#endif /* PRO_HAS_IO_URING */
+
+#endif /* PRO_IO_URING_REACTOR_H */
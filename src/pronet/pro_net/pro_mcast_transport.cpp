@@ -155,6 +155,8 @@ CProMcastTransport::Init(IProTransportObserver* observer,
         option = 0;
         pbsd_setsockopt(sockId, IPPROTO_IP, IP_MULTICAST_LOOP, &option, sizeof(int));
 
+        m_edgeTriggered = reactorTask->IsEdgeTriggered() && SupportsEdgeTrigger();
+
         if (!reactorTask->AddHandler(sockId, this, PRO_MASK_READ))
         {
             pbsd_setsockopt(sockId, IPPROTO_IP, IP_DROP_MEMBERSHIP, &mreq, sizeof(struct ip_mreq));
@@ -52,6 +52,11 @@ public:
 
     virtual void RemoveMcastReceiver(const char* mcastIp);
 
+    virtual const char* GetHandlerName() const
+    {
+        return "mcast_transport";
+    }
+
 private:
 
     CProMcastTransport(size_t recvPoolSize); /* = 0 */
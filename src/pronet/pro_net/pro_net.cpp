@@ -85,11 +85,21 @@ ProNetVersion(unsigned char* major, /* = NULL */
 PRO_NET_API
 IProReactor*
 ProCreateReactor(unsigned int ioThreadCount)
+{
+    PRO_REACTOR_CONFIG config;
+    config.ioThreadCount = ioThreadCount;
+
+    return ProCreateReactorEx(config);
+}
+
+PRO_NET_API
+IProReactor*
+ProCreateReactorEx(const PRO_REACTOR_CONFIG& config)
 {
     ProNetInit();
 
     CProTpReactorTask* reactorTask = new CProTpReactorTask;
-    if (!reactorTask->Start(ioThreadCount))
+    if (!reactorTask->Start(config))
     {
         delete reactorTask;
 
@@ -179,6 +189,22 @@ ProGetAcceptorPort(IProAcceptor* acceptor)
     return p->GetLocalPort();
 }
 
+PRO_NET_API
+void
+ProGetAcceptorTraceInfo(IProAcceptor* acceptor,
+                        char*         buf,
+                        size_t        size)
+{
+    assert(acceptor != NULL);
+    if (acceptor == NULL)
+    {
+        return;
+    }
+
+    CProAcceptor* p = (CProAcceptor*)acceptor;
+    p->GetTraceInfo(buf, size);
+}
+
 PRO_NET_API
 void
 ProDeleteAcceptor(IProAcceptor* acceptor)
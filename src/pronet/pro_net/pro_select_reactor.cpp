@@ -19,6 +19,7 @@
 #include "pro_select_reactor.h"
 #include "pro_base_reactor.h"
 #include "../pro_util/pro_bsd_wrapper.h"
+#include "../pro_util/pro_memory_pool.h"
 #include "../pro_util/pro_notify_pipe.h"
 #include "../pro_util/pro_thread.h"
 #include "../pro_util/pro_time_util.h"
@@ -325,9 +326,12 @@ CProSelectReactor::WorkerRun()
         m_threadId = ProGetThreadId();
     }
 
+    ProUpdateCachedTickCount64();
+
     while (1)
     {
         int64_t maxSockId = -1;
+        int     timeout   = -1;
 
         {
             CProThreadMutexGuard mon(m_lock);
@@ -341,15 +345,32 @@ CProSelectReactor::WorkerRun()
             m_fdsWr[1] = m_fdsWr[0];
             m_fdsRd[1] = m_fdsRd[0];
             m_fdsEx[1] = m_fdsEx[0];
+            timeout    = GetTimerTimeout(timeout);
         }
 
+        struct timeval tv;
+        tv.tv_sec  = timeout / 1000;
+        tv.tv_usec = timeout % 1000 * 1000;
+
         /*
          * select()
          */
-        int retc = pbsd_select(maxSockId + 1, &m_fdsRd[1], &m_fdsWr[1], &m_fdsEx[1], NULL);
+        int64_t start    = m_loopStats ? GetTickUs() : 0;
+        int     retc     = pbsd_select(maxSockId + 1, &m_fdsRd[1], &m_fdsWr[1], &m_fdsEx[1],
+            timeout >= 0 ? &tv : NULL);
+        int64_t waitTime = m_loopStats ? GetTickUs() - start : 0;
+        ProUpdateCachedTickCount64(); /* once per wakeup */
+        ProCollectSgiPoolRemoteFrees();
         if (retc == 0)
         {
-            ProSleep(1);
+            if (timeout >= 0)
+            {
+                ProcessTimers();
+            }
+            else
+            {
+                ProSleep(1);
+            }
             continue;
         }
 
@@ -361,7 +382,7 @@ CProSelectReactor::WorkerRun()
                 continue;
             }
 
-            CProStlMap<int64_t, PRO_HANDLER_INFO> sockId2HandlerInfo;
+            CProHandlerMap sockId2HandlerInfo;
 
             {
                 CProThreadMutexGuard mon(m_lock);
@@ -371,7 +392,7 @@ CProSelectReactor::WorkerRun()
                     break;
                 }
 
-                sockId2HandlerInfo = m_handlerMgr.GetAllHandlers();
+                m_handlerMgr.GetAllHandlers(sockId2HandlerInfo);
 
                 auto itr = sockId2HandlerInfo.begin();
                 auto end = sockId2HandlerInfo.end();
@@ -420,7 +441,7 @@ CProSelectReactor::WorkerRun()
             continue;
         }
 
-        CProStlMap<int64_t, PRO_HANDLER_INFO> handlers;
+        CProHandlerMap handlers;
 
         {
             CProThreadMutexGuard mon(m_lock);
@@ -451,6 +472,7 @@ CProSelectReactor::WorkerRun()
                 if (info.handler != NULL)
                 {
                     info.handler->AddRef();
+                    CountEvent(sockId);
                     PRO_HANDLER_INFO& info2 = handlers[sockId]; /* insert */
                     info2.handler = info.handler;
                     PRO_SET_BITS(info2.mask, PRO_MASK_WRITE);
@@ -476,6 +498,7 @@ CProSelectReactor::WorkerRun()
                 if (info.handler != NULL)
                 {
                     info.handler->AddRef();
+                    CountEvent(sockId);
                     PRO_HANDLER_INFO& info2 = handlers[sockId]; /* insert */
                     info2.handler = info.handler;
                     PRO_SET_BITS(info2.mask, PRO_MASK_READ);
@@ -501,6 +524,7 @@ CProSelectReactor::WorkerRun()
                 if (info.handler != NULL)
                 {
                     info.handler->AddRef();
+                    CountEvent(sockId);
                     PRO_HANDLER_INFO& info2 = handlers[sockId]; /* insert */
                     info2.handler = info.handler;
                     PRO_SET_BITS(info2.mask, PRO_MASK_EXCEPTION);
@@ -509,20 +533,18 @@ CProSelectReactor::WorkerRun()
 
 #else  /* _WIN32 */
 
-            const CProStlMap<int64_t, PRO_HANDLER_INFO>& sockId2HandlerInfo =
-                m_handlerMgr.GetAllHandlers();
-
-            auto itr = sockId2HandlerInfo.begin();
-            auto end = sockId2HandlerInfo.end();
-
-            for (; itr != end; ++itr)
+            for (int64_t sockId = 0; sockId <= maxSockId; ++sockId)
             {
-                int64_t                 sockId = itr->first;
-                const PRO_HANDLER_INFO& info   = itr->second;
+                PRO_HANDLER_INFO info = m_handlerMgr.FindHandler(sockId);
+                if (info.handler == NULL)
+                {
+                    continue;
+                }
 
                 if (PBSD_FD_ISSET(sockId, &m_fdsWr[1]))
                 {
                     info.handler->AddRef();
+                    CountEvent(sockId);
                     PRO_HANDLER_INFO& info2 = handlers[sockId]; /* insert */
                     info2.handler = info.handler;
                     PRO_SET_BITS(info2.mask, PRO_MASK_WRITE);
@@ -531,6 +553,7 @@ CProSelectReactor::WorkerRun()
                 if (PBSD_FD_ISSET(sockId, &m_fdsRd[1]))
                 {
                     info.handler->AddRef();
+                    CountEvent(sockId);
                     PRO_HANDLER_INFO& info2 = handlers[sockId]; /* insert */
                     info2.handler = info.handler;
                     PRO_SET_BITS(info2.mask, PRO_MASK_READ);
@@ -539,6 +562,7 @@ CProSelectReactor::WorkerRun()
                 if (PBSD_FD_ISSET(sockId, &m_fdsEx[1]))
                 {
                     info.handler->AddRef();
+                    CountEvent(sockId);
                     PRO_HANDLER_INFO& info2 = handlers[sockId]; /* insert */
                     info2.handler = info.handler;
                     PRO_SET_BITS(info2.mask, PRO_MASK_EXCEPTION);
@@ -548,6 +572,8 @@ CProSelectReactor::WorkerRun()
 #endif /* _WIN32 */
         }
 
+        RecordWakeup(waitTime, handlers.size());
+
         auto itr = handlers.begin();
         auto end = handlers.end();
 
@@ -558,23 +584,28 @@ CProSelectReactor::WorkerRun()
 
             if (PRO_BIT_ENABLED(info.mask, PRO_MASK_WRITE))
             {
-                info.handler->OnOutput(sockId);
+                Dispatch(sockId, info.handler, PRO_MASK_WRITE);
                 info.handler->Release();
             }
 
             if (PRO_BIT_ENABLED(info.mask, PRO_MASK_READ))
             {
-                info.handler->OnInput(sockId);
+                Dispatch(sockId, info.handler, PRO_MASK_READ);
                 info.handler->Release();
             }
 
             if (PRO_BIT_ENABLED(info.mask, PRO_MASK_EXCEPTION))
             {
-                info.handler->OnException(sockId);
+                Dispatch(sockId, info.handler, PRO_MASK_EXCEPTION);
                 info.handler->Release();
             }
         } /* end of for () */
+
+        ProcessTimers();
+        DoMigration();
     } /* end of while () */
+
+    ProResetCachedTickCount64();
 }
 
 void
@@ -586,7 +617,7 @@ CProSelectReactor::OnInput(int64_t sockId)
         return;
     }
 
-    if (m_notifyPipe->Roger())
+    if (RogerNotify())
     {
         return;
     }
@@ -61,6 +61,9 @@ public:
             return;
         }
 
+        static const unsigned int s_tag = ProRegisterSgiPoolTag("send_pool");
+        CProSgiPoolTagScope tagScope(s_tag);
+
         CProBuffer* buf2 = new CProBuffer;
         if (!buf2->Resize(size))
         {
@@ -115,7 +115,8 @@ CProServiceHost::Init(IProServiceHostObserver* observer,
         observer->AddRef();
         m_observer    = observer;
         m_reactor     = reactor;
-        m_timerId     = reactor->SetupTimer(this, HEARTBEAT_INTERVAL * 1000, HEARTBEAT_INTERVAL * 1000);
+        m_timerId     = reactor->SetupCoarseTimer(this,
+            HEARTBEAT_INTERVAL * 1000, HEARTBEAT_INTERVAL * 1000, HEARTBEAT_INTERVAL * 1000 / 2);
         m_servicePort = servicePort;
         m_connectTick = ProGetTickCount64();
 
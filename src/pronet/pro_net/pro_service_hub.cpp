@@ -122,7 +122,8 @@ CProServiceHub::Init(IProServiceHubObserver* observer,
         observer->AddRef();
         m_observer = observer;
         m_reactor  = reactor;
-        m_timerId  = reactor->SetupTimer(this, HEARTBEAT_INTERVAL * 1000, HEARTBEAT_INTERVAL * 1000);
+        m_timerId  = reactor->SetupCoarseTimer(this,
+            HEARTBEAT_INTERVAL * 1000, HEARTBEAT_INTERVAL * 1000, HEARTBEAT_INTERVAL * 1000 / 2);
     }
 
     return true;
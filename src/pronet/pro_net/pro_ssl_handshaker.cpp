@@ -127,7 +127,7 @@ CProSslHandshaker::Init(IProSslHandshakerObserver* observer,
         m_unixSocket  = unixSocket;
         m_onWr        = true;
         m_recvFirst   = recvFirst;
-        m_timerId     = reactorTask->SetupTimer(this, (uint64_t)timeoutInSeconds * 1000, 0, 0);
+        m_timerId     = reactorTask->SetupHandlerTimer(this, (uint64_t)timeoutInSeconds * 1000, 0, 0);
     }
 
     return true;
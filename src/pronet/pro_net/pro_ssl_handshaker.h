@@ -63,6 +63,11 @@ private:
 
     virtual ~CProSslHandshaker();
 
+    virtual const char* GetHandlerName() const
+    {
+        return "ssl_handshaker";
+    }
+
     virtual void OnInput(int64_t sockId);
 
     virtual void OnOutput(int64_t sockId);
@@ -28,6 +28,12 @@
 /////////////////////////////////////////////////////////////////////////////
 ////
 
+#define MAX_SENDING_PACKETS   8 /* edge-triggered only */
+#define MAX_RECEIVING_PACKETS 8 /* edge-triggered only */
+
+/////////////////////////////////////////////////////////////////////////////
+////
+
 CProSslTransport*
 CProSslTransport::CreateInstance(size_t recvPoolSize) /* = 0 */
 {
@@ -161,6 +167,8 @@ CProSslTransport::Init(IProTransportObserver* observer,
             return false;
         }
 
+        m_edgeTriggered = reactorTask->IsEdgeTriggered() && SupportsEdgeTrigger();
+
         if (suspendRecv)
         {
             if (!reactorTask->AddHandler(sockId, this, PRO_MASK_WRITE))
@@ -243,7 +251,22 @@ CProSslTransport::OnInput(int64_t sockId)
 void
 CProSslTransport::OnOutput(int64_t sockId)
 {
-    DoSend(sockId);
+    bool tryAgain = false;
+
+    for (int i = 0; i < MAX_SENDING_PACKETS; ++i)
+    {
+        DoSend(sockId, tryAgain);
+        if (!tryAgain)
+        {
+            break;
+        }
+    }
+
+    if (tryAgain)
+    {
+        ReplayOutput(); /* no more edge for what's left */
+    }
+
     DoRecv(sockId); /* !!! */
 }
 
@@ -257,6 +280,8 @@ CProSslTransport::DoRecv(int64_t sockId)
     }
 
     size_t msgSize = 0;
+    bool   more    = false;
+    int    reads   = 0;
 
     do
     {
@@ -280,6 +305,11 @@ CProSslTransport::DoRecv(int64_t sockId)
                 return;
             }
 
+            if (m_edgeTriggered && !PRO_BIT_ENABLED(GetMask(), PRO_MASK_READ))
+            {
+                return; /* suspended */
+            }
+
             size_t idleSize = m_recvPool.ContinuousIdleSize();
             size_t minSize  = (msgSize == 0 || msgSize > idleSize) ? idleSize : msgSize;
 
@@ -327,6 +357,8 @@ CProSslTransport::DoRecv(int64_t sockId)
                 sslCode   = recvSize;
             }
 
+            more = m_edgeTriggered && recvSize > 0; /* until WANT_READ */
+
             if (!error && !m_onWr && (regWr || m_pendingWr || m_requestOnSend))
             {
                 if (m_reactorTask->AddHandler(m_sockId, this, PRO_MASK_WRITE)) /* !!! */
@@ -367,16 +399,25 @@ EXIT:
 
         if (!m_canUpcall)
         {
+            more = false;
             Fini();
             break;
         }
     }
-    while (msgSize > 0); /* read a complete ssl record */
+    while (msgSize > 0 || (more && ++reads < MAX_RECEIVING_PACKETS)); /* read a complete ssl record */
+
+    if (more)
+    {
+        ReplayInput(); /* no more edge for what's left */
+    }
 }
 
 void
-CProSslTransport::DoSend(int64_t sockId)
+CProSslTransport::DoSend(int64_t sockId,
+                         bool&   tryAgain)
 {
+    tryAgain = false;
+
     assert(sockId != -1);
     if (sockId == -1)
     {
@@ -496,9 +537,12 @@ CProSslTransport::DoSend(int64_t sockId)
                     }
                 }
             }
+
+            tryAgain = m_edgeTriggered && m_pendingWr;
         }
         else
         {
+            tryAgain = m_edgeTriggered && sentSize > 0; /* a partial write. until WANT_WRITE */
         }
     }
 
@@ -506,6 +550,7 @@ CProSslTransport::DoSend(int64_t sockId)
 
     if (!m_canUpcall)
     {
+        tryAgain = false;
         Fini();
     }
 }
@@ -51,6 +51,11 @@ public:
 
     virtual PRO_SSL_SUITE_ID GetSslSuite(char suiteName[64]) const;
 
+    virtual const char* GetHandlerName() const
+    {
+        return "ssl_transport";
+    }
+
 private:
 
     CProSslTransport(size_t recvPoolSize); /* = 0 */
@@ -63,7 +68,10 @@ private:
 
     void DoRecv(int64_t sockId);
 
-    void DoSend(int64_t sockId);
+    void DoSend(
+        int64_t sockId,
+        bool&   tryAgain
+        );
 
 private:
 
@@ -129,7 +129,7 @@ CProTcpHandshaker::Init(IProTcpHandshakerObserver* observer,
         m_reactorTask = reactorTask;
         m_sockId      = sockId;
         m_unixSocket  = unixSocket;
-        m_timerId     = reactorTask->SetupTimer(this, (uint64_t)timeoutInSeconds * 1000, 0, 0);
+        m_timerId     = reactorTask->SetupHandlerTimer(this, (uint64_t)timeoutInSeconds * 1000, 0, 0);
     }
 
     return true;
@@ -61,6 +61,11 @@ private:
 
     virtual ~CProTcpHandshaker();
 
+    virtual const char* GetHandlerName() const
+    {
+        return "tcp_handshaker";
+    }
+
     virtual void OnInput(int64_t sockId);
 
     virtual void OnOutput(int64_t sockId);
@@ -25,6 +25,7 @@
 #include "pro_tp_reactor_task.h"
 #include "../pro_util/pro_bsd_wrapper.h"
 #include "../pro_util/pro_memory_pool.h"
+#include "../pro_util/pro_stl.h"
 #include "../pro_util/pro_thread_mutex.h"
 #include "../pro_util/pro_z.h"
 
@@ -33,6 +34,8 @@
 
 #define DEFAULT_RECV_POOL_SIZE (1024 * 65)
 #define MAX_SENDING_PACKETS    8
+#define MAX_RECEIVING_PACKETS  8 /* edge-triggered, or with reactor buffers */
+#define MAX_RECV_BACKLOG       (1024 * 1024) /* more than a reactor has in flight */
 
 #if !defined(_WIN32)
 
@@ -64,16 +67,23 @@ CProTcpTransport::CProTcpTransport(bool   recvFdMode,
 m_recvFdMode(recvFdMode),
 m_recvPoolSize(recvPoolSize > 0 ? recvPoolSize : DEFAULT_RECV_POOL_SIZE)
 {
-    m_observer      = NULL;
-    m_reactorTask   = NULL;
-    m_sockId        = -1;
-    m_onWr          = false;
-    m_pendingWr     = false;
-    m_requestOnSend = false;
-    m_sendingFd     = -1;
-    m_timerId       = 0;
-
-    m_canUpcall     = true;
+    m_observer       = NULL;
+    m_reactorTask    = NULL;
+    m_sockId         = -1;
+    m_edgeTriggered  = false;
+    m_recvBuffered   = false;
+    m_recvPending    = false;
+    m_recvHeld       = false;
+    m_recvBacklogPos = 0;
+    m_recvEnd        = false;
+    m_recvEndError   = 0;
+    m_onWr           = false;
+    m_pendingWr      = false;
+    m_requestOnSend  = false;
+    m_sendingFd      = -1;
+    m_timerId        = 0;
+
+    m_canUpcall      = true;
 
     memset(&m_localAddr , 0, sizeof(pbsd_sockaddr_in));
     memset(&m_remoteAddr, 0, sizeof(pbsd_sockaddr_in));
@@ -186,6 +196,9 @@ CProTcpTransport::Init(IProTransportObserver* observer,
             return false;
         }
 
+        m_edgeTriggered = reactorTask->IsEdgeTriggered() && SupportsEdgeTrigger();
+        m_recvBuffered  = reactorTask->HasRecvBuffers() && !m_recvFdMode;
+
         if (!suspendRecv && !reactorTask->AddHandler(sockId, this, PRO_MASK_READ))
         {
             return false;
@@ -448,6 +461,11 @@ CProTcpTransport::ResumeRecv()
     }
 
     m_reactorTask->AddHandler(m_sockId, this, PRO_MASK_READ);
+
+    if (m_recvPending || m_recvBacklogPos < m_recvBacklog.size() || m_recvEnd)
+    {
+        m_reactorTask->ReplayHandler(m_sockId, this, PRO_MASK_READ); /* what's held back */
+    }
 }
 
 void
@@ -462,7 +480,7 @@ CProTcpTransport::StartHeartbeat()
 
     if (m_timerId == 0)
     {
-        m_timerId = m_reactorTask->SetupHeartbeatTimer(this, 0);
+        m_timerId = m_reactorTask->SetupHandlerHeartbeatTimer(this, 0);
     }
 }
 
@@ -487,15 +505,253 @@ CProTcpTransport::OnInput(int64_t sockId)
     {
         OnInputFd(sockId);
     }
+    else if (m_recvBuffered)
+    {
+        OnInputBacklog(sockId); /* after OnInputBuffer(), or a replay */
+    }
     else
     {
         OnInputData(sockId);
     }
 }
 
+void
+CProTcpTransport::OnInputBuffer(int64_t     sockId,
+                                const void* buf,
+                                size_t      size,
+                                int         errorCode)
+{
+    assert(sockId != -1);
+    if (sockId == -1)
+    {
+        return;
+    }
+
+    {
+        CProThreadMutexGuard mon(m_lock);
+
+        if (m_observer == NULL || m_reactorTask == NULL)
+        {
+            return;
+        }
+
+        if (sockId != m_sockId || m_recvEnd)
+        {
+            return;
+        }
+
+        if (size == 0)
+        {
+            m_recvEnd      = true;
+            m_recvEndError = errorCode;
+
+            return;
+        }
+
+        /*
+         * into the pool, unless suspended or something is held back. The
+         * upcall is in OnInput(), once for the buffers of a wakeup
+         */
+        if (m_recvBacklogPos == m_recvBacklog.size() && PRO_BIT_ENABLED(GetMask(), PRO_MASK_READ))
+        {
+            while (size > 0) /* twice at most, across the end of the pool */
+            {
+                size_t idleSize = m_recvPool.ContinuousIdleSize();
+                if (idleSize == 0)
+                {
+                    break;
+                }
+
+                if (idleSize > size)
+                {
+                    idleSize = size;
+                }
+
+                memcpy(m_recvPool.ContinuousIdleBuf(), buf, idleSize);
+                m_recvPool.Fill(idleSize);
+                m_recvPending = true;
+
+                buf   = (const char*)buf + idleSize;
+                size -= idleSize;
+            }
+        }
+
+        /*
+         * The reactor stops reading at its next re-arm, and the input stays
+         * in the socket until this has gone, see HoldsRecvBuffers(). What
+         * the recv has in flight still comes
+         */
+        if (size > 0)
+        {
+            if (m_recvBacklog.size() + size > MAX_RECV_BACKLOG)
+            {
+                m_recvEnd      = true;
+                m_recvEndError = -1;
+            }
+            else
+            {
+                m_recvBacklog.append((const char*)buf, size);
+            }
+
+            m_recvHeld = true;
+        }
+    }
+}
+
+void
+CProTcpTransport::OnInputBacklog(int64_t sockId)
+{
+    bool tryAgain = false;
+
+    for (int i = 0; i < MAX_RECEIVING_PACKETS; ++i)
+    {
+        OnInputBacklog(sockId, tryAgain);
+        if (!tryAgain)
+        {
+            break;
+        }
+    }
+
+    if (tryAgain)
+    {
+        ReplayInput(); /* the rest in the next round */
+    }
+}
+
+void
+CProTcpTransport::OnInputBacklog(int64_t sockId,
+                                 bool&   tryAgain)
+{
+    tryAgain = false;
+
+    assert(sockId != -1);
+    if (sockId == -1)
+    {
+        return;
+    }
+
+    IProTransportObserver* observer  = NULL;
+    int                    recvSize  = 0;
+    int                    errorCode = 0;
+    int                    sslCode   = 0;
+    bool                   more      = false;
+
+    {
+        CProThreadMutexGuard mon(m_lock);
+
+        if (m_observer == NULL || m_reactorTask == NULL)
+        {
+            return;
+        }
+
+        if (sockId != m_sockId)
+        {
+            return;
+        }
+
+        if (!PRO_BIT_ENABLED(GetMask(), PRO_MASK_READ))
+        {
+            return; /* suspended. Replayed by ResumeRecv() */
+        }
+
+        size_t backlogSize = m_recvBacklog.size() - m_recvBacklogPos;
+        size_t idleSize    = m_recvPool.ContinuousIdleSize();
+        if (idleSize > backlogSize)
+        {
+            idleSize = backlogSize;
+        }
+
+        if (idleSize > 0)
+        {
+            memcpy(m_recvPool.ContinuousIdleBuf(), m_recvBacklog.data() + m_recvBacklogPos, idleSize);
+            m_recvPool.Fill(idleSize);
+            m_recvPending = true;
+
+            m_recvBacklogPos += idleSize;
+            if (m_recvBacklogPos == m_recvBacklog.size())
+            {
+                m_recvBacklog.clear();
+                m_recvBacklogPos = 0;
+                m_recvHeld       = false; /* read again from the next re-arm */
+            }
+        }
+
+        if (m_recvPending)
+        {
+            m_recvPending = false;
+            recvSize      = 1; /* some */
+
+            more = m_recvBacklogPos < m_recvBacklog.size() || m_recvEnd;
+        }
+        else if (backlogSize > 0)
+        {
+            recvSize  = -1; /* the pool is full */
+            errorCode = -1;
+        }
+        else if (m_recvEnd)
+        {
+            recvSize  = m_recvEndError != 0 ? -1 : 0;
+            errorCode = m_recvEndError;
+        }
+        else
+        {
+            return;
+        }
+
+        m_observer->AddRef();
+        observer = m_observer;
+    }
+
+    if (m_canUpcall)
+    {
+        if (recvSize > 0)
+        {
+            observer->OnRecv(this, &m_remoteAddr);
+
+            tryAgain = more;
+        }
+        else
+        {
+            m_canUpcall = false;
+            observer->OnClose(this, errorCode, sslCode);
+        }
+    }
+
+    observer->Release();
+
+    if (!m_canUpcall)
+    {
+        tryAgain = false;
+        Fini();
+    }
+}
+
 void
 CProTcpTransport::OnInputData(int64_t sockId)
 {
+    bool tryAgain = false;
+
+    for (int i = 0; i < MAX_RECEIVING_PACKETS; ++i) /* until EAGAIN if edge-triggered */
+    {
+        OnInputData(sockId, tryAgain);
+        if (!tryAgain)
+        {
+            break;
+        }
+    }
+
+    if (tryAgain)
+    {
+        ReplayInput(); /* no more edge for what's left */
+    }
+}
+
+void
+CProTcpTransport::OnInputData(int64_t sockId,
+                              bool&   tryAgain)
+{
+    tryAgain = false;
+
     assert(sockId != -1);
     if (sockId == -1)
     {
@@ -520,6 +776,11 @@ CProTcpTransport::OnInputData(int64_t sockId)
             return;
         }
 
+        if (m_edgeTriggered && !PRO_BIT_ENABLED(GetMask(), PRO_MASK_READ))
+        {
+            return; /* suspended */
+        }
+
         size_t idleSize = m_recvPool.ContinuousIdleSize();
 
         assert(idleSize > 0);
@@ -563,6 +824,8 @@ EXIT:
         {
             observer->OnRecv(this, &m_remoteAddr);
             assert(m_recvPool.ContinuousIdleSize() > 0);
+
+            tryAgain = m_edgeTriggered;
         }
         else if (
             (recvSize < 0 && errorCode != PBSD_EWOULDBLOCK)
@@ -582,6 +845,7 @@ EXIT:
 
     if (!m_canUpcall)
     {
+        tryAgain = false;
         Fini();
     }
 }
@@ -696,6 +960,11 @@ CProTcpTransport::OnOutput(int64_t sockId)
         }
     }
 
+    if (tryAgain && m_edgeTriggered)
+    {
+        ReplayOutput(); /* no more edge for what's left */
+    }
+
     if (m_pendingWr)
     {
         return;
@@ -855,6 +1124,7 @@ CProTcpTransport::OnOutput(int64_t sockId,
         }
         else
         {
+            tryAgain = m_edgeTriggered && sentSize > 0; /* a partial write. until EAGAIN */
         }
     }
 
@@ -862,10 +1132,40 @@ CProTcpTransport::OnOutput(int64_t sockId,
 
     if (!m_canUpcall)
     {
+        tryAgain = false;
         Fini();
     }
 }
 
+void
+CProTcpTransport::ReplayInput()
+{
+    CProThreadMutexGuard mon(m_lock);
+
+    if (m_observer == NULL || m_reactorTask == NULL)
+    {
+        return;
+    }
+
+    m_reactorTask->ReplayHandler(m_sockId, this, PRO_MASK_READ);
+}
+
+void
+CProTcpTransport::ReplayOutput()
+{
+    CProThreadMutexGuard mon(m_lock);
+
+    if (m_observer == NULL || m_reactorTask == NULL)
+    {
+        return;
+    }
+
+    if (m_onWr)
+    {
+        m_reactorTask->ReplayHandler(m_sockId, this, PRO_MASK_WRITE);
+    }
+}
+
 void
 CProTcpTransport::OnError(int64_t sockId,
                           int     errorCode)
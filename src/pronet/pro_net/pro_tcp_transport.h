@@ -25,6 +25,7 @@
 #include "pro_send_pool.h"
 #include "../pro_util/pro_bsd_wrapper.h"
 #include "../pro_util/pro_memory_pool.h"
+#include "../pro_util/pro_stl.h"
 #include "../pro_util/pro_thread_mutex.h"
 #include "../pro_util/pro_z.h"
 
@@ -130,6 +131,31 @@ public:
 
     bool SendFd(const PRO_SERVICE_PACKET& s2cPacket);
 
+    virtual bool SupportsEdgeTrigger() const
+    {
+        return !m_recvFdMode;
+    }
+
+    virtual bool SupportsMigration() const
+    {
+        return !m_recvBuffered; /* a recv in flight can't move */
+    }
+
+    virtual bool SupportsRecvBuffers() const
+    {
+        return m_recvBuffered;
+    }
+
+    virtual bool HoldsRecvBuffers() const
+    {
+        return m_recvHeld;
+    }
+
+    virtual const char* GetHandlerName() const
+    {
+        return "tcp_transport";
+    }
+
 protected:
 
     CProTcpTransport(
@@ -141,6 +167,13 @@ protected:
 
     virtual void OnInput(int64_t sockId);
 
+    virtual void OnInputBuffer(
+        int64_t     sockId,
+        const void* buf,
+        size_t      size,
+        int         errorCode
+        );
+
     virtual void OnOutput(int64_t sockId);
 
     virtual void OnError(
@@ -157,6 +190,18 @@ protected:
 
     void OnInputData(int64_t sockId);
 
+    void OnInputData(
+        int64_t sockId,
+        bool&   tryAgain
+        );
+
+    void OnInputBacklog(int64_t sockId);
+
+    void OnInputBacklog(
+        int64_t sockId,
+        bool&   tryAgain
+        );
+
     void OnInputFd(int64_t sockId);
 
     void OnOutput(
@@ -164,6 +209,10 @@ protected:
         bool&   tryAgain
         );
 
+    void ReplayInput();
+
+    void ReplayOutput();
+
 protected:
 
     const bool              m_recvFdMode;
@@ -171,6 +220,14 @@ protected:
     IProTransportObserver*  m_observer;
     CProTpReactorTask*      m_reactorTask;
     int64_t                 m_sockId;
+    bool                    m_edgeTriggered;
+    bool                    m_recvBuffered;   /* read by the reactor */
+    bool                    m_recvPending;    /* in the pool, not upcalled yet */
+    volatile bool           m_recvHeld;       /* a backlog, see HoldsRecvBuffers() */
+    CProStlString           m_recvBacklog;    /* with m_recvBuffered only */
+    size_t                  m_recvBacklogPos;
+    bool                    m_recvEnd;
+    int                     m_recvEndError;
     pbsd_sockaddr_in        m_localAddr;
     pbsd_sockaddr_in        m_remoteAddr;
     bool                    m_onWr;
@@ -20,9 +20,12 @@
 #include "pro_base_reactor.h"
 #include "pro_epoll_reactor.h"
 #include "pro_event_handler.h"
+#include "pro_io_uring_reactor.h"
 #include "pro_net.h"
 #include "pro_select_reactor.h"
+#include "../pro_shared/pro_shared.h"
 #include "../pro_util/pro_memory_pool.h"
+#include "../pro_util/pro_stat.h"
 #include "../pro_util/pro_stl.h"
 #include "../pro_util/pro_thread.h"
 #include "../pro_util/pro_thread_mutex.h"
@@ -32,12 +35,125 @@
 /////////////////////////////////////////////////////////////////////////////
 ////
 
+#define BALANCE_INTERVAL     1000   /* ms */
+#define BALANCE_MIN_CPU_TIME 100000 /* us per interval, 10% of a cpu */
+#define BALANCE_MIN_EVENTS   1000   /* per interval */
+#define SLOW_CALLS_SHOWN     4
+
+static
+PRO_REACTOR_BACKEND
+ResolveBackend_i(PRO_REACTOR_BACKEND backend)
+{
+#if defined(PRO_HAS_IO_URING)
+    if (backend == PRO_REACTOR_IO_URING)
+    {
+        return PRO_REACTOR_IO_URING;
+    }
+#endif
+#if defined(PRO_HAS_EPOLL)
+    if (backend != PRO_REACTOR_SELECT)
+    {
+        return PRO_REACTOR_EPOLL;
+    }
+#endif
+
+    return PRO_REACTOR_SELECT;
+}
+
+static
+CProBaseReactor*
+CreateReactorImpl_i(PRO_REACTOR_BACKEND backend,
+                    bool                edgeTriggered)
+{
+#if defined(PRO_HAS_IO_URING)
+    if (backend == PRO_REACTOR_IO_URING)
+    {
+        return new CProIoUringReactor;
+    }
+#endif
 #if defined(PRO_HAS_EPOLL)
-typedef CProEpollReactor  CProReactorImpl;
-#else
-typedef CProSelectReactor CProReactorImpl;
+    if (backend == PRO_REACTOR_EPOLL)
+    {
+        return new CProEpollReactor(edgeTriggered);
+    }
 #endif
 
+    return new CProSelectReactor;
+}
+
+static
+bool
+ParseCpus_i(const char*                  cpuList, /* "0-7,16" */
+            CProStlVector<unsigned int>& cpus)
+{
+    cpus.clear();
+
+    if (cpuList == NULL)
+    {
+        return true;
+    }
+
+    const char* p = cpuList;
+
+    while (*p != '\0')
+    {
+        if (*p == ',' || *p == ' ')
+        {
+            ++p;
+            continue;
+        }
+
+        if (*p < '0' || *p > '9')
+        {
+            return false;
+        }
+
+        char*        q     = NULL;
+        unsigned int first = (unsigned int)strtoul(p, &q, 10);
+        unsigned int last  = first;
+        p = q;
+
+        if (*p == '-')
+        {
+            ++p;
+            if (*p < '0' || *p > '9')
+            {
+                return false;
+            }
+
+            last = (unsigned int)strtoul(p, &q, 10);
+            p = q;
+        }
+
+        if (last < first || last - first >= 1024)
+        {
+            return false;
+        }
+
+        for (unsigned int cpu = first; cpu <= last; ++cpu)
+        {
+            cpus.push_back(cpu);
+        }
+    }
+
+    return true;
+}
+
+static
+const char*
+GetBackendName_i(PRO_REACTOR_BACKEND backend)
+{
+    switch (backend)
+    {
+    case PRO_REACTOR_IO_URING:
+        return "io_uring";
+    case PRO_REACTOR_EPOLL:
+        return "epoll";
+    default:
+        return "select";
+    }
+}
+
 /////////////////////////////////////////////////////////////////////////////
 ////
 
@@ -47,7 +163,23 @@ CProTpReactorTask::CProTpReactorTask()
     m_acceptThreadCount = 0;
     m_ioThreadCount     = 0;
     m_curThreadCount    = 0;
+    m_threadIndex       = 0;
+    m_backend           = PRO_REACTOR_DEFAULT;
+    m_balance           = PRO_BALANCE_HANDLERS;
+    m_edgeTriggered     = false;
+    m_recvBuffers       = false;
+    m_reusePortAccept   = false;
+    m_migrateHandlers   = false;
+    m_cpuTimeLoad       = false;
+    m_busyPollTime      = 0;
+    m_busyPollSockets   = false;
+    m_loopStats         = false;
+    m_slowCallbackTime  = 0;
+    m_handlerTimers     = false;
     m_wantExit          = false;
+    m_balanceTimerId    = 0;
+    m_trimTimerId       = 0;
+    m_migrationCount    = 0;
 }
 
 CProTpReactorTask::~CProTpReactorTask()
@@ -56,12 +188,23 @@ CProTpReactorTask::~CProTpReactorTask()
 }
 
 bool
-CProTpReactorTask::Start(unsigned int ioThreadCount)
+CProTpReactorTask::Start(const PRO_REACTOR_CONFIG& config)
 {{
     CProThreadMutexGuard mon(m_lockAtom);
 
-    assert(ioThreadCount > 0);
-    if (ioThreadCount == 0)
+    assert(config.ioThreadCount > 0);
+    if (config.ioThreadCount == 0)
+    {
+        return false;
+    }
+
+    CProStlVector<unsigned int> ioCpus;
+    CProStlVector<unsigned int> acceptCpus;
+    CProStlVector<unsigned int> timerCpus;
+
+    if (!ParseCpus_i(config.ioThreadCpus    , ioCpus)     ||
+        !ParseCpus_i(config.acceptThreadCpus, acceptCpus) ||
+        !ParseCpus_i(config.timerThreadCpus , timerCpus))
     {
         return false;
     }
@@ -76,69 +219,129 @@ CProTpReactorTask::Start(unsigned int ioThreadCount)
         }
 
         m_acceptThreadCount = 1;
-        m_ioThreadCount     = ioThreadCount; /* for StopMe() */
+        m_ioThreadCount     = config.ioThreadCount; /* for StopMe() */
+        m_backend           = ResolveBackend_i(config.backend);
+        m_edgeTriggered     = config.edgeTriggered && m_backend == PRO_REACTOR_EPOLL;
+        m_recvBuffers       = m_backend == PRO_REACTOR_IO_URING; /* and all the I/O reactors have them */
+#if defined(PRO_HAS_REUSEPORT)
+        m_reusePortAccept   = config.reusePortAccept;
+#endif
+        m_balance           = config.balance;
+        m_migrateHandlers   = config.balance == PRO_BALANCE_LOAD && config.migrateHandlers;
+        m_cpuTimeLoad       = ProGetThreadCpuTime(ProGetThreadId()) >= 0;
+        m_busyPollTime      = config.busyPollTime;
+        m_busyPollSockets   = config.busyPollTime > 0 && config.busyPollSockets;
+        m_loopStats         = config.loopStats;
+        m_slowCallbackTime  = config.slowCallbackTime;
+        m_handlerTimers     = config.handlerTimers;
+        m_acceptCpus        = acceptCpus;
+        m_ioCpus            = ioCpus;
+
+        m_ioReactors.resize(m_ioThreadCount, NULL);
+        m_ioLoads.resize(m_ioThreadCount);
 
         /*
-         * reactors
+         * threads. Every thread creates its own reactor, see Svc()
          */
         {
-            m_acceptReactor = new CProReactorImpl;
-            if (!m_acceptReactor->Init())
-            {
-                goto EXIT;
-            }
+            int i;
 
-            for (int i = 0; i < (int)m_ioThreadCount; ++i)
+            for (i = 0; i < (int)(m_acceptThreadCount + m_ioThreadCount); ++i)
             {
-                CProBaseReactor* reactor = new CProReactorImpl;
-                if (!reactor->Init())
+                if (!Spawn(false))
                 {
-                    delete reactor;
                     break;
                 }
+            }
+
+            assert(i == (int)(m_acceptThreadCount + m_ioThreadCount));
+            if (i != (int)(m_acceptThreadCount + m_ioThreadCount))
+            {
+                goto EXIT;
+            }
+        }
 
-                m_ioReactors.push_back(reactor);
+        /*
+         * timer factories
+         */
+        {
+            int timerCpu   = -1;
+            int mmTimerCpu = -1;
+            if (timerCpus.size() > 0)
+            {
+                timerCpu   = (int)timerCpus[0];
+                mmTimerCpu = (int)timerCpus[1 % timerCpus.size()];
             }
 
-            assert(m_ioReactors.size() == m_ioThreadCount);
-            if (m_ioReactors.size() != m_ioThreadCount)
+            m_timerFactory.SetLoopStats(m_loopStats, m_slowCallbackTime);
+            m_mmTimerFactory.SetLoopStats(m_loopStats, m_slowCallbackTime);
+            m_timerFactory.SetTimingWheel(config.timingWheel);
+            m_mmTimerFactory.SetTimingWheel(config.timingWheel);
+
+            if (!m_timerFactory.Start(false, timerCpu) || !m_mmTimerFactory.Start(true, mmTimerCpu))
             {
                 goto EXIT;
             }
         }
 
+        while (m_curThreadCount < m_acceptThreadCount + m_ioThreadCount)
+        {
+            m_initCond.Wait(&m_lock);
+        }
+
         /*
-         * threads
+         * reactors
          */
         {
-            int i;
+            int i = 0;
+            int c = (int)m_ioReactors.size();
 
-            for (i = 0; i < (int)(m_acceptThreadCount + m_ioThreadCount); ++i)
+            for (; i < c; ++i)
             {
-                if (!Spawn(false))
+                if (m_ioReactors[i] == NULL)
                 {
                     break;
                 }
             }
 
-            assert(i == (int)(m_acceptThreadCount + m_ioThreadCount));
-            if (i != (int)(m_acceptThreadCount + m_ioThreadCount))
+            assert(m_acceptReactor != NULL && i == c);
+            if (m_acceptReactor == NULL || i != c)
             {
                 goto EXIT;
             }
         }
 
         /*
-         * timer factories
+         * load sampling
          */
-        if (!m_timerFactory.Start(false) || !m_mmTimerFactory.Start(true))
+        if (m_balance == PRO_BALANCE_LOAD)
         {
-            goto EXIT;
+            for (int i = 0; i < (int)m_ioLoads.size(); ++i)
+            {
+                m_ioLoads[i].cpuTime = ProGetThreadCpuTime(m_ioLoads[i].threadId);
+            }
+
+            m_balanceTimerId = m_timerFactory.SetupTimer(
+                this, BALANCE_INTERVAL, BALANCE_INTERVAL, 0);
+            if (m_balanceTimerId == 0)
+            {
+                goto EXIT;
+            }
         }
 
-        while (m_curThreadCount < m_acceptThreadCount + m_ioThreadCount)
+        /*
+         * pool trimming
+         */
+        if (config.poolTrimInterval > 0)
         {
-            m_initCond.Wait(&m_lock);
+            uint64_t trimInterval = (uint64_t)config.poolTrimInterval * 1000;
+
+            m_trimTimerId = m_timerFactory.SetupCoarseTimer(
+                this, trimInterval, trimInterval, trimInterval / 2);
+            if (m_trimTimerId == 0)
+            {
+                goto EXIT;
+            }
         }
     }
 
@@ -172,6 +375,8 @@ CProTpReactorTask::StopMe()
 
         assert(m_threadIds.find(ProGetThreadId()) == m_threadIds.end()); /* deadlock */
 
+        m_timerFactory.CancelTimer(m_balanceTimerId);
+        m_timerFactory.CancelTimer(m_trimTimerId);
         m_wantExit = true;
 
         if (m_acceptReactor != NULL)
@@ -184,7 +389,10 @@ CProTpReactorTask::StopMe()
 
         for (; i < c; ++i)
         {
-            m_ioReactors[i]->Fini();
+            if (m_ioReactors[i] != NULL)
+            {
+                m_ioReactors[i]->Fini();
+            }
         }
     }
 
@@ -206,12 +414,31 @@ CProTpReactorTask::StopMe()
         }
 
         m_ioReactors.clear();
+        m_ioLoads.clear();
 
         m_acceptReactor     = NULL;
         m_acceptThreadCount = 0;
         m_ioThreadCount     = 0;
         m_curThreadCount    = 0;
+        m_threadIndex       = 0;
+        m_backend           = PRO_REACTOR_DEFAULT;
+        m_balance           = PRO_BALANCE_HANDLERS;
+        m_edgeTriggered     = false;
+        m_recvBuffers       = false;
+        m_reusePortAccept   = false;
+        m_migrateHandlers   = false;
+        m_cpuTimeLoad       = false;
+        m_busyPollTime      = 0;
+        m_busyPollSockets   = false;
+        m_loopStats         = false;
+        m_slowCallbackTime  = 0;
+        m_handlerTimers     = false;
         m_wantExit          = false;
+        m_balanceTimerId    = 0;
+        m_trimTimerId       = 0;
+        m_migrationCount    = 0;
+        m_acceptCpus.clear();
+        m_ioCpus.clear();
     }
 }
 
@@ -253,6 +480,46 @@ CProTpReactorTask::AddHandler(int64_t           sockId,
         }
 
         CProBaseReactor* ioReactor = handler->GetReactor();
+        if (ioReactor == NULL && m_reusePortAccept)
+        {
+            /*
+             * keep the accepted connections on the thread that accepted them
+             */
+            auto itr = m_threadId2IoReactor.find(ProGetThreadId());
+            if (itr != m_threadId2IoReactor.end())
+            {
+                ioReactor = itr->second;
+            }
+        }
+
+        if (ioReactor == NULL && m_balance == PRO_BALANCE_LOAD &&
+            !PRO_BIT_ENABLED(mask, PRO_MASK_ACCEPT))
+        {
+            int    best      = 0;
+            size_t bestCount = m_ioReactors[0]->GetHandlerCount();
+
+            for (int i = 1; i < (int)m_ioReactors.size(); ++i)
+            {
+                const PRO_IO_LOAD& load     = m_ioLoads[i];
+                const PRO_IO_LOAD& bestLoad = m_ioLoads[best];
+                size_t             count    = m_ioReactors[i]->GetHandlerCount();
+
+                if (load.load + load.bias < bestLoad.load + bestLoad.bias ||
+                    (load.load + load.bias == bestLoad.load + bestLoad.bias && count < bestCount))
+                {
+                    best      = i;
+                    bestCount = count;
+                }
+            }
+
+            /*
+             * until the next sample, assume an average share for the new
+             * handler, so that a burst of them doesn't land on one thread
+             */
+            m_ioLoads[best].bias += m_ioLoads[best].load / (int64_t)bestCount + 1;
+            ioReactor = m_ioReactors[best];
+        }
+
         if (ioReactor == NULL)
         {
             int i = 0;
@@ -283,6 +550,14 @@ CProTpReactorTask::AddHandler(int64_t           sockId,
         }
         else
         {
+#if defined(SO_BUSY_POLL)
+            if (m_busyPollSockets && handler->GetReactor() == NULL)
+            {
+                int option = (int)m_busyPollTime;
+                pbsd_setsockopt(sockId, SOL_SOCKET, SO_BUSY_POLL, &option, sizeof(int));
+            }
+#endif
+
             ret = ioReactor->AddHandler(sockId, handler, mask);
             if (ret)
             {
@@ -300,6 +575,71 @@ CProTpReactorTask::AddHandler(int64_t           sockId,
     return ret;
 }
 
+bool
+CProTpReactorTask::AddAcceptShard(int64_t           sockId,
+                                  CProEventHandler* handler,
+                                  unsigned int      shard)
+{
+    assert(sockId != -1);
+    assert(handler != NULL);
+    if (sockId == -1 || handler == NULL)
+    {
+        return false;
+    }
+
+    bool ret = false;
+
+    {
+        CProThreadMutexGuard mon(m_lock);
+
+        if (m_acceptThreadCount + m_ioThreadCount == 0                ||
+            m_curThreadCount != m_acceptThreadCount + m_ioThreadCount ||
+            m_wantExit)
+        {
+            return false;
+        }
+
+        assert(shard < m_ioThreadCount);
+        if (shard >= m_ioThreadCount)
+        {
+            return false;
+        }
+
+        /*
+         * The handler's reactor and mask are left alone. They belong to
+         * the accept reactor
+         */
+        ret = m_ioReactors[shard]->AddHandler(sockId, handler, PRO_MASK_ACCEPT);
+    }
+
+    return ret;
+}
+
+void
+CProTpReactorTask::RemoveAcceptShard(int64_t      sockId,
+                                     unsigned int shard)
+{
+    if (sockId == -1)
+    {
+        return;
+    }
+
+    {
+        CProThreadMutexGuard mon(m_lock);
+
+        if (m_acceptThreadCount + m_ioThreadCount == 0 ||
+            m_curThreadCount != m_acceptThreadCount + m_ioThreadCount)
+        {
+            return;
+        }
+
+        if (shard < m_ioThreadCount)
+        {
+            m_ioReactors[shard]->RemoveHandler(sockId, PRO_MASK_ACCEPT);
+        }
+    }
+}
+
 void
 CProTpReactorTask::RemoveHandler(int64_t           sockId,
                                  CProEventHandler* handler,
@@ -349,13 +689,17 @@ CProTpReactorTask::RemoveHandler(int64_t           sockId,
     }
 }
 
-uint64_t
-CProTpReactorTask::SetupTimer(IProOnTimer* onTimer,
-                              uint64_t     firstDelay,
-                              uint64_t     period,
-                              int64_t      userData) /* = 0 */
+void
+CProTpReactorTask::ReplayHandler(int64_t           sockId,
+                                 CProEventHandler* handler,
+                                 unsigned long     mask)
 {
-    uint64_t timerId = 0;
+    mask &= (PRO_MASK_WRITE | PRO_MASK_READ);
+
+    if (sockId == -1 || handler == NULL || mask == 0)
+    {
+        return;
+    }
 
     {
         CProThreadMutexGuard mon(m_lock);
@@ -364,20 +708,29 @@ CProTpReactorTask::SetupTimer(IProOnTimer* onTimer,
             m_curThreadCount != m_acceptThreadCount + m_ioThreadCount ||
             m_wantExit)
         {
-            return 0;
+            return;
         }
 
-        timerId = m_timerFactory.SetupTimer(onTimer, firstDelay, period, userData);
+        CProBaseReactor* ioReactor = handler->GetReactor();
+        if (ioReactor != NULL)
+        {
+            ioReactor->ReplayHandler(sockId, mask);
+        }
     }
-
-    return timerId;
 }
 
-uint64_t
-CProTpReactorTask::SetupHeartbeatTimer(IProOnTimer* onTimer,
-                                       int64_t      userData) /* = 0 */
+void
+CProTpReactorTask::MigrateHandler(int64_t           sockId,
+                                  CProEventHandler* handler,
+                                  CProBaseReactor*  from)
 {
-    uint64_t timerId = 0;
+    assert(sockId != -1);
+    assert(handler != NULL);
+    assert(from != NULL);
+    if (sockId == -1 || handler == NULL || from == NULL)
+    {
+        return;
+    }
 
     {
         CProThreadMutexGuard mon(m_lock);
@@ -386,40 +739,303 @@ CProTpReactorTask::SetupHeartbeatTimer(IProOnTimer* onTimer,
             m_curThreadCount != m_acceptThreadCount + m_ioThreadCount ||
             m_wantExit)
         {
-            return 0;
+            return;
         }
 
-        timerId = m_timerFactory.SetupHeartbeatTimer(onTimer, userData);
-    }
+        /*
+         * The handler changes its registration through us only. Then it's
+         * still on "from" with this mask, unless it has been removed
+         */
+        unsigned long mask = handler->GetMask() & ~PRO_MASK_ACCEPT;
+        if (handler->GetReactor() != from || mask == 0)
+        {
+            return;
+        }
 
-    return timerId;
-}
+        int to = -1;
 
-bool
-CProTpReactorTask::UpdateHeartbeatTimers(unsigned int htbtIntervalInSeconds)
-{
-    bool ret = false;
+        for (int i = 0; i < (int)m_ioReactors.size(); ++i)
+        {
+            if (m_ioReactors[i] == from)
+            {
+                continue;
+            }
 
-    {
-        CProThreadMutexGuard mon(m_lock);
+            if (to < 0 ||
+                m_ioLoads[i].load + m_ioLoads[i].bias < m_ioLoads[to].load + m_ioLoads[to].bias)
+            {
+                to = i;
+            }
+        }
 
-        if (m_acceptThreadCount + m_ioThreadCount == 0                ||
-            m_curThreadCount != m_acceptThreadCount + m_ioThreadCount ||
-            m_wantExit)
+        if (to < 0)
         {
-            return false;
+            return;
         }
 
-        ret = m_timerFactory.UpdateHeartbeatTimers(htbtIntervalInSeconds);
-    }
+        from->RemoveHandler(sockId, mask);
 
-    return ret;
-}
+        if (m_ioReactors[to]->AddHandler(sockId, handler, mask))
+        {
+            handler->SetReactor(m_ioReactors[to]);
+            ++m_migrationCount;
 
-void
-CProTpReactorTask::CancelTimer(uint64_t timerId)
-{
-    CProThreadMutexGuard mon(m_lock);
+            /*
+             * its timers go along, to keep off its new callbacks
+             */
+            if (m_handlerTimers)
+            {
+                int64_t htbtPeriod = (int64_t)m_timerFactory.GetHeartbeatInterval() * 1000;
+                from->MoveTimers(handler, m_ioReactors[to], htbtPeriod);
+            }
+        }
+        else if (!from->AddHandler(sockId, handler, mask))
+        {
+            handler->RemoveMask(mask);
+            handler->SetReactor(NULL);
+        }
+        else
+        {
+        }
+    }
+}
+
+void
+CProTpReactorTask::OnTimer(void*    factory,
+                           uint64_t timerId,
+                           int64_t  tick,
+                           int64_t  userData)
+{
+    bool trim = false;
+
+    {
+        CProThreadMutexGuard mon(m_lock);
+
+        trim = !m_wantExit && timerId != 0 && timerId == m_trimTimerId;
+    }
+
+    /*
+     * outside the lock, the pools have their own
+     */
+    if (trim)
+    {
+        for (int i = 0; i < 4; ++i)
+        {
+            ProTrimSgiPools(i);
+        }
+
+        CProThreadMutexGuard mon(m_lock);
+
+        if (m_wantExit)
+        {
+            return;
+        }
+
+        /*
+         * The reactor threads give their thread caches back at the next
+         * wakeup, so that the next trim can release those chunks too.
+         * An idle one is woken up for that
+         */
+        if (m_acceptReactor != NULL)
+        {
+            m_acceptReactor->Wakeup();
+        }
+
+        int i = 0;
+        int c = (int)m_ioReactors.size();
+
+        for (; i < c; ++i)
+        {
+            m_ioReactors[i]->Wakeup();
+        }
+
+        return;
+    }
+
+    CProThreadMutexGuard mon(m_lock);
+
+    if (m_acceptThreadCount + m_ioThreadCount == 0                ||
+        m_curThreadCount != m_acceptThreadCount + m_ioThreadCount ||
+        m_wantExit || timerId != m_balanceTimerId)
+    {
+        return;
+    }
+
+    int hot  = 0;
+    int cold = 0;
+
+    for (int i = 0; i < (int)m_ioLoads.size(); ++i)
+    {
+        PRO_IO_LOAD& load    = m_ioLoads[i];
+        uint64_t     events  = m_ioReactors[i]->GetEventCount();
+        int64_t      cpuTime = -1;
+        int64_t      sample  = 0;
+
+        if (m_cpuTimeLoad)
+        {
+            cpuTime = ProGetThreadCpuTime(load.threadId);
+        }
+
+        if (cpuTime >= 0 && load.cpuTime >= 0)
+        {
+            sample = cpuTime - load.cpuTime;
+        }
+        else
+        {
+            sample = (int64_t)(events - load.events);
+        }
+
+        load.delta   = events - load.events;
+        load.load    = (load.load * 3 + sample) / 4; /* EWMA */
+        load.bias    = 0;
+        load.cpuTime = cpuTime;
+        load.events  = events;
+
+        if (load.load > m_ioLoads[hot].load)
+        {
+            hot = i;
+        }
+        if (load.load < m_ioLoads[cold].load)
+        {
+            cold = i;
+        }
+    }
+
+    if (!m_migrateHandlers)
+    {
+        return;
+    }
+
+    int64_t minLoad = m_cpuTimeLoad ? BALANCE_MIN_CPU_TIME : BALANCE_MIN_EVENTS;
+
+    /*
+     * Move one handler a round, and only one that carries less than half
+     * of the difference, so that the two threads don't swap their roles
+     */
+    for (int j = 0; j < (int)m_ioReactors.size(); ++j)
+    {
+        if (j == hot && hot != cold && m_ioLoads[hot].load >= minLoad &&
+            m_ioLoads[hot].load > m_ioLoads[cold].load * 2)
+        {
+            uint64_t diff = 0;
+            if (m_ioLoads[hot].delta > m_ioLoads[cold].delta)
+            {
+                diff = m_ioLoads[hot].delta - m_ioLoads[cold].delta;
+            }
+
+            m_ioReactors[j]->CollectEvents((uint32_t)(diff / 2), this);
+        }
+        else
+        {
+            m_ioReactors[j]->CollectEvents(0, NULL);
+        }
+    }
+}
+
+uint64_t
+CProTpReactorTask::SetupTimer(IProOnTimer* onTimer,
+                              uint64_t     firstDelay,
+                              uint64_t     period,
+                              int64_t      userData) /* = 0 */
+{
+    uint64_t timerId = 0;
+
+    {
+        CProThreadMutexGuard mon(m_lock);
+
+        if (m_acceptThreadCount + m_ioThreadCount == 0                ||
+            m_curThreadCount != m_acceptThreadCount + m_ioThreadCount ||
+            m_wantExit)
+        {
+            return 0;
+        }
+
+        timerId = m_timerFactory.SetupTimer(onTimer, firstDelay, period, userData);
+    }
+
+    return timerId;
+}
+
+uint64_t
+CProTpReactorTask::SetupCoarseTimer(IProOnTimer* onTimer,
+                                    uint64_t     firstDelay,
+                                    uint64_t     period,
+                                    uint64_t     slack,
+                                    int64_t      userData) /* = 0 */
+{
+    uint64_t timerId = 0;
+
+    {
+        CProThreadMutexGuard mon(m_lock);
+
+        if (m_acceptThreadCount + m_ioThreadCount == 0                ||
+            m_curThreadCount != m_acceptThreadCount + m_ioThreadCount ||
+            m_wantExit)
+        {
+            return 0;
+        }
+
+        timerId = m_timerFactory.SetupCoarseTimer(onTimer, firstDelay, period, slack, userData);
+    }
+
+    return timerId;
+}
+
+uint64_t
+CProTpReactorTask::SetupHeartbeatTimer(IProOnTimer* onTimer,
+                                       int64_t      userData) /* = 0 */
+{
+    uint64_t timerId = 0;
+
+    {
+        CProThreadMutexGuard mon(m_lock);
+
+        if (m_acceptThreadCount + m_ioThreadCount == 0                ||
+            m_curThreadCount != m_acceptThreadCount + m_ioThreadCount ||
+            m_wantExit)
+        {
+            return 0;
+        }
+
+        timerId = m_timerFactory.SetupHeartbeatTimer(onTimer, userData);
+    }
+
+    return timerId;
+}
+
+bool
+CProTpReactorTask::UpdateHeartbeatTimers(unsigned int htbtIntervalInSeconds)
+{
+    bool ret = false;
+
+    {
+        CProThreadMutexGuard mon(m_lock);
+
+        if (m_acceptThreadCount + m_ioThreadCount == 0                ||
+            m_curThreadCount != m_acceptThreadCount + m_ioThreadCount ||
+            m_wantExit)
+        {
+            return false;
+        }
+
+        ret = m_timerFactory.UpdateHeartbeatTimers(htbtIntervalInSeconds);
+
+        if (ret && m_handlerTimers)
+        {
+            for (int i = 0; i < (int)m_ioThreadCount; ++i)
+            {
+                m_ioReactors[i]->UpdateHeartbeatTimers((int64_t)htbtIntervalInSeconds * 1000);
+            }
+        }
+    }
+
+    return ret;
+}
+
+void
+CProTpReactorTask::CancelTimer(uint64_t timerId)
+{
+    CProThreadMutexGuard mon(m_lock);
 
     if (m_acceptThreadCount + m_ioThreadCount == 0 ||
         m_curThreadCount != m_acceptThreadCount + m_ioThreadCount)
@@ -427,9 +1043,88 @@ CProTpReactorTask::CancelTimer(uint64_t timerId)
         return;
     }
 
+    /*
+     * the timer is on the I/O thread of its handler, unknown from the id
+     */
+    if (m_handlerTimers && timerId != 0)
+    {
+        for (int i = 0; i < (int)m_ioThreadCount; ++i)
+        {
+            if (m_ioReactors[i]->CancelTimer(timerId))
+            {
+                return;
+            }
+        }
+    }
+
     m_timerFactory.CancelTimer(timerId);
 }
 
+uint64_t
+CProTpReactorTask::SetupHandlerTimer(CProEventHandler* handler,
+                                     uint64_t          firstDelay,
+                                     uint64_t          period,
+                                     int64_t           userData) /* = 0 */
+{
+    uint64_t timerId = 0;
+
+    {
+        CProThreadMutexGuard mon(m_lock);
+
+        if (m_acceptThreadCount + m_ioThreadCount == 0                ||
+            m_curThreadCount != m_acceptThreadCount + m_ioThreadCount ||
+            m_wantExit)
+        {
+            return 0;
+        }
+
+        CProBaseReactor* ioReactor = handler != NULL ? handler->GetReactor() : NULL;
+        if (m_handlerTimers && ioReactor != NULL)
+        {
+            timerId = ioReactor->SetupTimer(handler, firstDelay, period, userData);
+        }
+
+        if (timerId == 0)
+        {
+            timerId = m_timerFactory.SetupTimer(handler, firstDelay, period, userData);
+        }
+    }
+
+    return timerId;
+}
+
+uint64_t
+CProTpReactorTask::SetupHandlerHeartbeatTimer(CProEventHandler* handler,
+                                              int64_t           userData) /* = 0 */
+{
+    uint64_t timerId = 0;
+
+    {
+        CProThreadMutexGuard mon(m_lock);
+
+        if (m_acceptThreadCount + m_ioThreadCount == 0                ||
+            m_curThreadCount != m_acceptThreadCount + m_ioThreadCount ||
+            m_wantExit)
+        {
+            return 0;
+        }
+
+        CProBaseReactor* ioReactor = handler != NULL ? handler->GetReactor() : NULL;
+        if (m_handlerTimers && ioReactor != NULL)
+        {
+            int64_t htbtPeriod = (int64_t)m_timerFactory.GetHeartbeatInterval() * 1000;
+            timerId = ioReactor->SetupHeartbeatTimer(handler, htbtPeriod, userData);
+        }
+
+        if (timerId == 0)
+        {
+            timerId = m_timerFactory.SetupHeartbeatTimer(handler, userData);
+        }
+    }
+
+    return timerId;
+}
+
 uint64_t
 CProTpReactorTask::SetupMmTimer(IProOnTimer* onTimer,
                                 uint64_t     firstDelay,
@@ -501,9 +1196,11 @@ CProTpReactorTask::GetTraceInfo(char*  buf,
 
         sprintf(
             theBuf,
+            " [I/O Backend] : %s \n"
             " [I/O Threads] : %d \n"
             " [I/O Sockets] : %d \n"
             ,
+            GetBackendName_i(m_backend),
             (int)m_ioThreadCount,
             theValue
             );
@@ -520,7 +1217,131 @@ CProTpReactorTask::GetTraceInfo(char*  buf,
 
         theInfo += "\n";
 
+        if (m_balance == PRO_BALANCE_LOAD)
+        {
+            /*
+             * cpu ms or events a second
+             */
+            for (int k = 0; k < (int)m_ioThreadCount; ++k)
+            {
+                int64_t load = m_ioLoads[k].load;
+                if (m_cpuTimeLoad)
+                {
+                    load /= 1000;
+                }
+
+                sprintf(theBuf, k == 0 ? " [ I/O Loads ] : %d " : "+ %d ", (int)load);
+                theInfo += theBuf;
+            }
+
+            sprintf(theBuf, "(%s) \n [ Migrated  ] : %u \n",
+                m_cpuTimeLoad ? "ms" : "events", m_migrationCount);
+            theInfo += theBuf;
+        }
+
+        if (m_busyPollTime > 0)
+        {
+            /*
+             * spin/blocked, in ms since Start()
+             */
+            for (int k = 0; k < (int)m_ioThreadCount; ++k)
+            {
+                uint64_t spinTime = 0;
+                uint64_t waitTime = 0;
+                m_ioReactors[k]->GetPollTimes(spinTime, waitTime);
+
+                sprintf(theBuf, k == 0 ? " [ Spin/Wait ] : %u/%u " : "+ %u/%u ",
+                    (unsigned int)(spinTime / 1000), (unsigned int)(waitTime / 1000));
+                theInfo += theBuf;
+            }
+
+            theInfo += "(ms) \n";
+        }
+
+        /*
+         * cross-thread wakeups, sent/coalesced
+         */
+        for (int m = 0; m < (int)m_ioThreadCount; ++m)
+        {
+            uint64_t sentCount      = 0;
+            uint64_t coalescedCount = 0;
+            m_ioReactors[m]->GetWakeupCounts(sentCount, coalescedCount);
+
+            sprintf(theBuf, m == 0 ? " [ Wakeups   ] : %u/%u " : "+ %u/%u ",
+                (unsigned int)sentCount, (unsigned int)coalescedCount);
+            theInfo += theBuf;
+        }
+
+        theInfo += "\n";
+
+        if (m_loopStats)
+        {
+            /*
+             * p50/p99/max since Start(), of each I/O thread
+             */
+            static const char* const s_titles[] =
+            {
+                " [ Loop Wait ] : ", " [ Loop Evts ] : ", " [ Loop Call ] : ", " [ Loop Lag  ] : "
+            };
+            static const char* const s_units[] = { "(us) \n", "\n", "(us) \n", "(us) \n" };
+
+            for (int n = 0; n < 4; ++n)
+            {
+                theInfo += s_titles[n];
+
+                for (int k = 0; k < (int)m_ioThreadCount; ++k)
+                {
+                    const CProBaseReactor*   reactor = m_ioReactors[k];
+                    const CProStatHistogram& histo   =
+                        n == 0 ? reactor->GetWaitHistogram()  :
+                        n == 1 ? reactor->GetEventHistogram() :
+                        n == 2 ? reactor->GetCallHistogram()  : reactor->GetLagHistogram();
+
+                    sprintf(theBuf, k == 0 ? "%u/%u/%u " : "+ %u/%u/%u ",
+                        (unsigned int)histo.CalcPercentile(50),
+                        (unsigned int)histo.CalcPercentile(99),
+                        (unsigned int)histo.GetMaxValue());
+                    theInfo += theBuf;
+                }
+
+                theInfo += s_units[n];
+            }
+
+            /*
+             * the timer and mm-timer threads
+             */
+            const CProStatHistogram& stCall = m_timerFactory.GetCallHistogram();
+            const CProStatHistogram& mmCall = m_mmTimerFactory.GetCallHistogram();
+            const CProStatHistogram& stLag  = m_timerFactory.GetLagHistogram();
+            const CProStatHistogram& mmLag  = m_mmTimerFactory.GetLagHistogram();
+
+            sprintf(
+                theBuf,
+                " [ Timer Call] : %u/%u/%u + %u/%u/%u (us) \n"
+                " [ Timer Lag ] : %u/%u/%u + %u/%u/%u (ms) \n"
+                ,
+                (unsigned int)stCall.CalcPercentile(50), (unsigned int)stCall.CalcPercentile(99),
+                (unsigned int)stCall.GetMaxValue(),
+                (unsigned int)mmCall.CalcPercentile(50), (unsigned int)mmCall.CalcPercentile(99),
+                (unsigned int)mmCall.GetMaxValue(),
+                (unsigned int)stLag.CalcPercentile(50), (unsigned int)stLag.CalcPercentile(99),
+                (unsigned int)stLag.GetMaxValue(),
+                (unsigned int)mmLag.CalcPercentile(50), (unsigned int)mmLag.CalcPercentile(99),
+                (unsigned int)mmLag.GetMaxValue()
+                );
+            theInfo += theBuf;
+        }
+
+        if (m_slowCallbackTime > 0)
+        {
+            AppendSlowCalls(theInfo);
+        }
+
         theValue = (int)m_timerFactory.GetTimerCount();
+        for (int j = 0; j < (int)m_ioThreadCount; ++j)
+        {
+            theValue += (int)m_ioReactors[j]->GetTimerCount();
+        }
         sprintf(theBuf, " [ ST Timers ] : %d \n", theValue);
         theInfo += theBuf;
 
@@ -536,33 +1357,203 @@ CProTpReactorTask::GetTraceInfo(char*  buf,
     }
 }
 
+void
+CProTpReactorTask::AppendSlowCalls(CProStlString& info) const
+{
+    CProStlVector<const CProStatSlowCalls*> slowCalls;
+    slowCalls.push_back(&m_acceptReactor->GetSlowCalls());
+    for (int i = 0; i < (int)m_ioThreadCount; ++i)
+    {
+        slowCalls.push_back(&m_ioReactors[i]->GetSlowCalls());
+    }
+    slowCalls.push_back(&m_timerFactory.GetSlowCalls());
+    slowCalls.push_back(&m_mmTimerFactory.GetSlowCalls());
+
+    /*
+     * the latest few of all threads
+     */
+    uint64_t                    count = 0;
+    CProStlVector<PRO_SLOW_CALL> calls;
+
+    for (int j = 0; j < (int)slowCalls.size(); ++j)
+    {
+        PRO_SLOW_CALL lastCalls[SLOW_CALLS_SHOWN];
+        size_t        lastCount = slowCalls[j]->GetLastCalls(lastCalls, SLOW_CALLS_SHOWN);
+
+        count += slowCalls[j]->GetCount();
+        calls.insert(calls.end(), lastCalls, lastCalls + lastCount);
+    }
+
+    std::sort(calls.begin(), calls.end(),
+        [](const PRO_SLOW_CALL& a, const PRO_SLOW_CALL& b) { return a.tick > b.tick; });
+    if (calls.size() > SLOW_CALLS_SHOWN)
+    {
+        calls.resize(SLOW_CALLS_SHOWN);
+    }
+
+    char    buf[256] = "";
+    int64_t tick     = ProGetTickCount64();
+
+    sprintf(buf, " [ Slow Calls] : %u \n", (unsigned int)count);
+    info += buf;
+
+    for (int k = 0; k < (int)calls.size(); ++k)
+    {
+        const PRO_SLOW_CALL& call = calls[k];
+
+        sprintf(buf, "   %s #%d %s %u us, %u s ago \n", call.name, (int)call.id, call.callback,
+            (unsigned int)call.time, (unsigned int)((tick - call.tick) / 1000));
+        info += buf;
+    }
+
+    /*
+     * the callbacks running too long now, which haven't returned yet
+     */
+    for (int m = -1; m < (int)m_ioThreadCount; ++m)
+    {
+        const CProBaseReactor* reactor = m < 0 ? m_acceptReactor : m_ioReactors[m];
+
+        PRO_SLOW_CALL call;
+        if (reactor->GetStuckCall(call))
+        {
+            sprintf(buf, " [ Stuck Call] : %s #%d %s %u ms \n", call.name, (int)call.id,
+                call.callback, (unsigned int)(call.time / 1000));
+            info += buf;
+        }
+    }
+}
+
 void
 CProTpReactorTask::Svc()
 {
-    uint64_t threadId = ProGetThreadId();
+    uint64_t            threadId = ProGetThreadId();
+    unsigned int        index    = 0;
+    bool                ioThread = false;
+    int                 cpu      = -1;
+    PRO_REACTOR_BACKEND backend  = PRO_REACTOR_DEFAULT;
+
+    {
+        CProThreadMutexGuard mon(m_lock);
+
+        index = m_threadIndex++;
+
+        if (index < m_acceptThreadCount)
+        {
+            if (m_acceptCpus.size() > 0)
+            {
+                cpu = (int)m_acceptCpus[index % m_acceptCpus.size()];
+            }
+
+            backend = ResolveBackend_i(PRO_REACTOR_DEFAULT);
+        }
+        else
+        {
+            index   -= m_acceptThreadCount; /* the I/O reactor index */
+            ioThread = true;
+
+            if (m_ioCpus.size() > 0)
+            {
+                cpu = (int)m_ioCpus[index % m_ioCpus.size()];
+            }
 
-    unsigned int threadCount = 0;
+            backend = m_backend;
+        }
+    }
+
+    if (cpu >= 0)
+    {
+        ProBindThreadToCpu((unsigned int)cpu);
+    }
+
+    if (ioThread)
+    {
+        /*
+         * spread the I/O threads over the SGI pool shards
+         */
+        ProSetSgiPoolShard((int)(index % 4));
+    }
+
+    /*
+     * The reactor is created here, after pinning, so that its memory is
+     * first touched on the local NUMA node
+     */
+    CProBaseReactor* reactor = CreateReactorImpl_i(backend, ioThread && m_edgeTriggered);
+    if (!reactor->Init())
+    {
+        delete reactor;
+        reactor = NULL;
+
+        if (backend == PRO_REACTOR_IO_URING)
+        {
+            /*
+             * refused by the kernel. retry with the default one
+             */
+            backend = ResolveBackend_i(PRO_REACTOR_DEFAULT);
+            reactor = CreateReactorImpl_i(backend, false);
+            if (!reactor->Init())
+            {
+                delete reactor;
+                reactor = NULL;
+            }
+        }
+    }
+
+    if (reactor != NULL)
+    {
+        if (ioThread)
+        {
+            reactor->SetBusyPollTime(m_busyPollTime);
+            reactor->SetHandlerTimers(m_handlerTimers);
+        }
+
+        reactor->SetLoopStats(m_loopStats, m_slowCallbackTime);
+    }
 
     {
         CProThreadMutexGuard mon(m_lock);
 
-        threadCount = ++m_curThreadCount;
-        m_threadIds.insert(threadId);
+        if (reactor != NULL && m_wantExit)
+        {
+            delete reactor;
+            reactor = NULL;
+        }
+
+        if (reactor != NULL)
+        {
+            if (ioThread)
+            {
+                m_ioReactors[index]            = reactor;
+                m_ioLoads[index].threadId      = threadId;
+                m_threadId2IoReactor[threadId] = reactor;
+                m_backend                      = backend;
+                m_recvBuffers                  = m_recvBuffers && reactor->HasRecvBuffers();
+            }
+            else
+            {
+                m_acceptReactor = reactor;
+            }
+
+            m_threadIds.insert(threadId);
+        }
+
+        ++m_curThreadCount;
         m_initCond.Signal();
     }
 
-    if (threadCount <= m_acceptThreadCount)
+    if (reactor != NULL)
     {
-        m_acceptReactor->WorkerRun();
+        reactor->WorkerRun();
     }
-    else
+
+    if (ioThread)
     {
-        m_ioReactors[threadCount - 2]->WorkerRun();
+        ProSetSgiPoolShard(-1);
     }
 
     {
         CProThreadMutexGuard mon(m_lock);
 
         m_threadIds.erase(threadId);
+        m_threadId2IoReactor.erase(threadId);
     }
 }
@@ -37,10 +37,33 @@
 class CProBaseReactor;
 class CProEventHandler;
 
+/*
+ * The load of an I/O thread, see CProTpReactorTask::OnTimer()
+ */
+struct PRO_IO_LOAD
+{
+    PRO_IO_LOAD()
+    {
+        threadId = 0;
+        cpuTime  = 0;
+        events   = 0;
+        delta    = 0;
+        load     = 0;
+        bias     = 0;
+    }
+
+    uint64_t threadId;
+    int64_t  cpuTime;  /* the last sample, in microseconds */
+    uint64_t events;   /* the last sample */
+    uint64_t delta;    /* events in the last interval */
+    int64_t  load;     /* smoothed, per interval */
+    int64_t  bias;     /* added by the placements since the last sample */
+};
+
 /////////////////////////////////////////////////////////////////////////////
 ////
 
-class CProTpReactorTask : public IProReactor, public CProThreadBase
+class CProTpReactorTask : public IProReactor, public IProOnTimer, public CProThreadBase
 {
 public:
 
@@ -48,7 +71,7 @@ public:
 
     virtual ~CProTpReactorTask();
 
-    bool Start(unsigned int ioThreadCount);
+    bool Start(const PRO_REACTOR_CONFIG& config);
 
     void Stop();
 
@@ -64,6 +87,60 @@ public:
         unsigned long     mask
         );
 
+    void ReplayHandler(
+        int64_t           sockId,
+        CProEventHandler* handler,
+        unsigned long     mask
+        );
+
+    bool IsEdgeTriggered() const
+    {
+        return m_edgeTriggered; /* read-only after Start() */
+    }
+
+    /*
+     * Whether all the I/O reactors read for the handlers that support it,
+     * see CProEventHandler::SupportsRecvBuffers()
+     */
+    bool HasRecvBuffers() const
+    {
+        return m_recvBuffers; /* read-only after Start() */
+    }
+
+    /*
+     * The acceptor registers one SO_REUSEPORT socket per I/O thread
+     */
+    bool AddAcceptShard(
+        int64_t           sockId,
+        CProEventHandler* handler,
+        unsigned int      shard
+        );
+
+    void RemoveAcceptShard(
+        int64_t      sockId,
+        unsigned int shard
+        );
+
+    bool IsReusePortAccept() const
+    {
+        return m_reusePortAccept; /* read-only after Start() */
+    }
+
+    unsigned int GetIoThreadCount() const
+    {
+        return m_ioThreadCount; /* read-only after Start() */
+    }
+
+    /*
+     * Called by the worker of the reactor "from", see
+     * CProBaseReactor::CollectEvents()
+     */
+    void MigrateHandler(
+        int64_t           sockId,
+        CProEventHandler* handler,
+        CProBaseReactor*  from
+        );
+
     virtual uint64_t SetupTimer(
         IProOnTimer* onTimer,
         uint64_t     firstDelay,
@@ -80,6 +157,23 @@ public:
 
     virtual void CancelTimer(uint64_t timerId);
 
+    /*
+     * With config.handlerTimers, the timer of a handler is fired by its I/O
+     * thread. Otherwise, or if the handler isn't on an I/O thread, these
+     * are SetupTimer() and SetupHeartbeatTimer()
+     */
+    uint64_t SetupHandlerTimer(
+        CProEventHandler* handler,
+        uint64_t          firstDelay,
+        uint64_t          period,
+        int64_t           userData = 0
+        );
+
+    uint64_t SetupHandlerHeartbeatTimer(
+        CProEventHandler* handler,
+        int64_t           userData = 0
+        );
+
     virtual uint64_t SetupMmTimer(
         IProOnTimer* onTimer,
         uint64_t     firstDelay,
@@ -94,10 +188,37 @@ public:
         size_t size
         ) const;
 
+    virtual uint64_t SetupCoarseTimer(
+        IProOnTimer* onTimer,
+        uint64_t     firstDelay,
+        uint64_t     period,
+        uint64_t     slack,
+        int64_t      userData /* = 0 */
+        );
+
 private:
 
+    virtual unsigned long AddRef()
+    {
+        return 1;
+    }
+
+    virtual unsigned long Release()
+    {
+        return 1;
+    }
+
+    virtual void OnTimer(
+        void*    factory,
+        uint64_t timerId,
+        int64_t  tick,
+        int64_t  userData
+        );
+
     void StopMe();
 
+    void AppendSlowCalls(CProStlString& info) const; /* with m_lock held */
+
     virtual void Svc();
 
 private:
@@ -109,8 +230,29 @@ private:
     unsigned int                    m_acceptThreadCount;
     unsigned int                    m_ioThreadCount;
     unsigned int                    m_curThreadCount;
+    unsigned int                    m_threadIndex;
+    PRO_REACTOR_BACKEND             m_backend;
+    PRO_REACTOR_BALANCE             m_balance;
+    bool                            m_edgeTriggered;
+    bool                            m_recvBuffers;
+    bool                            m_reusePortAccept;
+    bool                            m_migrateHandlers;
+    bool                            m_cpuTimeLoad;
+    unsigned int                    m_busyPollTime;
+    bool                            m_busyPollSockets;
+    bool                            m_loopStats;
+    unsigned int                    m_slowCallbackTime;
+    bool                            m_handlerTimers;
     bool                            m_wantExit;
+    uint64_t                        m_balanceTimerId;
+    uint64_t                        m_trimTimerId;
+    unsigned int                    m_migrationCount;
+    CProStlVector<unsigned int>     m_acceptCpus;
+    CProStlVector<unsigned int>     m_ioCpus;
+    CProStlVector<PRO_IO_LOAD>      m_ioLoads;
     CProStlSet<uint64_t>            m_threadIds;
+
+    CProStlMap<uint64_t, CProBaseReactor*> m_threadId2IoReactor;
     CProThreadMutexCondition        m_initCond;
     mutable CProThreadMutex         m_lock;
     CProThreadMutex                 m_lockAtom;
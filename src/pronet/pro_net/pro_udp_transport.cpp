@@ -30,6 +30,7 @@
 ////
 
 #define DEFAULT_RECV_POOL_SIZE (1024 * 65) /* EMSGSIZE */
+#define MAX_RECEIVING_PACKETS  32          /* edge-triggered only */
 
 /////////////////////////////////////////////////////////////////////////////
 ////
@@ -50,6 +51,7 @@ m_recvPoolSize(recvPoolSize > 0 ? recvPoolSize : DEFAULT_RECV_POOL_SIZE)
     m_observer         = NULL;
     m_reactorTask      = NULL;
     m_sockId           = -1;
+    m_edgeTriggered    = false;
     m_timerId          = 0;
 
     m_connResetAsError = false;
@@ -143,6 +145,8 @@ CProUdpTransport::Init(IProTransportObserver* observer,
             return false;
         }
 
+        m_edgeTriggered = reactorTask->IsEdgeTriggered() && SupportsEdgeTrigger();
+
         if (!reactorTask->AddHandler(sockId, this, PRO_MASK_READ))
         {
             ProCloseSockId(sockId);
@@ -346,7 +350,7 @@ CProUdpTransport::StartHeartbeat()
 
     if (m_timerId == 0)
     {
-        m_timerId = m_reactorTask->SetupHeartbeatTimer(this, 0);
+        m_timerId = m_reactorTask->SetupHandlerHeartbeatTimer(this, 0);
     }
 }
 
@@ -400,6 +404,29 @@ CProUdpTransport::UdpConnResetAsError(const pbsd_sockaddr_in* remoteAddr) /* = N
 void
 CProUdpTransport::OnInput(int64_t sockId)
 {
+    bool tryAgain = false;
+
+    for (int i = 0; i < MAX_RECEIVING_PACKETS; ++i) /* until EAGAIN if edge-triggered */
+    {
+        OnInput(sockId, tryAgain);
+        if (!tryAgain)
+        {
+            break;
+        }
+    }
+
+    if (tryAgain)
+    {
+        ReplayInput(); /* no more edge for what's left */
+    }
+}
+
+void
+CProUdpTransport::OnInput(int64_t sockId,
+                          bool&   tryAgain)
+{
+    tryAgain = false;
+
     assert(sockId != -1);
     if (sockId == -1)
     {
@@ -424,6 +451,11 @@ CProUdpTransport::OnInput(int64_t sockId)
             return;
         }
 
+        if (m_edgeTriggered && !PRO_BIT_ENABLED(GetMask(), PRO_MASK_READ))
+        {
+            return; /* suspended */
+        }
+
         size_t idleSize = m_recvPool.ContinuousIdleSize();
 
         assert(idleSize > 0);
@@ -468,6 +500,8 @@ EXIT:
         {
             observer->OnRecv(this, &remoteAddr);
             assert(m_recvPool.ContinuousIdleSize() > 0);
+
+            tryAgain = m_edgeTriggered;
         }
         else if (recvSize < 0 && errorCode == PBSD_ECONNRESET && m_connResetAsError)
         {
@@ -482,6 +516,10 @@ EXIT:
             m_canUpcall = false;
             observer->OnClose(this, errorCode, 0);
         }
+        else if (recvSize < 0 && errorCode != PBSD_EWOULDBLOCK)
+        {
+            tryAgain = m_edgeTriggered; /* ECONNRESET or EMSGSIZE. go on */
+        }
         else
         {
         }
@@ -491,10 +529,24 @@ EXIT:
 
     if (!m_canUpcall)
     {
+        tryAgain = false;
         Fini();
     }
 }
 
+void
+CProUdpTransport::ReplayInput()
+{
+    CProThreadMutexGuard mon(m_lock);
+
+    if (m_observer == NULL || m_reactorTask == NULL)
+    {
+        return;
+    }
+
+    m_reactorTask->ReplayHandler(m_sockId, this, PRO_MASK_READ);
+}
+
 void
 CProUdpTransport::OnError(int64_t sockId,
                           int     errorCode)
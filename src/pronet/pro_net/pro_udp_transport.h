@@ -113,6 +113,16 @@ public:
 
     virtual void UdpConnResetAsError(const pbsd_sockaddr_in* remoteAddr); /* = NULL */
 
+    virtual bool SupportsEdgeTrigger() const
+    {
+        return true;
+    }
+
+    virtual const char* GetHandlerName() const
+    {
+        return "udp_transport";
+    }
+
 protected:
 
     CProUdpTransport(
@@ -129,6 +139,7 @@ protected:
     IProTransportObserver*  m_observer;
     CProTpReactorTask*      m_reactorTask;
     int64_t                 m_sockId;
+    bool                    m_edgeTriggered;
     pbsd_sockaddr_in        m_localAddr;
     pbsd_sockaddr_in        m_defaultRemoteAddr;
     CProRecvPool            m_recvPool;
@@ -139,6 +150,13 @@ private:
 
     virtual void OnInput(int64_t sockId);
 
+    void OnInput(
+        int64_t sockId,
+        bool&   tryAgain
+        );
+
+    void ReplayInput();
+
     virtual void OnOutput(int64_t sockId)
     {
     }
@@ -218,7 +218,8 @@ CRtpMsgC2s::Init(IRtpMsgC2sObserver* observer,
         m_msgClient              = msgClient;
         m_service                = service;
         m_serviceHubPort         = localServiceHubPort;
-        m_timerId                = reactor->SetupTimer(this, HEARTBEAT_INTERVAL * 1000, HEARTBEAT_INTERVAL * 1000);
+        m_timerId                = reactor->SetupCoarseTimer(this,
+            HEARTBEAT_INTERVAL * 1000, HEARTBEAT_INTERVAL * 1000, HEARTBEAT_INTERVAL * 1000 / 2);
         m_connectTick            = ProGetTickCount64();
         m_uplinkIp               = uplinkIpByDNS;
         m_uplinkPort             = uplinkPort;
@@ -21,6 +21,7 @@
 #include "../pro_util/pro_bsd_wrapper.h"
 #include "../pro_util/pro_memory_pool.h"
 #include "../pro_util/pro_ref_count.h"
+#include "../pro_util/pro_slab_pool.h"
 #include "../pro_util/pro_z.h"
 
 /////////////////////////////////////////////////////////////////////////////
@@ -31,6 +32,11 @@
 /////////////////////////////////////////////////////////////////////////////
 ////
 
+IMPLEMENT_SLAB_POOL(CRtpPacket, 0)
+
+/////////////////////////////////////////////////////////////////////////////
+////
+
 CRtpPacket*
 CRtpPacket::CreateInstance(const void*       payloadBuffer,
                            size_t            payloadSize,
@@ -320,7 +326,12 @@ CRtpPacket::Init(const void* payloadBuffer,
         return;
     }
 
-    m_packet = (RTP_PACKET*)ProMalloc(sizeof(RTP_PACKET) + payloadSize + 16); /* (n + 16) bytes, for ssl */
+    {
+        static const unsigned int s_tag = ProRegisterSgiPoolTag("rtp_packet");
+        CProSgiPoolTagScope tagScope(s_tag);
+
+        m_packet = (RTP_PACKET*)ProMalloc(sizeof(RTP_PACKET) + payloadSize + 16); /* (n + 16) bytes, for ssl */
+    }
     if (m_packet == NULL)
     {
         return;
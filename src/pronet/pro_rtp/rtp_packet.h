@@ -26,6 +26,7 @@
 #include "rtp_base.h"
 #include "../pro_util/pro_memory_pool.h"
 #include "../pro_util/pro_ref_count.h"
+#include "../pro_util/pro_slab_pool.h"
 #include "../pro_util/pro_z.h"
 
 /////////////////////////////////////////////////////////////////////////////
@@ -243,7 +244,7 @@ private:
     int64_t                 m_magic2;
     RTP_PACKET*             m_packet;
 
-    DECLARE_SGI_POOL(0)
+    DECLARE_SLAB_POOL(0)
 };
 
 /////////////////////////////////////////////////////////////////////////////
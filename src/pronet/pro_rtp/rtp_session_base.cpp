@@ -849,9 +849,11 @@ CRtpSessionBase::OnHeartbeat(IProTransport* trans)
             size_t busyObjNum[64];
             size_t totalObjNum[64];
             size_t heapBytes;
+            size_t reclaimableBytes;
 
             {
                 ProGetSgiPoolInfo(freeList, objSize, busyObjNum, totalObjNum, &heapBytes, 0);
+                reclaimableBytes = ProGetSgiPoolReclaimableBytes(0);
                 snprintf_pro(
                     buffer,
                     size,
@@ -921,7 +923,7 @@ CRtpSessionBase::OnHeartbeat(IProTransport* trans)
                     "\t CRtpSessionBase(POOL-0) - [61] : %p, [%u], *%u/%u \n"
                     "\t CRtpSessionBase(POOL-0) - [62] : %p, [%u], *%u/%u \n"
                     "\t CRtpSessionBase(POOL-0) - [63] : %p, [%u], *%u/%u \n"
-                    "\t CRtpSessionBase(POOL-0) - size : %u \n"
+                    "\t CRtpSessionBase(POOL-0) - size : %u, reclaimable : %u \n"
                     ,
                     (unsigned int)ProGetProcessId(),
                     (unsigned int)ProGetProcessId(),
@@ -990,7 +992,28 @@ CRtpSessionBase::OnHeartbeat(IProTransport* trans)
                     freeList[61], (unsigned int)objSize[61], (unsigned int)busyObjNum[61], (unsigned int)totalObjNum[61],
                     freeList[62], (unsigned int)objSize[62], (unsigned int)busyObjNum[62], (unsigned int)totalObjNum[62],
                     freeList[63], (unsigned int)objSize[63], (unsigned int)busyObjNum[63], (unsigned int)totalObjNum[63],
-                    (unsigned int)heapBytes
+                    (unsigned int)heapBytes,
+                    (unsigned int)reclaimableBytes
+                    );
+#if defined(_WIN32)
+                    ::OutputDebugStringA(buffer);
+#else
+                    printf("%s", buffer);
+#endif
+            }
+
+            {
+                size_t slabLiveObjNum  = 0;
+                size_t slabTotalObjNum = 0;
+                CRtpPacket::GetSlabPool().GetInfo(NULL, &slabLiveObjNum, &slabTotalObjNum, NULL);
+
+                snprintf_pro(
+                    buffer,
+                    size,
+                    "\t CRtpSessionBase(SLAB) - CRtpPacket : *%u/%u \n"
+                    ,
+                    (unsigned int)slabLiveObjNum,
+                    (unsigned int)slabTotalObjNum
                     );
 #if defined(_WIN32)
                     ::OutputDebugStringA(buffer);
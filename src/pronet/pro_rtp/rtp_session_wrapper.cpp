@@ -54,6 +54,162 @@ extern CProFileMonitor g_fileMonitor;
 } /* extern "C" */
 #endif
 
+static CProStlMap<IProReactor*, CRtpSessionPacer*> g_s_pacers;
+static CProThreadMutex                             g_s_pacerLock;
+
+/////////////////////////////////////////////////////////////////////////////
+////
+
+CRtpSessionPacer*
+CRtpSessionPacer::Attach(IProReactor* reactor)
+{
+    assert(reactor != NULL);
+    if (reactor == NULL)
+    {
+        return NULL;
+    }
+
+    CProThreadMutexGuard mon(g_s_pacerLock);
+
+    CRtpSessionPacer* pacer = NULL;
+
+    auto itr = g_s_pacers.find(reactor);
+    if (itr != g_s_pacers.end())
+    {
+        pacer = itr->second;
+    }
+    else
+    {
+        pacer = new CRtpSessionPacer(reactor);
+        g_s_pacers[reactor] = pacer;
+    }
+
+    ++pacer->m_users;
+
+    return pacer;
+}
+
+CRtpSessionPacer::CRtpSessionPacer(IProReactor* reactor)
+{
+    m_reactor = reactor;
+    m_timerId = 0;
+    m_users   = 0;
+}
+
+void
+CRtpSessionPacer::Detach()
+{
+    {
+        CProThreadMutexGuard mon(g_s_pacerLock);
+
+        assert(m_users > 0);
+        --m_users;
+        if (m_users > 0)
+        {
+            return;
+        }
+
+        g_s_pacers.erase(m_reactor);
+    }
+
+    assert(m_sessions.size() == 0);
+    assert(m_timerId == 0);
+    Release();
+}
+
+bool
+CRtpSessionPacer::Add(CRtpSessionWrapper* session)
+{
+    assert(session != NULL);
+
+    CProThreadMutexGuard mon(m_lock);
+
+    /*
+     * the tick runs only while some session has packets queued
+     */
+    if (m_timerId == 0)
+    {
+        m_timerId = m_reactor->SetupMmTimer(this, 1, 1); /* 1ms */
+        if (m_timerId == 0)
+        {
+            return false;
+        }
+    }
+
+    m_sessions.insert(session);
+
+    return true;
+}
+
+void
+CRtpSessionPacer::Remove(CRtpSessionWrapper* session)
+{
+    CProThreadMutexGuard mon(m_lock);
+
+    m_sessions.erase(session);
+
+    if (m_sessions.size() == 0 && m_timerId != 0)
+    {
+        m_reactor->CancelMmTimer(m_timerId);
+        m_timerId = 0;
+    }
+}
+
+unsigned long
+CRtpSessionPacer::AddRef()
+{
+    return CProRefCount::AddRef();
+}
+
+unsigned long
+CRtpSessionPacer::Release()
+{
+    return CProRefCount::Release();
+}
+
+void
+CRtpSessionPacer::OnTimer(void*    factory,
+                          uint64_t timerId,
+                          int64_t  tick,
+                          int64_t  userData)
+{
+    CProStlVector<CRtpSessionWrapper*> sessions;
+
+    {
+        CProThreadMutexGuard mon(m_lock);
+
+        if (m_sessions.size() == 0)
+        {
+            return;
+        }
+
+        sessions.reserve(m_sessions.size());
+
+        auto itr = m_sessions.begin();
+        auto end = m_sessions.end();
+
+        for (; itr != end; ++itr)
+        {
+            CRtpSessionWrapper* session = *itr;
+            session->AddRef();
+            sessions.push_back(session);
+        }
+    }
+
+    /*
+     * outside m_lock. A session removes itself from the pacer when its
+     * queue runs dry
+     */
+    int i = 0;
+    int c = (int)sessions.size();
+
+    for (; i < c; ++i)
+    {
+        sessions[i]->OnPace(tick);
+        sessions[i]->Release();
+    }
+}
+
 /////////////////////////////////////////////////////////////////////////////
 ////
 
@@ -88,7 +244,8 @@ CRtpSessionWrapper::CRtpSessionWrapper(const RTP_SESSION_INFO& localInfo)
     m_onOkCalled       = false;
     m_traceTick        = 0;
 
-    m_sendTimerId      = 0;
+    m_pacer            = NULL;
+    m_pacing           = false;
     m_sendDurationMs   = 0;
     m_pushTick         = 0;
 }
@@ -545,6 +702,13 @@ CRtpSessionWrapper::Init(RTP_SESSION_TYPE     sessionType,
         m_statLossRateInput.SetTimeSpan(statInSeconds);
         m_statLossRateOutput.SetTimeSpan(statInSeconds);
 
+        /*
+         * the input is pushed by OnRecvSession() on the reactor thread
+         */
+        m_statFrameRateInput.SetCachedTick(true);
+        m_statBitRateInput.SetCachedTick(true);
+        m_statLossRateInput.SetCachedTick(true);
+
         initArgs2.comm.observer->AddRef();
         m_observer = initArgs2.comm.observer;
         m_reactor  = initArgs2.comm.reactor;
@@ -563,8 +727,8 @@ CRtpSessionWrapper::Init(RTP_SESSION_TYPE     sessionType,
         }
         if (enableTrace)
         {
-            m_timerId = m_reactor->SetupTimer(
-                this, HEARTBEAT_INTERVAL * 1000, HEARTBEAT_INTERVAL * 1000);
+            m_timerId = m_reactor->SetupCoarseTimer(this,
+                HEARTBEAT_INTERVAL * 1000, HEARTBEAT_INTERVAL * 1000, HEARTBEAT_INTERVAL * 1000 / 2);
         }
     }
 
@@ -577,6 +741,7 @@ CRtpSessionWrapper::Fini()
     IRtpSessionObserver*      observer = NULL;
     IRtpSession*              session  = NULL;
     IRtpBucket*               bucket   = NULL;
+    CRtpSessionPacer*         pacer    = NULL;
     CProStlDeque<IRtpPacket*> pushPackets;
 
     {
@@ -588,9 +753,15 @@ CRtpSessionWrapper::Fini()
         }
 
         m_reactor->CancelTimer(m_timerId);
-        m_reactor->CancelMmTimer(m_sendTimerId);
-        m_timerId     = 0;
-        m_sendTimerId = 0;
+        m_timerId = 0;
+
+        if (m_pacing)
+        {
+            m_pacer->Remove(this);
+            m_pacing = false;
+        }
+        pacer   = m_pacer;
+        m_pacer = NULL;
 
         pushPackets = m_pushPackets;
         m_pushPackets.clear();
@@ -611,6 +782,11 @@ CRtpSessionWrapper::Fini()
         pushPackets[i]->Release();
     }
 
+    if (pacer != NULL)
+    {
+        pacer->Detach();
+    }
+
     bucket->Destroy();
     DeleteRtpSession(session);
     observer->Release();
@@ -874,9 +1050,23 @@ CRtpSessionWrapper::SendPacketByTimer(IRtpPacket*  packet,
             return false;
         }
 
-        if (m_sendTimerId == 0)
+        if (m_pacer == NULL)
         {
-            m_sendTimerId = m_reactor->SetupMmTimer(this, 1, 1); /* 1ms */
+            m_pacer = CRtpSessionPacer::Attach(m_reactor);
+            if (m_pacer == NULL)
+            {
+                return false;
+            }
+        }
+
+        if (!m_pacing)
+        {
+            if (!m_pacer->Add(this))
+            {
+                return false;
+            }
+
+            m_pacing = true;
         }
 
         packet->AddRef();
@@ -1742,35 +1932,50 @@ CRtpSessionWrapper::OnTimer(void*    factory,
             }}}
             while (0);
         }
-        else if (timerId == m_sendTimerId)
+        else
         {
-            int64_t sendDurationMs = m_pushTick + m_sendDurationMs - tick;
-            if (sendDurationMs < 1)
-            {
-                sendDurationMs = 1;
-            }
+        }
+    }
+}
 
-            int64_t maxSendCount = (m_pushPackets.size() + sendDurationMs / 2) / sendDurationMs; /* rounded */
-            if (maxSendCount < 1)
-            {
-                maxSendCount = 1;
-            }
+void
+CRtpSessionWrapper::OnPace(int64_t tick)
+{
+    CProThreadMutexGuard mon(m_lock);
 
-            for (int i = 0; i < maxSendCount; ++i)
-            {
-                if (m_pushPackets.size() == 0)
-                {
-                    break;
-                }
+    if (m_observer == NULL || m_reactor == NULL || m_session == NULL || m_bucket == NULL)
+    {
+        return;
+    }
 
-                IRtpPacket* packet = m_pushPackets.front();
-                m_pushPackets.pop_front();
-                PushPacket(packet);
-                packet->Release();
-            }
-        }
-        else
+    int64_t sendDurationMs = m_pushTick + m_sendDurationMs - tick;
+    if (sendDurationMs < 1)
+    {
+        sendDurationMs = 1;
+    }
+
+    int64_t maxSendCount = (m_pushPackets.size() + sendDurationMs / 2) / sendDurationMs; /* rounded */
+    if (maxSendCount < 1)
+    {
+        maxSendCount = 1;
+    }
+
+    for (int i = 0; i < maxSendCount; ++i)
+    {
+        if (m_pushPackets.size() == 0)
         {
+            break;
         }
+
+        IRtpPacket* packet = m_pushPackets.front();
+        m_pushPackets.pop_front();
+        PushPacket(packet);
+        packet->Release();
+    }
+
+    if (m_pushPackets.size() == 0 && m_pacing)
+    {
+        m_pacer->Remove(this);
+        m_pacing = false;
     }
 }
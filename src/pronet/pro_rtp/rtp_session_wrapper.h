@@ -35,6 +35,57 @@
 /////////////////////////////////////////////////////////////////////////////
 ////
 
+class CRtpSessionWrapper;
+
+/*
+ * One 1ms pacing tick shared by the sessions of a reactor. It walks only the
+ * sessions with packets queued by SendPacketByTimer()
+ */
+class CRtpSessionPacer : public IProOnTimer, public CProRefCount
+{
+public:
+
+    static CRtpSessionPacer* Attach(IProReactor* reactor);
+
+    void Detach();
+
+    bool Add(CRtpSessionWrapper* session);
+
+    void Remove(CRtpSessionWrapper* session);
+
+    virtual unsigned long AddRef();
+
+    virtual unsigned long Release();
+
+private:
+
+    CRtpSessionPacer(IProReactor* reactor);
+
+    virtual ~CRtpSessionPacer()
+    {
+    }
+
+    virtual void OnTimer(
+        void*    factory,
+        uint64_t timerId,
+        int64_t  tick,
+        int64_t  userData
+        );
+
+private:
+
+    IProReactor*                    m_reactor;
+    uint64_t                        m_timerId;  /* 0 while no session is queued */
+    size_t                          m_users;    /* under g_s_pacerLock */
+    CProStlSet<CRtpSessionWrapper*> m_sessions; /* with packets queued */
+    CProThreadMutex                 m_lock;
+
+    DECLARE_SGI_POOL(0)
+};
+
+/////////////////////////////////////////////////////////////////////////////
+////
+
 class CRtpSessionWrapper
 :
 public IRtpSession,
@@ -200,6 +251,8 @@ private:
 
     bool PushPacket(IRtpPacket* packet);
 
+    void OnPace(int64_t tick);
+
     bool DoSendPacket();
 
 private:
@@ -220,7 +273,8 @@ private:
     volatile bool             m_onOkCalled;
     int64_t                   m_traceTick;
 
-    uint64_t                  m_sendTimerId;
+    CRtpSessionPacer*         m_pacer;
+    bool                      m_pacing; /* in m_pacer */
     unsigned int              m_sendDurationMs;
     int64_t                   m_pushTick;
     CProStlDeque<IRtpPacket*> m_pushPackets;
@@ -235,6 +289,8 @@ private:
     mutable CProThreadMutex   m_lock;
 
     DECLARE_SGI_POOL(0)
+
+    friend class CRtpSessionPacer;
 };
 
 /////////////////////////////////////////////////////////////////////////////
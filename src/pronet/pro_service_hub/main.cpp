@@ -35,13 +35,17 @@
 #define CONFIG_FILE_NAME       "pro_service_hub.cfg"
 #define LOG_LOOP_BYTES         (50 * 1000 * 1000)
 #define LOG_HEARTBEAT_INTERVAL 60
+#define PROFILE_DUMP_BYTES     (1024 * 64)
 
 struct SERVICE_HUB_CONFIG_INFO
 {
     SERVICE_HUB_CONFIG_INFO()
     {
-        hubs_thread_count      = 10;
-        hubs_handshake_timeout = 10;
+        hubs_thread_count       = 10;
+        hubs_handshake_timeout  = 10;
+        hubs_profile_interval   = 0;
+        hubs_pool_trim_interval = 0;
+        hubs_pool_huge_page     = false;
 
         hubs_tcpex_port_a.insert(3000);
         hubs_tcpex_port_b.insert(0);
@@ -53,15 +57,21 @@ struct SERVICE_HUB_CONFIG_INFO
     {
         CProConfigStream configStream;
 
-        configStream.AddUint    ("hubs_thread_count"     , hubs_thread_count);
-        configStream.AddUint    ("hubs_handshake_timeout", hubs_handshake_timeout);
+        configStream.AddUint    ("hubs_thread_count"       , hubs_thread_count);
+        configStream.Add        ("hubs_io_cpus"            , hubs_io_cpus);
+        configStream.Add        ("hubs_accept_cpus"        , hubs_accept_cpus);
+        configStream.Add        ("hubs_timer_cpus"         , hubs_timer_cpus);
+        configStream.AddUint    ("hubs_handshake_timeout"  , hubs_handshake_timeout);
+        configStream.AddUint    ("hubs_profile_interval"   , hubs_profile_interval);
+        configStream.AddUint    ("hubs_pool_trim_interval" , hubs_pool_trim_interval);
+        configStream.AddInt     ("hubs_pool_huge_page"     , hubs_pool_huge_page);
 
         auto itr = hubs_tcpex_port_a.begin();
         auto end = hubs_tcpex_port_a.end();
 
         for (; itr != end; ++itr)
         {
-            configStream.AddUint("hubs_tcpex_port_a"     , *itr);
+            configStream.AddUint("hubs_tcpex_port_a"       , *itr);
         }
 
         itr = hubs_tcpex_port_b.begin();
@@ -69,7 +79,7 @@ struct SERVICE_HUB_CONFIG_INFO
 
         for (; itr != end; ++itr)
         {
-            configStream.AddUint("hubs_tcpex_port_b"     , *itr);
+            configStream.AddUint("hubs_tcpex_port_b"       , *itr);
         }
 
         itr = hubs_tcp_port_a.begin();
@@ -77,7 +87,7 @@ struct SERVICE_HUB_CONFIG_INFO
 
         for (; itr != end; ++itr)
         {
-            configStream.AddUint("hubs_tcp_port_a"       , *itr);
+            configStream.AddUint("hubs_tcp_port_a"         , *itr);
         }
 
         itr = hubs_tcp_port_b.begin();
@@ -85,14 +95,20 @@ struct SERVICE_HUB_CONFIG_INFO
 
         for (; itr != end; ++itr)
         {
-            configStream.AddUint("hubs_tcp_port_b"       , *itr);
+            configStream.AddUint("hubs_tcp_port_b"         , *itr);
         }
 
         configStream.Get(configs);
     }
 
     unsigned int               hubs_thread_count; /* 1 ~ 100 */
+    CProStlString              hubs_io_cpus;      /* "0-7,16" */
+    CProStlString              hubs_accept_cpus;
+    CProStlString              hubs_timer_cpus;
     unsigned int               hubs_handshake_timeout;
+    unsigned int               hubs_profile_interval; /* SGI pool profile dump (s). 0: off */
+    unsigned int               hubs_pool_trim_interval; /* SGI pool trimming (s). 0: off */
+    bool                       hubs_pool_huge_page;
 
     CProStlSet<unsigned short> hubs_tcpex_port_a; /* class-a port with tcpex protocol, active-standby mode */
     CProStlSet<unsigned short> hubs_tcpex_port_b; /* class-b port with tcpex protocol, load-balance mode */
@@ -134,6 +150,18 @@ ReadConfig_i(const CProStlVector<PRO_CONFIG_ITEM>& configs,
                 configInfo.hubs_thread_count = value;
             }
         }
+        else if (stricmp_pro(configName.c_str(), "hubs_io_cpus") == 0)
+        {
+            configInfo.hubs_io_cpus = configValue;
+        }
+        else if (stricmp_pro(configName.c_str(), "hubs_accept_cpus") == 0)
+        {
+            configInfo.hubs_accept_cpus = configValue;
+        }
+        else if (stricmp_pro(configName.c_str(), "hubs_timer_cpus") == 0)
+        {
+            configInfo.hubs_timer_cpus = configValue;
+        }
         else if (stricmp_pro(configName.c_str(), "hubs_handshake_timeout") == 0)
         {
             int value = atoi(configValue.c_str());
@@ -142,6 +170,26 @@ ReadConfig_i(const CProStlVector<PRO_CONFIG_ITEM>& configs,
                 configInfo.hubs_handshake_timeout = value;
             }
         }
+        else if (stricmp_pro(configName.c_str(), "hubs_profile_interval") == 0)
+        {
+            int value = atoi(configValue.c_str());
+            if (value >= 0)
+            {
+                configInfo.hubs_profile_interval = value;
+            }
+        }
+        else if (stricmp_pro(configName.c_str(), "hubs_pool_trim_interval") == 0)
+        {
+            int value = atoi(configValue.c_str());
+            if (value >= 0)
+            {
+                configInfo.hubs_pool_trim_interval = value;
+            }
+        }
+        else if (stricmp_pro(configName.c_str(), "hubs_pool_huge_page") == 0)
+        {
+            configInfo.hubs_pool_huge_page = atoi(configValue.c_str()) != 0;
+        }
         else if (stricmp_pro(configName.c_str(), "hubs_tcpex_port_a") == 0)
         {
             int value = atoi(configValue.c_str());
@@ -427,7 +475,24 @@ int main(int argc, char* argv[])
         ReadConfig_i(configs, configInfo);
     }
 
-    reactor = ProCreateReactor(configInfo.hubs_thread_count);
+    if (configInfo.hubs_pool_huge_page)
+    {
+        for (int i = 0; i < 4; ++i)
+        {
+            ProSetSgiPoolHugePage(true, i);
+        }
+    }
+
+    {
+        PRO_REACTOR_CONFIG reactorConfig;
+        reactorConfig.ioThreadCount    = configInfo.hubs_thread_count;
+        reactorConfig.ioThreadCpus     = configInfo.hubs_io_cpus.c_str();
+        reactorConfig.acceptThreadCpus = configInfo.hubs_accept_cpus.c_str();
+        reactorConfig.timerThreadCpus  = configInfo.hubs_timer_cpus.c_str();
+        reactorConfig.poolTrimInterval = configInfo.hubs_pool_trim_interval;
+
+        reactor = ProCreateReactorEx(reactorConfig);
+    }
     if (reactor == NULL)
     {
         sprintf(
@@ -552,28 +617,67 @@ int main(int argc, char* argv[])
     printf("%s", s_traceInfo);
     logFile->Log(s_traceInfo, PRO_LL_INFO, false);
 
-    while (1)
+    if (configInfo.hubs_profile_interval > 0)
     {
+        ProEnableSgiPoolProfile(true);
+    }
+
+    {
+        int64_t heartbeatTick = ProGetTickCount64();
+        int64_t profileTick   = heartbeatTick;
+
+        while (1)
         {
-            CProThreadMutexGuard mon(g_s_lock);
+            int64_t tick     = ProGetTickCount64();
+            int64_t nextTick = heartbeatTick + LOG_HEARTBEAT_INTERVAL * 1000;
+            if (configInfo.hubs_profile_interval > 0 &&
+                profileTick + configInfo.hubs_profile_interval * 1000 < nextTick)
+            {
+                nextTick = profileTick + configInfo.hubs_profile_interval * 1000;
+            }
 
-            if (g_s_cond.Wait(&g_s_lock, LOG_HEARTBEAT_INTERVAL * 1000))
             {
-                break;
+                CProThreadMutexGuard mon(g_s_lock);
+
+                if (g_s_cond.Wait(&g_s_lock, nextTick > tick ? (unsigned int)(nextTick - tick) : 1))
+                {
+                    break;
+                }
             }
-        }
 
-        ProGetLocalTimeString(timeString);
-        sprintf(
-            s_traceInfo,
-            "\n"
-            "%s \n"
-            " pro_service_hub --- heartbeat. \n"
-            ,
-            timeString.c_str()
-            );
-        printf("%s", s_traceInfo);
-        logFile->Log(s_traceInfo, PRO_LL_INFO, false);
+            tick = ProGetTickCount64();
+
+            if (tick - heartbeatTick >= LOG_HEARTBEAT_INTERVAL * 1000)
+            {
+                heartbeatTick = tick;
+
+                ProGetLocalTimeString(timeString);
+                sprintf(
+                    s_traceInfo,
+                    "\n"
+                    "%s \n"
+                    " pro_service_hub --- heartbeat. \n"
+                    ,
+                    timeString.c_str()
+                    );
+                printf("%s", s_traceInfo);
+                logFile->Log(s_traceInfo, PRO_LL_INFO, false);
+            }
+
+            if (configInfo.hubs_profile_interval > 0 &&
+                tick - profileTick >= configInfo.hubs_profile_interval * 1000)
+            {
+                profileTick = tick;
+
+                char* profileInfo = (char*)ProMalloc(PROFILE_DUMP_BYTES);
+                if (profileInfo != NULL)
+                {
+                    ProDumpSgiPoolProfile(profileInfo, PROFILE_DUMP_BYTES);
+                    logFile->Log(profileInfo, PRO_LL_INFO, true);
+                    ProFree(profileInfo);
+                }
+            }
+        } /* end of while () */
     }
 
     ProGetLocalTimeString(timeString);
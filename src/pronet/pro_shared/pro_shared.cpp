@@ -40,6 +40,16 @@
 #endif
 #endif
 
+#if !defined(_WIN32) && !defined(PRO_HAS_MACH_ABSOLUTE_TIME) && \
+    !defined(PRO_LACKS_CLOCK_GETTIME) && defined(CLOCK_MONOTONIC_COARSE)
+#define HAS_COARSE_TICK
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HAS_TSC_TICK
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
+#endif
+
 #if defined(_MSC_VER)
 #pragma comment(lib, "winmm.lib")
 #endif
@@ -102,6 +112,132 @@ static CProThreadMutex_i*               g_s_lock2         = NULL;
 static std::__default_alloc_template<3> g_s_allocator3;
 static CProThreadMutex_i*               g_s_lock3         = NULL;
 
+#if !defined(PRO_LACKS_SGI_POOL_TCACHE)
+
+/*
+ * Thread cache (magazine) of one size class of one pool
+ */
+struct PRO_SGI_MAGAZINE
+{
+    std::__Obj*  head;
+    unsigned int count;
+    unsigned int reportedCount; /* the part of "count" folded into g_s_tcacheObjNum */
+    unsigned int hitNum;        /* not yet folded into g_s_tcacheHitNum */
+};
+
+/*
+ * Per-thread magazines of all pools. It's zero-initialized and trivially
+ * destructible, so the hot path pays nothing for the TLS access
+ */
+struct PRO_SGI_TCACHE
+{
+    bool             dead;
+    unsigned int     flushEpoch; /* the last flush request honored */
+    PRO_SGI_MAGAZINE magazines[4][std::__NFREELISTS];
+};
+
+/*
+ * Returns the magazines of a thread to the pools when the thread exits
+ */
+class CProSgiTcacheGuard_i
+{
+public:
+
+    ~CProSgiTcacheGuard_i();
+
+    void Touch()
+    {
+    }
+};
+
+static thread_local PRO_SGI_TCACHE       g_s_tcache;
+static thread_local CProSgiTcacheGuard_i g_s_tcacheGuard;
+static unsigned int                      g_s_tcacheDepth[std::__NFREELISTS];
+static std::atomic<uint64_t>             g_s_tcacheHitNum[4][std::__NFREELISTS];
+static std::atomic<uint64_t>             g_s_tcacheMissNum[4][std::__NFREELISTS];
+static std::atomic<int64_t>              g_s_tcacheObjNum[4][std::__NFREELISTS];
+static std::atomic<unsigned int>         g_s_tcacheFlushEpoch(0); /* bumped by ProTrimSgiPools() */
+
+#if !defined(PRO_LACKS_SGI_POOL_SHARD)
+
+/*
+ * Objects freed by threads of other shards, waiting for the next refill
+ * of their owner pool. They are pushed without a lock and taken as a whole
+ */
+static std::atomic<std::__Obj*>          g_s_remoteFree[4][std::__NFREELISTS];
+static std::atomic<int>                  g_s_remoteFreeNum[4][std::__NFREELISTS];
+static std::atomic<bool>                 g_s_remoteFreePending[4]; /* set when a list turns non-empty */
+
+/*
+ * A remote-free list longer than this many magazines is handed to its pool
+ * by the freeing thread, so that an owner that never refills can't let it
+ * grow without bound
+ */
+#define REMOTE_FREE_LIMIT 4
+
+#endif /* PRO_LACKS_SGI_POOL_SHARD */
+#endif /* PRO_LACKS_SGI_POOL_TCACHE */
+
+#if !defined(PRO_LACKS_SGI_POOL_SHARD)
+static thread_local int                  g_s_tlsShard = -1; /* the pool of the thread, or -1 */
+#endif
+
+/*
+ * The cached tick of a thread, stamped by ProUpdateCachedTickCount64()
+ */
+struct PRO_CACHED_TICK
+{
+    bool         stamped;
+    unsigned int stampNum;
+    int64_t      tickUs;
+    uint64_t     anchorTsc; /* the TSC source counts from here */
+    int64_t      anchorUs;
+};
+
+#define STALENESS_SAMPLE_INTERVAL 16
+#define TSC_ANCHOR_INTERVAL_US    1000000
+
+static thread_local PRO_CACHED_TICK      g_s_tlsCachedTick;
+static volatile int                      g_s_tickSource    = PRO_TICK_SOURCE_PRECISE;
+static double                            g_s_tscPerUs      = 0;
+static std::atomic<uint64_t>             g_s_staleSampleNum(0);
+static std::atomic<uint64_t>             g_s_staleSumUs(0);
+static std::atomic<int64_t>              g_s_staleMaxUs(0);
+
+/*
+ * The spare header word of an object keeps its owner and profile record:
+ * [31] profiled, [30, 29] owner pool, [28, 23] tag, [22, 0] birth tick.
+ * The tick counts PRO_SGI_PROFILE_LIFETIME_UNIT ms, so it wraps after
+ * about 6.2 days rather than 2.3 hours
+ */
+#define PROFILE_FLAG        0x80000000
+#define OWNER_POOL_SHIFT    29
+#define PROFILE_TAG_SHIFT   23
+#define PROFILE_TICK_MASK   0x007FFFFF
+
+#define PROFILE_TICK()      ((uint32_t)(ProGetTickCount64() / PRO_SGI_PROFILE_LIFETIME_UNIT))
+
+#define OWNER_POOL(header)  (((header) >> OWNER_POOL_SHIFT) & 3)
+
+/*
+ * Allocation counters of one size class or of one tag
+ */
+struct PRO_SGI_PROFILE
+{
+    std::atomic<uint64_t> allocNum;
+    std::atomic<uint64_t> freeNum;
+    std::atomic<int64_t>  liveBytes;
+    std::atomic<int64_t>  peakBytes;
+};
+
+static volatile bool                     g_s_profileFlag = false;
+static thread_local unsigned int         g_s_tlsTag      = 0;
+static unsigned int                      g_s_tagNum      = 1; /* tag 0 is the untagged allocations */
+static char                              g_s_tagNames[PRO_SGI_PROFILE_TAGS][32];
+static PRO_SGI_PROFILE                   g_s_classProfiles[4][64];
+static PRO_SGI_PROFILE                   g_s_tagProfiles[PRO_SGI_PROFILE_TAGS];
+static std::atomic<uint64_t>             g_s_tagLifetimes[PRO_SGI_PROFILE_TAGS][PRO_SGI_PROFILE_LIFETIMES];
+
 /////////////////////////////////////////////////////////////////////////////
 ////
 
@@ -311,6 +447,26 @@ Init_i()
     {
         g_s_lock3 = new CProThreadMutex_i;
     }
+
+#if !defined(PRO_LACKS_SGI_POOL_TCACHE)
+    if (g_s_tcacheDepth[0] == 0)
+    {
+        for (int i = 0; i < std::__NFREELISTS; ++i)
+        {
+            size_t depth = PRO_SGI_TCACHE_BYTES / g_s_allocator0.obj_size(i);
+            if (depth > PRO_SGI_TCACHE_DEPTH)
+            {
+                depth = PRO_SGI_TCACHE_DEPTH;
+            }
+            if (depth < 2)
+            {
+                depth = 0; /* not worth caching */
+            }
+
+            g_s_tcacheDepth[i] = (unsigned int)depth;
+        }
+    }
+#endif
 }
 
 static
@@ -349,638 +505,1813 @@ Delay1ms_i()
     }
 }
 
-/////////////////////////////////////////////////////////////////////////////
-////
+#if !defined(PRO_LACKS_SGI_POOL_TCACHE)
 
-PRO_SHARED_API
+static
+std::__Obj*
+AllocateBatch_i(size_t       size,
+                int&         nobjs,
+                unsigned int poolIndex)
+{
+    std::__Obj* head = NULL;
+
+    switch (poolIndex)
+    {
+    case 0:
+        head = g_s_allocator0.allocate_batch(size, nobjs, g_s_lock0);
+        break;
+    case 1:
+        head = g_s_allocator1.allocate_batch(size, nobjs, g_s_lock1);
+        break;
+    case 2:
+        head = g_s_allocator2.allocate_batch(size, nobjs, g_s_lock2);
+        break;
+    case 3:
+        head = g_s_allocator3.allocate_batch(size, nobjs, g_s_lock3);
+        break;
+    }
+
+    return head;
+}
+
+static
 void
-ProSharedVersion(unsigned char* major, /* = NULL */
-                 unsigned char* minor, /* = NULL */
-                 unsigned char* patch) /* = NULL */
+DeallocateBatch_i(std::__Obj*  first,
+                  std::__Obj*  last,
+                  int          nobjs,
+                  size_t       size,
+                  unsigned int poolIndex)
 {
-    if (major != NULL)
+    switch (poolIndex)
     {
-        *major = PRO_VER_MAJOR;
+    case 0:
+        g_s_allocator0.deallocate_batch(first, last, nobjs, size, g_s_lock0);
+        break;
+    case 1:
+        g_s_allocator1.deallocate_batch(first, last, nobjs, size, g_s_lock1);
+        break;
+    case 2:
+        g_s_allocator2.deallocate_batch(first, last, nobjs, size, g_s_lock2);
+        break;
+    case 3:
+        g_s_allocator3.deallocate_batch(first, last, nobjs, size, g_s_lock3);
+        break;
     }
-    if (minor != NULL)
+}
+
+static
+void
+TcacheFlushCounters_i(PRO_SGI_MAGAZINE& mag,
+                      unsigned int      poolIndex,
+                      int               index)
+{
+    if (mag.hitNum > 0)
     {
-        *minor = PRO_VER_MINOR;
+        g_s_tcacheHitNum[poolIndex][index].fetch_add(mag.hitNum, std::memory_order_relaxed);
+        mag.hitNum = 0;
     }
-    if (patch != NULL)
+
+    if (mag.count != mag.reportedCount)
     {
-        *patch = PRO_VER_PATCH;
+        g_s_tcacheObjNum[poolIndex][index].fetch_add(
+            (int64_t)mag.count - (int64_t)mag.reportedCount, std::memory_order_relaxed);
+        mag.reportedCount = mag.count;
     }
 }
 
-PRO_SHARED_API
+/*
+ * Keeps the "keepNum" most recently freed objects of a magazine,
+ * and returns the rest to the pool in one batch
+ */
+static
 void
-ProSrand()
+TcacheDrain_i(PRO_SGI_MAGAZINE& mag,
+              unsigned int      keepNum,
+              unsigned int      poolIndex,
+              int               index)
 {
-    srand((unsigned int)time(NULL));
-}
+    if (mag.count <= keepNum)
+    {
+        return;
+    }
 
-PRO_SHARED_API
-double
-ProRand_0_1()
-{
-    double ret = 0.0;
+    std::__Obj* first = mag.head;
+    for (unsigned int i = 0; i < keepNum; ++i)
+    {
+        first = first->_M_free_list_link;
+    }
 
-    for (int i = 0; i < 2; ++i)
+    std::__Obj* last = first;
+    while (last->_M_free_list_link != NULL)
     {
-        static std::atomic<bool> s_badDev;
-        if (!s_badDev)
+        last = last->_M_free_list_link;
+    }
+
+    if (keepNum == 0)
+    {
+        mag.head = NULL;
+    }
+    else
+    {
+        std::__Obj* keepLast = mag.head;
+        for (unsigned int i = 1; i < keepNum; ++i)
         {
-            /*
-             * Use try/catch to prevent std::random_device crashes on Android.
-             */
-            try
-            {
-                static thread_local std::random_device s_dev;
-                static thread_local std::seed_seq      s_seeds({ s_dev(), s_dev() % 12345678 });
-                static thread_local std::mt19937       s_gen(s_seeds);
+            keepLast = keepLast->_M_free_list_link;
+        }
 
-                static thread_local std::uniform_real_distribution<double> s_dist(0.0, 1.0);
+        keepLast->_M_free_list_link = NULL;
+    }
 
-                ret = s_dist(s_gen);
-                break;
-            }
-            catch (const std::exception&)
-            {
-                s_badDev = true;
-            }
-        }
-        else
-        {
-            auto ticks = std::chrono::system_clock::now().time_since_epoch().count();
+    DeallocateBatch_i(first, last, (int)(mag.count - keepNum),
+        g_s_allocator0.obj_size(index), poolIndex);
 
-            static thread_local std::seed_seq s_seeds({ ticks, ticks % 12345678 });
-            static thread_local std::mt19937  s_gen(s_seeds);
+    mag.count = keepNum;
+    TcacheFlushCounters_i(mag, poolIndex, index);
+}
 
-            static thread_local std::uniform_real_distribution<double> s_dist(0.0, 1.0);
+#if !defined(PRO_LACKS_SGI_POOL_SHARD)
 
-            ret = s_dist(s_gen);
-            break;
-        }
-    } /* end of for () */
+/*
+ * Takes all the objects of a remote-free list
+ */
+static
+std::__Obj*
+RemoteTake_i(unsigned int  poolIndex,
+             int           index,
+             std::__Obj*&  last,
+             unsigned int& count)
+{
+    last  = NULL;
+    count = 0;
 
-    if (ret < 0)
+    std::atomic<std::__Obj*>& head = g_s_remoteFree[poolIndex][index];
+    if (head.load(std::memory_order_relaxed) == NULL)
     {
-        ret = 0;
+        return NULL;
     }
-    if (ret > 1)
+
+    std::__Obj* first = head.exchange(NULL, std::memory_order_acquire);
+
+    for (std::__Obj* obj = first; obj != NULL; obj = obj->_M_free_list_link)
     {
-        ret = 1;
+        last = obj;
+        ++count;
     }
 
-    return ret;
+    g_s_remoteFreeNum[poolIndex][index].fetch_sub((int)count, std::memory_order_relaxed);
+
+    return first;
 }
 
-PRO_SHARED_API
-int
-ProRand_0_32767()
+/*
+ * Return: false if the object should go to its pool the usual way
+ */
+static
+bool
+RemoteDeallocate_i(void*        buf,
+                   size_t       size,
+                   unsigned int poolIndex)
 {
-    int ret = 0;
-
-    for (int i = 0; i < 2; ++i)
+    if (size > (size_t)std::__MAX_OBJ_BYTES)
     {
-        static std::atomic<bool> s_badDev;
-        if (!s_badDev)
-        {
-            /*
-             * Use try/catch to prevent std::random_device crashes on Android.
-             */
-            try
-            {
-                static thread_local std::random_device s_dev;
-                static thread_local std::seed_seq      s_seeds({ s_dev(), s_dev() % 12345678 });
-                static thread_local std::mt19937       s_gen(s_seeds);
-
-                static thread_local std::uniform_int_distribution<int> s_dist(0, 32767);
+        return false;
+    }
 
-                ret = s_dist(s_gen);
-                break;
-            }
-            catch (const std::exception&)
-            {
-                s_badDev = true;
-            }
-        }
-        else
-        {
-            auto ticks = std::chrono::system_clock::now().time_since_epoch().count();
+    int index = g_s_allocator0.freelist_index(size);
+    if (g_s_tcacheDepth[index] == 0)
+    {
+        return false; /* nobody would pick it up */
+    }
 
-            static thread_local std::seed_seq s_seeds({ ticks, ticks % 12345678 });
-            static thread_local std::mt19937  s_gen(s_seeds);
+    std::atomic<std::__Obj*>& head = g_s_remoteFree[poolIndex][index];
 
-            static thread_local std::uniform_int_distribution<int> s_dist(0, 32767);
+    std::__Obj* obj  = (std::__Obj*)buf;
+    std::__Obj* next = head.load(std::memory_order_relaxed);
 
-            ret = s_dist(s_gen);
-            break;
-        }
-    } /* end of for () */
+    do
+    {
+        obj->_M_free_list_link = next;
+    }
+    while (!head.compare_exchange_weak(
+        next, obj, std::memory_order_release, std::memory_order_relaxed));
 
-    if (ret < 0)
+    if (next == NULL)
     {
-        ret = 0;
+        g_s_remoteFreePending[poolIndex].store(true, std::memory_order_release);
     }
-    if (ret > 32767)
+
+    int limit = (int)(g_s_tcacheDepth[index] * REMOTE_FREE_LIMIT);
+    if (g_s_remoteFreeNum[poolIndex][index].fetch_add(1, std::memory_order_relaxed) + 1 >= limit)
     {
-        ret = 32767;
+        std::__Obj*  last      = NULL;
+        unsigned int remoteNum = 0;
+
+        std::__Obj* first = RemoteTake_i(poolIndex, index, last, remoteNum);
+        if (first != NULL)
+        {
+            DeallocateBatch_i(first, last, (int)remoteNum, g_s_allocator0.obj_size(index), poolIndex);
+        }
     }
 
-    return ret;
+    return true;
 }
 
-PRO_SHARED_API
-int64_t
-ProGetTickCount64()
-{
-    Init_i();
+#endif /* PRO_LACKS_SGI_POOL_SHARD */
 
-    int64_t ret = 0;
+/*
+ * Return: false if the request should go to the pool directly
+ */
+static
+bool
+TcacheAllocate_i(size_t       size,
+                 unsigned int poolIndex,
+                 void*&       buf)
+{
+    if (size > (size_t)std::__MAX_OBJ_BYTES || g_s_tcache.dead)
+    {
+        return false;
+    }
 
-#if defined(_WIN32)
+    int index = g_s_allocator0.freelist_index(size);
 
-    if (!g_s_tlsFlag)
+    unsigned int depth = g_s_tcacheDepth[index];
+    if (depth == 0)
     {
-        g_s_lock->Lock();
-        if (!g_s_tlsFlag) /* double check */
-        {
-            g_s_globalTick = ::timeGetTime();
-            g_s_tlsFlag    = true;
-        }
-        g_s_lock->Unlock();
+        return false;
     }
 
-    bool updateGlobalTick = false;
+    PRO_SGI_MAGAZINE& mag = g_s_tcache.magazines[poolIndex][index];
 
-    uint32_t tick0 = g_s_tlsTick0;
-    uint32_t tick1 = g_s_tlsTick1;
-    if (tick0 == 0 && tick1 == 0)
+    std::__Obj* obj = mag.head;
+    if (obj != NULL)
     {
-        g_s_lock->Lock();
-        tick0 = (uint32_t)g_s_globalTick;
-        tick1 = (uint32_t)(g_s_globalTick >> 32);
-        g_s_lock->Unlock();
+        mag.head = obj->_M_free_list_link;
+        --mag.count;
+        ++mag.hitNum;
 
-        g_s_tlsTick0 = tick0;
-        g_s_tlsTick1 = tick1;
+        buf = obj;
 
-        updateGlobalTick = true;
+        return true;
     }
 
-    uint32_t tick = ::timeGetTime();
-    if (tick > tick0)
+    g_s_tcacheGuard.Touch(); /* register the drain at thread exit */
+
+#if !defined(PRO_LACKS_SGI_POOL_SHARD)
+    /*
+     * refill from the objects handed back by other shards first
+     */
     {
-        tick0 = tick;
+        std::__Obj*  last      = NULL;
+        unsigned int remoteNum = 0;
 
-        g_s_tlsTick0 = tick0;
+        obj = RemoteTake_i(poolIndex, index, last, remoteNum);
+        if (obj != NULL)
+        {
+            mag.head  = obj->_M_free_list_link;
+            mag.count = remoteNum - 1;
+            if (mag.count > depth)
+            {
+                TcacheDrain_i(mag, depth / 2, poolIndex, index);
+            }
+            else
+            {
+                TcacheFlushCounters_i(mag, poolIndex, index);
+            }
+
+            buf = obj;
+
+            return true;
+        }
     }
-    else if (tick < tick0)
+#endif
+
+    /*
+     * refill: one for the caller, and half a magazine for later
+     */
+    int nobjs = (int)(depth / 2) + 1;
+
+    obj = AllocateBatch_i(size, nobjs, poolIndex);
+    if (obj != NULL)
     {
-        tick0 = tick;
-        ++tick1;
+        mag.head  = obj->_M_free_list_link;
+        mag.count = nobjs - 1;
+    }
 
-        g_s_tlsTick0 = tick0;
-        g_s_tlsTick1 = tick1;
+    g_s_tcacheMissNum[poolIndex][index].fetch_add(1, std::memory_order_relaxed);
+    TcacheFlushCounters_i(mag, poolIndex, index);
 
-        updateGlobalTick = true;
+    buf = obj;
+
+    return true;
+}
+
+/*
+ * Return: false if the request should go to the pool directly
+ */
+static
+bool
+TcacheDeallocate_i(void*        buf,
+                   size_t       size,
+                   unsigned int poolIndex)
+{
+    if (size > (size_t)std::__MAX_OBJ_BYTES || g_s_tcache.dead)
+    {
+        return false;
     }
-    else
+
+    int index = g_s_allocator0.freelist_index(size);
+
+    unsigned int depth = g_s_tcacheDepth[index];
+    if (depth == 0)
     {
+        return false;
     }
 
-    ret =   tick1;
-    ret <<= 32;
-    ret |=  tick0;
+    PRO_SGI_MAGAZINE& mag = g_s_tcache.magazines[poolIndex][index];
 
-    if (updateGlobalTick)
+    if (mag.count == 0)
     {
-        g_s_lock->Lock();
-        if (ret > g_s_globalTick)
-        {
-            g_s_globalTick = ret;
-        }
-        g_s_lock->Unlock();
+        g_s_tcacheGuard.Touch(); /* register the drain at thread exit */
     }
 
-#elif defined(PRO_HAS_MACH_ABSOLUTE_TIME) /* for iOS/macOS */
+    std::__Obj* obj = (std::__Obj*)buf;
+    obj->_M_free_list_link = mag.head;
+    mag.head = obj;
+    ++mag.count;
 
-    if (!g_s_timebaseFlag)
+    if (mag.count > depth)
     {
-        g_s_lock->Lock();
-        if (!g_s_timebaseFlag) /* double check */
-        {
-            mach_timebase_info(&g_s_timebaseInfo);
-            g_s_timebaseFlag = true;
-        }
-        g_s_lock->Unlock();
+        TcacheDrain_i(mag, depth / 2, poolIndex, index);
     }
 
-    ret =  mach_absolute_time();
-    ret =  ret * g_s_timebaseInfo.numer / g_s_timebaseInfo.denom; /* ns_ticks ---> ns */
-    ret /= 1000000;                                               /* ns       ---> ms */
+    return true;
+}
 
-#elif !defined(PRO_LACKS_CLOCK_GETTIME)
+CProSgiTcacheGuard_i::~CProSgiTcacheGuard_i()
+{
+    g_s_tcache.dead = true;
 
-    struct timespec now = { 0 };
-    clock_gettime(CLOCK_MONOTONIC, &now);
+    for (unsigned int i = 0; i < 4; ++i)
+    {
+        for (int j = 0; j < std::__NFREELISTS; ++j)
+        {
+            PRO_SGI_MAGAZINE& mag = g_s_tcache.magazines[i][j];
 
-    ret = (int64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+            TcacheDrain_i(mag, 0, i, j);
+            TcacheFlushCounters_i(mag, i, j);
+        }
+    }
+}
 
-#else
+#endif /* PRO_LACKS_SGI_POOL_TCACHE */
 
-    assert(0);
+/*
+ * madvise(MADV_HUGEPAGE) succeeds even if THP is switched off,
+ * so ask the kernel whether it will honour the advice
+ */
+static
+bool
+ThpAvailable_i()
+{
+#if defined(__linux__)
+    FILE* file = fopen("/sys/kernel/mm/transparent_hugepage/enabled", "r");
+    if (file == NULL)
+    {
+        return false;
+    }
 
-#endif
+    char line[256] = "";
+    if (fgets(line, sizeof(line), file) == NULL)
+    {
+        line[0] = '\0';
+    }
+    fclose(file);
 
-    return ret;
+    return strstr(line, "[always]") != NULL || strstr(line, "[madvise]") != NULL;
+#else
+    return false;
+#endif
 }
 
-PRO_SHARED_API
-int64_t
-ProGetNtpTickCount64()
+static
+void
+ProfileAdd_i(PRO_SGI_PROFILE& profile,
+             size_t           size)
 {
-    Init_i();
+    profile.allocNum.fetch_add(1, std::memory_order_relaxed);
 
-    int64_t tick1970 = 0;
+    int64_t liveBytes =
+        profile.liveBytes.fetch_add((int64_t)size, std::memory_order_relaxed) + (int64_t)size;
+    int64_t peakBytes = profile.peakBytes.load(std::memory_order_relaxed);
 
-#if defined(_WIN32)
+    while (liveBytes > peakBytes &&
+        !profile.peakBytes.compare_exchange_weak(peakBytes, liveBytes, std::memory_order_relaxed))
+    {
+    }
+}
 
-    FILETIME ft;
-    ::GetSystemTimeAsFileTime(&ft);
+static
+void
+ProfileSub_i(PRO_SGI_PROFILE& profile,
+             size_t           size)
+{
+    profile.freeNum.fetch_add(1, std::memory_order_relaxed);
+    profile.liveBytes.fetch_sub((int64_t)size, std::memory_order_relaxed);
+}
 
-    int64_t ft64 = ft.dwHighDateTime;
-    ft64 <<= 32;
-    ft64 |=  ft.dwLowDateTime;
-    ft64 /=  10000;
+/*
+ * size : the object size, including the header
+ *
+ * Return: the header word of the object
+ */
+static
+uint32_t
+ProfileAllocate_i(size_t       size,
+                  unsigned int poolIndex,
+                  unsigned int tag,
+                  uint32_t     birthTick)
+{
+    ProfileAdd_i(g_s_classProfiles[poolIndex][g_s_allocator0.class_index(size)], size);
+    ProfileAdd_i(g_s_tagProfiles[tag], size);
 
-    const int64_t TIME_DIFF_WINDOWS_UNIX = 11644473600LL; /* 1601 ---> 1970 */
+    return PROFILE_FLAG | (poolIndex << OWNER_POOL_SHIFT) | (tag << PROFILE_TAG_SHIFT) |
+        (birthTick & PROFILE_TICK_MASK);
+}
 
-    tick1970 = ft64 - TIME_DIFF_WINDOWS_UNIX * 1000;
+/*
+ * The object is counted against the pool and the tag it was allocated with
+ */
+static
+void
+ProfileDeallocate_i(uint32_t header,
+                    size_t   size,
+                    bool     lifetime)
+{
+    unsigned int poolIndex = OWNER_POOL(header);
+    unsigned int tag       = (header >> PROFILE_TAG_SHIFT) & (PRO_SGI_PROFILE_TAGS - 1);
 
-#else  /* _WIN32 */
+    ProfileSub_i(g_s_classProfiles[poolIndex][g_s_allocator0.class_index(size)], size);
+    ProfileSub_i(g_s_tagProfiles[tag], size);
 
-    struct timeval now = { 0 };
-    if (gettimeofday(&now, NULL) == 0)
+    if (!lifetime)
     {
-        tick1970 = (int64_t)now.tv_sec * 1000 + now.tv_usec / 1000;
+        return;
     }
 
-#endif /* _WIN32 */
-
-    const int64_t TIME_DIFF_UNIX_NTP = 2208988800LL; /* 1970 ---> 1900 */
+    /*
+     * [0] < 1 unit, [i] in [2^(i-1), 2^i) units, the last one has the rest
+     */
+    uint32_t units  = (PROFILE_TICK() - header) & PROFILE_TICK_MASK;
+    int      bucket = 0;
+    while (units > 0 && bucket < PRO_SGI_PROFILE_LIFETIMES - 1)
+    {
+        units >>= 1;
+        ++bucket;
+    }
 
-    return tick1970 + TIME_DIFF_UNIX_NTP * 1000;
+    g_s_tagLifetimes[tag][bucket].fetch_add(1, std::memory_order_relaxed);
 }
 
+/////////////////////////////////////////////////////////////////////////////
+////
+
 PRO_SHARED_API
 void
-ProSleep(unsigned int milliseconds)
+ProSharedVersion(unsigned char* major, /* = NULL */
+                 unsigned char* minor, /* = NULL */
+                 unsigned char* patch) /* = NULL */
 {
-    Init_i();
-
-    if (milliseconds == 0)
+    if (major != NULL)
     {
-#if defined(_WIN32)
-        ::Sleep(0);
-#else
-        usleep(0);
-#endif
-
-        return;
+        *major = PRO_VER_MAJOR;
     }
-
-    if (milliseconds == (unsigned int)-1)
+    if (minor != NULL)
     {
-        while (1)
-        {
-#if defined(_WIN32)
-            ::Sleep(-1);
-#else
-            usleep(999999);
-#endif
-        }
+        *minor = PRO_VER_MINOR;
     }
-
-    if (!g_s_socketFlag)
+    if (patch != NULL)
     {
-        g_s_lock->Lock();
-        if (!g_s_socketFlag) /* double check */
-        {
-            InitSocket_i();
-            g_s_socketFlag = true;
-        }
-        g_s_lock->Unlock();
+        *patch = PRO_VER_PATCH;
     }
+}
 
-    int64_t t0 = ProGetTickCount64();
-    int64_t te = t0 + milliseconds;
-    int64_t t  = 0;
+PRO_SHARED_API
+void
+ProSrand()
+{
+    srand((unsigned int)time(NULL));
+}
 
-    while (1)
+PRO_SHARED_API
+double
+ProRand_0_1()
+{
+    double ret = 0.0;
+
+    for (int i = 0; i < 2; ++i)
     {
-        t = t == 0 ? t0 : ProGetTickCount64();
-        if (t >= te)
+        static std::atomic<bool> s_badDev;
+        if (!s_badDev)
         {
-            break;
-        }
+            /*
+             * Use try/catch to prevent std::random_device crashes on Android.
+             */
+            try
+            {
+                static thread_local std::random_device s_dev;
+                static thread_local std::seed_seq      s_seeds({ s_dev(), s_dev() % 12345678 });
+                static thread_local std::mt19937       s_gen(s_seeds);
 
-        int64_t sockId = g_s_sockId;
-        if (sockId == -1)
-        {
-            g_s_lock->Lock();
-            FiniSocket_i();
-            InitSocket_i();
-            g_s_lock->Unlock();
+                static thread_local std::uniform_real_distribution<double> s_dist(0.0, 1.0);
 
-            Delay1ms_i();
-            continue;
+                ret = s_dist(s_gen);
+                break;
+            }
+            catch (const std::exception&)
+            {
+                s_badDev = true;
+            }
         }
+        else
+        {
+            auto ticks = std::chrono::system_clock::now().time_since_epoch().count();
 
-#if defined(_WIN32)
-
-        pbsd_fd_set fds;
-        PBSD_FD_ZERO(&fds);
-        PBSD_FD_SET(sockId, &fds);
-
-        struct timeval timeout = { 0 };
-        timeout.tv_sec  = (long)((te - t) / 1000);
-        timeout.tv_usec = (long)((te - t) % 1000 * 1000);
-
-        int retc = pbsd_select_i(NULL, NULL, &fds, &timeout);
+            static thread_local std::seed_seq s_seeds({ ticks, ticks % 12345678 });
+            static thread_local std::mt19937  s_gen(s_seeds);
 
-        assert(retc == 0);
-        if (retc != 0)
-        {
-            g_s_lock->Lock();
-            FiniSocket_i();
-            InitSocket_i();
-            g_s_lock->Unlock();
+            static thread_local std::uniform_real_distribution<double> s_dist(0.0, 1.0);
 
-            Delay1ms_i();
+            ret = s_dist(s_gen);
+            break;
         }
+    } /* end of for () */
 
-#elif defined(PRO_HAS_NANOSLEEP) /* for Linux */
-
-        struct timespec req = { 0 };
-        req.tv_sec  = (time_t)((te - t) / 1000);
-        req.tv_nsec = (long)  ((te - t) % 1000 * 1000000);
+    if (ret < 0)
+    {
+        ret = 0;
+    }
+    if (ret > 1)
+    {
+        ret = 1;
+    }
 
-        nanosleep(&req, NULL);
+    return ret;
+}
 
-#else                            /* for non-Linux */
+PRO_SHARED_API
+int
+ProRand_0_32767()
+{
+    int ret = 0;
 
-    pbsd_pollfd pfd;
-    memset(&pfd, 0, sizeof(pbsd_pollfd));
-    pfd.fd = (int)sockId;
+    for (int i = 0; i < 2; ++i)
+    {
+        static std::atomic<bool> s_badDev;
+        if (!s_badDev)
+        {
+            /*
+             * Use try/catch to prevent std::random_device crashes on Android.
+             */
+            try
+            {
+                static thread_local std::random_device s_dev;
+                static thread_local std::seed_seq      s_seeds({ s_dev(), s_dev() % 12345678 });
+                static thread_local std::mt19937       s_gen(s_seeds);
 
-    int retc = pbsd_poll_i(&pfd, 1, (int)(te - t));
+                static thread_local std::uniform_int_distribution<int> s_dist(0, 32767);
 
-    assert(retc == 0);
-    if (retc != 0)
+                ret = s_dist(s_gen);
+                break;
+            }
+            catch (const std::exception&)
+            {
+                s_badDev = true;
+            }
+        }
+        else
+        {
+            auto ticks = std::chrono::system_clock::now().time_since_epoch().count();
+
+            static thread_local std::seed_seq s_seeds({ ticks, ticks % 12345678 });
+            static thread_local std::mt19937  s_gen(s_seeds);
+
+            static thread_local std::uniform_int_distribution<int> s_dist(0, 32767);
+
+            ret = s_dist(s_gen);
+            break;
+        }
+    } /* end of for () */
+
+    if (ret < 0)
+    {
+        ret = 0;
+    }
+    if (ret > 32767)
+    {
+        ret = 32767;
+    }
+
+    return ret;
+}
+
+PRO_SHARED_API
+int64_t
+ProGetTickCount64()
+{
+    Init_i();
+
+    int64_t ret = 0;
+
+#if defined(_WIN32)
+
+    if (!g_s_tlsFlag)
     {
         g_s_lock->Lock();
-        FiniSocket_i();
-        InitSocket_i();
+        if (!g_s_tlsFlag) /* double check */
+        {
+            g_s_globalTick = ::timeGetTime();
+            g_s_tlsFlag    = true;
+        }
         g_s_lock->Unlock();
+    }
 
-        Delay1ms_i();
+    bool updateGlobalTick = false;
+
+    uint32_t tick0 = g_s_tlsTick0;
+    uint32_t tick1 = g_s_tlsTick1;
+    if (tick0 == 0 && tick1 == 0)
+    {
+        g_s_lock->Lock();
+        tick0 = (uint32_t)g_s_globalTick;
+        tick1 = (uint32_t)(g_s_globalTick >> 32);
+        g_s_lock->Unlock();
+
+        g_s_tlsTick0 = tick0;
+        g_s_tlsTick1 = tick1;
+
+        updateGlobalTick = true;
+    }
+
+    uint32_t tick = ::timeGetTime();
+    if (tick > tick0)
+    {
+        tick0 = tick;
+
+        g_s_tlsTick0 = tick0;
+    }
+    else if (tick < tick0)
+    {
+        tick0 = tick;
+        ++tick1;
+
+        g_s_tlsTick0 = tick0;
+        g_s_tlsTick1 = tick1;
+
+        updateGlobalTick = true;
+    }
+    else
+    {
+    }
+
+    ret =   tick1;
+    ret <<= 32;
+    ret |=  tick0;
+
+    if (updateGlobalTick)
+    {
+        g_s_lock->Lock();
+        if (ret > g_s_globalTick)
+        {
+            g_s_globalTick = ret;
+        }
+        g_s_lock->Unlock();
     }
 
+#elif defined(PRO_HAS_MACH_ABSOLUTE_TIME) /* for iOS/macOS */
+
+    if (!g_s_timebaseFlag)
+    {
+        g_s_lock->Lock();
+        if (!g_s_timebaseFlag) /* double check */
+        {
+            mach_timebase_info(&g_s_timebaseInfo);
+            g_s_timebaseFlag = true;
+        }
+        g_s_lock->Unlock();
+    }
+
+    ret =  mach_absolute_time();
+    ret =  ret * g_s_timebaseInfo.numer / g_s_timebaseInfo.denom; /* ns_ticks ---> ns */
+    ret /= 1000000;                                               /* ns       ---> ms */
+
+#elif !defined(PRO_LACKS_CLOCK_GETTIME)
+
+    struct timespec now = { 0 };
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    ret = (int64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+
+#else
+
+    assert(0);
+
 #endif
-    } /* end of while () */
+
+    return ret;
+}
+
+PRO_SHARED_API
+int64_t
+ProGetNtpTickCount64()
+{
+    Init_i();
+
+    int64_t tick1970 = 0;
+
+#if defined(_WIN32)
+
+    FILETIME ft;
+    ::GetSystemTimeAsFileTime(&ft);
+
+    int64_t ft64 = ft.dwHighDateTime;
+    ft64 <<= 32;
+    ft64 |=  ft.dwLowDateTime;
+    ft64 /=  10000;
+
+    const int64_t TIME_DIFF_WINDOWS_UNIX = 11644473600LL; /* 1601 ---> 1970 */
+
+    tick1970 = ft64 - TIME_DIFF_WINDOWS_UNIX * 1000;
+
+#else  /* _WIN32 */
+
+    struct timeval now = { 0 };
+    if (gettimeofday(&now, NULL) == 0)
+    {
+        tick1970 = (int64_t)now.tv_sec * 1000 + now.tv_usec / 1000;
+    }
+
+#endif /* _WIN32 */
+
+    const int64_t TIME_DIFF_UNIX_NTP = 2208988800LL; /* 1970 ---> 1900 */
+
+    return tick1970 + TIME_DIFF_UNIX_NTP * 1000;
+}
+
+PRO_SHARED_API
+void
+ProSleep(unsigned int milliseconds)
+{
+    Init_i();
+
+    if (milliseconds == 0)
+    {
+#if defined(_WIN32)
+        ::Sleep(0);
+#else
+        usleep(0);
+#endif
+
+        return;
+    }
+
+    if (milliseconds == (unsigned int)-1)
+    {
+        while (1)
+        {
+#if defined(_WIN32)
+            ::Sleep(-1);
+#else
+            usleep(999999);
+#endif
+        }
+    }
+
+    if (!g_s_socketFlag)
+    {
+        g_s_lock->Lock();
+        if (!g_s_socketFlag) /* double check */
+        {
+            InitSocket_i();
+            g_s_socketFlag = true;
+        }
+        g_s_lock->Unlock();
+    }
+
+    int64_t t0 = ProGetTickCount64();
+    int64_t te = t0 + milliseconds;
+    int64_t t  = 0;
+
+    while (1)
+    {
+        t = t == 0 ? t0 : ProGetTickCount64();
+        if (t >= te)
+        {
+            break;
+        }
+
+        int64_t sockId = g_s_sockId;
+        if (sockId == -1)
+        {
+            g_s_lock->Lock();
+            FiniSocket_i();
+            InitSocket_i();
+            g_s_lock->Unlock();
+
+            Delay1ms_i();
+            continue;
+        }
+
+#if defined(_WIN32)
+
+        pbsd_fd_set fds;
+        PBSD_FD_ZERO(&fds);
+        PBSD_FD_SET(sockId, &fds);
+
+        struct timeval timeout = { 0 };
+        timeout.tv_sec  = (long)((te - t) / 1000);
+        timeout.tv_usec = (long)((te - t) % 1000 * 1000);
+
+        int retc = pbsd_select_i(NULL, NULL, &fds, &timeout);
+
+        assert(retc == 0);
+        if (retc != 0)
+        {
+            g_s_lock->Lock();
+            FiniSocket_i();
+            InitSocket_i();
+            g_s_lock->Unlock();
+
+            Delay1ms_i();
+        }
+
+#elif defined(PRO_HAS_NANOSLEEP) /* for Linux */
+
+        struct timespec req = { 0 };
+        req.tv_sec  = (time_t)((te - t) / 1000);
+        req.tv_nsec = (long)  ((te - t) % 1000 * 1000000);
+
+        nanosleep(&req, NULL);
+
+#else                            /* for non-Linux */
+
+    pbsd_pollfd pfd;
+    memset(&pfd, 0, sizeof(pbsd_pollfd));
+    pfd.fd = (int)sockId;
+
+    int retc = pbsd_poll_i(&pfd, 1, (int)(te - t));
+
+    assert(retc == 0);
+    if (retc != 0)
+    {
+        g_s_lock->Lock();
+        FiniSocket_i();
+        InitSocket_i();
+        g_s_lock->Unlock();
+
+        Delay1ms_i();
+    }
+
+#endif
+    } /* end of while () */
+}
+
+static
+int64_t
+GetPreciseTickUs_i()
+{
+#if defined(HAS_COARSE_TICK)
+    struct timespec now = { 0 };
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (int64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+#else
+    return ProGetTickCount64() * 1000;
+#endif
+}
+
+static
+int64_t
+GetSourceTickUs_i(PRO_CACHED_TICK& cache,
+                  int              source)
+{
+#if defined(HAS_COARSE_TICK)
+    if (source == PRO_TICK_SOURCE_COARSE)
+    {
+        struct timespec now = { 0 };
+        clock_gettime(CLOCK_MONOTONIC_COARSE, &now);
+
+        return (int64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+    }
+#endif
+
+#if defined(HAS_TSC_TICK)
+    if (source == PRO_TICK_SOURCE_TSC)
+    {
+        uint64_t tsc = __rdtsc();
+
+        /*
+         * re-anchor to the precise clock now and then, so that the drift
+         * of the TSC frequency never piles up
+         */
+        if (cache.anchorUs == 0 || tsc < cache.anchorTsc ||
+            tsc - cache.anchorTsc >= (uint64_t)(g_s_tscPerUs * TSC_ANCHOR_INTERVAL_US))
+        {
+            cache.anchorTsc = __rdtsc();
+            cache.anchorUs  = GetPreciseTickUs_i();
+
+            return cache.anchorUs;
+        }
+
+        return cache.anchorUs + (int64_t)((double)(tsc - cache.anchorTsc) / g_s_tscPerUs);
+    }
+#endif
+
+    return GetPreciseTickUs_i();
+}
+
+PRO_SHARED_API
+int
+ProSetCachedTickSource(int source)
+{
+    Init_i();
+
+    if (source == PRO_TICK_SOURCE_TSC)
+    {
+#if defined(HAS_TSC_TICK)
+        unsigned int eax = 0;
+        unsigned int ebx = 0;
+        unsigned int ecx = 0;
+        unsigned int edx = 0;
+
+        /*
+         * the TSC must be invariant, i.e., ticking at a constant rate
+         * through P-, C- and T-states
+         */
+        if (__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) && (edx & (1 << 8)) != 0)
+        {
+            g_s_lock->Lock();
+            if (g_s_tscPerUs == 0)
+            {
+                uint64_t tsc0 = __rdtsc();
+                int64_t  us0  = GetPreciseTickUs_i();
+                usleep(10000);
+                uint64_t tsc1 = __rdtsc();
+                int64_t  us1  = GetPreciseTickUs_i();
+
+                if (us1 > us0 && tsc1 > tsc0)
+                {
+                    g_s_tscPerUs = (double)(tsc1 - tsc0) / (double)(us1 - us0);
+                }
+            }
+            g_s_lock->Unlock();
+        }
+
+        if (g_s_tscPerUs == 0)
+        {
+            source = PRO_TICK_SOURCE_PRECISE;
+        }
+#else
+        source = PRO_TICK_SOURCE_PRECISE;
+#endif
+    }
+    else if (source == PRO_TICK_SOURCE_COARSE)
+    {
+#if !defined(HAS_COARSE_TICK)
+        source = PRO_TICK_SOURCE_PRECISE;
+#endif
+    }
+    else
+    {
+        source = PRO_TICK_SOURCE_PRECISE;
+    }
+
+    g_s_tickSource = source;
+
+    return source;
+}
+
+PRO_SHARED_API
+int64_t
+ProUpdateCachedTickCount64()
+{
+    Init_i();
+
+    PRO_CACHED_TICK& cache  = g_s_tlsCachedTick;
+    int              source = g_s_tickSource;
+    int64_t          tickUs = GetSourceTickUs_i(cache, source);
+
+    if (cache.stamped && ++cache.stampNum % STALENESS_SAMPLE_INTERVAL == 0)
+    {
+        int64_t staleness = (source == PRO_TICK_SOURCE_PRECISE ? tickUs : GetPreciseTickUs_i())
+            - cache.tickUs;
+        if (staleness < 0)
+        {
+            staleness = 0;
+        }
+
+        g_s_staleSampleNum.fetch_add(1, std::memory_order_relaxed);
+        g_s_staleSumUs.fetch_add((uint64_t)staleness, std::memory_order_relaxed);
+
+        int64_t maxUs = g_s_staleMaxUs.load(std::memory_order_relaxed);
+        while (staleness > maxUs &&
+            !g_s_staleMaxUs.compare_exchange_weak(maxUs, staleness, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    if (!cache.stamped || tickUs > cache.tickUs) /* never goes backwards */
+    {
+        cache.tickUs = tickUs;
+    }
+    cache.stamped = true;
+
+    return cache.tickUs / 1000;
+}
+
+PRO_SHARED_API
+void
+ProResetCachedTickCount64()
+{
+    g_s_tlsCachedTick.stamped  = false;
+    g_s_tlsCachedTick.stampNum = 0;
+}
+
+PRO_SHARED_API
+int64_t
+ProGetCachedTickCount64()
+{
+    if (g_s_tlsCachedTick.stamped)
+    {
+        return g_s_tlsCachedTick.tickUs / 1000;
+    }
+
+    return ProGetTickCount64();
+}
+
+PRO_SHARED_API
+void
+ProGetCachedTickStaleness(int64_t*  maxStaleness, /* = NULL */
+                          int64_t*  avgStaleness, /* = NULL */
+                          uint64_t* sampleNum,    /* = NULL */
+                          bool      reset)
+{
+    uint64_t num   = 0;
+    uint64_t sumUs = 0;
+    int64_t  maxUs = 0;
+
+    if (reset)
+    {
+        num   = g_s_staleSampleNum.exchange(0, std::memory_order_relaxed);
+        sumUs = g_s_staleSumUs.exchange(0, std::memory_order_relaxed);
+        maxUs = g_s_staleMaxUs.exchange(0, std::memory_order_relaxed);
+    }
+    else
+    {
+        num   = g_s_staleSampleNum.load(std::memory_order_relaxed);
+        sumUs = g_s_staleSumUs.load(std::memory_order_relaxed);
+        maxUs = g_s_staleMaxUs.load(std::memory_order_relaxed);
+    }
+
+    if (maxStaleness != NULL)
+    {
+        *maxStaleness = maxUs;
+    }
+    if (avgStaleness != NULL)
+    {
+        *avgStaleness = num > 0 ? (int64_t)(sumUs / num) : 0;
+    }
+    if (sampleNum != NULL)
+    {
+        *sampleNum    = num;
+    }
+}
+
+PRO_SHARED_API
+uint64_t
+ProMakeTimerId()
+{
+    Init_i();
+
+    g_s_lock->Lock();
+
+    uint64_t timerId = g_s_nextTimerId;
+    g_s_nextTimerId += 2;
+
+    g_s_lock->Unlock();
+
+    return timerId;
+}
+
+PRO_SHARED_API
+uint64_t
+ProMakeMmTimerId()
+{
+    Init_i();
+
+    g_s_lock->Lock();
+
+    uint64_t timerId = g_s_nextMmTimerId;
+    g_s_nextMmTimerId += 2;
+    if (g_s_nextMmTimerId == 0)
+    {
+        g_s_nextMmTimerId += 2;
+    }
+
+    g_s_lock->Unlock();
+
+    return timerId;
+}
+
+PRO_SHARED_API
+void*
+ProAllocateSgiPoolBuffer(size_t       size,
+                         unsigned int poolIndex) /* [0, 3] */
+{
+    Init_i();
+
+    assert(poolIndex <= 3);
+    if (poolIndex > 3)
+    {
+        return NULL;
+    }
+
+    if (size == 0)
+    {
+        size = sizeof(uint32_t) + sizeof(uint32_t) + 1;
+    }
+    else
+    {
+        size = sizeof(uint32_t) + sizeof(uint32_t) + size;
+    }
+
+#if !defined(PRO_LACKS_SGI_POOL_SHARD)
+    if (poolIndex == 0 && g_s_tlsShard > 0)
+    {
+        poolIndex = (unsigned int)g_s_tlsShard;
+    }
+#endif
+
+    uint32_t* p      = NULL;
+    bool      cached = false;
+
+#if !defined(PRO_LACKS_SGI_POOL_TCACHE)
+    void* buf = NULL;
+    cached = TcacheAllocate_i(size, poolIndex, buf);
+    p      = (uint32_t*)buf;
+#endif
+
+    if (!cached)
+    {
+        switch (poolIndex)
+        {
+        case 0:
+            p = (uint32_t*)g_s_allocator0.allocate(size, g_s_lock0);
+            break;
+        case 1:
+            p = (uint32_t*)g_s_allocator1.allocate(size, g_s_lock1);
+            break;
+        case 2:
+            p = (uint32_t*)g_s_allocator2.allocate(size, g_s_lock2);
+            break;
+        case 3:
+            p = (uint32_t*)g_s_allocator3.allocate(size, g_s_lock3);
+            break;
+        }
+    }
+
+    if (p == NULL)
+    {
+        return NULL;
+    }
+    else
+    {
+        p[0] = (uint32_t)size;
+        p[1] = (uint32_t)poolIndex << OWNER_POOL_SHIFT;
+        if (g_s_profileFlag)
+        {
+            p[1] = ProfileAllocate_i(size, poolIndex, g_s_tlsTag, PROFILE_TICK());
+        }
+
+        return p + 2;
+    }
+}
+
+PRO_SHARED_API
+void*
+ProReallocateSgiPoolBuffer(void*        buf,
+                           size_t       newSize,
+                           unsigned int poolIndex) /* [0, 3] */
+{
+    Init_i();
+
+    assert(poolIndex <= 3);
+    if (poolIndex > 3)
+    {
+        return NULL;
+    }
+
+    if (buf == NULL)
+    {
+        return ProAllocateSgiPoolBuffer(newSize, poolIndex);
+    }
+
+    if (newSize == 0)
+    {
+        ProDeallocateSgiPoolBuffer(buf, poolIndex);
+
+        return NULL;
+    }
+
+    uint32_t* p = (uint32_t*)buf - 2;
+    if (*p < sizeof(uint32_t) + sizeof(uint32_t) + 1)
+    {
+        return NULL;
+    }
+
+    poolIndex = OWNER_POOL(p[1]); /* stay in the owner pool */
+    newSize   = sizeof(uint32_t) + sizeof(uint32_t) + newSize;
+
+    uint32_t  oldSize   = p[0];
+    uint32_t  oldHeader = p[1];
+    uint32_t* q         = NULL;
+
+    switch (poolIndex)
+    {
+    case 0:
+        q = (uint32_t*)g_s_allocator0.reallocate(p, *p, newSize, g_s_lock0);
+        break;
+    case 1:
+        q = (uint32_t*)g_s_allocator1.reallocate(p, *p, newSize, g_s_lock1);
+        break;
+    case 2:
+        q = (uint32_t*)g_s_allocator2.reallocate(p, *p, newSize, g_s_lock2);
+        break;
+    case 3:
+        q = (uint32_t*)g_s_allocator3.reallocate(p, *p, newSize, g_s_lock3);
+        break;
+    }
+
+    if (q == NULL)
+    {
+        return NULL;
+    }
+    else
+    {
+        q[0] = (uint32_t)newSize;
+        q[1] = (uint32_t)poolIndex << OWNER_POOL_SHIFT;
+
+        /*
+         * a resized object keeps its tag and birth tick
+         */
+        if (oldHeader & PROFILE_FLAG)
+        {
+            ProfileDeallocate_i(oldHeader, oldSize, false);
+            q[1] = ProfileAllocate_i(newSize, poolIndex,
+                (oldHeader >> PROFILE_TAG_SHIFT) & (PRO_SGI_PROFILE_TAGS - 1), oldHeader);
+        }
+        else if (g_s_profileFlag)
+        {
+            q[1] = ProfileAllocate_i(newSize, poolIndex, g_s_tlsTag, PROFILE_TICK());
+        }
+        else
+        {
+        }
+
+        return q + 2;
+    }
+}
+
+PRO_SHARED_API
+void
+ProDeallocateSgiPoolBuffer(void*        buf,
+                           unsigned int poolIndex) /* [0, 3] */
+{
+    Init_i();
+
+    assert(poolIndex <= 3);
+    if (buf == NULL || poolIndex > 3)
+    {
+        return;
+    }
+
+    uint32_t* p = (uint32_t*)buf - 2;
+    if (*p < sizeof(uint32_t) + sizeof(uint32_t) + 1)
+    {
+        return;
+    }
+
+    poolIndex = OWNER_POOL(p[1]); /* back to the owner pool */
+
+    if (p[1] & PROFILE_FLAG)
+    {
+        ProfileDeallocate_i(p[1], p[0], true);
+    }
+
+#if !defined(PRO_LACKS_SGI_POOL_TCACHE)
+#if !defined(PRO_LACKS_SGI_POOL_SHARD)
+    if (g_s_tlsShard >= 0 && (unsigned int)g_s_tlsShard != poolIndex &&
+        RemoteDeallocate_i(p, *p, poolIndex))
+    {
+        return;
+    }
+#endif
+
+    if (TcacheDeallocate_i(p, *p, poolIndex))
+    {
+        return;
+    }
+#endif
+
+    switch (poolIndex)
+    {
+    case 0:
+        g_s_allocator0.deallocate(p, *p, g_s_lock0);
+        break;
+    case 1:
+        g_s_allocator1.deallocate(p, *p, g_s_lock1);
+        break;
+    case 2:
+        g_s_allocator2.deallocate(p, *p, g_s_lock2);
+        break;
+    case 3:
+        g_s_allocator3.deallocate(p, *p, g_s_lock3);
+        break;
+    }
+}
+
+static
+void
+GetSgiPoolInfo_i(void*        freeList[64],
+                 size_t       objSize[64],
+                 size_t       busyObjNum[64],
+                 size_t       totalObjNum[64],
+                 size_t*      heapBytes,
+                 size_t*      reclaimableBytes,
+                 unsigned int poolIndex)
+{
+    Init_i();
+
+    memset(freeList   , 0, sizeof(void*)  * 64);
+    memset(objSize    , 0, sizeof(size_t) * 64);
+    memset(busyObjNum , 0, sizeof(size_t) * 64);
+    memset(totalObjNum, 0, sizeof(size_t) * 64);
+    if (heapBytes != NULL)
+    {
+        *heapBytes = 0;
+    }
+    if (reclaimableBytes != NULL)
+    {
+        *reclaimableBytes = 0;
+    }
+
+    assert(poolIndex <= 3);
+    if (poolIndex > 3)
+    {
+        return;
+    }
+
+    switch (poolIndex)
+    {
+    case 0:
+        g_s_allocator0.get_info(freeList, objSize, busyObjNum, totalObjNum, heapBytes, reclaimableBytes, g_s_lock0);
+        break;
+    case 1:
+        g_s_allocator1.get_info(freeList, objSize, busyObjNum, totalObjNum, heapBytes, reclaimableBytes, g_s_lock1);
+        break;
+    case 2:
+        g_s_allocator2.get_info(freeList, objSize, busyObjNum, totalObjNum, heapBytes, reclaimableBytes, g_s_lock2);
+        break;
+    case 3:
+        g_s_allocator3.get_info(freeList, objSize, busyObjNum, totalObjNum, heapBytes, reclaimableBytes, g_s_lock3);
+        break;
+    }
 }
 
 PRO_SHARED_API
-uint64_t
-ProMakeTimerId()
+void
+ProGetSgiPoolInfo(void*        freeList[64],
+                  size_t       objSize[64],
+                  size_t       busyObjNum[64],
+                  size_t       totalObjNum[64],
+                  size_t*      heapBytes, /* = NULL */
+                  unsigned int poolIndex) /* [0, 3] */
 {
-    Init_i();
-
-    g_s_lock->Lock();
-
-    uint64_t timerId = g_s_nextTimerId;
-    g_s_nextTimerId += 2;
-
-    g_s_lock->Unlock();
-
-    return timerId;
+    GetSgiPoolInfo_i(freeList, objSize, busyObjNum, totalObjNum, heapBytes, NULL, poolIndex);
 }
 
 PRO_SHARED_API
-uint64_t
-ProMakeMmTimerId()
+size_t
+ProGetSgiPoolReclaimableBytes(unsigned int poolIndex) /* [0, 3] */
 {
-    Init_i();
-
-    g_s_lock->Lock();
+    void*  freeList[64];
+    size_t objSize[64];
+    size_t busyObjNum[64];
+    size_t totalObjNum[64];
+    size_t reclaimableBytes = 0;
 
-    uint64_t timerId = g_s_nextMmTimerId;
-    g_s_nextMmTimerId += 2;
-    if (g_s_nextMmTimerId == 0)
-    {
-        g_s_nextMmTimerId += 2;
-    }
-
-    g_s_lock->Unlock();
+    GetSgiPoolInfo_i(freeList, objSize, busyObjNum, totalObjNum, NULL, &reclaimableBytes, poolIndex);
 
-    return timerId;
+    return reclaimableBytes;
 }
 
 PRO_SHARED_API
-void*
-ProAllocateSgiPoolBuffer(size_t       size,
-                         unsigned int poolIndex) /* [0, 3] */
+size_t
+ProTrimSgiPools(unsigned int poolIndex) /* [0, 3] */
 {
     Init_i();
 
     assert(poolIndex <= 3);
     if (poolIndex > 3)
     {
-        return NULL;
+        return 0;
     }
 
-    if (size == 0)
+#if !defined(PRO_LACKS_SGI_POOL_TCACHE)
+    if (!g_s_tcache.dead)
     {
-        size = sizeof(uint32_t) + sizeof(uint32_t) + 1;
+        for (int i = 0; i < std::__NFREELISTS; ++i)
+        {
+            TcacheDrain_i(g_s_tcache.magazines[poolIndex][i], 0, poolIndex, i);
+        }
     }
-    else
+
+    /*
+     * the other threads give their magazines back in their next
+     * ProCollectSgiPoolRemoteFrees()
+     */
+    g_s_tcacheFlushEpoch.fetch_add(1, std::memory_order_relaxed);
+
+#if !defined(PRO_LACKS_SGI_POOL_SHARD)
+    for (int i = 0; i < std::__NFREELISTS; ++i)
     {
-        size = sizeof(uint32_t) + sizeof(uint32_t) + size;
+        std::__Obj*  last      = NULL;
+        unsigned int remoteNum = 0;
+
+        std::__Obj* first = RemoteTake_i(poolIndex, i, last, remoteNum);
+        if (first != NULL)
+        {
+            DeallocateBatch_i(first, last, (int)remoteNum, g_s_allocator0.obj_size(i), poolIndex);
+        }
     }
+#endif
+#endif
 
-    uint32_t* p = NULL;
+    size_t releasedBytes = 0;
 
     switch (poolIndex)
     {
     case 0:
-        p = (uint32_t*)g_s_allocator0.allocate(size, g_s_lock0);
+        releasedBytes = g_s_allocator0.trim(g_s_lock0);
         break;
     case 1:
-        p = (uint32_t*)g_s_allocator1.allocate(size, g_s_lock1);
+        releasedBytes = g_s_allocator1.trim(g_s_lock1);
         break;
     case 2:
-        p = (uint32_t*)g_s_allocator2.allocate(size, g_s_lock2);
+        releasedBytes = g_s_allocator2.trim(g_s_lock2);
         break;
     case 3:
-        p = (uint32_t*)g_s_allocator3.allocate(size, g_s_lock3);
+        releasedBytes = g_s_allocator3.trim(g_s_lock3);
         break;
     }
 
-    if (p == NULL)
-    {
-        return NULL;
-    }
-    else
-    {
-        *p = (uint32_t)size;
-
-        return p + 2;
-    }
+    return releasedBytes;
 }
 
 PRO_SHARED_API
-void*
-ProReallocateSgiPoolBuffer(void*        buf,
-                           size_t       newSize,
-                           unsigned int poolIndex) /* [0, 3] */
+void
+ProSetSgiPoolHugePage(bool         enable,
+                      unsigned int poolIndex) /* [0, 3] */
 {
     Init_i();
 
     assert(poolIndex <= 3);
     if (poolIndex > 3)
     {
-        return NULL;
+        return;
     }
 
-    if (buf == NULL)
+    bool hugetlb = enable;
+    bool thp     = enable && ThpAvailable_i();
+
+    switch (poolIndex)
     {
-        return ProAllocateSgiPoolBuffer(newSize, poolIndex);
+    case 0:
+        g_s_allocator0.set_huge_page(hugetlb, thp, g_s_lock0);
+        break;
+    case 1:
+        g_s_allocator1.set_huge_page(hugetlb, thp, g_s_lock1);
+        break;
+    case 2:
+        g_s_allocator2.set_huge_page(hugetlb, thp, g_s_lock2);
+        break;
+    case 3:
+        g_s_allocator3.set_huge_page(hugetlb, thp, g_s_lock3);
+        break;
     }
+}
 
-    if (newSize == 0)
-    {
-        ProDeallocateSgiPoolBuffer(buf, poolIndex);
+PRO_SHARED_API
+void
+ProGetSgiPoolPageInfo(size_t       pageBytes[3],
+                      unsigned int poolIndex) /* [0, 3] */
+{
+    Init_i();
 
-        return NULL;
-    }
+    memset(pageBytes, 0, sizeof(size_t) * 3);
 
-    uint32_t* p = (uint32_t*)buf - 2;
-    if (*p < sizeof(uint32_t) + sizeof(uint32_t) + 1)
+    assert(poolIndex <= 3);
+    if (poolIndex > 3)
     {
-        return NULL;
+        return;
     }
 
-    newSize = sizeof(uint32_t) + sizeof(uint32_t) + newSize;
-
-    uint32_t* q = NULL;
-
     switch (poolIndex)
     {
     case 0:
-        q = (uint32_t*)g_s_allocator0.reallocate(p, *p, newSize, g_s_lock0);
+        g_s_allocator0.get_page_info(pageBytes, g_s_lock0);
         break;
     case 1:
-        q = (uint32_t*)g_s_allocator1.reallocate(p, *p, newSize, g_s_lock1);
+        g_s_allocator1.get_page_info(pageBytes, g_s_lock1);
         break;
     case 2:
-        q = (uint32_t*)g_s_allocator2.reallocate(p, *p, newSize, g_s_lock2);
+        g_s_allocator2.get_page_info(pageBytes, g_s_lock2);
         break;
     case 3:
-        q = (uint32_t*)g_s_allocator3.reallocate(p, *p, newSize, g_s_lock3);
+        g_s_allocator3.get_page_info(pageBytes, g_s_lock3);
         break;
     }
+}
 
-    if (q == NULL)
+PRO_SHARED_API
+void
+ProGetSgiPoolCacheInfo(size_t       hitNum[64],
+                       size_t       missNum[64],
+                       size_t       cachedObjNum[64],
+                       unsigned int poolIndex) /* [0, 3] */
+{
+    Init_i();
+
+    memset(hitNum      , 0, sizeof(size_t) * 64);
+    memset(missNum     , 0, sizeof(size_t) * 64);
+    memset(cachedObjNum, 0, sizeof(size_t) * 64);
+
+    assert(poolIndex <= 3);
+    if (poolIndex > 3)
     {
-        return NULL;
+        return;
     }
-    else
+
+#if !defined(PRO_LACKS_SGI_POOL_TCACHE)
+    for (int i = 0; i < std::__NFREELISTS; ++i)
     {
-        *q = (uint32_t)newSize;
+        int64_t objNum = g_s_tcacheObjNum[poolIndex][i].load(std::memory_order_relaxed);
 
-        return q + 2;
+        hitNum[i]       = (size_t)g_s_tcacheHitNum[poolIndex][i].load(std::memory_order_relaxed);
+        missNum[i]      = (size_t)g_s_tcacheMissNum[poolIndex][i].load(std::memory_order_relaxed);
+        cachedObjNum[i] = objNum > 0 ? (size_t)objNum : 0;
+    }
+#endif
+}
+
+PRO_SHARED_API
+int
+ProSetSgiPoolShard(int shard) /* [0, 3], or -1 */
+{
+    assert(shard >= -1 && shard <= 3);
+    if (shard < -1 || shard > 3)
+    {
+        return -1;
     }
+
+#if !defined(PRO_LACKS_SGI_POOL_SHARD)
+    int oldShard = g_s_tlsShard;
+    g_s_tlsShard = shard;
+
+    return oldShard;
+#else
+    return -1;
+#endif
 }
 
 PRO_SHARED_API
 void
-ProDeallocateSgiPoolBuffer(void*        buf,
-                           unsigned int poolIndex) /* [0, 3] */
+ProCollectSgiPoolRemoteFrees()
 {
-    Init_i();
+#if !defined(PRO_LACKS_SGI_POOL_TCACHE)
+    unsigned int flushEpoch = g_s_tcacheFlushEpoch.load(std::memory_order_relaxed);
+    if (flushEpoch != g_s_tcache.flushEpoch && !g_s_tcache.dead)
+    {
+        g_s_tcache.flushEpoch = flushEpoch;
 
-    assert(poolIndex <= 3);
-    if (buf == NULL || poolIndex > 3)
+        for (unsigned int i = 0; i < 4; ++i)
+        {
+            for (int j = 0; j < std::__NFREELISTS; ++j)
+            {
+                PRO_SGI_MAGAZINE& mag = g_s_tcache.magazines[i][j];
+
+                TcacheDrain_i(mag, 0, i, j);
+                TcacheFlushCounters_i(mag, i, j);
+            }
+        }
+    }
+#endif
+
+#if !defined(PRO_LACKS_SGI_POOL_TCACHE) && !defined(PRO_LACKS_SGI_POOL_SHARD)
+    int shard = g_s_tlsShard;
+    if (shard < 0 || !g_s_remoteFreePending[shard].load(std::memory_order_relaxed))
     {
         return;
     }
 
-    uint32_t* p = (uint32_t*)buf - 2;
-    if (*p < sizeof(uint32_t) + sizeof(uint32_t) + 1)
+    if (!g_s_remoteFreePending[shard].exchange(false, std::memory_order_acquire))
     {
         return;
     }
 
-    switch (poolIndex)
+    for (int i = 0; i < std::__NFREELISTS; ++i)
     {
-    case 0:
-        g_s_allocator0.deallocate(p, *p, g_s_lock0);
-        break;
-    case 1:
-        g_s_allocator1.deallocate(p, *p, g_s_lock1);
-        break;
-    case 2:
-        g_s_allocator2.deallocate(p, *p, g_s_lock2);
-        break;
-    case 3:
-        g_s_allocator3.deallocate(p, *p, g_s_lock3);
-        break;
+        std::__Obj*  last      = NULL;
+        unsigned int remoteNum = 0;
+
+        std::__Obj* first = RemoteTake_i(shard, i, last, remoteNum);
+        if (first == NULL)
+        {
+            continue;
+        }
+
+        unsigned int depth = g_s_tcacheDepth[i];
+        if (depth == 0 || g_s_tcache.dead)
+        {
+            DeallocateBatch_i(first, last, (int)remoteNum, g_s_allocator0.obj_size(i), shard);
+            continue;
+        }
+
+        g_s_tcacheGuard.Touch(); /* register the drain at thread exit */
+
+        PRO_SGI_MAGAZINE& mag = g_s_tcache.magazines[shard][i];
+
+        last->_M_free_list_link = mag.head;
+        mag.head                = first;
+        mag.count              += remoteNum;
+        if (mag.count > depth)
+        {
+            TcacheDrain_i(mag, depth / 2, shard, i);
+        }
+        else
+        {
+            TcacheFlushCounters_i(mag, shard, i);
+        }
     }
+#endif
 }
 
 PRO_SHARED_API
 void
-ProGetSgiPoolInfo(void*        freeList[64],
-                  size_t       objSize[64],
-                  size_t       busyObjNum[64],
-                  size_t       totalObjNum[64],
-                  size_t*      heapBytes, /* = NULL */
-                  unsigned int poolIndex) /* [0, 3] */
+ProEnableSgiPoolProfile(bool enable)
 {
     Init_i();
 
-    memset(freeList   , 0, sizeof(void*)  * 64);
-    memset(objSize    , 0, sizeof(size_t) * 64);
-    memset(busyObjNum , 0, sizeof(size_t) * 64);
-    memset(totalObjNum, 0, sizeof(size_t) * 64);
-    if (heapBytes != NULL)
+    g_s_profileFlag = enable;
+}
+
+PRO_SHARED_API
+unsigned int
+ProRegisterSgiPoolTag(const char* name)
+{
+    Init_i();
+
+    assert(name != NULL);
+    assert(name[0] != '\0');
+    if (name == NULL || name[0] == '\0')
     {
-        *heapBytes = 0;
+        return 0;
+    }
+
+    unsigned int tag = 0;
+
+    g_s_lock->Lock();
+
+    for (unsigned int i = 1; i < g_s_tagNum; ++i)
+    {
+        if (strcmp(g_s_tagNames[i], name) == 0)
+        {
+            tag = i;
+            break;
+        }
+    }
+
+    if (tag == 0 && g_s_tagNum < PRO_SGI_PROFILE_TAGS)
+    {
+        tag = g_s_tagNum;
+        ++g_s_tagNum;
+
+        strncpy(g_s_tagNames[tag], name, sizeof(g_s_tagNames[tag]) - 1);
+    }
+
+    g_s_lock->Unlock();
+
+    return tag;
+}
+
+PRO_SHARED_API
+unsigned int
+ProSetSgiPoolTag(unsigned int tag)
+{
+    if (tag >= PRO_SGI_PROFILE_TAGS)
+    {
+        tag = 0;
     }
 
+    unsigned int oldTag = g_s_tlsTag;
+    g_s_tlsTag = tag;
+
+    return oldTag;
+}
+
+PRO_SHARED_API
+void
+ProGetSgiPoolProfile(uint64_t     allocNum[64],
+                     uint64_t     freeNum[64],
+                     size_t       liveBytes[64],
+                     size_t       peakBytes[64],
+                     unsigned int poolIndex) /* [0, 3] */
+{
+    Init_i();
+
+    memset(allocNum , 0, sizeof(uint64_t) * 64);
+    memset(freeNum  , 0, sizeof(uint64_t) * 64);
+    memset(liveBytes, 0, sizeof(size_t)   * 64);
+    memset(peakBytes, 0, sizeof(size_t)   * 64);
+
     assert(poolIndex <= 3);
     if (poolIndex > 3)
     {
         return;
     }
 
-    switch (poolIndex)
+    for (int i = 0; i < 64; ++i)
     {
-    case 0:
-        g_s_allocator0.get_info(freeList, objSize, busyObjNum, totalObjNum, heapBytes, g_s_lock0);
-        break;
-    case 1:
-        g_s_allocator1.get_info(freeList, objSize, busyObjNum, totalObjNum, heapBytes, g_s_lock1);
-        break;
-    case 2:
-        g_s_allocator2.get_info(freeList, objSize, busyObjNum, totalObjNum, heapBytes, g_s_lock2);
-        break;
-    case 3:
-        g_s_allocator3.get_info(freeList, objSize, busyObjNum, totalObjNum, heapBytes, g_s_lock3);
-        break;
+        const PRO_SGI_PROFILE& profile = g_s_classProfiles[poolIndex][i];
+
+        int64_t live = profile.liveBytes.load(std::memory_order_relaxed);
+
+        allocNum[i]  = profile.allocNum.load(std::memory_order_relaxed);
+        freeNum[i]   = profile.freeNum.load(std::memory_order_relaxed);
+        liveBytes[i] = live > 0 ? (size_t)live : 0;
+        peakBytes[i] = (size_t)profile.peakBytes.load(std::memory_order_relaxed);
+    }
+}
+
+PRO_SHARED_API
+bool
+ProGetSgiPoolTagProfile(unsigned int tag,
+                        char         name[32],
+                        uint64_t*    allocNum,
+                        uint64_t*    freeNum,
+                        size_t*      liveBytes,
+                        size_t*      peakBytes,
+                        uint64_t     lifetimes[PRO_SGI_PROFILE_LIFETIMES])
+{
+    Init_i();
+
+    name[0]    = '\0';
+    *allocNum  = 0;
+    *freeNum   = 0;
+    *liveBytes = 0;
+    *peakBytes = 0;
+    memset(lifetimes, 0, sizeof(uint64_t) * PRO_SGI_PROFILE_LIFETIMES);
+
+    g_s_lock->Lock();
+
+    bool ret = tag < g_s_tagNum;
+    if (ret)
+    {
+        strncpy(name, tag == 0 ? "-" : g_s_tagNames[tag], 31);
+        name[31] = '\0';
+    }
+
+    g_s_lock->Unlock();
+
+    if (!ret)
+    {
+        return false;
+    }
+
+    const PRO_SGI_PROFILE& profile = g_s_tagProfiles[tag];
+
+    int64_t live = profile.liveBytes.load(std::memory_order_relaxed);
+
+    *allocNum  = profile.allocNum.load(std::memory_order_relaxed);
+    *freeNum   = profile.freeNum.load(std::memory_order_relaxed);
+    *liveBytes = live > 0 ? (size_t)live : 0;
+    *peakBytes = (size_t)profile.peakBytes.load(std::memory_order_relaxed);
+
+    for (int i = 0; i < PRO_SGI_PROFILE_LIFETIMES; ++i)
+    {
+        lifetimes[i] = g_s_tagLifetimes[tag][i].load(std::memory_order_relaxed);
     }
+
+    return true;
 }
 
 /////////////////////////////////////////////////////////////////////////////
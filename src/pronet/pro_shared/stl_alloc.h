@@ -14,6 +14,7 @@
 #ifndef __SGI_STL_INTERNAL_ALLOC_H
 #define __SGI_STL_INTERNAL_ALLOC_H
 
+#include <atomic>
 #include <cstddef>
 #include <cstdlib>
 #include <cstring>
@@ -28,6 +29,12 @@
 #include <windows.h>
 #else
 #include <pthread.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#endif
+
+#if defined(MAP_HUGETLB) && defined(MAP_HUGE_SHIFT) && !defined(MAP_HUGE_2MB)
+#define MAP_HUGE_2MB (21 << MAP_HUGE_SHIFT) /* in <linux/mman.h>, not in glibc */
 #endif
 
 #if defined(_WIN32)
@@ -109,7 +116,9 @@ private:
 //
 // Important implementation properties:
 // 1. If the client request an object of size > __MAX_OBJ_BYTES, the resulting
-//    object will be obtained directly from malloc.
+//    object will be obtained from the large object tier, which rounds it up to
+//    a power of two and caches a few freed objects per size. Objects larger
+//    than __MAX_LARGE_OBJ_BYTES are obtained directly from malloc.
 // 2. In all other cases, we allocate an object of size exactly
 //    _S_round_up(requested_size).  Thus the client has enough size
 //    information that we can return the object to the proper free list
@@ -135,6 +144,39 @@ enum { __MAX_OBJ_BYTES = 8 + 1024 * 128  }; /* sizeof(app_level_obj) <= 128K */
 enum { __BIG_OBJ_BYTES = 8 + 4096        }; /* sizeof(app_level_big_obj) >= 4096 */
 enum { __CHUNK_SIZE    = 1024 * 1024 * 4 }; /* sizeof(chunk) is 4M, >= glibc::M_MMAP_THRESHOLD */
 enum { __NFREELISTS    = 57              }; /* 57 levels */
+enum { __CHUNK_HDR_BYTES = 64            }; /* sizeof(chunk_hdr), a cache line */
+enum { __HUGE_PAGE_SIZE  = 1024 * 1024 * 2 }; /* the huge page size we ask for */
+enum { __MIN_LARGE_OBJ_BYTES = 8 + 1024 * 256        }; /* sizeof(app_level_large_obj) <= 256K, ... */
+enum { __MAX_LARGE_OBJ_BYTES = 8 + 1024 * 1024 * 16  }; /* sizeof(app_level_large_obj) <= 16M */
+enum { __NLARGELISTS         = 7                     }; /* 256K, 512K, ..., 16M */
+
+/*
+ * The cached bytes of the large objects, of all the sizes and pools.
+ * Please refer to "../pro_util/pro_a.h"
+ */
+#if !defined(PRO_SGI_LARGE_CACHE_BYTES)
+#define PRO_SGI_LARGE_CACHE_BYTES (1024 * 1024 * 8)
+#endif
+
+// The bytes held by the large object caches of all the instances,
+// charged against PRO_SGI_LARGE_CACHE_BYTES.
+inline std::atomic<size_t>& __large_cached_bytes()
+{
+    static std::atomic<size_t> __bytes(0);
+
+    return __bytes;
+}
+
+/*
+ * Chunk backing
+ */
+enum
+{
+    __PAGE_NORMAL  = 0, /* regular pages */
+    __PAGE_THP     = 1, /* transparent huge pages, madvise(MADV_HUGEPAGE) */
+    __PAGE_HUGETLB = 2, /* hugetlbfs pages, mmap(MAP_HUGETLB) */
+    __PAGE_KINDS   = 3
+};
 
 union __Obj
 {
@@ -142,6 +184,20 @@ union __Obj
     char         _M_client_data[1];
 };
 
+/*
+ * Chunks are aligned to __CHUNK_SIZE, so the header of the chunk an object
+ * belongs to is found by masking the object's address.
+ */
+struct __Chunk
+{
+    __Chunk* _M_prev;
+    __Chunk* _M_next;
+    size_t   _M_bytes;
+    size_t   _M_busy_obj_num;
+    int      _M_backing;
+    bool     _M_releasing;
+};
+
 template<int inst>
 class __default_alloc_template
 {
@@ -161,7 +217,7 @@ public:
 
         if (__n > (size_t)__MAX_OBJ_BYTES)
         {
-            __ret = malloc(__n);
+            __ret = _S_large_allocate(__n, __lock);
         }
         else
         {
@@ -187,6 +243,7 @@ public:
             if (__ret != NULL)
             {
                 ++_S_busy_obj_num[__index];
+                ++_S_chunk_of(__ret)->_M_busy_obj_num;
             }
 
             if (__lock != NULL)
@@ -211,7 +268,7 @@ public:
 
         if (__n > (size_t)__MAX_OBJ_BYTES)
         {
-            free(__p);
+            _S_large_deallocate(__p, __n, __lock);
         }
         else
         {
@@ -228,6 +285,7 @@ public:
             *__my_free_list = __q;
 
             --_S_busy_obj_num[__index];
+            --_S_chunk_of(__q)->_M_busy_obj_num;
 
             if (__lock != NULL)
             {
@@ -255,12 +313,32 @@ public:
             return NULL;
         }
 
-        if (__old_sz > (size_t)__MAX_OBJ_BYTES && __new_sz > (size_t)__MAX_OBJ_BYTES)
+        if (__old_sz > (size_t)__MAX_LARGE_OBJ_BYTES && __new_sz > (size_t)__MAX_LARGE_OBJ_BYTES)
         {
             return realloc(__p, __new_sz);
         }
 
-        if (_S_round_up(__old_sz) == _S_round_up(__new_sz))
+        if (__old_sz > (size_t)__MAX_OBJ_BYTES && __new_sz > (size_t)__MAX_OBJ_BYTES)
+        {
+            if (_S_large_index(__old_sz) == _S_large_index(__new_sz))
+            {
+                return __p;
+            }
+
+            // Don't copy megabytes under the lock.
+            void* __result = allocate(__new_sz, __lock);
+            if (__result != NULL)
+            {
+                size_t __copy_sz = __new_sz > __old_sz ? __old_sz : __new_sz;
+                memcpy(__result, __p, __copy_sz);
+                deallocate(__p, __old_sz, __lock);
+            }
+
+            return __result;
+        }
+
+        if (__old_sz <= (size_t)__MAX_OBJ_BYTES && __new_sz <= (size_t)__MAX_OBJ_BYTES &&
+            _S_round_up(__old_sz) == _S_round_up(__new_sz))
         {
             return __p;
         }
@@ -286,12 +364,146 @@ public:
         return __result;
     }
 
+    // Takes up to __nobjs objects of size __n off the free list in one
+    // locked pass, refilling it from the chunk as needed. The objects are
+    // returned as a NULL-terminated list, and __nobjs is updated with the
+    // number of objects actually taken.
+    static __Obj* allocate_batch(
+        size_t             __n,
+        int&               __nobjs,
+        CProThreadMutex_i* __lock /* = NULL */
+        )
+    {
+        if (__n == 0 || __n > (size_t)__MAX_OBJ_BYTES || __nobjs <= 0)
+        {
+            __nobjs = 0;
+
+            return NULL;
+        }
+
+        if (__lock != NULL)
+        {
+            __lock->Lock();
+        }
+
+        int     __index        = _S_freelist_index(__n);
+        __Obj** __my_free_list = _S_free_list + __index;
+        __Obj*  __head         = NULL;
+        int     __got          = 0;
+
+        while (__got < __nobjs)
+        {
+            __Obj* __result = *__my_free_list;
+
+            if (__result == NULL)
+            {
+                __result = (__Obj*)_S_refill(_S_round_up(__n));
+                if (__result == NULL)
+                {
+                    break;
+                }
+            }
+            else
+            {
+                *__my_free_list = __result->_M_free_list_link;
+            }
+
+            __result->_M_free_list_link = __head;
+            __head = __result;
+            ++__got;
+
+            ++_S_chunk_of(__result)->_M_busy_obj_num;
+        }
+
+        _S_busy_obj_num[__index] += __got;
+
+        if (__lock != NULL)
+        {
+            __lock->Unlock();
+        }
+
+        __nobjs = __got;
+
+        return __head;
+    }
+
+    // Puts a NULL-terminated list of __nobjs objects of size __n,
+    // from __first to __last, back on the free list in one locked pass.
+    static void deallocate_batch(
+        __Obj*             __first,
+        __Obj*             __last,
+        int                __nobjs,
+        size_t             __n,
+        CProThreadMutex_i* __lock /* = NULL */
+        )
+    {
+        if (__first == NULL || __last == NULL || __nobjs <= 0 ||
+            __n == 0 || __n > (size_t)__MAX_OBJ_BYTES)
+        {
+            return;
+        }
+
+        if (__lock != NULL)
+        {
+            __lock->Lock();
+        }
+
+        int     __index        = _S_freelist_index(__n);
+        __Obj** __my_free_list = _S_free_list + __index;
+
+        for (__Obj* __q = __first; __q != NULL; __q = __q->_M_free_list_link)
+        {
+            --_S_chunk_of(__q)->_M_busy_obj_num;
+        }
+
+        __last->_M_free_list_link = *__my_free_list;
+        *__my_free_list = __first;
+
+        _S_busy_obj_num[__index] -= __nobjs;
+
+        if (__lock != NULL)
+        {
+            __lock->Unlock();
+        }
+    }
+
+    static int freelist_index(size_t __bytes)
+    {
+        return _S_freelist_index(__bytes);
+    }
+
+    static size_t obj_size(int __index)
+    {
+        return _S_obj_size[__index];
+    }
+
+    // The entry of get_info() that an object of __bytes is counted in.
+    // Objects beyond the large object tier share the last entry.
+    static int class_index(size_t __bytes)
+    {
+        if (__bytes <= (size_t)__MAX_OBJ_BYTES)
+        {
+            return _S_freelist_index(__bytes);
+        }
+
+        int __index = _S_large_index(__bytes);
+        if (__index >= __NLARGELISTS)
+        {
+            __index = __NLARGELISTS - 1;
+        }
+
+        return __NFREELISTS + __index;
+    }
+
+    // The arrays have __NFREELISTS + __NLARGELISTS entries. The large object
+    // tier comes last, and its cached objects are counted as reclaimable.
     static void get_info(
-        void*              __free_list[__NFREELISTS],
-        size_t             __obj_size[__NFREELISTS],
-        size_t             __busy_obj_num[__NFREELISTS],
-        size_t             __total_obj_num[__NFREELISTS],
+        void*              __free_list[__NFREELISTS + __NLARGELISTS],
+        size_t             __obj_size[__NFREELISTS + __NLARGELISTS],
+        size_t             __busy_obj_num[__NFREELISTS + __NLARGELISTS],
+        size_t             __total_obj_num[__NFREELISTS + __NLARGELISTS],
         size_t*            __heap_size,
+        size_t*            __reclaimable_size,
         CProThreadMutex_i* __lock /* = NULL */
         )
     {
@@ -304,10 +516,185 @@ public:
         memcpy(__obj_size     , (void*)_S_obj_size     , sizeof(_S_obj_size));
         memcpy(__busy_obj_num , (void*)_S_busy_obj_num , sizeof(_S_busy_obj_num));
         memcpy(__total_obj_num, (void*)_S_total_obj_num, sizeof(_S_total_obj_num));
+        for (int __i = 0; __i < __NLARGELISTS; ++__i)
+        {
+            __free_list[__NFREELISTS + __i]     = _S_large_free_list[__i];
+            __obj_size[__NFREELISTS + __i]      = _S_large_obj_size(__i);
+            __busy_obj_num[__NFREELISTS + __i]  = _S_large_busy_obj_num[__i];
+            __total_obj_num[__NFREELISTS + __i] =
+                _S_large_busy_obj_num[__i] + _S_large_cached_obj_num[__i];
+        }
         if (__heap_size != NULL)
         {
             *__heap_size = _S_heap_size;
         }
+        if (__reclaimable_size != NULL)
+        {
+            *__reclaimable_size = 0;
+
+            for (int __i = 0; __i < __NLARGELISTS; ++__i)
+            {
+                *__reclaimable_size += _S_large_cached_obj_num[__i] * _S_large_obj_size(__i);
+            }
+
+            __Chunk* __carving = _S_carving_chunk();
+
+            for (__Chunk* __c = _S_chunk_list; __c != NULL; __c = __c->_M_next)
+            {
+                if (__c->_M_busy_obj_num == 0 && __c != __carving)
+                {
+                    *__reclaimable_size += __c->_M_bytes;
+                }
+            }
+        }
+
+        if (__lock != NULL)
+        {
+            __lock->Unlock();
+        }
+    }
+
+    // Gives the chunks that hold no busy object back to the system.
+    // The free lists are walked once to unlink the objects of those chunks,
+    // so the cost is proportional to the number of free objects.
+    // Returns the number of bytes released.
+    static size_t trim(CProThreadMutex_i* __lock /* = NULL */)
+    {
+        if (__lock != NULL)
+        {
+            __lock->Lock();
+        }
+
+        __Obj* __large_list = NULL;
+        size_t __released   = 0;
+
+        for (int __i = 0; __i < __NLARGELISTS; ++__i)
+        {
+            while (_S_large_free_list[__i] != NULL)
+            {
+                __Obj* __q = _S_large_free_list[__i];
+                _S_large_free_list[__i] = __q->_M_free_list_link;
+
+                __q->_M_free_list_link = __large_list;
+                __large_list = __q;
+            }
+
+            __released += _S_large_cached_obj_num[__i] * _S_large_obj_size(__i);
+            _S_large_cached_obj_num[__i] = 0;
+        }
+
+        __large_cached_bytes() -= __released;
+
+        __Chunk* __carving = _S_carving_chunk();
+        int      __marked  = 0;
+
+        for (__Chunk* __c = _S_chunk_list; __c != NULL; __c = __c->_M_next)
+        {
+            if (__c->_M_busy_obj_num == 0 && __c != __carving)
+            {
+                __c->_M_releasing = true;
+                ++__marked;
+            }
+        }
+
+        if (__marked > 0)
+        {
+            for (int __i = 0; __i < __NFREELISTS; ++__i)
+            {
+                __Obj** __link = _S_free_list + __i;
+
+                while (*__link != NULL)
+                {
+                    if (_S_chunk_of(*__link)->_M_releasing)
+                    {
+                        *__link = (*__link)->_M_free_list_link;
+                        --_S_total_obj_num[__i];
+                    }
+                    else
+                    {
+                        __link = &(*__link)->_M_free_list_link;
+                    }
+                }
+            }
+
+            if (__carving == NULL)
+            {
+                _S_start_free = NULL; // nothing left to carve, forget it
+                _S_end_free   = NULL;
+            }
+
+            __Chunk* __c = _S_chunk_list;
+
+            while (__c != NULL)
+            {
+                __Chunk* __next = __c->_M_next;
+
+                if (__c->_M_releasing)
+                {
+                    __released   += __c->_M_bytes;
+                    _S_heap_size -= __c->_M_bytes;
+                    _S_chunk_delete(__c);
+                }
+
+                __c = __next;
+            }
+        }
+
+        if (__lock != NULL)
+        {
+            __lock->Unlock();
+        }
+
+        while (__large_list != NULL)
+        {
+            __Obj* __q = __large_list;
+            __large_list = __q->_M_free_list_link;
+
+            free(__q);
+        }
+
+        return __released;
+    }
+
+    // Selects the huge page kinds new chunks may try, hugetlbfs first.
+    // Chunks that are already mapped keep their backing.
+    static void set_huge_page(
+        bool               __hugetlb,
+        bool               __thp,
+        CProThreadMutex_i* __lock /* = NULL */
+        )
+    {
+        if (__lock != NULL)
+        {
+            __lock->Lock();
+        }
+
+        _S_use_hugetlb = __hugetlb;
+        _S_use_thp     = __thp;
+
+        if (__lock != NULL)
+        {
+            __lock->Unlock();
+        }
+    }
+
+    // Returns the heap bytes of each chunk backing.
+    static void get_page_info(
+        size_t             __page_bytes[__PAGE_KINDS],
+        CProThreadMutex_i* __lock /* = NULL */
+        )
+    {
+        if (__lock != NULL)
+        {
+            __lock->Lock();
+        }
+
+        memset(__page_bytes, 0, sizeof(size_t) * __PAGE_KINDS);
+
+        for (__Chunk* __c = _S_chunk_list; __c != NULL; __c = __c->_M_next)
+        {
+            __page_bytes[__c->_M_backing] += __c->_M_bytes;
+        }
 
         if (__lock != NULL)
         {
@@ -369,6 +756,67 @@ private:
         int&   __nobjs
         );
 
+    static __Chunk* _S_chunk_of(void* __p)
+    {
+        return (__Chunk*)((uintptr_t)__p & ~(uintptr_t)(__CHUNK_SIZE - 1));
+    }
+
+    // The chunk being carved by _S_chunk_alloc(), or NULL if there is
+    // nothing left to carve.
+    static __Chunk* _S_carving_chunk()
+    {
+        if (_S_start_free == NULL || _S_start_free == _S_end_free)
+        {
+            return NULL;
+        }
+
+        return _S_chunk_of(_S_start_free);
+    }
+
+    // Maps a __CHUNK_SIZE aligned chunk of __bytes from the system, and
+    // links it into the chunk list.
+    static __Chunk* _S_chunk_new(size_t __bytes);
+
+#if !defined(_WIN32)
+    // Maps __bytes at a __CHUNK_SIZE aligned address, or returns NULL.
+    static char* _S_map_aligned(
+        size_t __bytes,
+        int    __flags
+        );
+#endif
+
+    // Unlinks a chunk from the chunk list, and unmaps it.
+    static void _S_chunk_delete(__Chunk* __c);
+
+    // Large object tier. Returns __NLARGELISTS if __bytes is beyond it.
+    static int _S_large_index(size_t __bytes)
+    {
+        int __index = 0;
+
+        while (__index < __NLARGELISTS && __bytes > _S_large_obj_size(__index))
+        {
+            ++__index;
+        }
+
+        return __index;
+    }
+
+    static size_t _S_large_obj_size(int __index)
+    {
+        return 8 + ((size_t)(__MIN_LARGE_OBJ_BYTES - 8) << __index);
+    }
+
+    static void* _S_large_allocate(
+        size_t             __n,
+        CProThreadMutex_i* __lock
+        );
+
+    static void _S_large_deallocate(
+        void*              __p,
+        size_t             __n,
+        CProThreadMutex_i* __lock
+        );
+
 private:
 
     static __Obj* _S_free_list[__NFREELISTS];
@@ -376,10 +824,17 @@ private:
     static size_t _S_busy_obj_num[__NFREELISTS];
     static size_t _S_total_obj_num[__NFREELISTS];
 
+    static __Obj* _S_large_free_list[__NLARGELISTS];
+    static size_t _S_large_busy_obj_num[__NLARGELISTS];
+    static size_t _S_large_cached_obj_num[__NLARGELISTS];
+
     // Chunk allocation state.
-    static char*  _S_start_free;
-    static char*  _S_end_free;
-    static size_t _S_heap_size;
+    static char*    _S_start_free;
+    static char*    _S_end_free;
+    static size_t   _S_heap_size;
+    static __Chunk* _S_chunk_list;
+    static bool     _S_use_hugetlb;
+    static bool     _S_use_thp;
 };
 
 template<int __inst>
@@ -412,6 +867,15 @@ size_t __default_alloc_template<__inst>::_S_busy_obj_num[__NFREELISTS] = { 0 };
 template<int __inst>
 size_t __default_alloc_template<__inst>::_S_total_obj_num[__NFREELISTS] = { 0 };
 
+template<int __inst>
+__Obj* __default_alloc_template<__inst>::_S_large_free_list[__NLARGELISTS] = { 0 };
+
+template<int __inst>
+size_t __default_alloc_template<__inst>::_S_large_busy_obj_num[__NLARGELISTS] = { 0 };
+
+template<int __inst>
+size_t __default_alloc_template<__inst>::_S_large_cached_obj_num[__NLARGELISTS] = { 0 };
+
 template<int __inst>
 char* __default_alloc_template<__inst>::_S_start_free = NULL;
 
@@ -421,6 +885,267 @@ char* __default_alloc_template<__inst>::_S_end_free = NULL;
 template<int __inst>
 size_t __default_alloc_template<__inst>::_S_heap_size = 0;
 
+template<int __inst>
+__Chunk* __default_alloc_template<__inst>::_S_chunk_list = NULL;
+
+template<int __inst>
+bool __default_alloc_template<__inst>::_S_use_hugetlb = false;
+
+template<int __inst>
+bool __default_alloc_template<__inst>::_S_use_thp = false;
+
+#if !defined(_WIN32)
+
+template<int __inst>
+char*
+__default_alloc_template<__inst>::_S_map_aligned(size_t __bytes,
+                                                 int    __flags)
+{
+    // Reserve address space with room to align, then map exactly the
+    // aligned part over it. Only __bytes of huge pages are taken, not
+    // __bytes + __CHUNK_SIZE.
+    char* __p = (char*)mmap(NULL, __bytes + __CHUNK_SIZE,
+        PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (__p == (char*)MAP_FAILED)
+    {
+        return NULL;
+    }
+
+    char* __base = (char*)
+        (((uintptr_t)__p + __CHUNK_SIZE - 1) & ~(uintptr_t)(__CHUNK_SIZE - 1));
+
+    if (mmap(__base, __bytes, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED | __flags, -1, 0) == MAP_FAILED)
+    {
+        munmap(__p, __bytes + __CHUNK_SIZE);
+
+        return NULL;
+    }
+
+    // Trim the misaligned head and the unused tail of the reservation.
+    if (__base > __p)
+    {
+        munmap(__p, __base - __p);
+    }
+    if (__p + __bytes + __CHUNK_SIZE > __base + __bytes)
+    {
+        munmap(__base + __bytes, __p + __bytes + __CHUNK_SIZE - (__base + __bytes));
+    }
+
+    return __base;
+}
+
+#endif /* _WIN32 */
+
+template<int __inst>
+__Chunk*
+__default_alloc_template<__inst>::_S_chunk_new(size_t __bytes)
+{
+    char* __base    = NULL;
+    int   __backing = __PAGE_NORMAL;
+
+#if defined(_WIN32)
+
+    // Reserve an oversized region to find an aligned address, then map
+    // exactly there. Another thread may take the address in between,
+    // so try a few times.
+    for (int __i = 0; __i < 8 && __base == NULL; ++__i)
+    {
+        char* __p = (char*)::VirtualAlloc(
+            NULL, __bytes + __CHUNK_SIZE, MEM_RESERVE, PAGE_NOACCESS);
+        if (__p == NULL)
+        {
+            return NULL;
+        }
+
+        char* __aligned = (char*)
+            (((uintptr_t)__p + __CHUNK_SIZE - 1) & ~(uintptr_t)(__CHUNK_SIZE - 1));
+        ::VirtualFree(__p, 0, MEM_RELEASE);
+
+        __base = (char*)::VirtualAlloc(
+            __aligned, __bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    }
+
+#else  /* _WIN32 */
+
+#if defined(MAP_HUGETLB) && defined(MAP_HUGE_2MB)
+    if (_S_use_hugetlb && __bytes % __HUGE_PAGE_SIZE == 0)
+    {
+        // Fails quietly if no huge pages are reserved.
+        __base = _S_map_aligned(__bytes, MAP_HUGETLB | MAP_HUGE_2MB);
+        if (__base != NULL)
+        {
+            __backing = __PAGE_HUGETLB;
+        }
+    }
+#endif
+
+    if (__base == NULL)
+    {
+        __base = _S_map_aligned(__bytes, 0);
+    }
+
+#if defined(MADV_HUGEPAGE)
+    if (_S_use_thp && __base != NULL && __backing == __PAGE_NORMAL &&
+        madvise(__base, __bytes, MADV_HUGEPAGE) == 0)
+    {
+        __backing = __PAGE_THP;
+    }
+#endif
+
+#endif /* _WIN32 */
+
+    if (__base == NULL)
+    {
+        return NULL;
+    }
+
+    __Chunk* __c = (__Chunk*)__base;
+    __c->_M_prev         = NULL;
+    __c->_M_next         = _S_chunk_list;
+    __c->_M_bytes        = __bytes;
+    __c->_M_busy_obj_num = 0;
+    __c->_M_backing      = __backing;
+    __c->_M_releasing    = false;
+
+    if (_S_chunk_list != NULL)
+    {
+        _S_chunk_list->_M_prev = __c;
+    }
+    _S_chunk_list = __c;
+
+    return __c;
+}
+
+template<int __inst>
+void
+__default_alloc_template<__inst>::_S_chunk_delete(__Chunk* __c)
+{
+    if (__c->_M_prev != NULL)
+    {
+        __c->_M_prev->_M_next = __c->_M_next;
+    }
+    else
+    {
+        _S_chunk_list = __c->_M_next;
+    }
+    if (__c->_M_next != NULL)
+    {
+        __c->_M_next->_M_prev = __c->_M_prev;
+    }
+
+#if defined(_WIN32)
+    ::VirtualFree(__c, 0, MEM_RELEASE);
+#else
+    munmap(__c, __c->_M_bytes);
+#endif
+}
+
+// The objects are malloc()ed at the size of their class, so any object of a
+// class can serve any request of that class. malloc() and free() are called
+// outside the lock.
+template<int __inst>
+void*
+__default_alloc_template<__inst>::_S_large_allocate(size_t             __n,
+                                                    CProThreadMutex_i* __lock)
+{
+    int __index = _S_large_index(__n);
+    if (__index >= __NLARGELISTS)
+    {
+        return malloc(__n);
+    }
+
+    if (__lock != NULL)
+    {
+        __lock->Lock();
+    }
+
+    __Obj* __result = _S_large_free_list[__index];
+    if (__result != NULL)
+    {
+        _S_large_free_list[__index] = __result->_M_free_list_link;
+        --_S_large_cached_obj_num[__index];
+        __large_cached_bytes() -= _S_large_obj_size(__index);
+    }
+    ++_S_large_busy_obj_num[__index];
+
+    if (__lock != NULL)
+    {
+        __lock->Unlock();
+    }
+
+    if (__result == NULL)
+    {
+        __result = (__Obj*)malloc(_S_large_obj_size(__index));
+        if (__result == NULL)
+        {
+            if (__lock != NULL)
+            {
+                __lock->Lock();
+            }
+
+            --_S_large_busy_obj_num[__index];
+
+            if (__lock != NULL)
+            {
+                __lock->Unlock();
+            }
+        }
+    }
+
+    return __result;
+}
+
+template<int __inst>
+void
+__default_alloc_template<__inst>::_S_large_deallocate(void*              __p,
+                                                      size_t             __n,
+                                                      CProThreadMutex_i* __lock)
+{
+    int __index = _S_large_index(__n);
+    if (__index >= __NLARGELISTS)
+    {
+        free(__p);
+
+        return;
+    }
+
+    size_t __obj_size = _S_large_obj_size(__index);
+
+    // Reserved before caching, so that the pools never hold more than the
+    // budget between them.
+    bool __cached =
+        __large_cached_bytes().fetch_add(__obj_size) + __obj_size <= (size_t)PRO_SGI_LARGE_CACHE_BYTES;
+    if (!__cached)
+    {
+        __large_cached_bytes() -= __obj_size;
+    }
+
+    if (__lock != NULL)
+    {
+        __lock->Lock();
+    }
+
+    --_S_large_busy_obj_num[__index];
+
+    if (__cached)
+    {
+        __Obj* __q = (__Obj*)__p;
+        __q->_M_free_list_link = _S_large_free_list[__index];
+        _S_large_free_list[__index] = __q;
+        ++_S_large_cached_obj_num[__index];
+
+        __p = NULL;
+    }
+
+    if (__lock != NULL)
+    {
+        __lock->Unlock();
+    }
+
+    free(__p);
+}
+
 // Returns an object of size __n, and optionally adds to size __n free list.
 // We assume that __n is properly aligned.
 template<int __inst>
@@ -540,20 +1265,22 @@ __default_alloc_template<__inst>::_S_chunk_alloc(size_t __size,
             }
         }
 
-        size_t __bytes_to_get = __CHUNK_SIZE;
+        size_t   __bytes_to_get = __CHUNK_SIZE;
+        __Chunk* __chunk        = _S_chunk_new(__bytes_to_get);
 
-        _S_start_free = (char*)malloc(__bytes_to_get);
+        _S_start_free = NULL;
         _S_end_free   = NULL;
-        if (_S_start_free == NULL)
+        if (__chunk == NULL)
         {
             __bytes_to_get = __CHUNK_SIZE / 2;
-            _S_start_free  = (char*)malloc(__bytes_to_get); // retry
+            __chunk        = _S_chunk_new(__bytes_to_get); // retry
         }
 
-        if (_S_start_free != NULL)
+        if (__chunk != NULL)
         {
-            _S_end_free  =  _S_start_free + __bytes_to_get;
-            _S_heap_size += __bytes_to_get;
+            _S_start_free =  (char*)__chunk + __CHUNK_HDR_BYTES;
+            _S_end_free   =  (char*)__chunk + __bytes_to_get;
+            _S_heap_size  += __bytes_to_get;
 
             return _S_chunk_alloc(__size, __nobjs);
         }
@@ -56,6 +56,12 @@
 #if !defined(PRO_HAS_EPOLL)
 #define PRO_HAS_EPOLL
 #endif
+#if !defined(PRO_HAS_EVENTFD)
+#define PRO_HAS_EVENTFD
+#endif
+#if !defined(PRO_HAS_REUSEPORT)
+#define PRO_HAS_REUSEPORT
+#endif
 #if !defined(PRO_HAS_PTHREAD_EXPLICIT_SCHED)
 #define PRO_HAS_PTHREAD_EXPLICIT_SCHED
 #endif
@@ -103,6 +109,15 @@
 #if defined(PRO_HAS_EPOLL) && !defined(PRO_EPOLLFD_GETSIZE)
 #define PRO_EPOLLFD_GETSIZE    1024
 #endif
+#if defined(PRO_HAS_IO_URING) && !defined(PRO_IO_URING_ENTRIES)
+#define PRO_IO_URING_ENTRIES   1024
+#endif
+#if defined(PRO_HAS_IO_URING) && !defined(PRO_IO_URING_BUF_COUNT)
+#define PRO_IO_URING_BUF_COUNT 256 /* a power of 2 */
+#endif
+#if defined(PRO_HAS_IO_URING) && !defined(PRO_IO_URING_BUF_SIZE)
+#define PRO_IO_URING_BUF_SIZE  (1024 * 2) /* small, so the buffers stay cached */
+#endif
 #if !defined(PRO_THREAD_STACK_SIZE)
 #define PRO_THREAD_STACK_SIZE  (1024 * 1024 - 8192)
 #endif
@@ -112,12 +127,27 @@
 #if !defined(PRO_ACCEPTOR_LENGTH)
 #define PRO_ACCEPTOR_LENGTH    20000
 #endif
+#if !defined(PRO_ACCEPTOR_BATCH)
+#define PRO_ACCEPTOR_BATCH     32
+#endif
 #if !defined(PRO_SERVICER_LENGTH)
 #define PRO_SERVICER_LENGTH    20000
 #endif
 #if !defined(PRO_TCP4_PAYLOAD_SIZE)
 #define PRO_TCP4_PAYLOAD_SIZE  (1024 * 1024 * 96)
 #endif
+#if !defined(PRO_SGI_TCACHE_BYTES)
+#define PRO_SGI_TCACHE_BYTES   (1024 * 32)
+#endif
+#if !defined(PRO_SGI_TCACHE_DEPTH)
+#define PRO_SGI_TCACHE_DEPTH   64
+#endif
+#if !defined(PRO_SGI_LARGE_CACHE_BYTES)
+#define PRO_SGI_LARGE_CACHE_BYTES (1024 * 1024 * 8)
+#endif
+#if !defined(PRO_SLAB_POOL_BYTES)
+#define PRO_SLAB_POOL_BYTES    (1024 * 16)
+#endif
 
 /////////////////////////////////////////////////////////////////////////////
 ////
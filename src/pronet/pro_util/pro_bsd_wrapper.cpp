@@ -863,7 +863,8 @@ int64_t
 pbsd_accept(int64_t           fd,
             pbsd_sockaddr_in* srcaddr)
 {
-    int64_t newfd = -1;
+    int64_t newfd    = -1;
+    bool    flagsSet = false; /* O_NONBLOCK and FD_CLOEXEC by accept4() */
 
 #if defined(_WIN32)
 
@@ -885,7 +886,7 @@ pbsd_accept(int64_t           fd,
 
 #else  /* _WIN32 */
 
-#if defined(PRO_HAS_ACCEPT4) && defined(SOCK_CLOEXEC)
+#if defined(PRO_HAS_ACCEPT4) && defined(SOCK_CLOEXEC) && defined(SOCK_NONBLOCK)
     static bool s_hasclose = true;
     int         errorcode  = 0;
     if (s_hasclose)
@@ -893,15 +894,23 @@ pbsd_accept(int64_t           fd,
         do
         {
             socklen_t addrlen = sizeof(pbsd_sockaddr_in);
-            newfd     = (int32_t)accept4((int)fd,
-                (struct sockaddr*)srcaddr, srcaddr != NULL ? &addrlen : NULL, SOCK_CLOEXEC);
+            newfd     = (int32_t)accept4((int)fd, (struct sockaddr*)srcaddr,
+                srcaddr != NULL ? &addrlen : NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
             errorcode = pbsd_errno((void*)&pbsd_accept);
         }
         while (newfd < 0 && errorcode == PBSD_EINTR);
+
+        flagsSet = newfd >= 0;
     }
-#endif
 
+    /*
+     * Fall back to accept() only if accept4() itself is refused. An empty
+     * backlog (EAGAIN) costs one syscall, not two
+     */
+    if (newfd < 0 && (!s_hasclose || errorcode == PBSD_EINVAL))
+#else
     if (newfd < 0)
+#endif
     {
         do
         {
@@ -911,7 +920,7 @@ pbsd_accept(int64_t           fd,
         }
         while (newfd < 0 && pbsd_errno((void*)&pbsd_accept) == PBSD_EINTR);
 
-#if defined(PRO_HAS_ACCEPT4) && defined(SOCK_CLOEXEC)
+#if defined(PRO_HAS_ACCEPT4) && defined(SOCK_CLOEXEC) && defined(SOCK_NONBLOCK)
         if (newfd >= 0 && errorcode == PBSD_EINVAL)
         {
             s_hasclose = false;
@@ -923,8 +932,11 @@ pbsd_accept(int64_t           fd,
 
     if (newfd >= 0)
     {
-        pbsd_ioctl_nonblock(newfd);
-        pbsd_ioctl_closexec(newfd);
+        if (!flagsSet)
+        {
+            pbsd_ioctl_nonblock(newfd);
+            pbsd_ioctl_closexec(newfd);
+        }
     }
     else
     {
@@ -942,7 +954,9 @@ pbsd_accept_un(int64_t           fd,
 
 #if !defined(_WIN32)
 
-#if defined(PRO_HAS_ACCEPT4) && defined(SOCK_CLOEXEC)
+    bool flagsSet = false; /* O_NONBLOCK and FD_CLOEXEC by accept4() */
+
+#if defined(PRO_HAS_ACCEPT4) && defined(SOCK_CLOEXEC) && defined(SOCK_NONBLOCK)
     static bool s_hasclose = true;
     int         errorcode  = 0;
     if (s_hasclose)
@@ -950,15 +964,19 @@ pbsd_accept_un(int64_t           fd,
         do
         {
             socklen_t addrlen = sizeof(pbsd_sockaddr_un);
-            newfd     = (int32_t)accept4((int)fd,
-                (struct sockaddr*)srcaddr, srcaddr != NULL ? &addrlen : NULL, SOCK_CLOEXEC);
+            newfd     = (int32_t)accept4((int)fd, (struct sockaddr*)srcaddr,
+                srcaddr != NULL ? &addrlen : NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
             errorcode = pbsd_errno((void*)&pbsd_accept_un);
         }
         while (newfd < 0 && errorcode == PBSD_EINTR);
+
+        flagsSet = newfd >= 0;
     }
-#endif
 
+    if (newfd < 0 && (!s_hasclose || errorcode == PBSD_EINVAL))
+#else
     if (newfd < 0)
+#endif
     {
         do
         {
@@ -968,7 +986,7 @@ pbsd_accept_un(int64_t           fd,
         }
         while (newfd < 0 && pbsd_errno((void*)&pbsd_accept_un) == PBSD_EINTR);
 
-#if defined(PRO_HAS_ACCEPT4) && defined(SOCK_CLOEXEC)
+#if defined(PRO_HAS_ACCEPT4) && defined(SOCK_CLOEXEC) && defined(SOCK_NONBLOCK)
         if (newfd >= 0 && errorcode == PBSD_EINVAL)
         {
             s_hasclose = false;
@@ -978,8 +996,11 @@ pbsd_accept_un(int64_t           fd,
 
     if (newfd >= 0)
     {
-        pbsd_ioctl_nonblock(newfd);
-        pbsd_ioctl_closexec(newfd);
+        if (!flagsSet)
+        {
+            pbsd_ioctl_nonblock(newfd);
+            pbsd_ioctl_closexec(newfd);
+        }
     }
     else
     {
@@ -1300,6 +1321,60 @@ pbsd_epoll_wait(int               epfd,
 
 #endif /* PRO_HAS_EPOLL */
 
+#if defined(PRO_HAS_IO_URING)
+
+int
+pbsd_io_uring_setup(unsigned int            entries,
+                    struct io_uring_params* params)
+{
+    int ringfd = (int)syscall(__NR_io_uring_setup, entries, params);
+    if (ringfd < 0)
+    {
+        return -1;
+    }
+
+    pbsd_ioctl_closexec(ringfd);
+
+    return ringfd;
+}
+
+int
+pbsd_io_uring_enter(int          ringfd,
+                    unsigned int toSubmit,
+                    unsigned int minComplete,
+                    unsigned int flags)
+{
+    int retc = -1;
+
+    do
+    {
+        retc = (int)syscall(
+            __NR_io_uring_enter, ringfd, toSubmit, minComplete, flags, NULL, 0);
+    }
+    while (retc < 0 && pbsd_errno((void*)&pbsd_io_uring_enter) == PBSD_EINTR);
+
+    return retc;
+}
+
+int
+pbsd_io_uring_register(int          ringfd,
+                       unsigned int opcode,
+                       void*        arg,
+                       unsigned int nrArgs)
+{
+    int retc = -1;
+
+    do
+    {
+        retc = (int)syscall(__NR_io_uring_register, ringfd, opcode, arg, nrArgs);
+    }
+    while (retc < 0 && pbsd_errno((void*)&pbsd_io_uring_register) == PBSD_EINTR);
+
+    return retc;
+}
+
+#endif /* PRO_HAS_IO_URING */
+
 void
 pbsd_shutdown_send(int64_t fd)
 {
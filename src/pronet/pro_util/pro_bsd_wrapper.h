@@ -54,6 +54,10 @@
 #if defined(PRO_HAS_EPOLL)
 #include <sys/epoll.h>
 #endif
+#if defined(PRO_HAS_IO_URING)
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#endif
 #include <sys/ioctl.h>
 #include <sys/select.h>
 #include <sys/socket.h>
@@ -356,6 +360,26 @@ pbsd_epoll_wait(int               epfd,
 
 #endif /* PRO_HAS_EPOLL */
 
+#if defined(PRO_HAS_IO_URING)
+
+int
+pbsd_io_uring_setup(unsigned int            entries,
+                    struct io_uring_params* params);
+
+int
+pbsd_io_uring_enter(int          ringfd,
+                    unsigned int toSubmit,
+                    unsigned int minComplete,
+                    unsigned int flags);
+
+int
+pbsd_io_uring_register(int          ringfd,
+                       unsigned int opcode,
+                       void*        arg,
+                       unsigned int nrArgs);
+
+#endif /* PRO_HAS_IO_URING */
+
 void
 pbsd_shutdown_send(int64_t fd);
 
@@ -19,11 +19,17 @@
 #include "pro_a.h"
 #include "pro_buffer.h"
 #include "pro_memory_pool.h"
+#include "pro_slab_pool.h"
 #include "pro_z.h"
 
 /////////////////////////////////////////////////////////////////////////////
 ////
 
+IMPLEMENT_SLAB_POOL(CProBuffer, 0)
+
+/////////////////////////////////////////////////////////////////////////////
+////
+
 CProBuffer::CProBuffer()
 {
     m_data  = NULL;
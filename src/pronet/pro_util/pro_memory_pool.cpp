@@ -19,6 +19,7 @@
 #include "pro_a.h"
 #include "pro_memory_pool.h"
 #include "pro_shared.h"
+#include "pro_thread_mutex.h"
 #include "pro_z.h"
 
 #if defined(_MSC_VER)
@@ -32,6 +33,24 @@ extern "C" {
 /////////////////////////////////////////////////////////////////////////////
 ////
 
+/*
+ * The counters seen by the previous ProDumpSgiPoolProfile()
+ */
+struct PRO_SGI_PROFILE_SNAPSHOT
+{
+    int64_t  tick;
+    uint64_t tagAllocNum[PRO_SGI_PROFILE_TAGS];
+    uint64_t tagFreeNum[PRO_SGI_PROFILE_TAGS];
+    uint64_t classAllocNum[4][64];
+    uint64_t classFreeNum[4][64];
+};
+
+static PRO_SGI_PROFILE_SNAPSHOT g_s_snapshot;
+static CProThreadMutex          g_s_lock;
+
+/////////////////////////////////////////////////////////////////////////////
+////
+
 void*
 ProMalloc(size_t size)
 {
@@ -114,6 +133,143 @@ ProFree(void* p)
 #endif
 }
 
+size_t
+ProDumpSgiPoolProfile(char*  buf,
+                      size_t size)
+{
+    assert(buf != NULL);
+    assert(size > 0);
+    if (buf == NULL || size == 0)
+    {
+        return 0;
+    }
+
+    buf[0] = '\0';
+
+    CProThreadMutexGuard mon(g_s_lock);
+
+    int64_t tick    = ProGetTickCount64();
+    double  seconds = 0;
+    if (g_s_snapshot.tick > 0)
+    {
+        seconds = (tick - g_s_snapshot.tick) / 1000.0;
+    }
+    g_s_snapshot.tick = tick;
+
+    size_t len = snprintf_pro(
+        buf,
+        size,
+        "\n"
+        " SGI POOL PROFILE --- [interval : %.1fs] \n"
+        ,
+        seconds
+        );
+
+    for (unsigned int i = 0; i < PRO_SGI_PROFILE_TAGS && len < size - 1; ++i)
+    {
+        char     name[32] = "";
+        uint64_t allocNum = 0;
+        uint64_t freeNum  = 0;
+        size_t   liveBytes;
+        size_t   peakBytes;
+        uint64_t lifetimes[PRO_SGI_PROFILE_LIFETIMES];
+
+        if (!ProGetSgiPoolTagProfile(
+            i, name, &allocNum, &freeNum, &liveBytes, &peakBytes, lifetimes))
+        {
+            break;
+        }
+
+        uint64_t allocDelta = allocNum - g_s_snapshot.tagAllocNum[i];
+        uint64_t freeDelta  = freeNum  - g_s_snapshot.tagFreeNum[i];
+        g_s_snapshot.tagAllocNum[i] = allocNum;
+        g_s_snapshot.tagFreeNum[i]  = freeNum;
+
+        if (allocNum == 0)
+        {
+            continue;
+        }
+
+        len += snprintf_pro(
+            buf + len,
+            size - len,
+            "\t TAG[%02u] %s : alloc %llu (%.1f/s), free %llu (%.1f/s), live %u, peak %u, lifetime(ms)"
+            ,
+            i,
+            name,
+            (unsigned long long)allocNum,
+            seconds > 0 ? allocDelta / seconds : 0.0,
+            (unsigned long long)freeNum,
+            seconds > 0 ? freeDelta  / seconds : 0.0,
+            (unsigned int)liveBytes,
+            (unsigned int)peakBytes
+            );
+
+        for (int j = 0; j < PRO_SGI_PROFILE_LIFETIMES && len < size - 1; ++j)
+        {
+            if (lifetimes[j] > 0)
+            {
+                len += snprintf_pro(
+                    buf + len,
+                    size - len,
+                    " %s%u:%llu",
+                    j == 0 ? "<" : "",
+                    j == 0 ? PRO_SGI_PROFILE_LIFETIME_UNIT : PRO_SGI_PROFILE_LIFETIME_UNIT << (j - 1),
+                    (unsigned long long)lifetimes[j]
+                    );
+            }
+        }
+
+        len += snprintf_pro(buf + len, size - len, " \n");
+    }
+
+    for (unsigned int i = 0; i < 4 && len < size - 1; ++i)
+    {
+        void*    freeList[64];
+        size_t   objSize[64];
+        size_t   busyObjNum[64];
+        size_t   totalObjNum[64];
+        uint64_t allocNum[64];
+        uint64_t freeNum[64];
+        size_t   liveBytes[64];
+        size_t   peakBytes[64];
+
+        ProGetSgiPoolInfo(freeList, objSize, busyObjNum, totalObjNum, NULL, i);
+        ProGetSgiPoolProfile(allocNum, freeNum, liveBytes, peakBytes, i);
+
+        for (int j = 0; j < 64 && len < size - 1; ++j)
+        {
+            uint64_t allocDelta = allocNum[j] - g_s_snapshot.classAllocNum[i][j];
+            uint64_t freeDelta  = freeNum[j]  - g_s_snapshot.classFreeNum[i][j];
+            g_s_snapshot.classAllocNum[i][j] = allocNum[j];
+            g_s_snapshot.classFreeNum[i][j]  = freeNum[j];
+
+            if (allocNum[j] == 0)
+            {
+                continue;
+            }
+
+            len += snprintf_pro(
+                buf + len,
+                size - len,
+                "\t POOL-%u[%02d] %u : alloc %llu (%.1f/s), free %llu (%.1f/s), live %u, peak %u \n"
+                ,
+                i,
+                j,
+                (unsigned int)objSize[j],
+                (unsigned long long)allocNum[j],
+                seconds > 0 ? allocDelta / seconds : 0.0,
+                (unsigned long long)freeNum[j],
+                seconds > 0 ? freeDelta  / seconds : 0.0,
+                (unsigned int)liveBytes[j],
+                (unsigned int)peakBytes[j]
+                );
+        }
+    }
+
+    return len;
+}
+
 /////////////////////////////////////////////////////////////////////////////
 ////
 
@@ -82,6 +82,35 @@ void
 ProDeallocateSgiPoolBuffer(void*        buf,
                            unsigned int poolIndex); /* [0, 3] */
 
+extern
+void
+ProSetSgiPoolHugePage(bool         enable,
+                      unsigned int poolIndex); /* [0, 3] */
+
+extern
+void
+ProCollectSgiPoolRemoteFrees();
+
+extern
+void
+ProEnableSgiPoolProfile(bool enable);
+
+extern
+unsigned int
+ProRegisterSgiPoolTag(const char* name);
+
+extern
+unsigned int
+ProSetSgiPoolTag(unsigned int tag);
+
+/*
+ * Formats the allocation profile of the SGI pools, with the rates since
+ * the previous call. Returns the length of the text
+ */
+size_t
+ProDumpSgiPoolProfile(char*  buf,
+                      size_t size);
+
 #if defined(__cplusplus)
 } /* extern "C" */
 #endif
@@ -89,6 +118,37 @@ ProDeallocateSgiPoolBuffer(void*        buf,
 /////////////////////////////////////////////////////////////////////////////
 ////
 
+/*
+ * Tags the SGI pool allocations of the current thread within a scope,
+ * see ProSetSgiPoolTag()
+ *
+ * Usage:
+ *
+ *   static const unsigned int s_tag = ProRegisterSgiPoolTag("xxx");
+ *   CProSgiPoolTagScope tagScope(s_tag);
+ */
+class CProSgiPoolTagScope
+{
+public:
+
+    CProSgiPoolTagScope(unsigned int tag)
+    {
+        m_oldTag = ProSetSgiPoolTag(tag);
+    }
+
+    ~CProSgiPoolTagScope()
+    {
+        ProSetSgiPoolTag(m_oldTag);
+    }
+
+private:
+
+    unsigned int m_oldTag;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+////
+
 namespace std {
 
 template<typename __T, unsigned int __poolIndex = 0>
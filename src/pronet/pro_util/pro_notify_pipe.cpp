@@ -20,26 +20,34 @@
 #include "pro_notify_pipe.h"
 #include "pro_bsd_wrapper.h"
 #include "pro_memory_pool.h"
-#include "pro_time_util.h"
 #include "pro_z.h"
 
+#if defined(PRO_HAS_EVENTFD)
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
 /////////////////////////////////////////////////////////////////////////////
 ////
 
 #define RECV_BUF_SIZE (1024 * 8)
 #define SEND_BUF_SIZE (1024 * 8)
 
+#if !defined(PRO_HAS_EVENTFD)
 static char g_s_buffer[1024];
+#endif
 
 /////////////////////////////////////////////////////////////////////////////
 ////
 
 CProNotifyPipe::CProNotifyPipe()
 {
-    m_sockIds[0] = -1;
-    m_sockIds[1] = -1;
-    m_signal     = false;
-    m_notifyTick = 0;
+    m_sockIds[0]     = -1;
+    m_sockIds[1]     = -1;
+    m_pending        = false;
+    m_sentCount      = 0;
+    m_coalescedCount = 0;
+    m_notifyTime     = 0;
 }
 
 CProNotifyPipe::~CProNotifyPipe()
@@ -103,6 +111,17 @@ CProNotifyPipe::Init()
     m_sockIds[0] = sockId;
     m_sockIds[1] = sockId;
 
+#elif defined(PRO_HAS_EVENTFD)
+
+    int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (fd < 0)
+    {
+        return;
+    }
+
+    m_sockIds[0] = fd;
+    m_sockIds[1] = fd;
+
 #else  /* _WIN32 */
 
     int64_t sockIds[2] = { -1, -1 };
@@ -124,6 +143,11 @@ CProNotifyPipe::Fini()
 {
 #if defined(_WIN32)
     pbsd_closesocket(m_sockIds[0]);
+#elif defined(PRO_HAS_EVENTFD)
+    if (m_sockIds[0] != -1)
+    {
+        close((int)m_sockIds[0]);
+    }
 #else
     pbsd_closesocket(m_sockIds[0]);
     pbsd_closesocket(m_sockIds[1]);
@@ -131,8 +155,7 @@ CProNotifyPipe::Fini()
 
     m_sockIds[0] = -1;
     m_sockIds[1] = -1;
-    m_signal     = false;
-    m_notifyTick = 0;
+    m_pending    = false;
 }
 
 void
@@ -144,23 +167,31 @@ CProNotifyPipe::Notify()
         return;
     }
 
-    int64_t tick = ProGetTickCount64();
-    if (tick > m_notifyTick)
+    if (m_pending.exchange(true))
     {
-        m_signal     = false;
-        m_notifyTick = 0;
-    }
+        ++m_coalescedCount;
 
-    if (m_signal)
-    {
         return;
     }
 
-    char buf[] = { 0 };
-    if (pbsd_send(sockId, buf, sizeof(buf), 0) > 0) /* connected */
+    m_notifyTime = (int64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+
+#if defined(PRO_HAS_EVENTFD)
+    uint64_t value = 1;
+    bool     sent  = write((int)sockId, &value, sizeof(uint64_t)) == (ssize_t)sizeof(uint64_t);
+#else
+    char     buf[] = { 0 };
+    bool     sent  = pbsd_send(sockId, buf, sizeof(buf), 0) > 0; /* connected */
+#endif
+
+    if (sent)
+    {
+        ++m_sentCount;
+    }
+    else
     {
-        m_signal     = true;
-        m_notifyTick = tick;
+        m_pending = false; /* the next one retries */
     }
 }
 
@@ -173,15 +204,20 @@ CProNotifyPipe::Roger()
         return false;
     }
 
+#if defined(PRO_HAS_EVENTFD)
+    uint64_t value = 0;
+    if (read((int)sockId, &value, sizeof(uint64_t)) == (ssize_t)sizeof(uint64_t) ||
+        errno == EAGAIN)
+#else
     int recvSize = pbsd_recv(sockId, g_s_buffer, sizeof(g_s_buffer), 0); /* connected */
     if (
         (recvSize > 0 && recvSize <= (int)sizeof(g_s_buffer))
         ||
         (recvSize < 0 && pbsd_errno((void*)&pbsd_recv) == PBSD_EWOULDBLOCK)
        )
+#endif
     {
-        m_signal     = false;
-        m_notifyTick = 0;
+        m_pending = false; /* after draining */
 
         return true;
     }
@@ -26,6 +26,14 @@
 /////////////////////////////////////////////////////////////////////////////
 ////
 
+/*
+ * A wakeup channel. With "PRO_HAS_EVENTFD", it's one eventfd, and the
+ * reader and the writer are the same descriptor.
+ *
+ * At most one wakeup is outstanding. A Notify() before the next Roger()
+ * is coalesced and costs no syscall. Roger() drains the channel before it
+ * clears the flag, so the owner must re-check its state after Roger()
+ */
 class CProNotifyPipe
 {
 public:
@@ -52,11 +60,32 @@ public:
 
     bool Roger();
 
+    uint64_t GetSentCount() const
+    {
+        return m_sentCount;
+    }
+
+    uint64_t GetCoalescedCount() const
+    {
+        return m_coalescedCount;
+    }
+
+    /*
+     * When the outstanding wakeup was sent, in monotonic microseconds.
+     * Read it before Roger()
+     */
+    int64_t GetNotifyTime() const
+    {
+        return m_notifyTime;
+    }
+
 private:
 
-    int64_t m_sockIds[2];
-    bool    m_signal;
-    int64_t m_notifyTick;
+    int64_t               m_sockIds[2];
+    std::atomic<bool>     m_pending;
+    std::atomic<uint64_t> m_sentCount;
+    std::atomic<uint64_t> m_coalescedCount;
+    std::atomic<int64_t>  m_notifyTime;
 
     DECLARE_SGI_POOL(0)
 };
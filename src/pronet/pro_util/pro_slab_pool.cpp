@@ -0,0 +1,449 @@
+/*
+ * Copyright (C) 2018-2019 Eric Tung <libpronet@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"),
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file is part of LibProNet (https://github.com/libpronet/libpronet)
+ */
+
+#include "pro_a.h"
+#include "pro_slab_pool.h"
+#include "pro_memory_pool.h"
+#include "pro_thread_mutex.h"
+#include "pro_z.h"
+#include <atomic>
+
+/////////////////////////////////////////////////////////////////////////////
+////
+
+#define CACHE_LINE_SIZE 64
+#define OBJ_ALIGN_SIZE  8
+#define TCACHE_SLOTS    16 /* pools beyond that share the slots */
+#define TCACHE_DEPTH    32
+
+/*
+ * The cached objects of one pool in one thread
+ */
+struct PRO_SLAB_TCACHE_SLOT
+{
+    CProSlabPool* pool;
+    PRO_SLAB_OBJ* head;
+    unsigned int  count;
+    unsigned int  reportedCount; /* the part of "count" folded into the pool */
+};
+
+/*
+ * It's zero-initialized and trivially destructible, so the hot path pays
+ * nothing for the TLS access
+ */
+struct PRO_SLAB_TCACHE
+{
+    PRO_SLAB_TCACHE_SLOT slots[TCACHE_SLOTS];
+    bool                 dead; /* set at thread exit, then the pools are used directly */
+};
+
+#if !defined(PRO_LACKS_SGI_POOL_TCACHE)
+
+/*
+ * Gives the thread cache back at thread exit. It's touched when a slot is
+ * first used, so that the destructor gets registered
+ */
+class CProSlabTcacheGuard_i
+{
+public:
+
+    ~CProSlabTcacheGuard_i();
+
+    void Touch()
+    {
+    }
+};
+
+static thread_local PRO_SLAB_TCACHE       g_s_tcache;
+static thread_local CProSlabTcacheGuard_i g_s_tcacheGuard;
+#endif
+static std::atomic<unsigned int>          g_s_nextSlot(0);
+
+/////////////////////////////////////////////////////////////////////////////
+////
+
+CProSlabPool::CProSlabPool(size_t       objSize,
+                           unsigned int poolIndex) /* = 0 */
+: m_poolIndex(poolIndex),
+  m_tcacheSlot(g_s_nextSlot.fetch_add(1) % TCACHE_SLOTS),
+  m_objSize(objSize > sizeof(PRO_SLAB_OBJ) ? objSize : sizeof(PRO_SLAB_OBJ))
+{
+    assert(objSize > 0);
+    assert(poolIndex <= 3);
+
+    m_freeList     = NULL;
+    m_startFree    = NULL;
+    m_endFree      = NULL;
+    m_liveObjNum   = 0;
+    m_cachedObjNum = 0;
+    m_totalObjNum  = 0;
+    m_slabBytes    = 0;
+    m_slabList     = NULL;
+}
+
+CProSlabPool::~CProSlabPool()
+{
+#if !defined(PRO_LACKS_SGI_POOL_TCACHE)
+    /*
+     * only the calling thread's cache can be reached
+     */
+    if (!g_s_tcache.dead && g_s_tcache.slots[m_tcacheSlot].pool == this)
+    {
+        g_s_tcache.slots[m_tcacheSlot].pool          = NULL;
+        g_s_tcache.slots[m_tcacheSlot].head          = NULL;
+        g_s_tcache.slots[m_tcacheSlot].count         = 0;
+        g_s_tcache.slots[m_tcacheSlot].reportedCount = 0;
+    }
+#endif
+
+    while (m_slabList != NULL)
+    {
+        PRO_SLAB_OBJ* slab = m_slabList;
+        m_slabList = slab->next;
+
+        ProDeallocateSgiPoolBuffer(((void**)slab)[1], m_poolIndex);
+    }
+}
+
+size_t
+CProSlabPool::GetObjSize() const
+{
+    return m_objSize;
+}
+
+void*
+CProSlabPool::Allocate(size_t size)
+{
+    if (size == 0)
+    {
+        size = 1;
+    }
+
+#if !defined(PRO_LACKS_SGI_POOL_TCACHE)
+    PRO_SLAB_TCACHE_SLOT* slot = NULL;
+
+    if (!g_s_tcache.dead)
+    {
+        slot = &g_s_tcache.slots[m_tcacheSlot];
+
+        if (slot->pool == this && slot->head != NULL && size <= m_objSize)
+        {
+            PRO_SLAB_OBJ* obj = slot->head;
+            slot->head = obj->next;
+            --slot->count;
+
+            return obj;
+        }
+
+        /*
+         * The slot is taken over outside the lock, since handing it back
+         * to another pool takes that pool's lock
+         */
+        if (slot->pool != this)
+        {
+            if (slot->pool != NULL)
+            {
+                slot->pool->DeallocateBatch_i(*slot, 0);
+            }
+
+            slot->pool = this;
+            g_s_tcacheGuard.Touch(); /* register the drain at thread exit */
+        }
+    }
+#endif
+
+    {
+        CProThreadMutexGuard mon(m_lock);
+
+        if (size <= m_objSize)
+        {
+            void* p = Pop_i();
+
+#if !defined(PRO_LACKS_SGI_POOL_TCACHE)
+            /*
+             * refill: one for the caller, and half a cache for later
+             */
+            if (p != NULL && slot != NULL)
+            {
+                for (int i = 0; i < TCACHE_DEPTH / 2; ++i)
+                {
+                    PRO_SLAB_OBJ* obj = (PRO_SLAB_OBJ*)Pop_i();
+                    if (obj == NULL)
+                    {
+                        break;
+                    }
+
+                    obj->next  = slot->head;
+                    slot->head = obj;
+                    ++slot->count;
+                }
+
+                m_cachedObjNum      += slot->count;
+                m_cachedObjNum      -= slot->reportedCount;
+                slot->reportedCount =  slot->count;
+            }
+#endif
+
+            return p;
+        }
+    }
+
+    return ProAllocateSgiPoolBuffer(size, m_poolIndex);
+}
+
+void
+CProSlabPool::Deallocate(void*  p,
+                         size_t size)
+{
+    if (p == NULL)
+    {
+        return;
+    }
+
+    if (size == 0)
+    {
+        size = 1;
+    }
+
+#if !defined(PRO_LACKS_SGI_POOL_TCACHE)
+    if (!g_s_tcache.dead && size <= m_objSize)
+    {
+        PRO_SLAB_TCACHE_SLOT& slot = g_s_tcache.slots[m_tcacheSlot];
+
+        if (slot.pool != this)
+        {
+            if (slot.pool != NULL)
+            {
+                slot.pool->DeallocateBatch_i(slot, 0);
+            }
+
+            slot.pool = this;
+            g_s_tcacheGuard.Touch(); /* register the drain at thread exit */
+        }
+
+        PRO_SLAB_OBJ* obj = (PRO_SLAB_OBJ*)p;
+        obj->next = slot.head;
+        slot.head = obj;
+        ++slot.count;
+
+        if (slot.count > TCACHE_DEPTH)
+        {
+            DeallocateBatch_i(slot, TCACHE_DEPTH / 2);
+        }
+
+        return;
+    }
+#endif
+
+    {
+        CProThreadMutexGuard mon(m_lock);
+
+        if (size <= m_objSize)
+        {
+            PRO_SLAB_OBJ* obj = (PRO_SLAB_OBJ*)p;
+            obj->next  = m_freeList;
+            m_freeList = obj;
+
+            --m_liveObjNum;
+
+            return;
+        }
+    }
+
+    ProDeallocateSgiPoolBuffer(p, m_poolIndex);
+}
+
+void
+CProSlabPool::GetInfo(size_t* objSize,     /* = NULL */
+                      size_t* liveObjNum,  /* = NULL */
+                      size_t* totalObjNum, /* = NULL */
+                      size_t* slabBytes)   /* = NULL */
+                      const
+{
+    CProThreadMutexGuard mon(m_lock);
+
+    if (objSize != NULL)
+    {
+        *objSize     = m_objSize;
+    }
+    if (liveObjNum != NULL)
+    {
+        /*
+         * objects freed by another module's pool may skew the counts
+         */
+        *liveObjNum  = m_liveObjNum > m_cachedObjNum ? m_liveObjNum - m_cachedObjNum : 0;
+    }
+    if (totalObjNum != NULL)
+    {
+        *totalObjNum = m_totalObjNum;
+    }
+    if (slabBytes != NULL)
+    {
+        *slabBytes   = m_slabBytes;
+    }
+}
+
+void
+CProSlabPool::FlushThreadCache()
+{
+#if !defined(PRO_LACKS_SGI_POOL_TCACHE)
+    for (int i = 0; i < TCACHE_SLOTS; ++i)
+    {
+        PRO_SLAB_TCACHE_SLOT& slot = g_s_tcache.slots[i];
+        if (slot.pool != NULL)
+        {
+            slot.pool->DeallocateBatch_i(slot, 0);
+            slot.pool = NULL;
+        }
+    }
+#endif
+}
+
+void*
+CProSlabPool::Pop_i()
+{
+    void* p = m_freeList;
+    if (p != NULL)
+    {
+        m_freeList = m_freeList->next;
+    }
+    else if (m_startFree != NULL || Grow_i())
+    {
+        p = m_startFree;
+        m_startFree += (m_objSize + OBJ_ALIGN_SIZE - 1) & ~(size_t)(OBJ_ALIGN_SIZE - 1);
+        if (m_startFree + m_objSize > m_endFree)
+        {
+            m_startFree = NULL; /* exhausted */
+        }
+
+        ++m_totalObjNum;
+    }
+    else
+    {
+    }
+
+    if (p != NULL)
+    {
+        ++m_liveObjNum;
+    }
+
+    return p;
+}
+
+bool
+CProSlabPool::Grow_i()
+{
+    /*
+     * a slab holds at least 8 objects
+     */
+    size_t bytes = PRO_SLAB_POOL_BYTES;
+    if (bytes < CACHE_LINE_SIZE + m_objSize * 8)
+    {
+        bytes = CACHE_LINE_SIZE + m_objSize * 8;
+    }
+
+    void* raw = ProAllocateSgiPoolBuffer(bytes + CACHE_LINE_SIZE, m_poolIndex);
+    if (raw == NULL)
+    {
+        return false;
+    }
+
+    /*
+     * The first cache line of a slab holds the slab link and the raw
+     * address. The objects start at the next one
+     */
+    char* slab = (char*)(((size_t)raw + CACHE_LINE_SIZE - 1) & ~(size_t)(CACHE_LINE_SIZE - 1));
+
+    ((PRO_SLAB_OBJ*)slab)->next = m_slabList;
+    ((void**)slab)[1]           = raw;
+    m_slabList                  = (PRO_SLAB_OBJ*)slab;
+
+    m_startFree =  slab + CACHE_LINE_SIZE;
+    m_endFree   =  slab + bytes;
+    m_slabBytes += bytes + CACHE_LINE_SIZE;
+
+    return true;
+}
+
+/*
+ * Keeps the "keepNum" most recently freed objects of a slot, and returns
+ * the rest to the pool in one batch
+ */
+void
+CProSlabPool::DeallocateBatch_i(PRO_SLAB_TCACHE_SLOT& slot,
+                                unsigned int          keepNum)
+{
+    PRO_SLAB_OBJ* first = slot.head;
+    PRO_SLAB_OBJ* prev  = NULL;
+    for (unsigned int i = 0; i < keepNum && first != NULL; ++i)
+    {
+        prev  = first;
+        first = first->next;
+    }
+
+    unsigned int num = 0;
+
+    PRO_SLAB_OBJ* last = first;
+    while (last != NULL)
+    {
+        ++num;
+        if (last->next == NULL)
+        {
+            break;
+        }
+
+        last = last->next;
+    }
+
+    if (prev != NULL)
+    {
+        prev->next = NULL;
+    }
+    else
+    {
+        slot.head = NULL;
+    }
+
+    slot.count -= num;
+
+    CProThreadMutexGuard mon(m_lock);
+
+    if (num > 0)
+    {
+        last->next  =  m_freeList;
+        m_freeList  =  first;
+        m_liveObjNum -= num;
+    }
+
+    m_cachedObjNum     += slot.count;
+    m_cachedObjNum     -= slot.reportedCount;
+    slot.reportedCount =  slot.count;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+////
+
+#if !defined(PRO_LACKS_SGI_POOL_TCACHE)
+
+CProSlabTcacheGuard_i::~CProSlabTcacheGuard_i()
+{
+    CProSlabPool::FlushThreadCache();
+    g_s_tcache.dead = true;
+}
+
+#endif /* PRO_LACKS_SGI_POOL_TCACHE */
@@ -0,0 +1,289 @@
+/*
+ * Copyright (C) 2018-2019 Eric Tung <libpronet@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"),
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This file is part of LibProNet (https://github.com/libpronet/libpronet)
+ */
+
+/*
+ * A slab pool serves objects of one fixed size. Objects are carved from
+ * cache-line aligned slabs and recycled through an intrusive free list,
+ * so they carry no per-object header, and the live count of each type
+ * can be observed. Every thread keeps a small cache of each pool in front
+ * of the pool lock, refilled and drained in batches.
+ *
+ * Usage:
+ *
+ *   //// xxx.h
+ *   class CXxx
+ *   {
+ *       ...
+ *       DECLARE_SLAB_POOL(0)
+ *   };
+ *
+ *   //// xxx.cpp
+ *   IMPLEMENT_SLAB_POOL(CXxx, 0)
+ *
+ * The pool of a class is defined in the translation unit of the class.
+ * pro_util is a static library, so every shared library that links it
+ * gets a pool of its own for the same type. An object freed by another
+ * module goes to that module's pool. The slabs are never released, so
+ * that's safe, but the live counts of both pools are then off. The pools
+ * of IMPLEMENT_SLAB_POOL() are never deleted. Other pools must outlive
+ * the threads that use them, because of the thread caches.
+ */
+
+#ifndef ____PRO_SLAB_POOL_H____
+#define ____PRO_SLAB_POOL_H____
+
+#include "pro_a.h"
+#include "pro_memory_pool.h"
+#include "pro_thread_mutex.h"
+#include "pro_z.h"
+#include <map>
+
+/////////////////////////////////////////////////////////////////////////////
+////
+
+struct PRO_SLAB_OBJ
+{
+    PRO_SLAB_OBJ* next;
+};
+
+struct PRO_SLAB_TCACHE_SLOT;
+
+/////////////////////////////////////////////////////////////////////////////
+////
+
+class CProSlabPool
+{
+public:
+
+    CProSlabPool(
+        size_t       objSize,
+        unsigned int poolIndex /* = 0 */
+        );
+
+    ~CProSlabPool();
+
+    size_t GetObjSize() const;
+
+    /*
+     * Sizes larger than the object size go to the SGI pool
+     */
+    void* Allocate(size_t size);
+
+    void Deallocate(
+        void*  p,
+        size_t size
+        );
+
+    /*
+     * The objects parked in thread caches are not counted as live. That
+     * part is folded in at refill and drain, so it lags slightly
+     */
+    void GetInfo(
+        size_t* objSize,      /* = NULL */
+        size_t* liveObjNum,   /* = NULL */
+        size_t* totalObjNum,  /* = NULL */
+        size_t* slabBytes     /* = NULL */
+        ) const;
+
+    /*
+     * Gives the cached objects of the calling thread back to their pools.
+     * It's done at thread exit anyway
+     */
+    static void FlushThreadCache();
+
+private:
+
+    void* Pop_i();
+
+    bool Grow_i();
+
+    void DeallocateBatch_i(
+        PRO_SLAB_TCACHE_SLOT& slot,
+        unsigned int          keepNum
+        );
+
+private:
+
+    const unsigned int      m_poolIndex;
+    const unsigned int      m_tcacheSlot;
+    const size_t            m_objSize;
+    PRO_SLAB_OBJ*           m_freeList;
+    char*                   m_startFree;
+    char*                   m_endFree;
+    size_t                  m_liveObjNum;   /* including the objects in thread caches */
+    size_t                  m_cachedObjNum; /* reported by the thread caches */
+    size_t                  m_totalObjNum;
+    size_t                  m_slabBytes;
+    PRO_SLAB_OBJ*           m_slabList;   /* the first line of each slab links them */
+    mutable CProThreadMutex m_lock;
+
+    DECLARE_SGI_POOL(0)
+};
+
+/////////////////////////////////////////////////////////////////////////////
+////
+
+#if defined(DECLARE_SLAB_POOL)
+#undef DECLARE_SLAB_POOL
+#endif
+#if defined(IMPLEMENT_SLAB_POOL)
+#undef IMPLEMENT_SLAB_POOL
+#endif
+
+#if !defined(PRO_LACKS_SGI_POOL) && !defined(PRO_LACKS_SGI_POOL_OPNEW)
+#define DECLARE_SLAB_POOL(a)                                                                     \
+public:                                                                                          \
+    static CProSlabPool& GetSlabPool();                                                          \
+    static void* operator new(size_t size);                                                      \
+    static void  operator delete(void* p, size_t size);                                          \
+    static void* operator new[](size_t size)     { return ProAllocateSgiPoolBuffer(size, (a)); } \
+    static void  operator delete[](void* p)      { ProDeallocateSgiPoolBuffer(p, (a)); }         \
+    static void* operator new(size_t, void* p)   { return p; }                                   \
+    static void  operator delete(void*, void*)   {}                                              \
+    static void* operator new[](size_t, void* p) { return p; }                                   \
+    static void  operator delete[](void*, void*) {}                                              \
+protected:
+#define IMPLEMENT_SLAB_POOL(c, a)                                                                \
+    CProSlabPool& c::GetSlabPool()                                                               \
+    {                                                                                            \
+        static CProSlabPool* s_pool = new CProSlabPool(sizeof(c), (a)); /* never deleted */      \
+        return *s_pool;                                                                          \
+    }                                                                                            \
+    void* c::operator new(size_t size)             { return GetSlabPool().Allocate(size); }     \
+    void  c::operator delete(void* p, size_t size) { GetSlabPool().Deallocate(p, size); }
+#else
+#define DECLARE_SLAB_POOL(a)                                                                     \
+public:                                                                                          \
+    static CProSlabPool& GetSlabPool();                                                          \
+protected:
+#define IMPLEMENT_SLAB_POOL(c, a)                                                                \
+    CProSlabPool& c::GetSlabPool()                                                               \
+    {                                                                                            \
+        static CProSlabPool* s_pool = new CProSlabPool(sizeof(c), (a)); /* never deleted */      \
+        return *s_pool;                                                                          \
+    }
+#endif
+
+/////////////////////////////////////////////////////////////////////////////
+////
+
+namespace std {
+
+/*
+ * The size of the tree node that set and map allocate for a __V. Pass it
+ * to the slab pool of a pro_slab_allocator
+ */
+template<typename __V>
+struct pro_tree_node_size
+{
+#if defined(_MSC_VER)
+    static const size_t value = sizeof(_Tree_node<__V, void*>);
+#elif defined(_LIBCPP_VERSION)
+    static const size_t value = sizeof(__tree_node<__V, void*>);
+#else
+    static const size_t value = sizeof(_Rb_tree_node<__V>);
+#endif
+};
+
+/*
+ * An allocator for node based containers, such as set and map. Single
+ * nodes come from the slab pool returned by __getPool(), everything
+ * else from the SGI pool.
+ */
+template<typename __T, CProSlabPool& (*__getPool)()>
+class pro_slab_allocator : public pro_allocator<__T, 0>
+{
+public:
+
+    template<typename __Other>
+    struct rebind
+    {
+        typedef pro_slab_allocator<__Other, __getPool> other;
+    };
+
+    pro_slab_allocator() : pro_allocator<__T, 0>()
+    {
+    }
+
+    pro_slab_allocator(const pro_slab_allocator<__T, __getPool>&) : pro_allocator<__T, 0>()
+    {
+    }
+
+    template<typename __Other>
+    pro_slab_allocator(const pro_slab_allocator<__Other, __getPool>&)
+    {
+        /*
+         * do nothing
+         */
+    }
+
+    template<typename __Other>
+    pro_slab_allocator<__T, __getPool>& operator=(const pro_slab_allocator<__Other, __getPool>&)
+    {
+        /*
+         * do nothing
+         */
+        return *this;
+    }
+
+    __T* allocate(size_t __n)
+    {
+#if !defined(PRO_LACKS_SGI_POOL) && !defined(PRO_LACKS_SGI_POOL_STL)
+        if (__n == 1)
+        {
+            /*
+             * a pool sized for another node type would pass it on to the
+             * SGI pool, one node at a time
+             */
+            assert(sizeof(__T) <= __getPool().GetObjSize());
+
+            return (__T*)__getPool().Allocate(sizeof(__T));
+        }
+#endif
+
+        return pro_allocator<__T, 0>::allocate(__n);
+    }
+
+    __T* allocate(size_t __n, const void*)
+    {
+        return allocate(__n);
+    }
+
+    void deallocate(void* __p, size_t __n)
+    {
+#if !defined(PRO_LACKS_SGI_POOL) && !defined(PRO_LACKS_SGI_POOL_STL)
+        if (__n == 1)
+        {
+            __getPool().Deallocate(__p, sizeof(__T));
+
+            return;
+        }
+#endif
+
+        pro_allocator<__T, 0>::deallocate(__p, __n);
+    }
+
+    DECLARE_SGI_POOL(0)
+};
+
+} /* namespace std */
+
+/////////////////////////////////////////////////////////////////////////////
+////
+
+#endif /* ____PRO_SLAB_POOL_H____ */
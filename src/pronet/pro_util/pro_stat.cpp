@@ -20,6 +20,7 @@
 #include "pro_stat.h"
 #include "pro_memory_pool.h"
 #include "pro_stl.h"
+#include "pro_thread_mutex.h"
 #include "pro_time_util.h"
 #include "pro_z.h"
 
@@ -36,9 +37,21 @@
 /////////////////////////////////////////////////////////////////////////////
 ////
 
+static
+inline
+int64_t
+GetTick_i(bool cachedTick)
+{
+    return cachedTick ? ProGetCachedTickCount64() : ProGetTickCount64();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+////
+
 CProStatBitRate::CProStatBitRate()
 {
-    m_timeSpan = 5;
+    m_cachedTick = false;
+    m_timeSpan   = 5;
 
     Reset();
 }
@@ -64,6 +77,12 @@ CProStatBitRate::SetTimeSpan(unsigned int timeSpanInSeconds) /* = 5 */
     m_timeSpan = timeSpanInSeconds;
 }
 
+void
+CProStatBitRate::SetCachedTick(bool cachedTick) /* = false */
+{
+    m_cachedTick = cachedTick;
+}
+
 void
 CProStatBitRate::PushDataBytes(size_t dataBytes)
 {
@@ -73,7 +92,7 @@ CProStatBitRate::PushDataBytes(size_t dataBytes)
 void
 CProStatBitRate::PushDataBits(size_t dataBits)
 {
-    int64_t tick = ProGetTickCount64();
+    int64_t tick = GetTick_i(m_cachedTick);
 
     if (m_startTick == 0)
     {
@@ -94,7 +113,7 @@ CProStatBitRate::PushDataBits(size_t dataBits)
 double
 CProStatBitRate::CalcBitRate()
 {
-    Update(ProGetTickCount64());
+    Update(GetTick_i(m_cachedTick));
 
     return m_bitRate;
 }
@@ -328,6 +347,7 @@ struct PRO_REORDER_BLOCK
 
 CProStatLossRate::CProStatLossRate()
 {
+    m_cachedTick        = false;
     m_timeSpan          = 5;
     m_maxBrokenDuration = 5;
     m_reorder           = new PRO_REORDER_BLOCK;
@@ -381,11 +401,17 @@ CProStatLossRate::SetMaxBrokenDuration(unsigned int brokenDurationInSeconds) /*
     m_maxBrokenDuration = brokenDurationInSeconds;
 }
 
+void
+CProStatLossRate::SetCachedTick(bool cachedTick) /* = false */
+{
+    m_cachedTick = cachedTick;
+}
+
 void
 CProStatLossRate::PushData(uint16_t seq,
                            uint32_t ssrc) /* = 0 */
 {
-    int64_t tick = ProGetTickCount64();
+    int64_t tick = GetTick_i(m_cachedTick);
 
     /*
      * reset
@@ -517,7 +543,7 @@ CProStatLossRate::CalcLossRate()
 {
     if (m_startTick > 0)
     {
-        int64_t tick = ProGetTickCount64();
+        int64_t tick = GetTick_i(m_cachedTick);
         if (tick - m_reorder->popTick > MAX_POP_INTERVAL_MS)
         {
             CProStlVector<int64_t> seqs;
@@ -573,7 +599,8 @@ CProStatLossRate::Update(int64_t tick)
 
 CProStatAvgValue::CProStatAvgValue()
 {
-    m_timeSpan = 5;
+    m_cachedTick = false;
+    m_timeSpan   = 5;
 
     Reset();
 }
@@ -600,10 +627,16 @@ CProStatAvgValue::SetTimeSpan(unsigned int timeSpanInSeconds) /* = 5 */
     m_timeSpan = timeSpanInSeconds;
 }
 
+void
+CProStatAvgValue::SetCachedTick(bool cachedTick) /* = false */
+{
+    m_cachedTick = cachedTick;
+}
+
 void
 CProStatAvgValue::PushData(double dataValue)
 {
-    int64_t tick = ProGetTickCount64();
+    int64_t tick = GetTick_i(m_cachedTick);
 
     if (m_startTick == 0)
     {
@@ -655,6 +688,145 @@ CProStatAvgValue::Update(int64_t tick)
 /////////////////////////////////////////////////////////////////////////////
 ////
 
+CProStatHistogram::CProStatHistogram()
+{
+    for (int i = 0; i < (int)(sizeof(m_buckets) / sizeof(m_buckets[0])); ++i)
+    {
+        m_buckets[i] = 0;
+    }
+
+    m_maxValue = 0;
+}
+
+void
+CProStatHistogram::PushData(uint64_t dataValue)
+{
+    int index = 0;
+    for (uint64_t value = dataValue; value != 0 && index < 32; value >>= 1)
+    {
+        ++index;
+    }
+
+    /*
+     * one writer, so no read-modify-write is needed
+     */
+    std::atomic<uint32_t>& bucket = m_buckets[index];
+    bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+    if (dataValue > m_maxValue.load(std::memory_order_relaxed))
+    {
+        m_maxValue.store(dataValue, std::memory_order_relaxed);
+    }
+}
+
+uint64_t
+CProStatHistogram::CalcPercentile(double percent) const
+{
+    uint32_t counts[sizeof(m_buckets) / sizeof(m_buckets[0])];
+    uint64_t total = 0;
+
+    for (int i = 0; i < (int)(sizeof(m_buckets) / sizeof(m_buckets[0])); ++i)
+    {
+        counts[i] = m_buckets[i].load(std::memory_order_relaxed);
+        total    += counts[i];
+    }
+
+    if (total == 0)
+    {
+        return 0;
+    }
+
+    uint64_t rank = (uint64_t)(total * percent / 100);
+    if (rank == 0)
+    {
+        rank = 1;
+    }
+
+    uint64_t maxValue = m_maxValue.load(std::memory_order_relaxed);
+    uint64_t sum      = 0;
+
+    for (int j = 0; j < (int)(sizeof(m_buckets) / sizeof(m_buckets[0])); ++j)
+    {
+        sum += counts[j];
+        if (sum >= rank)
+        {
+            uint64_t bound = j == 0 ? 0 : ((uint64_t)1 << j) - 1;
+
+            return bound < maxValue ? bound : maxValue;
+        }
+    }
+
+    return maxValue;
+}
+
+uint64_t
+CProStatHistogram::GetCount() const
+{
+    uint64_t total = 0;
+
+    for (int i = 0; i < (int)(sizeof(m_buckets) / sizeof(m_buckets[0])); ++i)
+    {
+        total += m_buckets[i].load(std::memory_order_relaxed);
+    }
+
+    return total;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+////
+
+CProStatSlowCalls::CProStatSlowCalls()
+{
+    memset(m_calls, 0, sizeof(m_calls));
+    m_count = 0;
+}
+
+void
+CProStatSlowCalls::PushCall(int64_t     id,
+                            const char* name,
+                            const char* callback,
+                            uint64_t    time)
+{
+    CProThreadMutexGuard mon(m_lock);
+
+    PRO_SLOW_CALL& call = m_calls[m_count % (sizeof(m_calls) / sizeof(m_calls[0]))];
+    call.tick     = ProGetTickCount64();
+    call.id       = id;
+    call.name     = name;
+    call.callback = callback;
+    call.time     = time;
+
+    ++m_count;
+}
+
+uint64_t
+CProStatSlowCalls::GetCount() const
+{
+    CProThreadMutexGuard mon(m_lock);
+
+    return m_count;
+}
+
+size_t
+CProStatSlowCalls::GetLastCalls(PRO_SLOW_CALL* calls, /* the latest first */
+                                size_t         count) const
+{
+    const size_t capacity = sizeof(m_calls) / sizeof(m_calls[0]);
+
+    CProThreadMutexGuard mon(m_lock);
+
+    size_t i = 0;
+    for (; i < count && i < capacity && i < m_count; ++i)
+    {
+        calls[i] = m_calls[(m_count - 1 - i) % capacity];
+    }
+
+    return i;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+////
+
 int64_t
 ProSeq16ToSeq64(uint16_t inputSeq,
                 int64_t  referenceSeq64)
@@ -21,6 +21,7 @@
 
 #include "pro_a.h"
 #include "pro_memory_pool.h"
+#include "pro_thread_mutex.h"
 #include "pro_z.h"
 
 /////////////////////////////////////////////////////////////////////////////
@@ -39,6 +40,12 @@ public:
 
     void SetTimeSpan(unsigned int timeSpanInSeconds); /* = 5 */
 
+    /*
+     * Whether the tick is the per-wakeup stamp of a reactor thread. Set it
+     * only if the data is pushed on the reactor thread
+     */
+    void SetCachedTick(bool cachedTick); /* = false */
+
     void PushDataBytes(size_t dataBytes);
 
     void PushDataBits(size_t dataBits);
@@ -53,6 +60,7 @@ private:
 
 private:
 
+    bool    m_cachedTick;
     int64_t m_timeSpan;
     int64_t m_startTick;
     int64_t m_calcTick;
@@ -77,6 +85,12 @@ public:
 
     void SetMaxBrokenDuration(unsigned int brokenDurationInSeconds); /* = 5 */
 
+    /*
+     * Whether the tick is the per-wakeup stamp of a reactor thread. Set it
+     * only if the data is pushed on the reactor thread
+     */
+    void SetCachedTick(bool cachedTick); /* = false */
+
     void PushData(
         uint16_t seq,
         uint32_t ssrc = 0
@@ -96,6 +110,7 @@ private:
 
 private:
 
+    bool               m_cachedTick;
     int64_t            m_timeSpan;
     int64_t            m_maxBrokenDuration;
     int64_t            m_startTick;
@@ -123,6 +138,12 @@ public:
 
     void SetTimeSpan(unsigned int timeSpanInSeconds); /* = 5 */
 
+    /*
+     * Whether the tick is the per-wakeup stamp of a reactor thread. Set it
+     * only if the data is pushed on the reactor thread
+     */
+    void SetCachedTick(bool cachedTick); /* = false */
+
     void PushData(double dataValue);
 
     double CalcAvgValue();
@@ -135,6 +156,7 @@ private:
 
 private:
 
+    bool    m_cachedTick;
     int64_t m_timeSpan;
     int64_t m_startTick;
     int64_t m_calcTick;
@@ -148,6 +170,82 @@ private:
 /////////////////////////////////////////////////////////////////////////////
 ////
 
+/*
+ * Log2 buckets, pushed by one thread and read by any without a lock.
+ * A percentile is the upper bound of its bucket, no more than the max
+ */
+class CProStatHistogram
+{
+public:
+
+    CProStatHistogram();
+
+    void PushData(uint64_t dataValue);
+
+    uint64_t CalcPercentile(double percent) const; /* (0, 100] */
+
+    uint64_t GetMaxValue() const
+    {
+        return m_maxValue;
+    }
+
+    uint64_t GetCount() const;
+
+private:
+
+    std::atomic<uint32_t> m_buckets[33]; /* 0, [1, 2), [2, 4), ... */
+    std::atomic<uint64_t> m_maxValue;
+
+    DECLARE_SGI_POOL(0)
+};
+
+/////////////////////////////////////////////////////////////////////////////
+////
+
+struct PRO_SLOW_CALL
+{
+    int64_t     tick;     /* ms, when it returned */
+    int64_t     id;       /* sockId or timerId */
+    const char* name;     /* a string literal */
+    const char* callback; /* a string literal */
+    uint64_t    time;     /* us */
+};
+
+/*
+ * The last few callbacks that ran longer than a threshold
+ */
+class CProStatSlowCalls
+{
+public:
+
+    CProStatSlowCalls();
+
+    void PushCall(
+        int64_t     id,
+        const char* name,
+        const char* callback,
+        uint64_t    time
+        );
+
+    uint64_t GetCount() const;
+
+    size_t GetLastCalls(
+        PRO_SLOW_CALL* calls, /* the latest first */
+        size_t         count
+        ) const;
+
+private:
+
+    PRO_SLOW_CALL           m_calls[8];
+    uint64_t                m_count;
+    mutable CProThreadMutex m_lock;
+
+    DECLARE_SGI_POOL(0)
+};
+
+/////////////////////////////////////////////////////////////////////////////
+////
+
 int64_t
 ProSeq16ToSeq64(uint16_t inputSeq,
                 int64_t  referenceSeq64);
@@ -32,6 +32,15 @@
 #include <pthread.h>
 #endif
 
+#if defined(__linux__)
+#include <sched.h>
+#include <time.h>
+#endif
+
+#if defined(__APPLE__)
+#include <mach/mach.h>
+#endif
+
 /////////////////////////////////////////////////////////////////////////////
 ////
 
@@ -259,3 +268,73 @@ ProGetProcessId()
 
     return pid;
 }
+
+bool
+ProBindThreadToCpu(unsigned int cpu)
+{
+    bool ret = false;
+
+#if defined(_WIN32)
+    if (cpu < sizeof(DWORD_PTR) * 8)
+    {
+        ret = ::SetThreadAffinityMask(::GetCurrentThread(), (DWORD_PTR)1 << cpu) != 0;
+    }
+#elif defined(__linux__)
+    if (cpu < CPU_SETSIZE)
+    {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(cpu, &cpus);
+
+        ret = sched_setaffinity(0, sizeof(cpu_set_t), &cpus) == 0; /* 0 is the calling thread */
+    }
+#endif
+
+    return ret;
+}
+
+int64_t
+ProGetThreadCpuTime(uint64_t threadId)
+{
+    int64_t us = -1;
+
+#if defined(_WIN32)
+    HANDLE thread = ::OpenThread(THREAD_QUERY_LIMITED_INFORMATION, FALSE, (DWORD)threadId);
+    if (thread != NULL)
+    {
+        FILETIME creationTime;
+        FILETIME exitTime;
+        FILETIME kernelTime;
+        FILETIME userTime;
+        if (::GetThreadTimes(thread, &creationTime, &exitTime, &kernelTime, &userTime))
+        {
+            uint64_t t100ns =
+                (((uint64_t)kernelTime.dwHighDateTime << 32) | kernelTime.dwLowDateTime) +
+                (((uint64_t)userTime.dwHighDateTime   << 32) | userTime.dwLowDateTime);
+            us = (int64_t)(t100ns / 10);
+        }
+        ::CloseHandle(thread);
+    }
+#elif defined(__APPLE__)
+    mach_port_t              port  = pthread_mach_thread_np((pthread_t)threadId);
+    thread_basic_info_data_t info;
+    mach_msg_type_number_t   count = THREAD_BASIC_INFO_COUNT;
+    if (thread_info(port, THREAD_BASIC_INFO, (thread_info_t)&info, &count) == KERN_SUCCESS)
+    {
+        us = (int64_t)info.user_time.seconds   * 1000000 + info.user_time.microseconds +
+             (int64_t)info.system_time.seconds * 1000000 + info.system_time.microseconds;
+    }
+#elif defined(__linux__)
+    clockid_t clk;
+    if (pthread_getcpuclockid((pthread_t)threadId, &clk) == 0)
+    {
+        struct timespec ts;
+        if (clock_gettime(clk, &ts) == 0)
+        {
+            us = (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+        }
+    }
+#endif
+
+    return us;
+}
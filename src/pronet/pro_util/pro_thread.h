@@ -82,6 +82,20 @@ ProGetThreadId();
 uint64_t
 ProGetProcessId();
 
+/*
+ * Pins the calling thread to one logical cpu. macOS has no hard affinity,
+ * so it returns false there
+ */
+bool
+ProBindThreadToCpu(unsigned int cpu);
+
+/*
+ * Cpu time consumed by a thread of this process, in microseconds. The
+ * threadId is a value of ProGetThreadId(). Returns -1 if not supported
+ */
+int64_t
+ProGetThreadCpuTime(uint64_t threadId);
+
 /////////////////////////////////////////////////////////////////////////////
 ////
 
@@ -21,7 +21,10 @@
 #include "pro_command_task.h"
 #include "pro_memory_pool.h"
 #include "pro_shared.h"
+#include "pro_slab_pool.h"
+#include "pro_stat.h"
 #include "pro_stl.h"
+#include "pro_thread.h"
 #include "pro_thread_mutex.h"
 #include "pro_time_util.h"
 #include "pro_z.h"
@@ -43,6 +46,615 @@
 /////////////////////////////////////////////////////////////////////////////
 ////
 
+static
+unsigned int
+TimerTag_i()
+{
+    static const unsigned int s_tag = ProRegisterSgiPoolTag("timer");
+
+    return s_tag;
+}
+
+static
+int64_t
+GetTickUs_i()
+{
+    return (int64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+////
+
+CProSlabPool&
+PRO_TIMER_NODE::GetSlabPool()
+{
+    static CProSlabPool* s_pool = new CProSlabPool(
+        std::pro_tree_node_size<PRO_TIMER_NODE>::value, 0); /* never deleted */
+
+    return *s_pool;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+////
+
+#define WHEEL_LEVELS    6
+#define WHEEL_SLOTS     256
+#define WHEEL_MAX_DELAY (((int64_t)1 << (8 * WHEEL_LEVELS - 1)) - 1)
+
+struct PRO_WHEEL_NODE
+{
+    PRO_TIMER_NODE  node;
+    PRO_WHEEL_NODE* prev;
+    PRO_WHEEL_NODE* next;
+    int             level;
+    int             slot;
+
+    DECLARE_SGI_POOL(0)
+};
+
+static
+int
+FindSlot_i(const uint64_t bits[4],
+           int            from)
+{
+    int i = from;
+
+    while (i < WHEEL_SLOTS)
+    {
+        uint64_t word = bits[i >> 6] >> (i & 63);
+        if (word == 0)
+        {
+            i = (i | 63) + 1;
+            continue;
+        }
+
+        while ((word & 1) == 0)
+        {
+            word >>= 1;
+            ++i;
+        }
+
+        return i;
+    }
+
+    return -1;
+}
+
+CProTimerWheel::CProTimerWheel(int64_t tick)
+{
+    m_tick = tick;
+    m_due  = NULL;
+
+    memset(m_slots, 0, sizeof(m_slots));
+    memset(m_bits , 0, sizeof(m_bits));
+}
+
+CProTimerWheel::~CProTimerWheel()
+{
+    auto itr = m_id2Node.begin();
+    auto end = m_id2Node.end();
+
+    for (; itr != end; ++itr)
+    {
+        delete itr->second;
+    }
+
+    m_id2Node.clear();
+}
+
+void
+CProTimerWheel::Insert(const PRO_TIMER_NODE& node)
+{
+    assert(m_id2Node.find(node.timerId) == m_id2Node.end());
+
+    PRO_WHEEL_NODE* wnode = new PRO_WHEEL_NODE;
+    wnode->node = node;
+
+    Link(wnode);
+    m_id2Node[node.timerId] = wnode;
+}
+
+bool
+CProTimerWheel::Remove(uint64_t        timerId,
+                       PRO_TIMER_NODE& node)
+{
+    auto itr = m_id2Node.find(timerId);
+    if (itr == m_id2Node.end())
+    {
+        return false;
+    }
+
+    PRO_WHEEL_NODE* wnode = itr->second;
+    m_id2Node.erase(itr);
+
+    Unlink(wnode);
+    node = wnode->node;
+    delete wnode;
+
+    return true;
+}
+
+void
+CProTimerWheel::Expire(int64_t                        tick,
+                       CProStlVector<PRO_TIMER_NODE>& timers)
+{
+    if (m_id2Node.size() == 0)
+    {
+        if (tick >= m_tick)
+        {
+            m_tick = tick + 1;
+        }
+
+        return;
+    }
+
+    while (m_due != NULL)
+    {
+        PRO_WHEEL_NODE* wnode = m_due;
+
+        Unlink(wnode);
+        m_id2Node.erase(wnode->node.timerId);
+        timers.push_back(wnode->node);
+        delete wnode;
+    }
+
+    while (m_tick <= tick)
+    {
+        int slot = (int)(m_tick & (WHEEL_SLOTS - 1));
+        if (slot == 0)
+        {
+            Cascade(1);
+        }
+
+        PRO_WHEEL_NODE* wnode = m_slots[0][slot];
+        while (wnode != NULL)
+        {
+            PRO_WHEEL_NODE* next = wnode->next;
+
+            Unlink(wnode);
+            m_id2Node.erase(wnode->node.timerId);
+            timers.push_back(wnode->node);
+            delete wnode;
+
+            wnode = next;
+        }
+
+        ++m_tick;
+
+        /*
+         * skip the empty slots up to the next cascade
+         */
+        slot = (int)(m_tick & (WHEEL_SLOTS - 1));
+        if (slot != 0 && FindSlot_i(m_bits[0], slot) < 0)
+        {
+            int64_t edge = (m_tick | (WHEEL_SLOTS - 1)) + 1;
+            m_tick = edge < tick + 1 ? edge : tick + 1;
+        }
+    }
+}
+
+int64_t
+CProTimerWheel::GetNextTick() const
+{
+    if (m_id2Node.size() == 0)
+    {
+        return -1;
+    }
+
+    if (m_due != NULL)
+    {
+        return m_tick - 1;
+    }
+
+    int64_t next = -1;
+
+    for (int level = 0; level < WHEEL_LEVELS; ++level)
+    {
+        int shift = 8 * level;
+        int from  = (int)((m_tick >> shift) & (WHEEL_SLOTS - 1));
+        int slot  = FindSlot_i(m_bits[level], from);
+        if (slot < 0)
+        {
+            continue;
+        }
+
+        /*
+         * the tick when the slot expires or cascades
+         */
+        int64_t tick = (m_tick >> (shift + 8) << (shift + 8)) | ((int64_t)slot << shift);
+        if (tick < m_tick)
+        {
+            tick = m_tick;
+        }
+        if (next < 0 || tick < next)
+        {
+            next = tick;
+        }
+    }
+
+    return next;
+}
+
+void
+CProTimerWheel::GetAll(CProStlVector<PRO_TIMER_NODE>& timers) const
+{
+    auto itr = m_id2Node.begin();
+    auto end = m_id2Node.end();
+
+    for (; itr != end; ++itr)
+    {
+        timers.push_back(itr->second->node);
+    }
+}
+
+void
+CProTimerWheel::Link(PRO_WHEEL_NODE* wnode)
+{
+    int64_t expireTick = wnode->node.expireTick;
+    if (expireTick < m_tick)
+    {
+        wnode->level = -1;
+        wnode->slot  = 0;
+        wnode->prev  = NULL;
+        wnode->next  = m_due;
+        if (wnode->next != NULL)
+        {
+            wnode->next->prev = wnode;
+        }
+
+        m_due = wnode;
+
+        return;
+    }
+    if (expireTick - m_tick > WHEEL_MAX_DELAY)
+    {
+        expireTick = m_tick + WHEEL_MAX_DELAY; /* relinked when it comes down */
+    }
+
+    uint64_t diff  = (uint64_t)(expireTick ^ m_tick);
+    int      level = 0;
+
+    while (level < WHEEL_LEVELS - 1 && (diff >> (8 * (level + 1))) != 0)
+    {
+        ++level;
+    }
+
+    int slot = (int)((expireTick >> (8 * level)) & (WHEEL_SLOTS - 1));
+
+    wnode->level = level;
+    wnode->slot  = slot;
+    wnode->prev  = NULL;
+    wnode->next  = m_slots[level][slot];
+    if (wnode->next != NULL)
+    {
+        wnode->next->prev = wnode;
+    }
+
+    m_slots[level][slot] = wnode;
+    m_bits[level][slot >> 6] |= (uint64_t)1 << (slot & 63);
+}
+
+void
+CProTimerWheel::Unlink(PRO_WHEEL_NODE* wnode)
+{
+    int level = wnode->level;
+    int slot  = wnode->slot;
+
+    if (wnode->prev != NULL)
+    {
+        wnode->prev->next = wnode->next;
+    }
+    else if (level < 0)
+    {
+        m_due = wnode->next;
+    }
+    else
+    {
+        m_slots[level][slot] = wnode->next;
+    }
+    if (wnode->next != NULL)
+    {
+        wnode->next->prev = wnode->prev;
+    }
+
+    if (level >= 0 && m_slots[level][slot] == NULL)
+    {
+        m_bits[level][slot >> 6] &= ~((uint64_t)1 << (slot & 63));
+    }
+
+    wnode->prev = NULL;
+    wnode->next = NULL;
+}
+
+void
+CProTimerWheel::Cascade(int level)
+{
+    for (; level < WHEEL_LEVELS; ++level)
+    {
+        int slot = (int)((m_tick >> (8 * level)) & (WHEEL_SLOTS - 1));
+
+        PRO_WHEEL_NODE* wnode = m_slots[level][slot];
+        m_slots[level][slot] = NULL;
+        m_bits[level][slot >> 6] &= ~((uint64_t)1 << (slot & 63));
+
+        while (wnode != NULL)
+        {
+            PRO_WHEEL_NODE* next = wnode->next;
+            Link(wnode); /* into a lower level */
+            wnode = next;
+        }
+
+        if (slot != 0)
+        {
+            break;
+        }
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+////
+
+struct PRO_HTBT_NODE
+{
+    uint64_t       timerId;
+    IProOnTimer*   onTimer;
+    int64_t        userData;
+    unsigned int   slot;
+    PRO_HTBT_NODE* prev;
+    PRO_HTBT_NODE* next;
+
+    DECLARE_SGI_POOL(0)
+};
+
+CProHeartbeatSlots::CProHeartbeatSlots(unsigned int slotCount) /* = 1000 */
+{
+    assert(slotCount > 0);
+    if (slotCount == 0)
+    {
+        slotCount = 1;
+    }
+
+    m_heads.resize(slotCount, NULL);
+    m_counts.resize(slotCount, 0);
+    m_slotTimerIds.resize(slotCount, 0);
+    m_slotsInUse = 0;
+    m_nextSlot   = 0;
+}
+
+CProHeartbeatSlots::~CProHeartbeatSlots()
+{
+    auto itr = m_id2Node.begin();
+    auto end = m_id2Node.end();
+
+    for (; itr != end; ++itr)
+    {
+        delete itr->second;
+    }
+
+    m_id2Node.clear();
+}
+
+bool
+CProHeartbeatSlots::Add(uint64_t        timerId,
+                        IProOnTimer*    onTimer,
+                        int64_t         userData,
+                        int64_t         tick,
+                        int64_t         period,
+                        PRO_TIMER_NODE& slotNode)
+{
+    assert(timerId > 0);
+    assert(onTimer != NULL);
+    assert(period > 0);
+    if (timerId == 0 || onTimer == NULL || period <= 0)
+    {
+        return false;
+    }
+
+    unsigned int slot = m_nextSlot;
+    m_nextSlot = (m_nextSlot + 1) % (unsigned int)m_heads.size(); /* round-robin */
+
+    PRO_HTBT_NODE* hnode = new PRO_HTBT_NODE;
+    hnode->timerId  = timerId;
+    hnode->onTimer  = onTimer;
+    hnode->userData = userData;
+    hnode->slot     = slot;
+    hnode->prev     = NULL;
+    hnode->next     = m_heads[slot];
+    if (hnode->next != NULL)
+    {
+        hnode->next->prev = hnode;
+    }
+
+    m_heads[slot] = hnode;
+    ++m_counts[slot];
+    m_id2Node[timerId] = hnode;
+
+    slotNode = PRO_TIMER_NODE();
+    if (m_counts[slot] == 1)
+    {
+        m_slotTimerIds[slot] = ProMakeTimerId();
+        ++m_slotsInUse;
+
+        MakeSlotNode(slot, tick, period, slotNode);
+    }
+
+    return true;
+}
+
+bool
+CProHeartbeatSlots::Remove(uint64_t      timerId,
+                           IProOnTimer*& onTimer,
+                           uint64_t&     slotTimerId)
+{
+    onTimer     = NULL;
+    slotTimerId = 0;
+
+    auto itr = m_id2Node.find(timerId);
+    if (itr == m_id2Node.end())
+    {
+        return false;
+    }
+
+    PRO_HTBT_NODE* hnode = itr->second;
+    unsigned int   slot  = hnode->slot;
+    m_id2Node.erase(itr);
+
+    if (hnode->prev != NULL)
+    {
+        hnode->prev->next = hnode->next;
+    }
+    else
+    {
+        m_heads[slot] = hnode->next;
+    }
+    if (hnode->next != NULL)
+    {
+        hnode->next->prev = hnode->prev;
+    }
+
+    --m_counts[slot];
+    if (m_counts[slot] == 0)
+    {
+        slotTimerId          = m_slotTimerIds[slot];
+        m_slotTimerIds[slot] = 0;
+        --m_slotsInUse;
+    }
+
+    onTimer = hnode->onTimer;
+    delete hnode;
+
+    return true;
+}
+
+void
+CProHeartbeatSlots::RemoveAll(IProOnTimer*                   onTimer,
+                              CProStlVector<PRO_TIMER_NODE>& timers,
+                              CProStlVector<uint64_t>&       slotTimerIds)
+{
+    CProStlVector<PRO_TIMER_NODE> nodes;
+
+    {
+        auto itr = m_id2Node.begin();
+        auto end = m_id2Node.end();
+
+        for (; itr != end; ++itr)
+        {
+            const PRO_HTBT_NODE* hnode = itr->second;
+            if (hnode->onTimer != onTimer)
+            {
+                continue;
+            }
+
+            PRO_TIMER_NODE node;
+            node.timerId   = hnode->timerId;
+            node.onTimer   = hnode->onTimer;
+            node.heartbeat = true;
+            node.userData  = hnode->userData;
+            nodes.push_back(node);
+        }
+    }
+
+    for (int i = 0; i < (int)nodes.size(); ++i)
+    {
+        IProOnTimer* onTimer2    = NULL;
+        uint64_t     slotTimerId = 0;
+        Remove(nodes[i].timerId, onTimer2, slotTimerId);
+
+        timers.push_back(nodes[i]);
+        if (slotTimerId != 0)
+        {
+            slotTimerIds.push_back(slotTimerId);
+        }
+    }
+}
+
+void
+CProHeartbeatSlots::GetSlotNodes(int64_t                        tick,
+                                 int64_t                        period,
+                                 CProStlVector<PRO_TIMER_NODE>& slotNodes) const
+{
+    for (unsigned int i = 0; i < (unsigned int)m_slotTimerIds.size(); ++i)
+    {
+        if (m_slotTimerIds[i] != 0)
+        {
+            PRO_TIMER_NODE node;
+            MakeSlotNode(i, tick, period, node);
+            slotNodes.push_back(node);
+        }
+    }
+}
+
+void
+CProHeartbeatSlots::GetSubscribers(unsigned int                   slot,
+                                   CProStlVector<PRO_TIMER_NODE>& timers) const
+{
+    if (slot >= (unsigned int)m_heads.size())
+    {
+        return;
+    }
+
+    for (PRO_HTBT_NODE* hnode = m_heads[slot]; hnode != NULL; hnode = hnode->next)
+    {
+        PRO_TIMER_NODE node;
+        node.timerId       = hnode->timerId;
+        node.onTimer       = hnode->onTimer;
+        node.heartbeat     = true;
+        node.htbtSlotIndex = slot;
+        node.userData      = hnode->userData;
+
+        node.onTimer->AddRef();
+        timers.push_back(node);
+    }
+}
+
+void
+CProHeartbeatSlots::Clear(CProStlVector<IProOnTimer*>& onTimers)
+{
+    auto itr = m_id2Node.begin();
+    auto end = m_id2Node.end();
+
+    for (; itr != end; ++itr)
+    {
+        onTimers.push_back(itr->second->onTimer);
+        delete itr->second;
+    }
+
+    m_id2Node.clear();
+
+    for (unsigned int i = 0; i < (unsigned int)m_heads.size(); ++i)
+    {
+        m_heads[i]        = NULL;
+        m_counts[i]       = 0;
+        m_slotTimerIds[i] = 0;
+    }
+
+    m_slotsInUse = 0;
+}
+
+void
+CProHeartbeatSlots::MakeSlotNode(unsigned int    slot,
+                                 int64_t         tick,
+                                 int64_t         period,
+                                 PRO_TIMER_NODE& slotNode) const
+{
+    int64_t step = period / (int64_t)m_heads.size();
+
+    slotNode.expireTick    =  tick / period * period + step * slot;
+    if (slotNode.expireTick < tick)
+    {
+        slotNode.expireTick += period; /* within one period */
+    }
+    slotNode.timerId       =  m_slotTimerIds[slot];
+    slotNode.onTimer       =  NULL;
+    slotNode.period        =  period;
+    slotNode.heartbeat     =  true;
+    slotNode.htbtSlotIndex =  slot;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+////
+
 CProTimerFactory::CProTimerFactory()
 : m_cond(true) /* isSocketMode is true */
 {
@@ -52,7 +664,10 @@ CProTimerFactory::CProTimerFactory()
     m_mmResolution = 0;
     m_htbtPeriod   = DEFAULT_HEARTBEAT_INTERVAL * 1000;
 
-    m_htbtTimerCounts.resize(1000); /* 1000 slots */
+    m_timingWheel      = false;
+    m_wheel            = NULL;
+    m_loopStats        = false;
+    m_slowCallbackTime = 0;
 }
 
 CProTimerFactory::~CProTimerFactory()
@@ -61,7 +676,8 @@ CProTimerFactory::~CProTimerFactory()
 }
 
 bool
-CProTimerFactory::Start(bool mmTimer)
+CProTimerFactory::Start(bool mmTimer,
+                        int  cpu) /* = -1 */
 {{
     CProThreadMutexGuard mon(m_lockAtom);
 
@@ -97,12 +713,14 @@ CProTimerFactory::Start(bool mmTimer)
 
         m_mmTimer = mmTimer;
 
-        int i = 0;
-        int c = (int)m_htbtTimerCounts.size();
+        if (m_timingWheel)
+        {
+            m_wheel = new CProTimerWheel(ProGetTickCount64());
+        }
 
-        for (; i < c; ++i)
+        if (cpu >= 0)
         {
-            m_htbtTimerCounts[i] = 0; /* clean all slots */
+            m_task->PostCall(&ProBindThreadToCpu, (unsigned int)cpu);
         }
 
         m_task->PostCall(*this, &CProTimerFactory::WorkerRun);
@@ -116,7 +734,8 @@ CProTimerFactory::Stop()
 {{
     CProThreadMutexGuard mon(m_lockAtom);
 
-    CProStlSet<PRO_TIMER_NODE> timers;
+    CProStlVector<PRO_TIMER_NODE> timers;
+    CProStlVector<IProOnTimer*>   htbtTimers;
 
     {
         CProThreadMutexGuard mon(m_lock);
@@ -126,9 +745,20 @@ CProTimerFactory::Stop()
             return;
         }
 
-        m_timerId2ExpireTick.clear();
-        timers = m_timers;
-        m_timers.clear();
+        m_htbtSlots.Clear(htbtTimers);
+
+        if (m_wheel != NULL)
+        {
+            m_wheel->GetAll(timers);
+            delete m_wheel;
+            m_wheel = NULL;
+        }
+        else
+        {
+            timers.assign(m_timers.begin(), m_timers.end());
+            m_timerId2ExpireTick.clear();
+            m_timers.clear();
+        }
 
         m_wantExit = true;
         m_cond.Signal();
@@ -148,6 +778,11 @@ CProTimerFactory::Stop()
         }
     }
 
+    for (int i = 0; i < (int)htbtTimers.size(); ++i)
+    {
+        htbtTimers[i]->Release();
+    }
+
     {
         CProThreadMutexGuard mon(m_lock);
 
@@ -173,6 +808,16 @@ CProTimerFactory::SetupTimer(IProOnTimer* onTimer,
                              uint64_t     firstDelay, /* [0, 0xFFFFFFFFFFFF] */
                              uint64_t     period,     /* [0, 0xFFFFFFFFFFFF] */
                              int64_t      userData)   /* = 0 */
+{
+    return SetupCoarseTimer(onTimer, firstDelay, period, 0, userData);
+}
+
+uint64_t
+CProTimerFactory::SetupCoarseTimer(IProOnTimer* onTimer,
+                                   uint64_t     firstDelay, /* [0, 0xFFFFFFFFFFFF] */
+                                   uint64_t     period,     /* [0, 0xFFFFFFFFFFFF] */
+                                   uint64_t     slack,      /* [0, period] if period > 0 */
+                                   int64_t      userData)   /* = 0 */
 {
     if (firstDelay > 0xFFFFFFFFFFFFULL)
     {
@@ -183,16 +828,36 @@ CProTimerFactory::SetupTimer(IProOnTimer* onTimer,
         period     = 0xFFFFFFFFFFFFULL;
     }
 
+    if (period > 0 && slack > period)
+    {
+        slack      = period;
+    }
+
     assert(onTimer != NULL);
     if (onTimer == NULL)
     {
         return 0;
     }
 
+    /*
+     * the grid is the largest power of 2 within slack, so that the timers of
+     * different slacks still share the deadlines
+     */
+    int64_t grid = 0;
+    if (slack > 1)
+    {
+        grid = 1;
+        while ((uint64_t)grid * 2 <= slack)
+        {
+            grid *= 2;
+        }
+    }
+
     PRO_TIMER_NODE node;
 
     {
         CProThreadMutexGuard mon(m_lock);
+        CProSgiPoolTagScope  tagScope(TimerTag_i());
 
         if (m_task == NULL || m_wantExit)
         {
@@ -204,11 +869,11 @@ CProTimerFactory::SetupTimer(IProOnTimer* onTimer,
         node.onTimer    = onTimer;
         node.period     = period;
         node.userData   = userData;
+        node.slackGrid  = grid;
+        node.Align();
 
         node.onTimer->AddRef();
-        m_timers.insert(node);
-        m_timerId2ExpireTick[node.timerId] = node.expireTick;
-        assert(m_timers.size() == m_timerId2ExpireTick.size());
+        AddNode(node);
 
         m_cond.Signal();
     }
@@ -241,6 +906,7 @@ CProTimerFactory::SetupTimer(const IProOnTimer2& onTimer,
 
     {
         CProThreadMutexGuard mon(m_lock);
+        CProSgiPoolTagScope  tagScope(TimerTag_i());
 
         if (m_task == NULL || m_wantExit)
         {
@@ -253,9 +919,7 @@ CProTimerFactory::SetupTimer(const IProOnTimer2& onTimer,
         node.period     = period;
         node.userData   = userData;
 
-        m_timers.insert(node);
-        m_timerId2ExpireTick[node.timerId] = node.expireTick;
-        assert(m_timers.size() == m_timerId2ExpireTick.size());
+        AddNode(node);
 
         m_cond.Signal();
     }
@@ -273,10 +937,11 @@ CProTimerFactory::SetupHeartbeatTimer(IProOnTimer* onTimer,
         return 0;
     }
 
-    PRO_TIMER_NODE node;
+    uint64_t timerId = 0;
 
     {
         CProThreadMutexGuard mon(m_lock);
+        CProSgiPoolTagScope  tagScope(TimerTag_i());
 
         if (m_task == NULL || m_wantExit)
         {
@@ -289,48 +954,25 @@ CProTimerFactory::SetupHeartbeatTimer(IProOnTimer* onTimer,
             return 0;
         }
 
-        int    index = 0;
-        size_t count = m_htbtTimerCounts[0];
-
-        int i = 1;
-        int c = (int)m_htbtTimerCounts.size();
+        int64_t        tick = ProGetTickCount64();
+        PRO_TIMER_NODE slotNode;
 
-        for (; i < c; ++i)
+        timerId = ProMakeTimerId();
+        if (!m_htbtSlots.Add(timerId, onTimer, userData, tick, m_htbtPeriod, slotNode))
         {
-            if (m_htbtTimerCounts[i] < count)
-            {
-                index = i;
-                count = m_htbtTimerCounts[i];
-            }
+            return 0;
         }
 
-        /*
-         * put it into the step
-         */
-        ++m_htbtTimerCounts[index];
-
-        int64_t step = m_htbtPeriod / c;
-        int64_t tick = ProGetTickCount64();
-
-        node.expireTick    =  (tick + m_htbtPeriod - 1) / m_htbtPeriod * m_htbtPeriod;
-        node.expireTick    += step * index;
-        node.expireTick    += ProRand_0_32767() % step;
-        node.timerId       =  ProMakeTimerId();
-        node.onTimer       =  onTimer;
-        node.period        =  m_htbtPeriod;
-        node.heartbeat     =  true;
-        node.htbtSlotIndex =  index;
-        node.userData      =  userData;
-
-        node.onTimer->AddRef();
-        m_timers.insert(node);
-        m_timerId2ExpireTick[node.timerId] = node.expireTick;
-        assert(m_timers.size() == m_timerId2ExpireTick.size());
+        onTimer->AddRef();
+        if (slotNode.timerId != 0)
+        {
+            AddNode(slotNode);
+        }
 
         m_cond.Signal();
     }
 
-    return node.timerId;
+    return timerId;
 }
 
 void
@@ -351,30 +993,19 @@ CProTimerFactory::CancelTimer(uint64_t timerId)
             return;
         }
 
-        auto itr = m_timerId2ExpireTick.find(timerId);
-        if (itr == m_timerId2ExpireTick.end())
+        if (!RemoveNode(timerId, node))
         {
-            return;
-        }
-
-        node.expireTick = itr->second;
-        node.timerId    = timerId;
-
-        auto itr2 = m_timers.find(node);
-        if (itr2 == m_timers.end())
-        {
-            return;
-        }
-
-        node = *itr2;
-
-        m_timers.erase(itr2);
-        m_timerId2ExpireTick.erase(itr);
-        assert(m_timers.size() == m_timerId2ExpireTick.size());
+            uint64_t slotTimerId = 0;
+            if (!m_htbtSlots.Remove(timerId, node.onTimer, slotTimerId))
+            {
+                return;
+            }
 
-        if (node.heartbeat)
-        {
-            --m_htbtTimerCounts[node.htbtSlotIndex];
+            if (slotTimerId != 0)
+            {
+                PRO_TIMER_NODE slotNode;
+                RemoveNode(slotTimerId, slotNode);
+            }
         }
     }
 
@@ -392,7 +1023,7 @@ CProTimerFactory::GetTimerCount() const
     {
         CProThreadMutexGuard mon(m_lock);
 
-        count = m_timers.size();
+        count = GetNodeCount() - m_htbtSlots.GetSlotsInUse() + m_htbtSlots.GetCount();
     }
 
     return count;
@@ -411,6 +1042,7 @@ CProTimerFactory::UpdateHeartbeatTimers(unsigned int htbtIntervalInSeconds)
 
     {
         CProThreadMutexGuard mon(m_lock);
+        CProSgiPoolTagScope  tagScope(TimerTag_i());
 
         if (m_task == NULL || m_wantExit)
         {
@@ -428,58 +1060,19 @@ CProTimerFactory::UpdateHeartbeatTimers(unsigned int htbtIntervalInSeconds)
         m_htbtPeriod = period;
 
         /*
-         * todo...
+         * re-time the slots. The subscribers stay where they are
          */
-        CProStlVector<PRO_TIMER_NODE> timers;
-
-        auto itr = m_timers.begin();
-        auto end = m_timers.end();
-
-        while (itr != end)
-        {
-            const PRO_TIMER_NODE& node = *itr;
-            if (node.heartbeat)
-            {
-                timers.push_back(node);
-                m_timers.erase(itr++);
-            }
-            else
-            {
-                ++itr;
-            }
-        }
-
-        int     slots = (int)m_htbtTimerCounts.size();
-        int64_t step  = m_htbtPeriod / slots;
-        int64_t tick  = ProGetTickCount64();
+        CProStlVector<PRO_TIMER_NODE> slotNodes;
+        m_htbtSlots.GetSlotNodes(ProGetTickCount64(), m_htbtPeriod, slotNodes);
 
         int i = 0;
-        int c = (int)timers.size();
+        int c = (int)slotNodes.size();
 
         for (; i < c; ++i)
         {
-            /*
-             * put it into the slot
-             */
-            if (i < slots)
-            {
-                m_htbtTimerCounts[i] = 1;
-            }
-            else
-            {
-                ++m_htbtTimerCounts[i % slots];
-            }
-
-            PRO_TIMER_NODE& node = timers[i];
-            node.expireTick    =  (tick + m_htbtPeriod - 1) / m_htbtPeriod * m_htbtPeriod;
-            node.expireTick    += step * (i % slots);
-            node.expireTick    += ProRand_0_32767() % step;
-            node.period        =  m_htbtPeriod;
-            node.htbtSlotIndex =  i % slots;
-
-            m_timers.insert(node);
-            m_timerId2ExpireTick[node.timerId] = node.expireTick;
-            assert(m_timers.size() == m_timerId2ExpireTick.size());
+            PRO_TIMER_NODE node;
+            RemoveNode(slotNodes[i].timerId, node);
+            AddNode(slotNodes[i]);
         }
 
         m_cond.Signal();
@@ -502,6 +1095,96 @@ CProTimerFactory::GetHeartbeatInterval() const
     return (unsigned int)(period / 1000);
 }
 
+void
+CProTimerFactory::SetLoopStats(bool         loopStats,
+                               unsigned int slowCallbackTime)
+{
+    CProThreadMutexGuard mon(m_lock);
+
+    assert(m_task == NULL);
+    if (m_task != NULL)
+    {
+        return;
+    }
+
+    m_loopStats        = loopStats || slowCallbackTime > 0;
+    m_slowCallbackTime = slowCallbackTime;
+}
+
+void
+CProTimerFactory::SetTimingWheel(bool timingWheel)
+{
+    CProThreadMutexGuard mon(m_lock);
+
+    assert(m_task == NULL);
+    if (m_task != NULL)
+    {
+        return;
+    }
+
+    m_timingWheel = timingWheel;
+}
+
+void
+CProTimerFactory::AddNode(const PRO_TIMER_NODE& node)
+{
+    if (m_wheel != NULL)
+    {
+        m_wheel->Insert(node);
+
+        return;
+    }
+
+    m_timers.insert(node);
+    m_timerId2ExpireTick[node.timerId] = node.expireTick;
+    assert(m_timers.size() == m_timerId2ExpireTick.size());
+}
+
+bool
+CProTimerFactory::RemoveNode(uint64_t        timerId,
+                             PRO_TIMER_NODE& node)
+{
+    if (m_wheel != NULL)
+    {
+        return m_wheel->Remove(timerId, node);
+    }
+
+    auto itr = m_timerId2ExpireTick.find(timerId);
+    if (itr == m_timerId2ExpireTick.end())
+    {
+        return false;
+    }
+
+    PRO_TIMER_NODE key;
+    key.expireTick = itr->second;
+    key.timerId    = timerId;
+
+    auto itr2 = m_timers.find(key);
+    if (itr2 == m_timers.end())
+    {
+        return false;
+    }
+
+    node = *itr2;
+
+    m_timers.erase(itr2);
+    m_timerId2ExpireTick.erase(itr);
+    assert(m_timers.size() == m_timerId2ExpireTick.size());
+
+    return true;
+}
+
+size_t
+CProTimerFactory::GetNodeCount() const
+{
+    if (m_wheel != NULL)
+    {
+        return m_wheel->GetCount();
+    }
+
+    return m_timers.size();
+}
+
 void
 CProTimerFactory::WorkerRun()
 {
@@ -518,10 +1201,11 @@ CProTimerFactory::Process()
 
     {
         CProThreadMutexGuard mon(m_lock);
+        CProSgiPoolTagScope  tagScope(TimerTag_i());
 
         while (1)
         {
-            if (m_wantExit || m_timers.size() > 0)
+            if (m_wantExit || GetNodeCount() > 0)
             {
                 break;
             }
@@ -538,25 +1222,44 @@ CProTimerFactory::Process()
 
         unsigned int timeout = 0xFFFFFFFF;
 
-        auto itr = m_timers.begin();
-        auto end = m_timers.end();
-
-        for (; itr != end; ++itr)
+        if (m_wheel != NULL)
         {
-            const PRO_TIMER_NODE& node = *itr;
-            if (node.expireTick > tick)
+            m_wheel->Expire(tick, timers); /* removed from the wheel */
+
+            int64_t nextTick = m_wheel->GetNextTick();
+            if (nextTick >= 0)
             {
-                uint64_t delta = node.expireTick - tick;
+                uint64_t delta = nextTick > tick ? nextTick - tick : 0;
                 if (delta > 0xFFFFFFFF)
                 {
                     delta = 0xFFFFFFFF;
                 }
 
                 timeout = (unsigned int)delta;
-                break;
             }
+        }
+        else
+        {
+            auto itr = m_timers.begin();
+            auto end = m_timers.end();
+
+            for (; itr != end; ++itr)
+            {
+                const PRO_TIMER_NODE& node = *itr;
+                if (node.expireTick > tick)
+                {
+                    uint64_t delta = node.expireTick - tick;
+                    if (delta > 0xFFFFFFFF)
+                    {
+                        delta = 0xFFFFFFFF;
+                    }
+
+                    timeout = (unsigned int)delta;
+                    break;
+                }
 
-            timers.push_back(node);
+                timers.push_back(node);
+            }
         }
 
         int i = 0;
@@ -565,42 +1268,56 @@ CProTimerFactory::Process()
         for (; i < c; ++i)
         {
             PRO_TIMER_NODE& node = timers[i];
-            if (node.period > 0)
+
+            if (m_loopStats)
             {
-                m_timers.erase(node);
+                m_lagHisto.PushData(tick - node.expireTick);
+            }
 
-                if (node.heartbeat)
-                {
-                    int64_t offset = node.expireTick % node.period;
-                    node.expireTick =
-                        (tick + node.period - 1) / node.period * node.period + offset;
-                    if (node.expireTick == tick)
-                    {
-                        node.expireTick += node.period; /* !!! */
-                    }
-                }
-                else
+            if (node.period > 0)
+            {
+                if (m_wheel == NULL)
                 {
-                    node.expireTick = tick + node.period;
+                    m_timers.erase(node);
                 }
 
+                node.Rearm(tick);
+
                 if (node.onTimer != NULL)
                 {
                     node.onTimer->AddRef(); /* !!! */
                 }
 
-                m_timers.insert(node);
-                m_timerId2ExpireTick[node.timerId] = node.expireTick;
+                if (m_wheel != NULL)
+                {
+                    m_wheel->Insert(node);
+                }
+                else
+                {
+                    m_timers.insert(node);
+                    m_timerId2ExpireTick[node.timerId] = node.expireTick;
+                }
             }
-            else
+            else if (m_wheel == NULL)
             {
                 m_timers.erase(node);
                 m_timerId2ExpireTick.erase(node.timerId);
             }
 
-            assert(m_timers.size() == m_timerId2ExpireTick.size());
+            assert(m_wheel != NULL || m_timers.size() == m_timerId2ExpireTick.size());
         } /* end of for () */
 
+        /*
+         * the subscribers of the slots due, appended as one-shot nodes
+         */
+        for (i = 0; i < c; ++i)
+        {
+            if (timers[i].IsHeartbeatSlot())
+            {
+                m_htbtSlots.GetSubscribers(timers[i].htbtSlotIndex, timers);
+            }
+        }
+
         if (c == 0)
         {
             m_cond.Wait(&m_lock, timeout);
@@ -614,6 +1331,13 @@ CProTimerFactory::Process()
     for (; i < c; ++i)
     {
         const PRO_TIMER_NODE& node = timers[i];
+        if (node.IsHeartbeatSlot())
+        {
+            continue;
+        }
+
+        int64_t start = m_loopStats ? GetTickUs_i() : 0;
+
         if (node.onTimer != NULL)
         {
             node.onTimer->OnTimer(this, node.timerId, tick, node.userData);
@@ -624,6 +1348,18 @@ CProTimerFactory::Process()
             node.onTimer2(this, node.timerId, tick, node.userData);
         }
 
+        if (m_loopStats)
+        {
+            uint64_t time = GetTickUs_i() - start;
+            m_callHisto.PushData(time);
+
+            if (m_slowCallbackTime > 0 && time >= m_slowCallbackTime)
+            {
+                m_slowCalls.PushCall((int64_t)node.timerId,
+                    node.heartbeat ? "heartbeat" : "timer", "OnTimer", time);
+            }
+        }
+
         ++j;
         if (j == PRO_TIMER_UPCALL_COUNT)
         {
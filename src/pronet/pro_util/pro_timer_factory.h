@@ -21,6 +21,8 @@
 
 #include "pro_a.h"
 #include "pro_memory_pool.h"
+#include "pro_slab_pool.h"
+#include "pro_stat.h"
 #include "pro_stl.h"
 #include "pro_thread_mutex.h"
 #include "pro_z.h"
@@ -49,6 +51,8 @@ struct PRO_TIMER_NODE
         heartbeat     = false;
         htbtSlotIndex = 0;
         userData      = 0;
+        slackGrid     = 0;
+        dueTick       = 0;
     }
 
     bool operator<(const PRO_TIMER_NODE& other) const
@@ -65,6 +69,59 @@ struct PRO_TIMER_NODE
         return timerId < other.timerId;
     }
 
+    /*
+     * The node of a heartbeat slot, standing for its subscribers, see
+     * CProHeartbeatSlots
+     */
+    bool IsHeartbeatSlot() const
+    {
+        return heartbeat && onTimer == NULL;
+    }
+
+    /*
+     * Moves a periodic timer fired at tick to its next expiry. A heartbeat
+     * timer keeps its offset in the period
+     */
+    void Rearm(int64_t tick)
+    {
+        if (heartbeat)
+        {
+            int64_t offset = expireTick % period;
+            expireTick = (tick + period - 1) / period * period + offset;
+            if (expireTick == tick)
+            {
+                expireTick += period; /* !!! */
+            }
+        }
+        else if (slackGrid > 0)
+        {
+            expireTick = dueTick + period; /* no drift from the rounding */
+            if (expireTick <= tick)
+            {
+                expireTick = tick + period;
+            }
+
+            Align();
+        }
+        else
+        {
+            expireTick = tick + period;
+        }
+    }
+
+    /*
+     * Rounds expireTick up to the slack grid, so that the coarse timers due
+     * around the same time share one deadline and fire in one batch
+     */
+    void Align()
+    {
+        if (slackGrid > 0)
+        {
+            dueTick    = expireTick;
+            expireTick = (expireTick + slackGrid - 1) / slackGrid * slackGrid;
+        }
+    }
+
     int64_t      expireTick;
     uint64_t     timerId;
 
@@ -74,6 +131,186 @@ struct PRO_TIMER_NODE
     bool         heartbeat;
     unsigned int htbtSlotIndex;
     int64_t      userData;
+    int64_t      slackGrid;     /* ms, a power of 2. 0 for an exact timer */
+    int64_t      dueTick;       /* expireTick before Align() */
+
+    /*
+     * The pool of the tree nodes holding PRO_TIMER_NODE, see CProTimerNodeSet
+     */
+    static CProSlabPool& GetSlabPool();
+
+    DECLARE_SGI_POOL(0)
+};
+
+using CProTimerNodeSet = std::set<
+    PRO_TIMER_NODE,
+    std::less<PRO_TIMER_NODE>,
+    std::pro_slab_allocator<PRO_TIMER_NODE, &PRO_TIMER_NODE::GetSlabPool>
+    >;
+
+/////////////////////////////////////////////////////////////////////////////
+////
+
+struct PRO_WHEEL_NODE;
+
+/*
+ * A hierarchical timing wheel of 1ms ticks, 6 levels of 256 slots each.
+ * A timer sits in the level of the highest byte where its expireTick differs
+ * from the wheel's tick, and falls down when that byte comes round.
+ * Insert, Remove and the expiry of a timer are O(1)
+ */
+class CProTimerWheel
+{
+public:
+
+    CProTimerWheel(int64_t tick);
+
+    ~CProTimerWheel();
+
+    void Insert(const PRO_TIMER_NODE& node);
+
+    bool Remove(
+        uint64_t        timerId,
+        PRO_TIMER_NODE& node
+        );
+
+    void Expire( /* removes and appends the timers expired at or before tick */
+        int64_t                        tick,
+        CProStlVector<PRO_TIMER_NODE>& timers
+        );
+
+    int64_t GetNextTick() const; /* -1 if empty */
+
+    size_t GetCount() const
+    {
+        return m_id2Node.size();
+    }
+
+    void GetAll(CProStlVector<PRO_TIMER_NODE>& timers) const;
+
+private:
+
+    void Link(PRO_WHEEL_NODE* wnode);
+
+    void Unlink(PRO_WHEEL_NODE* wnode);
+
+    void Cascade(int level);
+
+private:
+
+    int64_t                                   m_tick; /* the next tick to expire */
+    PRO_WHEEL_NODE*                           m_due;  /* expired before m_tick */
+    PRO_WHEEL_NODE*                           m_slots[6][256];
+    uint64_t                                  m_bits[6][4];
+    CProStlHashMap<uint64_t, PRO_WHEEL_NODE*> m_id2Node;
+
+    DECLARE_SGI_POOL(0)
+};
+
+/////////////////////////////////////////////////////////////////////////////
+////
+
+struct PRO_HTBT_NODE;
+
+/*
+ * The heartbeat timers, spread over the slots of the period. A slot keeps
+ * an intrusive list of its subscribers and is one periodic timer node of
+ * the owner, fired for all of them in one batch. Changing the period
+ * re-times the slot nodes only
+ */
+class CProHeartbeatSlots
+{
+public:
+
+    CProHeartbeatSlots(unsigned int slotCount = 1000);
+
+    ~CProHeartbeatSlots();
+
+    /*
+     * Puts the subscriber into the next slot in turn. If the slot was
+     * empty, slotNode is set to its node, for the owner to set up
+     */
+    bool Add(
+        uint64_t        timerId,
+        IProOnTimer*    onTimer,
+        int64_t         userData,
+        int64_t         tick,
+        int64_t         period,
+        PRO_TIMER_NODE& slotNode
+        );
+
+    /*
+     * If the slot becomes empty, slotTimerId is set to its node, for the
+     * owner to cancel
+     */
+    bool Remove(
+        uint64_t      timerId,
+        IProOnTimer*& onTimer,
+        uint64_t&     slotTimerId
+        );
+
+    /*
+     * Removes the subscribers of onTimer and appends them as nodes, with
+     * their references. The slots that become empty are appended to
+     * slotTimerIds, for the owner to cancel
+     */
+    void RemoveAll(
+        IProOnTimer*                   onTimer,
+        CProStlVector<PRO_TIMER_NODE>& timers,
+        CProStlVector<uint64_t>&       slotTimerIds
+        );
+
+    /*
+     * The nodes of the slots in use, timed for the new period
+     */
+    void GetSlotNodes(
+        int64_t                        tick,
+        int64_t                        period,
+        CProStlVector<PRO_TIMER_NODE>& slotNodes
+        ) const;
+
+    /*
+     * Appends the subscribers of the slot as nodes, with their onTimer
+     * objects AddRef()'d
+     */
+    void GetSubscribers(
+        unsigned int                   slot,
+        CProStlVector<PRO_TIMER_NODE>& timers
+        ) const;
+
+    /*
+     * Removes all the subscribers. Their onTimer objects are to be
+     * Release()'d by the caller
+     */
+    void Clear(CProStlVector<IProOnTimer*>& onTimers);
+
+    size_t GetCount() const
+    {
+        return m_id2Node.size();
+    }
+
+    size_t GetSlotsInUse() const
+    {
+        return m_slotsInUse;
+    }
+
+private:
+
+    void MakeSlotNode(
+        unsigned int    slot,
+        int64_t         tick,
+        int64_t         period,
+        PRO_TIMER_NODE& slotNode
+        ) const;
+
+private:
+
+    CProStlVector<PRO_HTBT_NODE*>            m_heads;
+    CProStlVector<size_t>                    m_counts;
+    CProStlVector<uint64_t>                  m_slotTimerIds; /* 0 if not in use */
+    size_t                                   m_slotsInUse;
+    unsigned int                             m_nextSlot;
+    CProStlHashMap<uint64_t, PRO_HTBT_NODE*> m_id2Node;
 
     DECLARE_SGI_POOL(0)
 };
@@ -116,7 +353,10 @@ public:
 
     ~CProTimerFactory();
 
-    bool Start(bool mmTimer);
+    bool Start(
+        bool mmTimer,
+        int  cpu = -1 /* pins the worker thread if >= 0 */
+        );
 
     void Stop();
 
@@ -134,6 +374,18 @@ public:
         int64_t             userData = 0
         );
 
+    /*
+     * A timer that may fire up to slack late. The coarse timers are aligned
+     * to shared deadlines and fired in batches
+     */
+    uint64_t SetupCoarseTimer(
+        IProOnTimer* onTimer,
+        uint64_t     firstDelay, /* [0, 0xFFFFFFFFFFFF] */
+        uint64_t     period,     /* [0, 0xFFFFFFFFFFFF] */
+        uint64_t     slack,      /* [0, period] if period > 0 */
+        int64_t      userData = 0
+        );
+
     uint64_t SetupHeartbeatTimer(
         IProOnTimer* onTimer,
         int64_t      userData = 0
@@ -147,8 +399,39 @@ public:
 
     unsigned int GetHeartbeatInterval() const;
 
+    void SetLoopStats( /* before Start() */
+        bool         loopStats,
+        unsigned int slowCallbackTime /* us. 0 means no watchdog */
+        );
+
+    const CProStatHistogram& GetCallHistogram() const /* us per callback */
+    {
+        return m_callHisto;
+    }
+
+    const CProStatHistogram& GetLagHistogram() const  /* ms past the expiry */
+    {
+        return m_lagHisto;
+    }
+
+    const CProStatSlowCalls& GetSlowCalls() const
+    {
+        return m_slowCalls;
+    }
+
+    void SetTimingWheel(bool timingWheel); /* before Start() */
+
 private:
 
+    void AddNode(const PRO_TIMER_NODE& node);
+
+    bool RemoveNode(
+        uint64_t        timerId,
+        PRO_TIMER_NODE& node
+        );
+
+    size_t GetNodeCount() const;
+
     void WorkerRun();
 
     bool Process();
@@ -159,10 +442,17 @@ private:
     bool                          m_wantExit;
     bool                          m_mmTimer;
     unsigned int                  m_mmResolution;
-    CProStlSet<PRO_TIMER_NODE>    m_timers;
+    CProTimerNodeSet              m_timers;
     CProStlMap<uint64_t, int64_t> m_timerId2ExpireTick;
+    bool                          m_timingWheel;
+    CProTimerWheel*               m_wheel;            /* replaces m_timers if used */
     int64_t                       m_htbtPeriod;
-    CProStlVector<size_t>         m_htbtTimerCounts;
+    CProHeartbeatSlots            m_htbtSlots;
+    bool                          m_loopStats;
+    unsigned int                  m_slowCallbackTime; /* us */
+    CProStatHistogram             m_callHisto;
+    CProStatHistogram             m_lagHisto;
+    CProStatSlowCalls             m_slowCalls;
     CProThreadMutexCondition      m_cond;
     mutable CProThreadMutex       m_lock;
     CProThreadMutex               m_lockAtom;
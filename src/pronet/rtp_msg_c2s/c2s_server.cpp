@@ -33,6 +33,11 @@
 /////////////////////////////////////////////////////////////////////////////
 ////
 
+#define PROFILE_DUMP_BYTES (1024 * 64)
+
+/////////////////////////////////////////////////////////////////////////////
+////
+
 CC2sServer*
 CC2sServer::CreateInstance(CProLogFile& logFile)
 {
@@ -47,6 +52,7 @@ CC2sServer::CC2sServer(CProLogFile& logFile)
     m_localSslConfig  = NULL;
     m_msgC2s          = NULL;
     m_onOkTick        = 0;
+    m_profileTimerId  = 0;
 }
 
 CC2sServer::~CC2sServer()
@@ -262,6 +268,14 @@ CC2sServer::Init(IProReactor*                  reactor,
                 &m_configInfo.c2ss_uplink_password[0], m_configInfo.c2ss_uplink_password.length());
             m_configInfo.c2ss_uplink_password = "";
         }
+
+        if (configInfo.c2ss_profile_interval > 0)
+        {
+            ProEnableSgiPoolProfile(true);
+
+            m_profileTimerId = reactor->SetupTimer(this,
+                configInfo.c2ss_profile_interval * 1000, configInfo.c2ss_profile_interval * 1000);
+        }
     }
 
     return true;
@@ -290,6 +304,9 @@ CC2sServer::Fini()
             return;
         }
 
+        m_reactor->CancelTimer(m_profileTimerId);
+        m_profileTimerId = 0;
+
         msgC2s = m_msgC2s;
         m_msgC2s = NULL;
         localSslConfig = m_localSslConfig;
@@ -579,3 +596,41 @@ CC2sServer::OnCloseUser(IRtpMsgC2s*         msgC2s,
         m_logFile.Log(traceInfo, PRO_LL_INFO, true);
     }}}
 }
+
+void
+CC2sServer::OnTimer(void*    factory,
+                    uint64_t timerId,
+                    int64_t  tick,
+                    int64_t  userData)
+{
+    assert(factory != NULL);
+    assert(timerId > 0);
+    if (factory == NULL || timerId == 0)
+    {
+        return;
+    }
+
+    {
+        CProThreadMutexGuard mon(m_lock);
+
+        if (m_reactor == NULL || m_msgC2s == NULL)
+        {
+            return;
+        }
+
+        if (timerId != m_profileTimerId)
+        {
+            return;
+        }
+    }
+
+    {{{
+        char* traceInfo = (char*)ProMalloc(PROFILE_DUMP_BYTES);
+        if (traceInfo != NULL)
+        {
+            ProDumpSgiPoolProfile(traceInfo, PROFILE_DUMP_BYTES);
+            m_logFile.Log(traceInfo, PRO_LL_INFO, true);
+            ProFree(traceInfo);
+        }
+    }}}
+}
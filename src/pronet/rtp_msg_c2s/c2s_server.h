@@ -60,6 +60,9 @@ struct C2S_SERVER_CONFIG_INFO
 
         c2ss_log_loop_bytes             = 50 * 1000 * 1000;
         c2ss_log_level_green            = 0;
+        c2ss_profile_interval           = 0;
+        c2ss_pool_trim_interval         = 0;
+        c2ss_pool_huge_page             = false;
 
         RtpMsgString2User("255-0-0", &c2ss_uplink_id);
 
@@ -92,6 +95,9 @@ struct C2S_SERVER_CONFIG_INFO
         CProConfigStream configStream;
 
         configStream.AddUint("c2ss_thread_count"              , c2ss_thread_count);
+        configStream.Add    ("c2ss_io_cpus"                   , c2ss_io_cpus);
+        configStream.Add    ("c2ss_accept_cpus"               , c2ss_accept_cpus);
+        configStream.Add    ("c2ss_timer_cpus"                , c2ss_timer_cpus);
         configStream.AddUint("c2ss_mm_type"                   , c2ss_mm_type);
         configStream.Add    ("c2ss_uplink_ip"                 , c2ss_uplink_ip);
         configStream.AddUint("c2ss_uplink_port"               , c2ss_uplink_port);
@@ -120,11 +126,17 @@ struct C2S_SERVER_CONFIG_INFO
 
         configStream.AddUint("c2ss_log_loop_bytes"            , c2ss_log_loop_bytes);
         configStream.AddInt ("c2ss_log_level_green"           , c2ss_log_level_green);
+        configStream.AddUint("c2ss_profile_interval"          , c2ss_profile_interval);
+        configStream.AddUint("c2ss_pool_trim_interval"        , c2ss_pool_trim_interval);
+        configStream.AddInt ("c2ss_pool_huge_page"            , c2ss_pool_huge_page);
 
         configStream.Get(configs);
     }
 
     unsigned int                 c2ss_thread_count; /* 1 ~ 100 */
+    CProStlString                c2ss_io_cpus;      /* "0-7,16" */
+    CProStlString                c2ss_accept_cpus;
+    CProStlString                c2ss_timer_cpus;
     RTP_MM_TYPE                  c2ss_mm_type;      /* RTP_MMT_MSG_MIN ~ RTP_MMT_MSG_MAX */
     CProStlString                c2ss_uplink_ip;
     unsigned short               c2ss_uplink_port;
@@ -153,6 +165,9 @@ struct C2S_SERVER_CONFIG_INFO
 
     unsigned int                 c2ss_log_loop_bytes;
     int                          c2ss_log_level_green;
+    unsigned int                 c2ss_profile_interval; /* SGI pool profile dump (s). 0: off */
+    unsigned int                 c2ss_pool_trim_interval; /* SGI pool trimming (s). 0: off */
+    bool                         c2ss_pool_huge_page;
 
     DECLARE_SGI_POOL(0)
 };
@@ -160,7 +175,7 @@ struct C2S_SERVER_CONFIG_INFO
 /////////////////////////////////////////////////////////////////////////////
 ////
 
-class CC2sServer : public IRtpMsgC2sObserver, public CProRefCount
+class CC2sServer : public IRtpMsgC2sObserver, public IProOnTimer, public CProRefCount
 {
 public:
 
@@ -226,6 +241,13 @@ private:
     {
     }
 
+    virtual void OnTimer(
+        void*    factory,
+        uint64_t timerId,
+        int64_t  tick,
+        int64_t  userData
+        );
+
 private:
 
     CProLogFile&           m_logFile;
@@ -235,6 +257,7 @@ private:
     PRO_SSL_SERVER_CONFIG* m_localSslConfig;
     IRtpMsgC2s*            m_msgC2s;
     int64_t                m_onOkTick;
+    uint64_t               m_profileTimerId;
     CProThreadMutex        m_lock;
 
     DECLARE_SGI_POOL(0)
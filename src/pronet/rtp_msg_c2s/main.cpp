@@ -22,6 +22,7 @@
 #include "../pro_rtp/rtp_msg.h"
 #include "../pro_util/pro_config_file.h"
 #include "../pro_util/pro_log_file.h"
+#include "../pro_util/pro_memory_pool.h"
 #include "../pro_util/pro_ssl_util.h"
 #include "../pro_util/pro_stl.h"
 #include "../pro_util/pro_time_util.h"
@@ -68,6 +69,18 @@ ReadConfig_i(const CProStlString&            exeRoot,
                 configInfo.c2ss_thread_count = value;
             }
         }
+        else if (stricmp_pro(configName.c_str(), "c2ss_io_cpus") == 0)
+        {
+            configInfo.c2ss_io_cpus = configValue;
+        }
+        else if (stricmp_pro(configName.c_str(), "c2ss_accept_cpus") == 0)
+        {
+            configInfo.c2ss_accept_cpus = configValue;
+        }
+        else if (stricmp_pro(configName.c_str(), "c2ss_timer_cpus") == 0)
+        {
+            configInfo.c2ss_timer_cpus = configValue;
+        }
         else if (stricmp_pro(configName.c_str(), "c2ss_mm_type") == 0)
         {
             int value = atoi(configValue.c_str());
@@ -306,6 +319,26 @@ ReadConfig_i(const CProStlString&            exeRoot,
         {
             configInfo.c2ss_log_level_green    = atoi(configValue.c_str());
         }
+        else if (stricmp_pro(configName.c_str(), "c2ss_profile_interval") == 0)
+        {
+            int value = atoi(configValue.c_str());
+            if (value >= 0)
+            {
+                configInfo.c2ss_profile_interval = value;
+            }
+        }
+        else if (stricmp_pro(configName.c_str(), "c2ss_pool_trim_interval") == 0)
+        {
+            int value = atoi(configValue.c_str());
+            if (value >= 0)
+            {
+                configInfo.c2ss_pool_trim_interval = value;
+            }
+        }
+        else if (stricmp_pro(configName.c_str(), "c2ss_pool_huge_page") == 0)
+        {
+            configInfo.c2ss_pool_huge_page = atoi(configValue.c_str()) != 0;
+        }
         else
         {
         }
@@ -378,7 +411,24 @@ int main(int argc, char* argv[])
     logFile->SetMaxSize(configInfo.c2ss_log_loop_bytes);
     logFile->SetGreenLevel(configInfo.c2ss_log_level_green);
 
-    reactor = ProCreateReactor(configInfo.c2ss_thread_count);
+    if (configInfo.c2ss_pool_huge_page)
+    {
+        for (int i = 0; i < 4; ++i)
+        {
+            ProSetSgiPoolHugePage(true, i);
+        }
+    }
+
+    {
+        PRO_REACTOR_CONFIG reactorConfig;
+        reactorConfig.ioThreadCount    = configInfo.c2ss_thread_count;
+        reactorConfig.ioThreadCpus     = configInfo.c2ss_io_cpus.c_str();
+        reactorConfig.acceptThreadCpus = configInfo.c2ss_accept_cpus.c_str();
+        reactorConfig.timerThreadCpus  = configInfo.c2ss_timer_cpus.c_str();
+        reactorConfig.poolTrimInterval = configInfo.c2ss_pool_trim_interval;
+
+        reactor = ProCreateReactorEx(reactorConfig);
+    }
     if (reactor == NULL)
     {
         sprintf(
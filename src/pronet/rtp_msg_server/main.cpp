@@ -24,6 +24,7 @@
 #include "../pro_rtp/rtp_msg.h"
 #include "../pro_util/pro_config_file.h"
 #include "../pro_util/pro_log_file.h"
+#include "../pro_util/pro_memory_pool.h"
 #include "../pro_util/pro_stl.h"
 #include "../pro_util/pro_time_util.h"
 #include "../pro_util/pro_version.h"
@@ -66,6 +67,18 @@ ReadConfig_i(const CProStlString&            exeRoot,
                 configInfo.msgs_thread_count = value;
             }
         }
+        else if (stricmp_pro(configName.c_str(), "msgs_io_cpus") == 0)
+        {
+            configInfo.msgs_io_cpus = configValue;
+        }
+        else if (stricmp_pro(configName.c_str(), "msgs_accept_cpus") == 0)
+        {
+            configInfo.msgs_accept_cpus = configValue;
+        }
+        else if (stricmp_pro(configName.c_str(), "msgs_timer_cpus") == 0)
+        {
+            configInfo.msgs_timer_cpus = configValue;
+        }
         else if (stricmp_pro(configName.c_str(), "msgs_mm_type") == 0)
         {
             int value = atoi(configValue.c_str());
@@ -203,6 +216,26 @@ ReadConfig_i(const CProStlString&            exeRoot,
         {
             configInfo.msgs_log_level_green    = atoi(configValue.c_str());
         }
+        else if (stricmp_pro(configName.c_str(), "msgs_profile_interval") == 0)
+        {
+            int value = atoi(configValue.c_str());
+            if (value >= 0)
+            {
+                configInfo.msgs_profile_interval = value;
+            }
+        }
+        else if (stricmp_pro(configName.c_str(), "msgs_pool_trim_interval") == 0)
+        {
+            int value = atoi(configValue.c_str());
+            if (value >= 0)
+            {
+                configInfo.msgs_pool_trim_interval = value;
+            }
+        }
+        else if (stricmp_pro(configName.c_str(), "msgs_pool_huge_page") == 0)
+        {
+            configInfo.msgs_pool_huge_page = atoi(configValue.c_str()) != 0;
+        }
         else
         {
         }
@@ -300,7 +333,24 @@ int main(int argc, char* argv[])
         CleanMsgOnlineRows(*db);
     }
 
-    reactor = ProCreateReactor(configInfo.msgs_thread_count);
+    if (configInfo.msgs_pool_huge_page)
+    {
+        for (int i = 0; i < 4; ++i)
+        {
+            ProSetSgiPoolHugePage(true, i);
+        }
+    }
+
+    {
+        PRO_REACTOR_CONFIG reactorConfig;
+        reactorConfig.ioThreadCount    = configInfo.msgs_thread_count;
+        reactorConfig.ioThreadCpus     = configInfo.msgs_io_cpus.c_str();
+        reactorConfig.acceptThreadCpus = configInfo.msgs_accept_cpus.c_str();
+        reactorConfig.timerThreadCpus  = configInfo.msgs_timer_cpus.c_str();
+        reactorConfig.poolTrimInterval = configInfo.msgs_pool_trim_interval;
+
+        reactor = ProCreateReactorEx(reactorConfig);
+    }
     if (reactor == NULL)
     {
         sprintf(
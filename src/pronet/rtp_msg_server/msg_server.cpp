@@ -34,6 +34,8 @@
 /////////////////////////////////////////////////////////////////////////////
 ////
 
+#define PROFILE_DUMP_BYTES (1024 * 64)
+
 static const unsigned char SERVER_CID = 1;
 
 /////////////////////////////////////////////////////////////////////////////
@@ -52,9 +54,10 @@ CMsgServer::CMsgServer(CProLogFile&   logFile,
 m_logFile(logFile),
 m_db(db)
 {
-    m_reactor   = NULL;
-    m_sslConfig = NULL;
-    m_msgServer = NULL;
+    m_reactor        = NULL;
+    m_sslConfig      = NULL;
+    m_msgServer      = NULL;
+    m_profileTimerId = 0;
 }
 
 CMsgServer::~CMsgServer()
@@ -180,6 +183,14 @@ CMsgServer::Init(IProReactor*                  reactor,
         m_configInfo = configInfo;
         m_sslConfig  = sslConfig;
         m_msgServer  = msgServer;
+
+        if (configInfo.msgs_profile_interval > 0)
+        {
+            ProEnableSgiPoolProfile(true);
+
+            m_profileTimerId = reactor->SetupTimer(this,
+                configInfo.msgs_profile_interval * 1000, configInfo.msgs_profile_interval * 1000);
+        }
     }
 
     return true;
@@ -206,6 +217,9 @@ CMsgServer::Fini()
             return;
         }
 
+        m_reactor->CancelTimer(m_profileTimerId);
+        m_profileTimerId = 0;
+
         msgServer = m_msgServer;
         m_msgServer = NULL;
         sslConfig = m_sslConfig;
@@ -626,3 +640,41 @@ CMsgServer::OnCloseUser(IRtpMsgServer*      msgServer,
         m_logFile.Log(traceInfo, PRO_LL_INFO, true);
     }}}
 }
+
+void
+CMsgServer::OnTimer(void*    factory,
+                    uint64_t timerId,
+                    int64_t  tick,
+                    int64_t  userData)
+{
+    assert(factory != NULL);
+    assert(timerId > 0);
+    if (factory == NULL || timerId == 0)
+    {
+        return;
+    }
+
+    {
+        CProThreadMutexGuard mon(m_lock);
+
+        if (m_reactor == NULL || m_msgServer == NULL)
+        {
+            return;
+        }
+
+        if (timerId != m_profileTimerId)
+        {
+            return;
+        }
+    }
+
+    {{{
+        char* traceInfo = (char*)ProMalloc(PROFILE_DUMP_BYTES);
+        if (traceInfo != NULL)
+        {
+            ProDumpSgiPoolProfile(traceInfo, PROFILE_DUMP_BYTES);
+            m_logFile.Log(traceInfo, PRO_LL_INFO, true);
+            ProFree(traceInfo);
+        }
+    }}}
+}
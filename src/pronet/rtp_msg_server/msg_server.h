@@ -53,6 +53,9 @@ struct MSG_SERVER_CONFIG_INFO
 
         msgs_log_loop_bytes      = 50 * 1000 * 1000;
         msgs_log_level_green     = 0;
+        msgs_profile_interval    = 0;
+        msgs_pool_trim_interval  = 0;
+        msgs_pool_huge_page      = false;
 
         msgs_ssl_cafiles.push_back("ca.crt");
         msgs_ssl_cafiles.push_back("");
@@ -67,6 +70,9 @@ struct MSG_SERVER_CONFIG_INFO
         CProConfigStream configStream;
 
         configStream.AddUint("msgs_thread_count"       , msgs_thread_count);
+        configStream.Add    ("msgs_io_cpus"            , msgs_io_cpus);
+        configStream.Add    ("msgs_accept_cpus"        , msgs_accept_cpus);
+        configStream.Add    ("msgs_timer_cpus"         , msgs_timer_cpus);
         configStream.AddUint("msgs_mm_type"            , msgs_mm_type);
         configStream.AddUint("msgs_hub_port"           , msgs_hub_port);
         configStream.AddUint("msgs_handshake_timeout"  , msgs_handshake_timeout);
@@ -84,11 +90,17 @@ struct MSG_SERVER_CONFIG_INFO
 
         configStream.AddUint("msgs_log_loop_bytes"     , msgs_log_loop_bytes);
         configStream.AddInt ("msgs_log_level_green"    , msgs_log_level_green);
+        configStream.AddUint("msgs_profile_interval"   , msgs_profile_interval);
+        configStream.AddUint("msgs_pool_trim_interval" , msgs_pool_trim_interval);
+        configStream.AddInt ("msgs_pool_huge_page"     , msgs_pool_huge_page);
 
         configStream.Get(configs);
     }
 
     unsigned int                 msgs_thread_count; /* 1 ~ 100 */
+    CProStlString                msgs_io_cpus;      /* "0-7,16" */
+    CProStlString                msgs_accept_cpus;
+    CProStlString                msgs_timer_cpus;
     RTP_MM_TYPE                  msgs_mm_type;      /* RTP_MMT_MSG_MIN ~ RTP_MMT_MSG_MAX */
     unsigned short               msgs_hub_port;
     unsigned int                 msgs_handshake_timeout;
@@ -106,6 +118,9 @@ struct MSG_SERVER_CONFIG_INFO
 
     unsigned int                 msgs_log_loop_bytes;
     int                          msgs_log_level_green;
+    unsigned int                 msgs_profile_interval; /* SGI pool profile dump (s). 0: off */
+    unsigned int                 msgs_pool_trim_interval; /* SGI pool trimming (s). 0: off */
+    bool                         msgs_pool_huge_page;
 
     DECLARE_SGI_POOL(0)
 };
@@ -120,7 +135,7 @@ struct MSG_USER_CTX
 /////////////////////////////////////////////////////////////////////////////
 ////
 
-class CMsgServer : public IRtpMsgServerObserver, public CProRefCount
+class CMsgServer : public IRtpMsgServerObserver, public IProOnTimer, public CProRefCount
 {
 public:
 
@@ -199,6 +214,13 @@ private:
     {
     }
 
+    virtual void OnTimer(
+        void*    factory,
+        uint64_t timerId,
+        int64_t  tick,
+        int64_t  userData
+        );
+
 private:
 
     CProLogFile&                       m_logFile;
@@ -207,6 +229,7 @@ private:
     MSG_SERVER_CONFIG_INFO             m_configInfo;
     PRO_SSL_SERVER_CONFIG*             m_sslConfig;
     IRtpMsgServer*                     m_msgServer;
+    uint64_t                           m_profileTimerId;
 
     CProStlMap<uint64_t, MSG_USER_CTX> m_uid2Ctx[256]; /* cid0 ~ cid255 */
 
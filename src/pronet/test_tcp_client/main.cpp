@@ -57,6 +57,18 @@ ReadConfig_i(const CProStlString&            exeRoot,
                 configInfo.tcpc_thread_count = value;
             }
         }
+        else if (stricmp_pro(configName.c_str(), "tcpc_io_cpus") == 0)
+        {
+            configInfo.tcpc_io_cpus = configValue;
+        }
+        else if (stricmp_pro(configName.c_str(), "tcpc_accept_cpus") == 0)
+        {
+            configInfo.tcpc_accept_cpus = configValue;
+        }
+        else if (stricmp_pro(configName.c_str(), "tcpc_timer_cpus") == 0)
+        {
+            configInfo.tcpc_timer_cpus = configValue;
+        }
         else if (stricmp_pro(configName.c_str(), "tcpc_server_ip") == 0)
         {
             if (!configValue.empty())
@@ -143,6 +155,18 @@ ReadConfig_i(const CProStlString&            exeRoot,
                 configInfo.tcpc_recvpool_size = value;
             }
         }
+        else if (stricmp_pro(configName.c_str(), "tcpc_edge_triggered") == 0)
+        {
+            configInfo.tcpc_edge_triggered = atoi(configValue.c_str()) != 0;
+        }
+        else if (stricmp_pro(configName.c_str(), "tcpc_reactor_backend") == 0)
+        {
+            int value = atoi(configValue.c_str());
+            if (value >= 0 && value <= 3)
+            {
+                configInfo.tcpc_reactor_backend = value;
+            }
+        }
         else if (stricmp_pro(configName.c_str(), "tcpc_enable_ssl") == 0)
         {
             configInfo.tcpc_enable_ssl = atoi(configValue.c_str()) != 0;
@@ -289,7 +313,17 @@ int main(int argc, char* argv[])
     static char s_traceInfo[4096] = "";
     s_traceInfo[sizeof(s_traceInfo) - 1] = '\0';
 
-    reactor = ProCreateReactor(configInfo.tcpc_thread_count);
+    {
+        PRO_REACTOR_CONFIG reactorConfig;
+        reactorConfig.ioThreadCount    = configInfo.tcpc_thread_count;
+        reactorConfig.edgeTriggered    = configInfo.tcpc_edge_triggered;
+        reactorConfig.backend          = (PRO_REACTOR_BACKEND)configInfo.tcpc_reactor_backend;
+        reactorConfig.ioThreadCpus     = configInfo.tcpc_io_cpus.c_str();
+        reactorConfig.acceptThreadCpus = configInfo.tcpc_accept_cpus.c_str();
+        reactorConfig.timerThreadCpus  = configInfo.tcpc_timer_cpus.c_str();
+
+        reactor = ProCreateReactorEx(reactorConfig);
+    }
     if (reactor == NULL)
     {
         printf(
@@ -353,6 +387,9 @@ int main(int argc, char* argv[])
         "                      for example, \"htbttime 200\" \n"
         " htbtsize <bytes>   : set new heartbeat data size in bytes. [0 ~ 1024] \n"
         "                      for example, \"htbtsize 0\" \n"
+        " bench <seconds>    : echo test packets with the server on all connections, \n"
+        "                      and show the round trips per second. \n"
+        "                      for example, \"bench 10\" \n"
         );
 
     reactor->GetTraceInfo(s_traceInfo, sizeof(s_traceInfo));
@@ -422,7 +459,8 @@ int main(int argc, char* argv[])
         }
 
         if (stricmp_pro(p, "help") == 0 || stricmp_pro(p, "--help") == 0 ||
-            stricmp_pro(p, "htbttime") == 0 || stricmp_pro(p, "htbtsize") == 0)
+            stricmp_pro(p, "htbttime") == 0 || stricmp_pro(p, "htbtsize") == 0 ||
+            stricmp_pro(p, "bench") == 0)
         {
             printf(
                 "\n"
@@ -431,6 +469,9 @@ int main(int argc, char* argv[])
                 "                      for example, \"htbttime 200\" \n"
                 " htbtsize <bytes>   : set new heartbeat data size in bytes. [0 ~ 1024] \n"
                 "                      for example, \"htbtsize 0\" \n"
+                " bench <seconds>    : echo test packets with the server on all connections, \n"
+                "                      and show the round trips per second. \n"
+                "                      for example, \"bench 10\" \n"
                 );
         }
         else if (strnicmp_pro(p, "htbttime ", 9) == 0)
@@ -493,6 +534,38 @@ int main(int argc, char* argv[])
                 );
             printf(" [ HTBT Size ] : %u \n", (unsigned int)tester->GetHeartbeatDataSize());
         }
+        else if (strnicmp_pro(p, "bench ", 6) == 0)
+        {
+            p += 6;
+
+            int seconds = atoi(p);
+            if (seconds <= 0)
+            {
+                continue;
+            }
+
+            printf(
+                "\n"
+                "%s \n"
+                " bench : bench... \n"
+                ,
+                timeString.c_str()
+                );
+            unsigned long connections = tester->StartBench(seconds);
+            ProSleep(seconds * 1000 + 100);
+
+            ProGetLocalTimeString(timeString);
+            printf(
+                "\n"
+                "%s \n"
+                " [ Bench ] : %u connections, %u seconds, %u round trips/s \n"
+                ,
+                timeString.c_str(),
+                (unsigned int)connections,
+                (unsigned int)seconds,
+                (unsigned int)(tester->GetBenchCount() / seconds)
+                );
+        }
         else
         {
             tester->SendMsg(p);
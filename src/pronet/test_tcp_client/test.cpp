@@ -32,6 +32,14 @@
 /////////////////////////////////////////////////////////////////////////////
 ////
 
+/*
+ * a packet for testing purposes, with an 8 bytes zero payload
+ */
+static const char g_s_benchPacket[sizeof(uint16_t) + 8] = { 0, 8 };
+
+/////////////////////////////////////////////////////////////////////////////
+////
+
 CTest*
 CTest::CreateInstance()
 {
@@ -47,6 +55,9 @@ CTest::CTest()
     m_heartbeatData[0] = 0;
     m_heartbeatData[1] = 0;
     m_heartbeatSize    = sizeof(uint16_t);
+
+    m_benchEndTick     = 0;
+    m_benchCount       = 0;
 }
 
 CTest::~CTest()
@@ -329,6 +340,36 @@ CTest::SendMsg(const char* msg)
     }
 }
 
+unsigned long
+CTest::StartBench(unsigned long seconds)
+{
+    CProThreadMutexGuard mon(m_lock);
+
+    if (m_reactor == NULL)
+    {
+        return 0;
+    }
+
+    m_benchCount   = 0;
+    m_benchEndTick = ProGetTickCount64() + (int64_t)seconds * 1000;
+
+    auto itr = m_transports.begin();
+    auto end = m_transports.end();
+
+    for (; itr != end; ++itr)
+    {
+        (*itr)->SendData(g_s_benchPacket, sizeof(g_s_benchPacket));
+    }
+
+    return (unsigned long)m_transports.size();
+}
+
+uint64_t
+CTest::GetBenchCount() const
+{
+    return m_benchCount;
+}
+
 void
 CTest::OnConnectOk(IProConnector*   connector,
                    int64_t          sockId,
@@ -816,11 +857,17 @@ CTest::OnRecv(IProTransport*          trans,
             recvPool.Flush(length);
 
             /*
-             * a packet for testing purposes
+             * a packet for testing purposes. echo it again while benching
              */
             if (buf[sizeof(uint16_t)] == '\0')
             {
                 ProFree(buf);
+
+                if (ProGetTickCount64() < m_benchEndTick)
+                {
+                    ++m_benchCount;
+                    trans->SendData(g_s_benchPacket, sizeof(g_s_benchPacket));
+                }
                 continue;
             }
         }
@@ -27,6 +27,7 @@
 #include "../pro_util/pro_thread_mutex.h"
 #include "../pro_util/pro_timer_factory.h"
 #include "../pro_util/pro_z.h"
+#include <atomic>
 
 /////////////////////////////////////////////////////////////////////////////
 ////
@@ -47,6 +48,8 @@ struct TCP_CLIENT_CONFIG_INFO
         tcpc_sockbuf_size_recv   = 0;
         tcpc_sockbuf_size_send   = 0;
         tcpc_recvpool_size       = 0;
+        tcpc_edge_triggered      = false;
+        tcpc_reactor_backend     = 0;
 
         tcpc_enable_ssl          = false;
         tcpc_ssl_enable_sha1cert = true;
@@ -63,6 +66,9 @@ struct TCP_CLIENT_CONFIG_INFO
         CProConfigStream configStream;
 
         configStream.AddUint("tcpc_thread_count"       , tcpc_thread_count);
+        configStream.Add    ("tcpc_io_cpus"            , tcpc_io_cpus);
+        configStream.Add    ("tcpc_accept_cpus"        , tcpc_accept_cpus);
+        configStream.Add    ("tcpc_timer_cpus"         , tcpc_timer_cpus);
         configStream.Add    ("tcpc_server_ip"          , tcpc_server_ip);
         configStream.AddUint("tcpc_server_port"        , tcpc_server_port);
         configStream.Add    ("tcpc_local_ip"           , tcpc_local_ip);
@@ -74,6 +80,8 @@ struct TCP_CLIENT_CONFIG_INFO
         configStream.AddUint("tcpc_sockbuf_size_recv"  , tcpc_sockbuf_size_recv);
         configStream.AddUint("tcpc_sockbuf_size_send"  , tcpc_sockbuf_size_send);
         configStream.AddUint("tcpc_recvpool_size"      , tcpc_recvpool_size);
+        configStream.AddInt ("tcpc_edge_triggered"     , tcpc_edge_triggered);
+        configStream.AddUint("tcpc_reactor_backend"    , tcpc_reactor_backend);
 
         configStream.AddInt ("tcpc_enable_ssl"         , tcpc_enable_ssl);
         configStream.AddInt ("tcpc_ssl_enable_sha1cert", tcpc_ssl_enable_sha1cert);
@@ -86,6 +94,9 @@ struct TCP_CLIENT_CONFIG_INFO
     }
 
     unsigned int                 tcpc_thread_count;      /* 1 ~ 100 */
+    CProStlString                tcpc_io_cpus;           /* "0-7,16" */
+    CProStlString                tcpc_accept_cpus;
+    CProStlString                tcpc_timer_cpus;
     CProStlString                tcpc_server_ip;
     unsigned short               tcpc_server_port;
     CProStlString                tcpc_local_ip;
@@ -97,6 +108,8 @@ struct TCP_CLIENT_CONFIG_INFO
     unsigned int                 tcpc_sockbuf_size_recv; /* 0 or >= 1024 */
     unsigned int                 tcpc_sockbuf_size_send; /* 0 or >= 1024 */
     unsigned int                 tcpc_recvpool_size;     /* 0 or >= 1024 */
+    bool                         tcpc_edge_triggered;
+    unsigned int                 tcpc_reactor_backend;   /* 0 ~ 3 */
 
     bool                         tcpc_enable_ssl;
     bool                         tcpc_ssl_enable_sha1cert;
@@ -141,6 +154,14 @@ public:
 
     void SendMsg(const char* msg);
 
+    /*
+     * echoes test packets with the server on all connections for some
+     * seconds. returns the number of connections
+     */
+    unsigned long StartBench(unsigned long seconds);
+
+    uint64_t GetBenchCount() const; /* round trips */
+
 private:
 
     CTest();
@@ -263,6 +284,9 @@ private:
     unsigned long                  m_heartbeatSize; /* 0 ~ 1024 */
     mutable CProThreadMutex        m_lock2;
 
+    std::atomic<int64_t>           m_benchEndTick;
+    std::atomic<uint64_t>          m_benchCount;
+
     DECLARE_SGI_POOL(0)
 };
 
@@ -19,6 +19,7 @@
 #include "test.h"
 #include "../pro_net/pro_net.h"
 #include "../pro_util/pro_config_file.h"
+#include "../pro_util/pro_memory_pool.h"
 #include "../pro_util/pro_stl.h"
 #include "../pro_util/pro_time_util.h"
 #include "../pro_util/pro_version.h"
@@ -60,6 +61,18 @@ ReadConfig_i(const CProStlString&            exeRoot,
                 configInfo.tcps_thread_count = value;
             }
         }
+        else if (stricmp_pro(configName.c_str(), "tcps_io_cpus") == 0)
+        {
+            configInfo.tcps_io_cpus = configValue;
+        }
+        else if (stricmp_pro(configName.c_str(), "tcps_accept_cpus") == 0)
+        {
+            configInfo.tcps_accept_cpus = configValue;
+        }
+        else if (stricmp_pro(configName.c_str(), "tcps_timer_cpus") == 0)
+        {
+            configInfo.tcps_timer_cpus = configValue;
+        }
         else if (stricmp_pro(configName.c_str(), "tcps_using_hub") == 0)
         {
             configInfo.tcps_using_hub = atoi(configValue.c_str()) != 0;
@@ -120,6 +133,78 @@ ReadConfig_i(const CProStlString&            exeRoot,
                 configInfo.tcps_recvpool_size = value;
             }
         }
+        else if (stricmp_pro(configName.c_str(), "tcps_edge_triggered") == 0)
+        {
+            configInfo.tcps_edge_triggered = atoi(configValue.c_str()) != 0;
+        }
+        else if (stricmp_pro(configName.c_str(), "tcps_reactor_backend") == 0)
+        {
+            int value = atoi(configValue.c_str());
+            if (value >= 0 && value <= 3)
+            {
+                configInfo.tcps_reactor_backend = value;
+            }
+        }
+        else if (stricmp_pro(configName.c_str(), "tcps_reuseport_accept") == 0)
+        {
+            configInfo.tcps_reuseport_accept = atoi(configValue.c_str()) != 0;
+        }
+        else if (stricmp_pro(configName.c_str(), "tcps_reactor_balance") == 0)
+        {
+            int value = atoi(configValue.c_str());
+            if (value >= 0 && value <= 1)
+            {
+                configInfo.tcps_reactor_balance = value;
+            }
+        }
+        else if (stricmp_pro(configName.c_str(), "tcps_migrate_handlers") == 0)
+        {
+            configInfo.tcps_migrate_handlers = atoi(configValue.c_str()) != 0;
+        }
+        else if (stricmp_pro(configName.c_str(), "tcps_busy_poll_time") == 0)
+        {
+            int value = atoi(configValue.c_str());
+            if (value >= 0 && value <= 1000000)
+            {
+                configInfo.tcps_busy_poll_time = value;
+            }
+        }
+        else if (stricmp_pro(configName.c_str(), "tcps_busy_poll_sockets") == 0)
+        {
+            configInfo.tcps_busy_poll_sockets = atoi(configValue.c_str()) != 0;
+        }
+        else if (stricmp_pro(configName.c_str(), "tcps_loop_stats") == 0)
+        {
+            configInfo.tcps_loop_stats = atoi(configValue.c_str()) != 0;
+        }
+        else if (stricmp_pro(configName.c_str(), "tcps_slow_callback_time") == 0)
+        {
+            int value = atoi(configValue.c_str());
+            if (value >= 0 && value <= 60000000)
+            {
+                configInfo.tcps_slow_callback_time = value;
+            }
+        }
+        else if (stricmp_pro(configName.c_str(), "tcps_timing_wheel") == 0)
+        {
+            configInfo.tcps_timing_wheel = atoi(configValue.c_str()) != 0;
+        }
+        else if (stricmp_pro(configName.c_str(), "tcps_handler_timers") == 0)
+        {
+            configInfo.tcps_handler_timers = atoi(configValue.c_str()) != 0;
+        }
+        else if (stricmp_pro(configName.c_str(), "tcps_pool_trim_interval") == 0)
+        {
+            int value = atoi(configValue.c_str());
+            if (value >= 0)
+            {
+                configInfo.tcps_pool_trim_interval = value;
+            }
+        }
+        else if (stricmp_pro(configName.c_str(), "tcps_pool_huge_page") == 0)
+        {
+            configInfo.tcps_pool_huge_page = atoi(configValue.c_str()) != 0;
+        }
         else if (stricmp_pro(configName.c_str(), "tcps_enable_ssl") == 0)
         {
             configInfo.tcps_enable_ssl = atoi(configValue.c_str()) != 0;
@@ -317,10 +402,38 @@ int main(int argc, char* argv[])
         ReadConfig_i(exeRoot, configs, configInfo);
     }
 
-    static char s_traceInfo[4096] = "";
+    static char s_traceInfo[8192] = "";
     s_traceInfo[sizeof(s_traceInfo) - 1] = '\0';
 
-    reactor = ProCreateReactor(configInfo.tcps_thread_count);
+    if (configInfo.tcps_pool_huge_page)
+    {
+        for (int i = 0; i < 4; ++i)
+        {
+            ProSetSgiPoolHugePage(true, i);
+        }
+    }
+
+    {
+        PRO_REACTOR_CONFIG reactorConfig;
+        reactorConfig.ioThreadCount    = configInfo.tcps_thread_count;
+        reactorConfig.edgeTriggered    = configInfo.tcps_edge_triggered;
+        reactorConfig.backend          = (PRO_REACTOR_BACKEND)configInfo.tcps_reactor_backend;
+        reactorConfig.reusePortAccept  = configInfo.tcps_reuseport_accept;
+        reactorConfig.ioThreadCpus     = configInfo.tcps_io_cpus.c_str();
+        reactorConfig.acceptThreadCpus = configInfo.tcps_accept_cpus.c_str();
+        reactorConfig.timerThreadCpus  = configInfo.tcps_timer_cpus.c_str();
+        reactorConfig.balance          = (PRO_REACTOR_BALANCE)configInfo.tcps_reactor_balance;
+        reactorConfig.migrateHandlers  = configInfo.tcps_migrate_handlers;
+        reactorConfig.busyPollTime     = configInfo.tcps_busy_poll_time;
+        reactorConfig.busyPollSockets  = configInfo.tcps_busy_poll_sockets;
+        reactorConfig.loopStats        = configInfo.tcps_loop_stats;
+        reactorConfig.slowCallbackTime = configInfo.tcps_slow_callback_time;
+        reactorConfig.timingWheel      = configInfo.tcps_timing_wheel;
+        reactorConfig.handlerTimers    = configInfo.tcps_handler_timers;
+        reactorConfig.poolTrimInterval = configInfo.tcps_pool_trim_interval;
+
+        reactor = ProCreateReactorEx(reactorConfig);
+    }
     if (reactor == NULL)
     {
         printf(
@@ -769,10 +769,12 @@ CTest::OnRecv(IProTransport*          trans,
             memcpy(buf, &length, sizeof(uint16_t));
 
             /*
-             * a packet for testing purposes
+             * a packet for testing purposes. echo it silently
              */
             if (buf[sizeof(uint16_t)] == '\0')
             {
+                trans->SendData(buf, size); /* response */
+
                 ProFree(buf);
                 continue;
             }
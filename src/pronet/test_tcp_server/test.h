@@ -43,6 +43,19 @@ struct TCP_SERVER_CONFIG_INFO
         tcps_sockbuf_size_recv   = 0;
         tcps_sockbuf_size_send   = 0;
         tcps_recvpool_size       = 0;
+        tcps_edge_triggered      = false;
+        tcps_reactor_backend     = 0;
+        tcps_reuseport_accept    = false;
+        tcps_reactor_balance     = 0;
+        tcps_migrate_handlers    = false;
+        tcps_busy_poll_time      = 0;
+        tcps_busy_poll_sockets   = false;
+        tcps_loop_stats          = false;
+        tcps_slow_callback_time  = 0;
+        tcps_timing_wheel        = false;
+        tcps_handler_timers      = false;
+        tcps_pool_trim_interval  = 0;
+        tcps_pool_huge_page      = false;
 
         tcps_enable_ssl          = true;
         tcps_ssl_enable_sha1cert = true;
@@ -61,6 +74,9 @@ struct TCP_SERVER_CONFIG_INFO
         CProConfigStream configStream;
 
         configStream.AddUint("tcps_thread_count"       , tcps_thread_count);
+        configStream.Add    ("tcps_io_cpus"            , tcps_io_cpus);
+        configStream.Add    ("tcps_accept_cpus"        , tcps_accept_cpus);
+        configStream.Add    ("tcps_timer_cpus"         , tcps_timer_cpus);
         configStream.AddInt ("tcps_using_hub"          , tcps_using_hub);
         configStream.AddUint("tcps_port"               , tcps_port);
         configStream.AddUint("tcps_handshake_timeout"  , tcps_handshake_timeout);
@@ -69,6 +85,19 @@ struct TCP_SERVER_CONFIG_INFO
         configStream.AddUint("tcps_sockbuf_size_recv"  , tcps_sockbuf_size_recv);
         configStream.AddUint("tcps_sockbuf_size_send"  , tcps_sockbuf_size_send);
         configStream.AddUint("tcps_recvpool_size"      , tcps_recvpool_size);
+        configStream.AddInt ("tcps_edge_triggered"     , tcps_edge_triggered);
+        configStream.AddUint("tcps_reactor_backend"    , tcps_reactor_backend);
+        configStream.AddInt ("tcps_reuseport_accept"   , tcps_reuseport_accept);
+        configStream.AddUint("tcps_reactor_balance"    , tcps_reactor_balance);
+        configStream.AddInt ("tcps_migrate_handlers"   , tcps_migrate_handlers);
+        configStream.AddUint("tcps_busy_poll_time"     , tcps_busy_poll_time);
+        configStream.AddInt ("tcps_busy_poll_sockets"  , tcps_busy_poll_sockets);
+        configStream.AddInt ("tcps_loop_stats"         , tcps_loop_stats);
+        configStream.AddUint("tcps_slow_callback_time" , tcps_slow_callback_time);
+        configStream.AddInt ("tcps_timing_wheel"       , tcps_timing_wheel);
+        configStream.AddInt ("tcps_handler_timers"     , tcps_handler_timers);
+        configStream.AddUint("tcps_pool_trim_interval" , tcps_pool_trim_interval);
+        configStream.AddInt ("tcps_pool_huge_page"     , tcps_pool_huge_page);
 
         configStream.AddInt ("tcps_enable_ssl"         , tcps_enable_ssl);
         configStream.AddInt ("tcps_ssl_enable_sha1cert", tcps_ssl_enable_sha1cert);
@@ -81,6 +110,9 @@ struct TCP_SERVER_CONFIG_INFO
     }
 
     unsigned int                 tcps_thread_count;      /* 1 ~ 100 */
+    CProStlString                tcps_io_cpus;           /* "0-7,16" */
+    CProStlString                tcps_accept_cpus;
+    CProStlString                tcps_timer_cpus;
     bool                         tcps_using_hub;
     unsigned short               tcps_port;
     unsigned int                 tcps_handshake_timeout;
@@ -89,6 +121,19 @@ struct TCP_SERVER_CONFIG_INFO
     unsigned int                 tcps_sockbuf_size_recv; /* 0 or >= 1024 */
     unsigned int                 tcps_sockbuf_size_send; /* 0 or >= 1024 */
     unsigned int                 tcps_recvpool_size;     /* 0 or >= 1024 */
+    bool                         tcps_edge_triggered;
+    unsigned int                 tcps_reactor_backend;   /* 0 ~ 3 */
+    bool                         tcps_reuseport_accept;
+    unsigned int                 tcps_reactor_balance;   /* 0 ~ 1 */
+    bool                         tcps_migrate_handlers;
+    unsigned int                 tcps_busy_poll_time;    /* 0 ~ 1000000 */
+    bool                         tcps_busy_poll_sockets;
+    bool                         tcps_loop_stats;
+    unsigned int                 tcps_slow_callback_time; /* 0 ~ 60000000 */
+    bool                         tcps_timing_wheel;
+    bool                         tcps_handler_timers;
+    unsigned int                 tcps_pool_trim_interval; /* SGI pool trimming (s). 0: off */
+    bool                         tcps_pool_huge_page;
 
     bool                         tcps_enable_ssl;
     bool                         tcps_ssl_enable_sha1cert;